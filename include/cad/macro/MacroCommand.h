@@ -1,6 +1,8 @@
 #ifndef cad_macro_MacroCommand_h
 #define cad_macro_MacroCommand_h
 
+#include "cad/macro/interpreter/Future.h"
+
 #include <cad/core/command/Command.h>
 
 namespace cad {
@@ -19,6 +21,7 @@ namespace macro {
 class MacroCommand : public core::command::Command {
   std::weak_ptr<interpreter::OperatorProvider> op_provider_;
   std::weak_ptr<CommandProvider> command_provider_;
+  interpreter::Future::Executor executor_;
 
 public:
   enum class E { MISSING_PROVIDER };
@@ -28,9 +31,12 @@ public:
    *
    * @param  op_provider       The OperatorProvider
    * @param  command_provider  The CommandProvider
+   * @param  executor          The Executor of the async calls and the
+   *                           parallel loops of the macros
    */
   MacroCommand(std::weak_ptr<interpreter::OperatorProvider> op_provider,
-               std::weak_ptr<CommandProvider> command_provider);
+               std::weak_ptr<CommandProvider> command_provider,
+               interpreter::Future::Executor executor);
 
   /**
    * @brief  Executes the Command
@@ -40,7 +46,9 @@ public:
    *                 the macro will be executed with, 'Macroname'(string) the
    *                 name of the macro or file it is from and 'Output'
    *                 (std::reference_wrapper<std::ostream>) as the ouptut that
-   *                 will be used for the print operator.
+   *                 will be used for the print operator. 'Cancellation'
+   *                 (interpreter::Cancellation) stops the macro on request or
+   *                 once its deadline passed.
    *
    * @return can be anything
    *
@@ -0,0 +1,178 @@
+#ifndef cad_macro_MacroExecutor_h
+#define cad_macro_MacroExecutor_h
+
+#include "cad/macro/interpreter/Cancellation.h"
+#include "cad/macro/interpreter/Future.h"
+
+#include <p3/common/module_system/BaseProvider.h>
+
+#include <cad/core/command/argument/Arguments.h>
+
+#include <any.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+class CompiledMacro;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+/**
+ * @brief   The MacroExecutor runs batches of independent macros on the
+ *          threads of an interpreter::Future::Executor
+ * @details Every worker owns a queue of jobs. A submitted batch is split in
+ *          contiguous blocks, one per worker, a worker that runs out of jobs
+ *          steals from the back of the queue of another worker. A worker is
+ *          started with the Executor when jobs are submitted and returns once
+ *          all queues are empty, no thread is held while there is nothing to
+ *          do. The macros of a batch share nothing but the CompiledMacro, see
+ *          interpreter::Interpreter for the guarantees of concurrent runs.
+ *          A job must not wait for another job of the same MacroExecutor, the
+ *          Executor may have no thread left to run it.
+ */
+class MacroExecutor : public p3::common::module_system::BaseProvider {
+public:
+  using Arguments = cad::core::command::argument::Arguments;
+
+  /**
+   * @brief  One macro execution
+   */
+  struct Job {
+    std::shared_ptr<const interpreter::CompiledMacro> macro;
+    Arguments args;
+    // the scope from which the macro is executed, to get the right
+    // core::Command instances
+    std::string scope;
+    // the output of the print operator, nullptr to use the output of the
+    // interpreter::Interpreter that compiled the macro
+    std::ostream* out = nullptr;
+    // stops the macro on request or once its deadline passed
+    interpreter::Cancellation cancellation;
+  };
+
+  /**
+   * @brief  The outcome of one Job
+   */
+  struct Result {
+    linb::any value;
+    // nullptr if the Job succeeded
+    std::exception_ptr error;
+  };
+
+  /**
+   * @brief  Called once all jobs of a batch are done
+   *
+   * @param  results  The Result of every Job in the order of the batch
+   */
+  using Callback = std::function<void(std::vector<Result> results)>;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  interpreter::Future::Executor executor_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::atomic<std::size_t> next_;
+  std::atomic<std::size_t> pending_;
+  std::mutex mutex_;
+  std::condition_variable idle_;
+  // per worker: started with the Executor and not returned yet
+  std::vector<bool> running_;
+  std::size_t active_;
+
+  /**
+   * @brief  Distributes the given tasks over the queues and starts the workers
+   *         that aren't running
+   *
+   * @param  tasks  The tasks to run
+   */
+  void enqueue(std::vector<std::function<void()>> tasks);
+  /**
+   * @brief  Takes a task from the queue of the given worker or steals one from
+   *         the other queues
+   *
+   * @param  worker  The index of the worker
+   * @param  task    Set to the taken task
+   *
+   * @return true if a task was taken, false if all queues are empty
+   */
+  bool take(std::size_t worker, std::function<void()>& task);
+  /**
+   * @brief  Runs tasks until all queues are empty
+   *
+   * @param  worker  The index of the worker
+   */
+  void work(std::size_t worker);
+
+public:
+  /**
+   * @brief  Ctor - one worker per hardware thread
+   *
+   * @param  executor  The Executor that runs the workers
+   */
+  explicit MacroExecutor(interpreter::Future::Executor executor);
+  /**
+   * @brief  Ctor
+   *
+   * @param  executor  The Executor that runs the workers
+   * @param  workers   The maximum number of workers that run at the same
+   *                   time, at least one
+   */
+  MacroExecutor(interpreter::Future::Executor executor, std::size_t workers);
+  /**
+   * @brief  Dtor - waits until the workers ran the remaining jobs
+   */
+  ~MacroExecutor();
+
+  MacroExecutor(const MacroExecutor&) = delete;
+  MacroExecutor& operator=(const MacroExecutor&) = delete;
+
+  /**
+   * @brief  The maximum number of workers that run at the same time
+   *
+   * @return number of workers
+   */
+  std::size_t workers() const;
+
+  /**
+   * @brief  Runs the given jobs
+   *
+   * @param  jobs  The jobs to run
+   *
+   * @return one future per Job in the order of the jobs, the future holds the
+   *         result of the macro or rethrows its exception
+   */
+  std::vector<std::future<linb::any>> submit(std::vector<Job> jobs);
+  /**
+   * @brief   Runs the given jobs and calls the given Callback once all are
+   *          done
+   * @details The Callback is called on the thread that finished the last Job,
+   *          or on the calling thread if there are no jobs. Exceptions thrown
+   *          by the Callback are ignored.
+   *
+   * @param   jobs  The jobs to run
+   * @param   done  The Callback
+   */
+  void submit(std::vector<Job> jobs, Callback done);
+};
+}
+}
+#endif
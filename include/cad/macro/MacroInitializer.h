@@ -1,12 +1,14 @@
 #ifndef cad_macro_MacroInitializer_h
 #define cad_macro_MacroInitializer_h
 
+#include "cad/macro/interpreter/Future.h"
+
 #include <cad/core/CoreInitializerBase.h>
 
 namespace cad {
 namespace macro {
 namespace macro_initializer {
-enum class STEPS { OPERATOR_PROVIDER, MACRO_COMMAND, SIZE };
+enum class STEPS { OPERATOR_PROVIDER, MACRO_EXECUTOR, MACRO_COMMAND, SIZE };
 }
 
 /**
@@ -14,6 +16,9 @@ enum class STEPS { OPERATOR_PROVIDER, MACRO_COMMAND, SIZE };
  */
 class MacroInitializer
     : public cad::core::CoreInitializerBase<macro_initializer::STEPS> {
+  // runs the async calls, parallel loops and macro batches on the ThreadManager
+  interpreter::Future::Executor executor_;
+
 public:
   /**
    * @brief Ctor
@@ -33,8 +33,9 @@ protected:
     IndentStream indent_os(os);
 
     indent_os << '@' << prefix << " {\n";
-    indent_os.indent() << "line: " << token.line << " column: " << token.column
-                       << " token: " << token.token << "\n";
+    indent_os.indent() << "line: " << token.line()
+                       << " column: " << token.column()
+                       << " token: " << token.text() << "\n";
     fun(indent_os);
     indent_os.dedent() << "}\n";
   }
@@ -91,7 +91,7 @@ public:
   /**
    * @brief  MCtor
    */
-  Operator(Operator&& other);
+  Operator(Operator&& other) noexcept;
   /**
    * @brief  Ctor
    *
@@ -105,7 +105,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(Operator& first, Operator& second) {
+  friend void swap(Operator& first, Operator& second) noexcept {
     // enable ADL
     using std::swap;
 
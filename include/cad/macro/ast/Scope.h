@@ -6,6 +6,7 @@
 #include "cad/macro/ast/Define.h"
 #include "cad/macro/ast/Literal.h"
 #include "cad/macro/ast/Operator.h"
+#include "cad/macro/ast/ScopeRef.h"
 #include "cad/macro/ast/Variable.h"
 #include "cad/macro/ast/callable/Callable.h"
 #include "cad/macro/ast/callable/Return.h"
@@ -18,6 +19,11 @@
 
 #include <eggs/variant.hpp>
 
+#include <experimental/string_view>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace cad {
@@ -53,6 +59,29 @@ public:
                     Literal<Literals::INT>, Literal<Literals::STRING>, Return,
                     Scope, Variable, While>;
 
+  /**
+   * @brief   A variable of an outer frame that a callable::Function assigns
+   * @details An assignment always writes the frame it runs in, the function
+   *          reads the outer variable through its own slot until it assigns
+   *          it.
+   */
+  struct Shadow {
+    Address outer;       // relative to the frame of the function
+    std::uint32_t slot;  // in the frame of the function
+  };
+  /**
+   * @brief   The variables of a frame, see Address
+   * @details Set on the root Scope and on the bodies of the callable::Function
+   *          and parallel loop::For instances. Every name that is defined or
+   *          assigned in the frame has one slot, the parameter of a function
+   *          and the loop and reduction variables of a parallel loop come
+   *          first.
+   */
+  struct Frame {
+    std::vector<std::experimental::string_view> slots;
+    std::vector<Shadow> shadows;
+  };
+
 private:
   /**
    * @brief  Pretty prints the internals of this struct
@@ -63,6 +92,13 @@ private:
 
 public:
   std::vector<Node> nodes;
+  // indices of the nodes that define a callable::Function, set once after the
+  // analysis by parser::index_functions
+  std::vector<std::size_t> functions;
+  // the bodies of the nodes, only the root Scope of a parsed macro owns them
+  std::shared_ptr<ScopeArena> arena;
+  // set by the parser::Analyser
+  mutable Frame frame;
 
   /**
    * @brief  Ctor
@@ -75,6 +111,15 @@ public:
    */
   Scope(parser::Token token);
 
+  /**
+   * @brief  Access to the functions defined in this Scope
+   *
+   * @param  index  The index into functions
+   *
+   * @return the callable::Function or callable::EntryFunction
+   */
+  const callable::Function& function(std::size_t index) const;
+
   /**
    * @brief  Equality comparison
    *
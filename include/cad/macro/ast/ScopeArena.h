@@ -0,0 +1,52 @@
+#ifndef cad_macro_ast_ScopeArena_h
+#define cad_macro_ast_ScopeArena_h
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/ast/ScopeRef.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+namespace cad {
+namespace macro {
+namespace ast {
+/**
+ * @brief   The ScopeArena stores the bodies of the nodes of a macro.
+ * @details The Scope instances are stored in blocks and never move, they are
+ *          only freed together with the arena. The nodes refer to them with
+ *          a ScopeRef. The arena has to be owned by a std::shared_ptr for
+ *          the copies of the ScopeRef instances to share it.
+ */
+class ScopeArena : public std::enable_shared_from_this<ScopeArena> {
+  std::deque<Scope> scopes_;
+
+public:
+  /**
+   * @brief  Adds a Scope to the arena
+   *
+   * @param  scope  The Scope
+   *
+   * @return reference to the Scope in the arena, it does not own the arena
+   */
+  ScopeRef add(Scope scope);
+  /**
+   * @brief  Access to a Scope of the arena
+   *
+   * @param  index  The index of the Scope
+   *
+   * @return the Scope
+   */
+  Scope& at(std::uint32_t index);
+  /**
+   * @brief  The number of Scope instances in the arena
+   *
+   * @return the number
+   */
+  std::size_t size() const;
+};
+}
+}
+}
+#endif
@@ -0,0 +1,103 @@
+#ifndef cad_macro_ast_ScopeRef_h
+#define cad_macro_ast_ScopeRef_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cad {
+namespace macro {
+namespace ast {
+struct Scope;
+class ScopeArena;
+
+/**
+ * @brief   The ScopeRef refers to the Scope of a body by its index in a
+ *          ScopeArena.
+ * @details The bodies of the functions, loops and ifs the parser creates are
+ *          in the ScopeArena of the root Scope. The ScopeRef the arena hands
+ *          out does not own it, the bodies in the arena would keep it alive
+ *          otherwise. A copy shares the ownership of the arena, a node copied
+ *          out of a parsed tree stays valid after the root is gone. A ScopeRef
+ *          that is made from a std::unique_ptr owns a ScopeArena of its own.
+ *          Copies refer to the same Scope, the bodies are not changed after
+ *          the parsing and copying a node with a body does not clone it.
+ */
+class ScopeRef {
+  friend class ScopeArena;
+
+  ScopeArena* arena_;
+  std::shared_ptr<ScopeArena> owner_;  // empty for the ScopeArena::add ones
+  std::uint32_t index_;
+
+  /**
+   * @brief  Ctor of a ScopeRef that does not own the arena
+   *
+   * @param  arena  The arena
+   * @param  index  The index of the Scope in the arena
+   */
+  ScopeRef(ScopeArena& arena, std::uint32_t index) noexcept;
+
+public:
+  /**
+   * @brief  Ctor of a ScopeRef without Scope
+   */
+  ScopeRef() noexcept;
+  /**
+   * @brief  Ctor of a ScopeRef without Scope
+   */
+  ScopeRef(std::nullptr_t) noexcept;
+  /**
+   * @brief  Ctor of a ScopeRef that owns a ScopeArena with the given Scope
+   *
+   * @param  scope  The Scope, nullptr for a ScopeRef without Scope
+   */
+  ScopeRef(std::unique_ptr<Scope> scope);
+  /**
+   * @brief  CCtor, the copy shares the ownership of the arena
+   */
+  ScopeRef(const ScopeRef& other);
+  /**
+   * @brief  MCtor
+   */
+  ScopeRef(ScopeRef&& other) noexcept = default;
+  /**
+   * @brief  Assignment, a copy shares the ownership of the arena
+   */
+  ScopeRef& operator=(const ScopeRef& other);
+  /**
+   * @brief  Move assignment
+   */
+  ScopeRef& operator=(ScopeRef&& other) noexcept = default;
+
+  /**
+   * @brief  Checks if there is a Scope
+   *
+   * @return true if there is one
+   */
+  explicit operator bool() const noexcept {
+    return arena_ != nullptr;
+  }
+  /**
+   * @brief  Access to the Scope
+   *
+   * @return the Scope, nullptr if there is none
+   */
+  Scope* get() const;
+  /**
+   * @brief  Access to the Scope
+   *
+   * @return the Scope
+   */
+  Scope& operator*() const;
+  /**
+   * @brief  Access to the Scope
+   *
+   * @return the Scope
+   */
+  Scope* operator->() const;
+};
+}
+}
+}
+#endif
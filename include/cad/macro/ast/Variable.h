@@ -3,14 +3,31 @@
 
 #include "cad/macro/ast/AST.h"
 
+#include <cstdint>
+
 namespace cad {
 namespace macro {
 namespace ast {
+/**
+ * @brief   The position of a Variable at run time
+ * @details A frame is the interpreter::Stack of the root Scope, of a
+ *          callable::Function call or of an iteration of a parallel
+ *          loop::For. The depth is the number of frames to walk up from the
+ *          running one and the slot is the index in that frame.
+ */
+struct Address {
+  std::uint32_t depth = 0;
+  std::uint32_t slot = 0;
+};
+
 /**
  * @brief  The Variable class represents all variables in the macro.
  */
 struct Variable : public AST {
 public:
+  // the definition the Variable refers to, set by the parser::Analyser
+  mutable Address address;
+
   /**
    * @brief  Ctor
    */
@@ -23,7 +23,8 @@ namespace callable {
  *
  * @details The function calls can either be directed at ast::Function or a
  *          core::Command. The macro syntax is fun() / fun(foo:gun()) /
- *          fun(foo:gun(), bar:hun())
+ *          fun(foo:gun(), bar:hun()) / async fun(). An async call of a
+ *          core::Command returns a future that is joined when it is read.
  */
 struct Callable : public AST {
 protected:
@@ -36,6 +37,7 @@ protected:
 
 public:
   std::vector<std::pair<Variable, ValueProducer>> parameter;
+  bool async;
 
   /**
    * @brief  Ctor
@@ -48,7 +50,7 @@ public:
   /**
    * @brief  MCtor
    */
-  Callable(Callable&&);
+  Callable(Callable&&) noexcept;
   /**
    * @brief  Ctor
    *
@@ -102,7 +104,7 @@ public:
  * @param  first   Operator swapped with second
  * @param  second  Operator swapped with first
  */
-void swap(Callable& first, Callable& second);
+void swap(Callable& first, Callable& second) noexcept;
 }
 }
 }
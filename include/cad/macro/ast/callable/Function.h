@@ -2,14 +2,13 @@
 #define cad_macro_ast_callable_Function_h
 
 #include "cad/macro/ast/AST.h"
+#include "cad/macro/ast/ScopeRef.h"
 
-#include <memory>
 #include <vector>
 
 namespace cad {
 namespace macro {
 namespace ast {
-struct Scope;
 struct Variable;
 }
 }
@@ -37,7 +36,7 @@ protected:
 
 public:
   std::vector<Variable> parameter;
-  std::unique_ptr<Scope> scope;
+  ScopeRef scope;
 
   /**
    * @brief  Ctor
@@ -50,7 +49,7 @@ public:
   /**
    * @brief  MCtor
    */
-  Function(Function&&);
+  Function(Function&&) noexcept;
   /**
    * @brief  Ctor
    *
@@ -68,7 +67,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(Function& first, Function& second) {
+  friend void swap(Function& first, Function& second) noexcept {
     // enable ADL
     using std::swap;
 
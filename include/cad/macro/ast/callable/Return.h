@@ -44,7 +44,7 @@ public:
   /**
    * @brief  MCtor
    */
-  Return(Return&&);
+  Return(Return&&) noexcept;
   /**
    * @brief  Ctor
    *
@@ -58,7 +58,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(Return& first, Return& second) {
+  friend void swap(Return& first, Return& second) noexcept {
     // enable ADL
     using std::swap;
 
@@ -44,7 +44,7 @@ public:
   /**
    * @brief  MCtor
    */
-  Condition(Condition&&);
+  Condition(Condition&&) noexcept;
   /**
    * @brief  Ctor
    *
@@ -62,7 +62,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(Condition& first, Condition& second) {
+  friend void swap(Condition& first, Condition& second) noexcept {
     // enable ADL
     using std::swap;
 
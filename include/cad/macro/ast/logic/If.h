@@ -1,16 +1,9 @@
 #ifndef cad_macro_ast_logic_If_h
 #define cad_macro_ast_logic_If_h
 
+#include "cad/macro/ast/ScopeRef.h"
 #include "cad/macro/ast/logic/Condition.h"
 
-namespace cad {
-namespace macro {
-namespace ast {
-struct Scope;
-}
-}
-}
-
 namespace cad {
 namespace macro {
 namespace ast {
@@ -31,8 +24,8 @@ protected:
   void print_internals(IndentStream& os) const;
 
 public:
-  std::unique_ptr<Scope> true_scope;
-  std::unique_ptr<Scope> false_scope;
+  ScopeRef true_scope;
+  ScopeRef false_scope;
 
   /**
    * @brief  Ctor
@@ -45,7 +38,7 @@ public:
   /**
    * @brief  MCtor
    */
-  If(If&& other);
+  If(If&& other) noexcept;
   /**
    * @brief  Ctor
    *
@@ -63,7 +56,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(If& first, If& second) {
+  friend void swap(If& first, If& second) noexcept {
     using std::swap;
 
     swap(static_cast<Condition&>(first), static_cast<Condition&>(second));
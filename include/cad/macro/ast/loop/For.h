@@ -11,6 +11,8 @@
 #include <eggs/variant.hpp>
 #include <experimental/optional>
 
+#include <vector>
+
 namespace cad {
 namespace macro {
 namespace ast {
@@ -21,8 +23,55 @@ namespace loop {
  * @details The syntax is for(;;){...} / for(def a = true;;){...} / for(a =
  *          true;;){...} / for(; a<0;){...} / for(; fun();){...} / for(;
  *          false;){...} / for(;;fun()){...} / for(;;false){...} / ...
+ *
+ *          The iterations of a parallel for(var i = 0; i < n; i = i + 1)
+ *          reduce(sum: a, collect: b){...} are executed concurrently, each
+ *          with its own copy of the loop variable and the reduction variables.
+ *          The copy of a sum starts at the zero of the type of the outer
+ *          variable (0, 0.0 or ""), the copy of a minimum or maximum at the
+ *          outer variable and the copy of a collect empty - sum = sum + i
+ *          counts the outer value once. A sum of any other type has no zero,
+ *          the iterations of the loop are executed in order then and each
+ *          continues the sum of the previous one, the first one the outer
+ *          variable. The reduction variables are combined after the loop in
+ *          the order of the iterations. A collect gets the value its copy has
+ *          at the end of an iteration, an iteration that assigns it twice
+ *          contributes the last value only. The rows of batched calls are
+ *          passed on after the loop in the order of the iterations too, all
+ *          other calls are executed as the iterations run.
  */
 struct For : public While {
+  /**
+   * @brief  A variable the iterations of a parallel For contribute to
+   */
+  struct Reduction {
+    enum class Kind { SUM, MIN, MAX, COLLECT };
+
+    Kind kind;
+    Variable variable;
+
+    /**
+     * @brief  Equality comparison
+     *
+     * @param  other  The reduction to compare against
+     *
+     * @return true if the two objects are same
+     */
+    bool operator==(const Reduction& other) const {
+      return kind == other.kind && variable == other.variable;
+    }
+    /**
+     * @brief  Equality comparison
+     *
+     * @param  other  The reduction to compare against
+     *
+     * @return false if the two objects are same
+     */
+    bool operator!=(const Reduction& other) const {
+      return !(*this == other);
+    }
+  };
+
 protected:
   /**
    * @brief  Pretty prints the internals of this struct
@@ -35,6 +84,8 @@ public:
   std::experimental::optional<Define> define;
   std::experimental::optional<ValueProducer> variable;
   std::experimental::optional<ValueProducer> operation;
+  std::vector<Reduction> reductions;
+  bool parallel = false;
 
   /**
    * @brief  Ctor
@@ -47,6 +98,14 @@ public:
    */
   For(parser::Token token);
 
+  /**
+   * @brief  The variable the For iterates - the defined variable or the
+   *         variable that is assigned by the initialization
+   *
+   * @return the variable or nullptr if there is none
+   */
+  const Variable* loop_variable() const;
+
   /**
    * @brief  Equality comparison
    *
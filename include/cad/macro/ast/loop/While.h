@@ -2,18 +2,9 @@
 #define cad_macro_ast_loop_While_h
 
 #include "cad/macro/ast/AST.h"
+#include "cad/macro/ast/ScopeRef.h"
 #include "cad/macro/ast/logic/Condition.h"
 
-#include <memory>
-
-namespace cad {
-namespace macro {
-namespace ast {
-struct Scope;
-}
-}
-}
-
 namespace cad {
 namespace macro {
 namespace ast {
@@ -33,7 +24,7 @@ protected:
   void print_internals(IndentStream& os) const;
 
 public:
-  std::unique_ptr<Scope> scope;
+  ScopeRef scope;
 
   /**
    * @brief  Ctor
@@ -46,7 +37,7 @@ public:
   /**
    * @brief  MCtor
    */
-  While(While&& other);
+  While(While&& other) noexcept;
   /**
    * @brief  Ctor
    *
@@ -64,7 +55,7 @@ public:
    * @param  first   Operator swapped with second
    * @param  second  Operator swapped with first
    */
-  friend void swap(While& first, While& second) {
+  friend void swap(While& first, While& second) noexcept {
     // enable ADL
     using std::swap;
 
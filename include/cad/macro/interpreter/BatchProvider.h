@@ -0,0 +1,130 @@
+#ifndef cad_macro_interpreter_BatchProvider_h
+#define cad_macro_interpreter_BatchProvider_h
+
+#include <cad/core/command/argument/Arguments.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The BatchProvider holds the core::Command instances that opted in
+ *          to be executed with many argument rows at once
+ * @details A call of such a core::Command whose result is not used is queued
+ *          instead of executed. The queued rows are passed to the batch
+ *          function in chunks, at the latest before anything else that is
+ *          observable from outside the macro happens - another core::Command
+ *          is executed, something is printed or the run ends.
+ */
+class BatchProvider {
+public:
+  using Arguments = cad::core::command::argument::Arguments;
+  using Batch = std::function<void(const std::vector<Arguments>& rows)>;
+
+  enum class E { BATCH_EXISTS };
+
+private:
+  std::unordered_map<std::string, std::unordered_map<std::string, Batch>>
+      batches_;
+  std::size_t chunk_size_;
+
+public:
+  /**
+   * @brief  Ctor
+   *
+   * @param  chunk_size  The maximum number of rows passed to a batch function
+   *                     at once
+   */
+  BatchProvider(std::size_t chunk_size = 1024);
+
+  /**
+   * @brief  Adds the batch function of the core::Command with the given name
+   *         in the given scope
+   *
+   * @param  scope  The scope of the core::Command
+   * @param  name   The name of the core::Command
+   * @param  batch  The function that executes the core::Command once per row
+   *
+   * @throws Exc<E, E::BATCH_EXISTS>
+   */
+  void add(const std::string& scope, const std::string& name, Batch batch);
+  /**
+   * @brief  Finds the batch function of the core::Command with the given name
+   *         in the given scope
+   *
+   * @param  scope  The scope of the core::Command
+   * @param  name   The name of the core::Command
+   *
+   * @return the batch function or nullptr if the core::Command didn't opt in
+   */
+  const Batch* find(const std::string& scope, const std::string& name) const;
+  /**
+   * @brief  The maximum number of rows passed to a batch function at once
+   *
+   * @return chunk size
+   */
+  std::size_t chunk_size() const;
+};
+
+/**
+ * @brief   The BatchQueue collects the rows of the batched calls of one run
+ * @details Only the rows of one batch function are queued at a time, a call
+ *          of another batch function flushes the queue first. This keeps the
+ *          order of the calls as they are in the macro.
+ *
+ *          A recording BatchQueue never passes its rows on by itself, they
+ *          are moved to another BatchQueue with replay. The iterations of a
+ *          parallel ast::loop::For record their rows, which are replayed in
+ *          the order of the iterations after the loop.
+ */
+class BatchQueue {
+  using Arguments = BatchProvider::Arguments;
+  using Batch = BatchProvider::Batch;
+
+  const Batch* batch_;
+  std::vector<Arguments> rows_;
+  std::size_t chunk_size_;
+  std::vector<std::pair<const Batch*, std::vector<Arguments>>> recorded_;
+
+public:
+  /**
+   * @brief  Ctor
+   *
+   * @param  chunk_size  The number of rows after which the queue is flushed
+   */
+  BatchQueue(std::size_t chunk_size);
+  /**
+   * @brief  Ctor of a recording BatchQueue
+   */
+  BatchQueue();
+
+  /**
+   * @brief  Queues a row for the given batch function
+   *
+   * @param  batch  The batch function
+   * @param  row    The arguments of the call
+   */
+  void add(const Batch& batch, Arguments row);
+  /**
+   * @brief  Passes all queued rows to their batch function, does nothing if
+   *         the BatchQueue is recording
+   */
+  void flush();
+  /**
+   * @brief  Moves the recorded rows to the given BatchQueue in the order they
+   *         were added
+   *
+   * @param  queue  The BatchQueue the rows are added to
+   */
+  void replay(BatchQueue& queue);
+};
+}
+}
+}
+#endif
@@ -0,0 +1,193 @@
+#ifndef cad_macro_interpreter_Bytecode_h
+#define cad_macro_interpreter_Bytecode_h
+
+#include "cad/macro/interpreter/Value.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace ast {
+namespace callable {
+struct Callable;
+struct Function;
+}
+namespace loop {
+struct For;
+}
+}
+namespace parser {
+struct Token;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace bytecode {
+/**
+ * @brief   The operation codes the VM understands
+ * @details The VM has an operand stack of Value instances and a result
+ *          register that holds the value of the last executed compound
+ *          statement (if, loops, scopes and return), the result register is
+ *          the return value of a Chunk.
+ */
+enum class OpCode : std::uint8_t {
+  CONSTANT,         // push constants[argument]
+  LOAD,             // push copy of the variable lookups[argument]
+  SHADOW,           // define shadows[argument] with a copy of the outer one
+  STORE,            // assign the top of the operand stack to slot argument
+  DEFINE_VARIABLE,  // define the variable in slot argument
+  DEFINE_FUNCTION,  // define the function definitions[argument] once
+  POP,              // drop the top of the operand stack
+  BINARY,           // pop rhs and lhs, push the OperatorProvider result
+  UNARY,            // pop rhs, push the OperatorProvider result
+  PRINT,            // pop rhs, print and push the printed string
+  JUMP,             // continue at argument
+  JUMP_IF_FALSE,    // pop, continue at argument if the value is false
+  // convert the top to bool, continue at argument if it is false / true and
+  // keep it as result of the && / || - otherwise pop it
+  JUMP_IF_FALSE_OR_POP,
+  JUMP_IF_TRUE_OR_POP,
+  TO_BOOL,          // convert the top of the operand stack to bool
+  CALL,             // pop the parameter of calls[argument] and call it
+  SET_RESULT,       // pop into the result register
+  CLEAR_RESULT,     // empty the result register
+  RETURN,           // pop into the result register and leave the Chunk
+  ITERATION,        // pop the value of the loop variable of an iteration
+  PARALLEL,         // execute the iterations of parallels[argument]
+  END               // leave the Chunk
+};
+
+/**
+ * @brief  A single instruction of a Chunk
+ */
+struct Instruction {
+  OpCode code;
+  std::uint32_t argument;
+  std::uint32_t token;  // index into Bytecode::tokens for error messages
+};
+
+/**
+ * @brief  The position of a variable: the number of Stack parents to walk up
+ *         and the slot in that Stack
+ */
+struct Address {
+  std::uint32_t depth;
+  std::uint32_t slot;
+};
+
+/**
+ * @brief   The position of a variable that is read
+ * @details The position is the definition of the ast::Variable that is
+ *          visible where it is read, the same one the Analyser checked.
+ */
+struct Lookup {
+  std::uint32_t name;  // index into Bytecode::names
+  Address address;
+};
+
+/**
+ * @brief   A variable of an outer Stack that a ast::callable::Function assigns
+ * @details An assignment always writes the Stack of the running chunk, the
+ *          function works on a copy of the outer variable that is made when
+ *          the function is entered. The outer Stack can't change while the
+ *          function runs, so the copy reads the same as the outer variable
+ *          until it is assigned.
+ */
+struct Shadow {
+  std::uint32_t lookup;  // the outer variable, index into Bytecode::lookups
+  std::uint32_t slot;    // the slot of the copy in the Stack of the function
+};
+
+/**
+ * @brief  A ast::callable::Function that is defined in the slot of a Stack
+ */
+struct Definition {
+  std::reference_wrapper<const ast::callable::Function> function;
+  std::uint32_t slot;  // is defined once the function is defined
+};
+
+/**
+ * @brief  A ast::callable::Function a call site can be bound to
+ */
+struct Binding {
+  std::uint32_t depth;  // number of Stack parents to walk up
+  std::uint32_t slot;   // slot of the Definition in that Stack
+  std::uint32_t chunk;  // chunk of the function
+  // per parameter of the call: the slot of the parameter in the function Stack
+  std::vector<std::uint32_t> parameter;
+  const ast::callable::Function* function;
+};
+
+/**
+ * @brief   A call site that is resolved once at compile time
+ * @details The candidates are all functions that match the name and the
+ *          parameter of the call from the innermost to the outermost Stack, the
+ *          first defined one is called. If none is defined the
+ *          ast::callable::Callable is a core::Command.
+ */
+struct Call {
+  std::reference_wrapper<const ast::callable::Callable> callable;
+  std::vector<Binding> candidates;
+};
+
+/**
+ * @brief   A parallel ast::loop::For
+ * @details The body of the loop is its own chunk, the first slot of its Stack
+ *          is the loop variable and the next slots are the reduction
+ *          variables in the order of the ast::loop::For. Each iteration
+ *          executes the chunk on its own Stack.
+ */
+struct Parallel {
+  std::reference_wrapper<const ast::loop::For> loop;
+  std::uint32_t chunk;  // chunk of the body
+  // per reduction: the lookup of the variable before the loop and the slot it
+  // is assigned to after the loop
+  std::vector<std::uint32_t> lookups;
+  std::vector<std::uint32_t> stores;
+};
+
+/**
+ * @brief  The instructions of the root ast::Scope, of one
+ *         ast::callable::Function or of the body of a parallel ast::loop::For
+ */
+struct Chunk {
+  std::vector<Instruction> code;
+  // names of the variables and functions in the slots of the Stack, the first
+  // slots are the parameter of the ast::callable::Function in the order of its
+  // definition
+  std::vector<std::string> slots;
+};
+
+/**
+ * @brief   The Bytecode is the linear representation of an analysed macro
+ * @details The Bytecode references the ast::Scope it was compiled from, the
+ *          ast::Scope has to outlive the Bytecode.
+ */
+struct Bytecode {
+  using TokenRef = std::reference_wrapper<const parser::Token>;
+
+  // chunks[0] is the root ast::Scope
+  std::vector<Chunk> chunks;
+  std::vector<Value> constants;
+  std::vector<std::string> names;
+  std::vector<Lookup> lookups;
+  std::vector<Shadow> shadows;
+  std::vector<Call> calls;
+  std::vector<Definition> definitions;
+  std::vector<Parallel> parallels;
+  std::vector<TokenRef> tokens;
+  std::unordered_map<const ast::callable::Function*, std::uint32_t>
+      function_chunks;
+};
+}
+}
+}
+}
+#endif
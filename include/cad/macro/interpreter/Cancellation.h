@@ -0,0 +1,130 @@
+#ifndef cad_macro_interpreter_Cancellation_h
+#define cad_macro_interpreter_Cancellation_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace cad {
+namespace macro {
+namespace parser {
+struct Token;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Cancellation stops a run of a macro on request or once its
+ *          deadline passed
+ * @details Copies share the request, a Cancellation can be handed to a run and
+ *          cancelled from another thread. The runs check it at the back edges
+ *          of loops and at the calls of macro functions, a running
+ *          core::Command is not interrupted.
+ */
+class Cancellation {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class E { CANCELLED, DEADLINE };
+
+  /**
+   * @brief   Checks a Cancellation for one thread of a run
+   * @details The request is read at every check, the clock only at every 64th
+   *          check
+   */
+  class Probe {
+    const Cancellation& cancellation_;
+    std::uint32_t ticks_;
+
+  public:
+    /**
+     * @brief  Ctor
+     *
+     * @param  cancellation  The Cancellation to check, has to outlive the
+     *                       Probe
+     */
+    explicit Probe(const Cancellation& cancellation)
+        : cancellation_(cancellation)
+        , ticks_(0) {
+    }
+
+    /**
+     * @brief  The checked Cancellation
+     *
+     * @return the Cancellation
+     */
+    const Cancellation& cancellation() const {
+      return cancellation_;
+    }
+    /**
+     * @brief  Throws if the run has to stop
+     *
+     * @param  token  The Token the run is at
+     * @param  file   The file name / name of the macro.
+     *
+     * @throws Exc<E,  E::CANCELLED>
+     * @throws Exc<E,  E::DEADLINE>
+     */
+    void check(const parser::Token& token, const std::string& file) {
+      if(cancellation_.cancelled_->load(std::memory_order_relaxed)
+         || (cancellation_.deadline_ != Clock::time_point::max()
+             && ticks_++ % 64 == 0 && Clock::now() >= cancellation_.deadline_)) {
+        cancellation_.stop(token, file);
+      }
+    }
+  };
+
+private:
+  std::shared_ptr<std::atomic<bool>> cancelled_;
+  Clock::time_point deadline_;
+
+  /**
+   * @brief  Throws the exception of the reason to stop
+   *
+   * @param  token  The Token the run is at
+   * @param  file   The file name / name of the macro.
+   *
+   * @throws Exc<E,  E::CANCELLED>
+   * @throws Exc<E,  E::DEADLINE>
+   */
+  [[noreturn]] void stop(const parser::Token& token,
+                         const std::string& file) const;
+
+public:
+  /**
+   * @brief  Ctor - without a deadline
+   */
+  Cancellation();
+  /**
+   * @brief  Ctor
+   *
+   * @param  deadline  The point in time after which the run stops
+   */
+  explicit Cancellation(Clock::time_point deadline);
+
+  /**
+   * @brief  Requests all runs with this Cancellation, or a copy of it, to stop
+   */
+  void cancel() const;
+  /**
+   * @brief  Whether the runs were requested to stop
+   *
+   * @return true if cancel was called
+   */
+  bool is_cancelled() const;
+  /**
+   * @brief  The point in time after which the run stops
+   *
+   * @return deadline, Clock::time_point::max() if there is none
+   */
+  Clock::time_point deadline() const;
+};
+}
+}
+}
+#endif
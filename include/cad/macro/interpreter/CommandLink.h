@@ -0,0 +1,108 @@
+#ifndef cad_macro_interpreter_CommandLink_h
+#define cad_macro_interpreter_CommandLink_h
+
+#include "cad/macro/interpreter/BatchProvider.h"
+#include "cad/macro/interpreter/Bytecode.h"
+
+#include <cad/core/command/CommandProvider.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The CommandLink holds the core::Command instances the call sites of
+ *          a bytecode::Bytecode resolve to in one scope
+ * @details Only call sites without any ast::callable::Function candidate are
+ *          linked, they can only be satisfied by a core::Command. The
+ *          core::Command instances are looked up once per scope, a run copies
+ *          the prototype instead of asking the CommandProvider at every call.
+ *          A CommandLink is immutable and can be shared between threads.
+ *          The CommandProvider is filled by the menus of the core and isn't
+ *          known to be thread-safe, all lookups go through CommandLink::lookup
+ *          which serialises them. The looked up core::Command instances are
+ *          executed without a lock.
+ */
+struct CommandLink {
+  using CommandProvider = cad::core::command::CommandProvider;
+  using Invoker = decltype(std::declval<CommandProvider&>().get_command(
+      std::declval<const std::string&>(), std::declval<const std::string&>()));
+
+  /**
+   * @brief  A resolved core::Command of one call site
+   */
+  struct Command {
+    Invoker prototype;
+    // true for every parameter of the call the core::Command accepts, in the
+    // order of the parameter of the call
+    std::vector<bool> accepted;
+    // nullptr if the core::Command didn't opt in to be batched
+    const BatchProvider::Batch* batch;
+  };
+
+  const CommandProvider* provider;
+  const BatchProvider* batches;
+  std::size_t generation;
+  // one entry per bytecode::Bytecode::calls, nullptr if not linked
+  std::vector<std::unique_ptr<const Command>> calls;
+  std::unordered_map<const ast::callable::Callable*, const Command*> callables;
+
+  /**
+   * @brief   Resolves every call site of the given Bytecode that can only be
+   *          satisfied by a core::Command
+   * @details All missing core::Command instances are reported at once,
+   *          before the macro is executed
+   *
+   * @param   provider     The CommandProvider to get core::Command instances
+   *                       from
+   * @param   batches      The BatchProvider to get the batch functions from,
+   *                       may be nullptr
+   * @param   generation   The generation of the core::Command instances
+   * @param   code         The Bytecode to link
+   * @param   file         The file name / name of the macro.
+   * @param   scope        The scope to get the core::Command instances from
+   *
+   * @return  the linked call sites
+   *
+   * @throws  Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  static std::shared_ptr<const CommandLink>
+  link(CommandProvider& provider, const BatchProvider* batches,
+       std::size_t generation, const bytecode::Bytecode& code,
+       const std::string& file, const std::string& scope);
+
+  /**
+   * @brief   Gets a core::Command from the given CommandProvider
+   * @details The lookups of all threads are serialised
+   *
+   * @param   provider  The CommandProvider to get the core::Command from
+   * @param   scope     The scope to get the core::Command from
+   * @param   name      The name of the core::Command
+   *
+   * @return  the core::Command
+   *
+   * @throws  the exception of the CommandProvider if there is no such
+   *          core::Command
+   */
+  static Invoker lookup(CommandProvider& provider, const std::string& scope,
+                        const std::string& name);
+
+  /**
+   * @brief  Finds the linked core::Command of the given call site
+   *
+   * @param  call  The call site
+   *
+   * @return the Command or nullptr if the call site isn't linked
+   */
+  const Command* find(const ast::callable::Callable& call) const;
+};
+}
+}
+}
+#endif
@@ -0,0 +1,142 @@
+#ifndef cad_macro_interpreter_CompiledMacro_h
+#define cad_macro_interpreter_CompiledMacro_h
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/Bytecode.h"
+#include "cad/macro/interpreter/CommandLink.h"
+#include "cad/macro/interpreter/Interpreter.h"
+
+#include <any.hpp>
+
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The CompiledMacro is a parsed and analysed macro that can be
+ *          executed many times without running the parser again
+ * @details Instances are obtained with Interpreter::compile and are immutable
+ *          afterwards. The ast::Scope is owned by the instance and the function
+ *          definitions of each run refer to it, therefore the instance has to
+ *          outlive every run. Each run gets its own Stack, which makes run
+ *          re-entrant and allows to share one instance between threads - each
+ *          thread should pass its own output stream to run. The core::Command
+ *          instances of the call sites are linked once per scope and kept
+ *          until Interpreter::invalidate_commands is called.
+ */
+class CompiledMacro {
+  using Arguments = cad::core::command::argument::Arguments;
+  using CommandProvider = cad::core::command::CommandProvider;
+
+  Interpreter interpreter_;
+  ast::Scope scope_;
+  std::string file_;
+  bytecode::Bytecode bytecode_;
+  mutable std::mutex links_mutex_;
+  mutable std::unordered_map<std::string, std::shared_ptr<const CommandLink>>
+      links_;
+
+public:
+  /**
+   * @brief  Ctor
+   *
+   * @param  interpreter  The Interpreter that will execute the macro
+   * @param  scope        The analysed root ast::Scope of the macro
+   * @param  file_name    The file name / name of the macro.
+   */
+  CompiledMacro(Interpreter interpreter, ast::Scope scope,
+                std::string file_name);
+
+  CompiledMacro(const CompiledMacro&) = delete;
+  CompiledMacro& operator=(const CompiledMacro&) = delete;
+
+  /**
+   * @brief  The analysed root ast::Scope of the macro
+   *
+   * @return root ast::Scope
+   */
+  const ast::Scope& scope() const;
+  /**
+   * @brief  The file name / name of the macro
+   *
+   * @return file name
+   */
+  const std::string& file_name() const;
+  /**
+   * @brief  The Bytecode the Compiler produced from the root ast::Scope
+   *
+   * @return Bytecode
+   */
+  const bytecode::Bytecode& bytecode() const;
+  /**
+   * @brief  The Interpreter that executes the macro
+   *
+   * @return Interpreter
+   */
+  const Interpreter& interpreter() const;
+  /**
+   * @brief   The CommandLink of the given scope
+   * @details The call sites are linked if there is no CommandLink for the
+   *          scope yet or if it was linked with another CommandProvider,
+   *          BatchProvider or generation
+   *
+   * @param   provider    The CommandProvider to get core::Command instances
+   *                      from
+   * @param   batches     The BatchProvider to get the batch functions from,
+   *                      may be nullptr
+   * @param   generation  The current generation of the core::Command instances
+   * @param   scope       The scope to get the core::Command instances from
+   *
+   * @return  the CommandLink
+   *
+   * @throws  Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  std::shared_ptr<const CommandLink> link(CommandProvider& provider,
+                                          const BatchProvider* batches,
+                                          std::size_t generation,
+                                          const std::string& scope) const;
+
+  /**
+   * @brief  Executes the main function of the macro
+   *
+   * @param  args    The arguments to interpret the macro with
+   * @param  scope   The scope from which the interpretation was started in, to
+   *                 get the right core::Command instances
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @return result of the interpretation
+   *
+   * @throws Exc<Interpreter::E,  Interpreter::E::BAD_BOOL_CAST>
+   * @throws Exc<Interpreter::E,  Interpreter::E::MISSING_FUNCTION>
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  linb::any run(Arguments args, std::string scope = "",
+                const Cancellation& cancellation = Cancellation()) const;
+  /**
+   * @brief  Executes the main function of the macro and prints to the given
+   *         std::ostream
+   *
+   * @param  args    The arguments to interpret the macro with
+   * @param  scope   The scope from which the interpretation was started in, to
+   *                 get the right core::Command instances
+   * @param  out     The output stream of the run
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @return result of the interpretation
+   *
+   * @throws Exc<Interpreter::E,  Interpreter::E::BAD_BOOL_CAST>
+   * @throws Exc<Interpreter::E,  Interpreter::E::MISSING_FUNCTION>
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  linb::any run(Arguments args, std::string scope, std::ostream& out,
+                const Cancellation& cancellation = Cancellation()) const;
+};
+}
+}
+}
+#endif
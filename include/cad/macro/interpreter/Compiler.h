@@ -0,0 +1,289 @@
+#ifndef cad_macro_interpreter_Compiler_h
+#define cad_macro_interpreter_Compiler_h
+
+#include "cad/macro/interpreter/Bytecode.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace ast {
+struct Address;
+struct Operator;
+struct Scope;
+struct ValueProducer;
+struct Variable;
+namespace callable {
+struct Callable;
+struct Function;
+struct Return;
+}
+namespace logic {
+struct If;
+}
+namespace loop {
+struct Break;
+struct Continue;
+struct DoWhile;
+struct For;
+struct While;
+}
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Compiler lowers an analysed ast::Scope into bytecode::Bytecode
+ *          that can be executed by the VM
+ * @details The compiled Bytecode mirrors the semantics of the Interpreter: all
+ *          ast::Scope instances of a function share one Stack, functions are
+ *          defined when the ast::Scope they are in is entered and every
+ *          compound statement (if, loops, scopes and return) sets the result
+ *          of the enclosing ast::Scope. The slots of the variables are the
+ *          ones the parser::Analyser assigned.
+ */
+class Compiler {
+  /**
+   * @brief  Jumps of break and continue statements of the innermost loop that
+   *         have to be patched once the targets are known
+   */
+  struct Loop {
+    std::vector<std::size_t> breaks;
+    std::vector<std::size_t> continues;
+  };
+
+  bytecode::Bytecode code_;
+  std::unordered_map<std::string, std::uint32_t> names_;
+  std::vector<Loop> loops_;
+  // per chunk: the chunk the function was defined in
+  std::vector<std::uint32_t> parents_;
+  // per chunk: the indices of the definitions in the chunk
+  std::vector<std::vector<std::uint32_t>> definitions_;
+  // per call: the chunk the call is in
+  std::vector<std::uint32_t> call_chunks_;
+
+  //////////////////////////////////////////
+  /// Helper
+  //////////////////////////////////////////
+  /**
+   * @brief  Interns the given name
+   *
+   * @param  name  The name of a ast::Variable
+   *
+   * @return index into bytecode::Bytecode::names
+   */
+  std::uint32_t name(const std::string& name);
+  /**
+   * @brief  Adds a chunk for the given frame
+   *
+   * @param  parent  The index of the chunk the frame is defined in
+   * @param  body    The analysed body of the frame
+   *
+   * @return index of the chunk
+   */
+  std::uint32_t chunk(std::uint32_t parent, const ast::Scope& body);
+  /**
+   * @brief  Adds a lookup for the given variable read
+   *
+   * @param  var   The analysed ast::Variable
+   *
+   * @return index into bytecode::Bytecode::lookups
+   */
+  std::uint32_t lookup(const ast::Variable& var);
+  /**
+   * @brief  Adds a lookup for a variable read
+   *
+   * @param  name     The name of the ast::Variable
+   * @param  address  The position the parser::Analyser assigned
+   *
+   * @return index into bytecode::Bytecode::lookups
+   */
+  std::uint32_t lookup(const std::string& name, const ast::Address& address);
+  /**
+   * @brief  Adds the definition of the given ast::callable::Function to the
+   *         given chunk, the definition gets its own slot
+   *
+   * @param  chunk  The index of the chunk
+   * @param  fun    The ast::callable::Function to define
+   *
+   * @return index into bytecode::Bytecode::definitions
+   */
+  std::uint32_t definition(std::uint32_t chunk,
+                           const ast::callable::Function& fun);
+  /**
+   * @brief  Resolves the candidates of all calls
+   */
+  void resolve_calls();
+  /**
+   * @brief  Adds the given value to the constants
+   *
+   * @param  value  The value of a ast::Literal
+   *
+   * @return index into bytecode::Bytecode::constants
+   */
+  std::uint32_t constant(Value value);
+  /**
+   * @brief  Appends an instruction to the given chunk
+   *
+   * @param  chunk     The index of the chunk
+   * @param  code      The operation
+   * @param  argument  The argument of the operation
+   * @param  token     The token the instruction was generated from
+   *
+   * @return index of the instruction in the chunk
+   */
+  std::size_t emit(std::uint32_t chunk, bytecode::OpCode code,
+                   std::uint32_t argument, const parser::Token& token);
+  /**
+   * @brief  The index the next instruction of the given chunk will have
+   *
+   * @param  chunk  The index of the chunk
+   *
+   * @return index of the next instruction
+   */
+  std::uint32_t here(std::uint32_t chunk) const;
+  /**
+   * @brief  Sets the target of a jump instruction
+   *
+   * @param  chunk        The index of the chunk
+   * @param  instruction  The index of the jump instruction
+   * @param  target       The target of the jump
+   */
+  void patch(std::uint32_t chunk, std::size_t instruction,
+             std::uint32_t target);
+  /**
+   * @brief  Compiles the given ast::callable::Function into its own chunk if
+   *         that was not done before
+   *
+   * @param  parent  The index of the chunk the function is defined in
+   * @param  fun     The ast::callable::Function to compile
+   */
+  void compile_function(std::uint32_t parent,
+                        const ast::callable::Function& fun);
+  /**
+   * @brief  Compiles the body of the given parallel ast::loop::For into its
+   *         own chunk
+   *
+   * @param  parent  The index of the chunk the loop is in
+   * @param  foor    The parallel ast::loop::For to compile
+   *
+   * @return index into bytecode::Bytecode::parallels
+   */
+  std::uint32_t compile_parallel(std::uint32_t parent,
+                                 const ast::loop::For& foor);
+
+  //////////////////////////////////////////
+  /// Compile values
+  //////////////////////////////////////////
+  /**
+   * @brief  Compiles the given ast::ValueProducer, the produced value will be
+   *         on top of the operand stack
+   *
+   * @param  chunk  The index of the chunk
+   * @param  vp     The ast::ValueProducer to compile
+   */
+  void compile(std::uint32_t chunk, const ast::ValueProducer& vp);
+  /**
+   * @brief  Compiles the given ast::Operator, the produced value will be on top
+   *         of the operand stack
+   *
+   * @param  chunk  The index of the chunk
+   * @param  op     The ast::Operator to compile
+   */
+  void compile(std::uint32_t chunk, const ast::Operator& op);
+  /**
+   * @brief  Compiles the given ast::callable::Callable, the produced value will
+   *         be on top of the operand stack
+   *
+   * @param  chunk  The index of the chunk
+   * @param  call   The ast::callable::Callable to compile
+   */
+  void compile(std::uint32_t chunk, const ast::callable::Callable& call);
+
+  //////////////////////////////////////////
+  /// Compile statements
+  //////////////////////////////////////////
+  /**
+   * @brief  Compiles the given ast::loop::Break
+   *
+   * @param  chunk  The index of the chunk
+   * @param  br     The ast::loop::Break to compile
+   */
+  void compile(std::uint32_t chunk, const ast::loop::Break& br);
+  /**
+   * @brief  Compiles the given ast::loop::Continue
+   *
+   * @param  chunk  The index of the chunk
+   * @param  con    The ast::loop::Continue to compile
+   */
+  void compile(std::uint32_t chunk, const ast::loop::Continue& con);
+  /**
+   * @brief  Compiles the given ast::logic::If
+   *
+   * @param  chunk  The index of the chunk
+   * @param  iff    The ast::logic::If to compile
+   */
+  void compile(std::uint32_t chunk, const ast::logic::If& iff);
+  /**
+   * @brief  Compiles the given ast::loop::DoWhile
+   *
+   * @param  chunk  The index of the chunk
+   * @param  whi    The ast::loop::DoWhile to compile
+   */
+  void compile(std::uint32_t chunk, const ast::loop::DoWhile& whi);
+  /**
+   * @brief  Compiles the given ast::loop::For
+   *
+   * @param  chunk  The index of the chunk
+   * @param  foor   The ast::loop::For to compile
+   */
+  void compile(std::uint32_t chunk, const ast::loop::For& foor);
+  /**
+   * @brief  Compiles the given ast::loop::While
+   *
+   * @param  chunk  The index of the chunk
+   * @param  whi    The ast::loop::While to compile
+   */
+  void compile(std::uint32_t chunk, const ast::loop::While& whi);
+  /**
+   * @brief  Compiles the given ast::callable::Return
+   *
+   * @param  chunk  The index of the chunk
+   * @param  ret    The ast::callable::Return to compile
+   */
+  void compile(std::uint32_t chunk, const ast::callable::Return& ret);
+  /**
+   * @brief  Compiles the given ast::Scope as statement, the result of the
+   *         ast::Scope starts empty
+   *
+   * @param  chunk  The index of the chunk
+   * @param  scope  The ast::Scope to compile
+   */
+  void compile(std::uint32_t chunk, const ast::Scope& scope);
+  /**
+   * @brief  Compiles the nodes of the given ast::Scope
+   *
+   * @param  chunk  The index of the chunk
+   * @param  scope  The ast::Scope to compile
+   */
+  void compile_shared(std::uint32_t chunk, const ast::Scope& scope);
+
+public:
+  /**
+   * @brief  Compiles the given analysed root ast::Scope
+   *
+   * @param  root  The root ast::Scope of a macro
+   *
+   * @return the compiled Bytecode, it references the given ast::Scope
+   */
+  bytecode::Bytecode compile(const ast::Scope& root);
+};
+}
+}
+}
+#endif
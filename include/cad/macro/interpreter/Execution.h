@@ -0,0 +1,170 @@
+#ifndef cad_macro_interpreter_Execution_h
+#define cad_macro_interpreter_Execution_h
+
+#include "cad/macro/interpreter/BatchProvider.h"
+#include "cad/macro/interpreter/Cancellation.h"
+#include "cad/macro/interpreter/FrameArena.h"
+#include "cad/macro/interpreter/Future.h"
+#include "cad/macro/interpreter/VM.h"
+
+#include <cad/core/command/argument/Arguments.h>
+
+#include <any.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+class CompiledMacro;
+struct CommandLink;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Execution is a run of a CompiledMacro that can be suspended and
+ *          resumed
+ * @details Each call of resume executes the macro until it is done or the
+ *          Budget is used up, the next call continues at the same
+ *          instruction. The state of the run is an explicit continuation of
+ *          the VM, therefore the calling thread is free between two calls -
+ *          a GUI thread can interleave the macro with rendering. The core::Command
+ *          calls, parallel loops and the TREE backend are not interrupted, the
+ *          TREE backend runs the whole macro in the first call of resume.
+ */
+class Execution {
+  using Arguments = cad::core::command::argument::Arguments;
+
+public:
+  enum class E { NOT_DONE };
+
+  /**
+   * @brief  The amount of work one call of resume may do, 0 means no limit
+   */
+  struct Budget {
+    std::size_t steps = 0;  // executed bytecode instructions
+    std::chrono::microseconds time = std::chrono::microseconds(0);
+  };
+
+private:
+  enum class Phase { ROOT, MAIN, DONE };
+
+  std::shared_ptr<const CompiledMacro> macro_;
+  const Interpreter& interpreter_;
+  Budget budget_;
+  std::string scope_;
+  std::reference_wrapper<std::ostream> out_;
+  Arguments args_;
+  Cancellation cancellation_;
+  Cancellation::Probe probe_;
+  std::shared_ptr<const CommandLink> commands_;
+  FrameArena frames_;
+  BatchQueue batches_;
+  Futures futures_;
+  FrameArena::Frame root_;
+  VM vm_;
+  VM::Context context_;
+  VM::Continuation continuation_;
+  Phase phase_;
+  linb::any result_;
+  std::exception_ptr error_;
+
+  /**
+   * @brief  Finishes the run with the current exception
+   */
+  void fail();
+
+public:
+  /**
+   * @brief  Ctor - links the core::Command instances, nothing is executed
+   *         before the first call of resume
+   *
+   * @param  macro   The compiled macro to execute
+   * @param  args    The arguments to execute the macro with
+   * @param  scope   The scope from which the execution was started in, to get
+   *                 the right core::Command instances
+   *
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+            std::string scope = "");
+  /**
+   * @brief  Ctor - links the core::Command instances, nothing is executed
+   *         before the first call of resume
+   *
+   * @param  macro   The compiled macro to execute
+   * @param  args    The arguments to execute the macro with
+   * @param  scope   The scope from which the execution was started in, to get
+   *                 the right core::Command instances
+   * @param  budget  The Budget of each call of resume
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+            std::string scope, Budget budget,
+            Cancellation cancellation = Cancellation());
+  /**
+   * @brief  Ctor - links the core::Command instances, nothing is executed
+   *         before the first call of resume
+   *
+   * @param  macro   The compiled macro to execute
+   * @param  args    The arguments to execute the macro with
+   * @param  scope   The scope from which the execution was started in, to get
+   *                 the right core::Command instances
+   * @param  budget  The Budget of each call of resume
+   * @param  out     The output stream of the run
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+            std::string scope, Budget budget, std::ostream& out,
+            Cancellation cancellation = Cancellation());
+  /**
+   * @brief  Dtor - a run that isn't done is abandoned, the async calls are
+   *         waited for and the batched calls are made
+   */
+  ~Execution();
+
+  Execution(const Execution&) = delete;
+  Execution& operator=(const Execution&) = delete;
+
+  /**
+   * @brief  Continues the run until it is done or the Budget is used up
+   *
+   * @return true if the run is done
+   */
+  bool resume();
+  /**
+   * @brief  Whether the run is done, successfully or not
+   *
+   * @return true if done
+   */
+  bool is_done() const;
+  /**
+   * @brief  The result of the run
+   *
+   * @return result of the main function
+   *
+   * @throws Exc<E,                   E::NOT_DONE>
+   * @throws Exc<Interpreter::E,  Interpreter::E::BAD_BOOL_CAST>
+   * @throws Exc<Interpreter::E,  Interpreter::E::MISSING_FUNCTION>
+   * @throws Exc<Interpreter::E,  Interpreter::E::TAIL>
+   */
+  const linb::any& result() const;
+};
+}
+}
+}
+#endif
@@ -0,0 +1,115 @@
+#ifndef cad_macro_interpreter_FrameArena_h
+#define cad_macro_interpreter_FrameArena_h
+
+#include "cad/macro/interpreter/Stack.h"
+
+#include <cstddef>
+#include <deque>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The FrameArena holds the Stack instances of one run of a macro
+ *
+ * @details The Stack instances are handed out in LIFO order from blocks of
+ *          memory that don't move, a released Stack keeps its memory and is
+ *          reused by the next push. The Stack instances don't own their
+ *          parents, this is fine because a ast::callable::Function is only
+ *          called with the Stack it was defined in and this Stack is always a
+ *          parent of the calling Stack - it is released after the call.
+ */
+class FrameArena {
+  std::deque<Stack> frames_;
+  std::size_t size_;
+
+public:
+  /**
+   * @brief  RAII helper that pushes a Stack on construction and pops it on
+   *         destruction
+   */
+  class Frame {
+    FrameArena& arena_;
+    Stack& stack_;
+
+  public:
+    /**
+     * @brief  Ctor
+     *
+     * @param  arena      The FrameArena to push the Stack to
+     * @param  parent     The parent Stack, has to outlive the Frame
+     * @param  slots      The number of variables that are accessed by index
+     * @param  variables  The number of variables of the Interpreter
+     */
+    Frame(FrameArena& arena, Stack* parent, std::size_t slots = 0,
+          std::size_t variables = 0)
+        : arena_(arena)
+        , stack_(arena.push(parent, slots, variables)) {
+    }
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+    /**
+     * @brief  Dtor - pops the Stack
+     */
+    ~Frame() {
+      arena_.pop(stack_);
+    }
+
+    /**
+     * @brief  The Stack of the Frame
+     *
+     * @return the Stack
+     */
+    Stack& stack() const {
+      return stack_;
+    }
+  };
+
+  /**
+   * @brief  Ctor
+   */
+  FrameArena();
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /**
+   * @brief  Pushes a new Stack
+   *
+   * @param  parent     The parent Stack, has to outlive the new Stack
+   * @param  slots      The number of variables that are accessed by index
+   * @param  variables  The number of variables of the Interpreter
+   *
+   * @return the Stack
+   */
+  Stack& push(Stack* parent, std::size_t slots = 0,
+              std::size_t variables = 0);
+  /**
+   * @brief  Pops the last pushed Stack, all definitions of the Stack are
+   *         released
+   *
+   * @param  stack  The last pushed Stack
+   */
+  void pop(Stack& stack);
+
+  /**
+   * @brief  The number of pushed Stack instances
+   *
+   * @return the number
+   */
+  std::size_t size() const {
+    return size_;
+  }
+  /**
+   * @brief  The number of Stack instances that were allocated, the arena
+   *         never shrinks
+   *
+   * @return the number
+   */
+  std::size_t capacity() const {
+    return frames_.size();
+  }
+};
+}
+}
+}
+#endif
@@ -0,0 +1,115 @@
+#ifndef cad_macro_interpreter_Future_h
+#define cad_macro_interpreter_Future_h
+
+#include "cad/macro/interpreter/Value.h"
+
+#include <any.hpp>
+
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace parser {
+struct Token;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Future class is the value of an async call until it is read
+ * @details Variables hold the Future as boxed value, reading the variable
+ *          joins the Future and replaces it with the result of the call.
+ */
+class Future {
+  std::shared_future<linb::any> future_;
+
+public:
+  /**
+   * @brief  Runs a task, the task will be called on another thread
+   */
+  using Executor = std::function<void(std::function<void()> task)>;
+
+  /**
+   * @brief  Ctor
+   *
+   * @param  future  The future of the result of the call
+   */
+  Future(std::shared_future<linb::any> future);
+
+  /**
+   * @brief  Waits for the result of the call
+   *
+   * @return result of the call
+   *
+   * @throws the exception of the call
+   */
+  linb::any get() const;
+
+  /**
+   * @brief  Replaces the given any instance with the result of the call if it
+   *         holds a Future
+   *
+   * @param  any   The any instance
+   *
+   * @throws the exception of the call
+   */
+  static void join(linb::any& any);
+  /**
+   * @brief  Replaces the given Value with the result of the call if it holds a
+   *         Future
+   *
+   * @param  value  The Value
+   *
+   * @throws the exception of the call
+   */
+  static void join(Value& value);
+};
+
+/**
+ * @brief   The Futures class holds the Future instances of one run
+ * @details A run has to join all of them before it ends, the tasks must not
+ *          outlive the run and their errors must not get lost.
+ */
+class Futures {
+  struct Pending {
+    std::shared_future<linb::any> future;
+    std::reference_wrapper<const parser::Token> token;
+  };
+
+  std::vector<Pending> pending_;
+
+public:
+  /**
+   * @brief  Starts the given task with the given Executor
+   *
+   * @param  executor  The Executor to run the task with
+   * @param  token     The token of the async call
+   * @param  task      The task that executes the call
+   *
+   * @return the Future of the result of the task
+   */
+  Future launch(const Future::Executor& executor, const parser::Token& token,
+                std::function<linb::any()> task);
+  /**
+   * @brief  Waits for all tasks, errors are ignored
+   */
+  void wait() noexcept;
+  /**
+   * @brief  Waits for all tasks
+   *
+   * @param  file  The file name / name of the macro.
+   *
+   * @throws Exc<Interpreter::E, Interpreter::E::TAIL>
+   */
+  void join(const std::string& file);
+};
+}
+}
+}
+#endif
@@ -1,8 +1,13 @@
 #ifndef cad_macro_interpreter_Interpreter_h
 #define cad_macro_interpreter_Interpreter_h
 
+#include "cad/macro/interpreter/Cancellation.h"
+#include "cad/macro/interpreter/Future.h"
+
 #include <any.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <iostream>
 #include <memory>
 
@@ -21,6 +26,7 @@ struct Define;
 struct Operator;
 struct Scope;
 struct ValueProducer;
+struct Variable;
 namespace callable {
 struct Callable;
 struct Function;
@@ -38,6 +44,8 @@ struct While;
 }
 }
 namespace interpreter {
+class BatchProvider;
+class CompiledMacro;
 class Stack;
 class OperatorProvider;
 }
@@ -48,10 +56,25 @@ namespace cad {
 namespace macro {
 namespace interpreter {
 /**
- * @brief  The Interpreter accepts a macro as std::string, converts it with the
- *         parser::parse method and executes the obtained abstract syntax tree
+ * @brief   The Interpreter accepts a macro as std::string, converts it with the
+ *          parser::parse method and executes the obtained abstract syntax tree
+ * @details The interpret and compile methods may be called from many threads
+ *          at once. Every run owns its Stack, frames, batches, futures and,
+ *          if requested, its output - the CompiledMacro and the
+ *          OperatorProvider are only read. The setters are not synchronised,
+ *          the Interpreter has to be configured before it is shared.
  */
 class Interpreter {
+  friend class Execution;
+  friend class VM;
+
+public:
+  /**
+   * @brief  The backend that executes a CompiledMacro, the TREE backend is the
+   *         original ast walking interpreter and kept to compare results
+   */
+  enum class Backend { TREE, BYTECODE };
+
 protected:
   using CommandProvider = cad::core::command::CommandProvider;
   using Arguments = cad::core::command::argument::Arguments;
@@ -75,7 +98,14 @@ protected:
 
   std::shared_ptr<CommandProvider> command_provider_;
   std::shared_ptr<OperatorProvider> operator_provider_;
+  std::shared_ptr<BatchProvider> batch_provider_;
+  Future::Executor executor_;
+  std::size_t workers_;
+  // shared with the copies held by CompiledMacro instances
+  std::shared_ptr<std::atomic<std::size_t>> command_generation_;
   std::reference_wrapper<std::ostream> out_;
+  Backend backend_;
+  bool folding_;
 
   //////////////////////////////////////////
   /// Helper
@@ -116,11 +146,11 @@ protected:
    * @param  outer_state  The outer state of the interpretation
    * @param  val          The ast::ValueProducer that provides the ast::Function
    *                      with the value of the ast::Variable
-   * @param  parameter    The name of the ast::Function parameter
+   * @param  parameter    The ast::Function parameter
    */
   void add_parameter(State& state, State& outer_state,
                      const ast::ValueProducer& val,
-                     const std::string& parameter) const;
+                     const ast::Variable& parameter) const;
   /**
    * @brief  Adds the ast::Variable parameter from the calling (outer)
    *         ast::Scope to the new (inner) ast::Scope
@@ -161,24 +191,14 @@ protected:
    */
   void define_variable(State& state, const ast::Define& def) const;
   /**
-   * @brief   Defines a ast::Function or ast::EntryFunction
-   * @details If the given ast::Define holds a ast::Function or
-   *          ast::EntryFunction it will be defined after this function call. If
-   *          the ast::Define does not hold a ast::Function or
-   *          ast::EntryFunction nothing happens.
+   * @brief   The function will define all ast::Function or ast::EntryFunction
+   *          in the given Scope
+   * @details The precomputed ast::Scope::functions table is added to the
+   *          Stack, entering the ast::Scope again does nothing.
    *
    * @param   state  The state of the interpretation
-   * @param   def    The ast::Define object which possibly holds a ast::Function
-   *                 or ast::EntryFunction
-   */
-  void define_function(State& state, const ast::Define& def) const;
-  /**
-   * @brief  The function will define all ast::Function or ast::EntryFunction in
-   *         the given Scope
-   *
-   * @param  state  The state of the interpretation
-   * @param  scope  The scope that possible holds the definitions of
-   *                ast::Function or ast::EntryFunction
+   * @param   scope  The scope that possible holds the definitions of
+   *                 ast::Function or ast::EntryFunction
    */
   void define_functions(State& state, const ast::Scope& scope) const;
 
@@ -347,13 +367,14 @@ protected:
    */
   linb::any interpret_not_equal(State& state, const ast::Operator& op) const;
   /**
-   * @brief  Interprets the given ast::Operator instance as 'and'
+   * @brief   Interprets the given ast::Operator instance as 'and'
+   * @details The right operand is only interpreted if the left operand is
+   *          true
    *
-   * @param  state   The state of the interpretation
-   * @param  op      The ast::Operation instance to interpret
+   * @param   state  The state of the interpretation
+   * @param   op     The ast::Operation instance to interpret
    *
-   * @return result of the operator specified for the given types in the
-   *         OperatorProvider
+   * @return  true if both operands are true, false otherwise
    *
    * @throws Exc<E,  E::BAD_BOOL_CAST>
    * @throws Exc<E,  E::MISSING_FUNCTION>
@@ -361,13 +382,14 @@ protected:
    */
   linb::any interpret_and(State& state, const ast::Operator& op) const;
   /**
-   * @brief  Interprets the given ast::Operator instance as 'or'
+   * @brief   Interprets the given ast::Operator instance as 'or'
+   * @details The right operand is only interpreted if the left operand is
+   *          false
    *
-   * @param  state   The state of the interpretation
-   * @param  op      The ast::Operation instance to interpret
+   * @param   state  The state of the interpretation
+   * @param   op     The ast::Operation instance to interpret
    *
-   * @return result of the operator specified for the given types in the
-   *         OperatorProvider
+   * @return  true if one of the operands is true, false otherwise
    *
    * @throws Exc<E,  E::BAD_BOOL_CAST>
    * @throws Exc<E,  E::MISSING_FUNCTION>
@@ -537,6 +559,24 @@ protected:
    * @throws Exc<E,  E::TAIL>
    */
   linb::any interpret(State& state, const ast::loop::For& fo) const;
+  /**
+   * @brief   Interprets the given parallel ast::loop::For instance
+   * @details The values of the loop variable are collected first, then the
+   *          iterations are executed by the Scheduler - each on its own Stack
+   *          with its own loop and reduction variables. The output of the
+   *          iterations, the reduction variables and the rows of the batched
+   *          calls are combined afterwards in the order of the iterations.
+   *
+   * @param   state   The state of the interpretation
+   * @param   fo      The ast::loop::For instance to interpret
+   *
+   * @return  result of the interpretation - always empty
+   *
+   * @throws  Exc<E,  E::BAD_BOOL_CAST>
+   * @throws  Exc<E,  E::MISSING_FUNCTION>
+   * @throws  Exc<E,  E::TAIL>
+   */
+  linb::any interpret_parallel(State& state, const ast::loop::For& fo) const;
   /**
    * @brief  Interprets the given ast::loop::While instance
    *
@@ -566,16 +606,19 @@ protected:
   /**
    * @brief  Interprets the given ast::callable::Callable instance
    *
-   * @param  state   The state of the interpretation
-   * @param  call    The ast::callable::Callable instance to interpret
+   * @param  state      The state of the interpretation
+   * @param  call       The ast::callable::Callable instance to interpret
+   * @param  discarded  true if the result isn't used, a batched core::Command
+   *                    is queued in that case
    *
    * @return result of the interpretation
    *
-   * @throws Exc<E,  E::BAD_BOOL_CAST>
-   * @throws Exc<E,  E::MISSING_FUNCTION>
-   * @throws Exc<E,  E::TAIL>
+   * @throws Exc<E,     E::BAD_BOOL_CAST>
+   * @throws Exc<E,     E::MISSING_FUNCTION>
+   * @throws Exc<E,     E::TAIL>
    */
-  linb::any interpret(State& state, const ast::callable::Callable& call) const;
+  linb::any interpret(State& state, const ast::callable::Callable& call,
+                      bool discarded = false) const;
   /**
    * @brief  Interprets the given ast::Scope instance
    *
@@ -652,6 +695,90 @@ public:
               std::shared_ptr<OperatorProvider> operator_provider,
               std::ostream& out = std::cout);
 
+  /**
+   * @brief  Sets the backend that will execute the macros
+   *
+   * @param  backend  The backend
+   */
+  void set_backend(Backend backend);
+  /**
+   * @brief  The backend that executes the macros
+   *
+   * @return the backend
+   */
+  Backend backend() const;
+  /**
+   * @brief  Enables or disables the folding of constant expressions when a
+   *         macro is compiled, it is enabled by default
+   *
+   * @param  folding  true to enable folding, false to disable it
+   */
+  void set_folding(bool folding);
+  /**
+   * @brief  Checks if constant expressions are folded when a macro is compiled
+   *
+   * @return true if folding is enabled, false otherwise
+   */
+  bool folding() const;
+  /**
+   * @brief   Sets the BatchProvider with the core::Command instances that are
+   *          executed with many argument rows at once
+   * @details Batching is disabled without a BatchProvider, which is the
+   *          default
+   *
+   * @param   batch_provider  The BatchProvider, may be nullptr
+   */
+  void set_batch_provider(std::shared_ptr<BatchProvider> batch_provider);
+  /**
+   * @brief  The BatchProvider of the batched core::Command instances
+   *
+   * @return the BatchProvider, may be nullptr
+   */
+  const std::shared_ptr<BatchProvider>& batch_provider() const;
+  /**
+   * @brief   Sets the Executor that runs the async calls and the workers of
+   *          the parallel ast::loop::For instances
+   * @details By default every task runs on the calling thread when it is
+   *          started, async calls are made right away and a parallel
+   *          ast::loop::For runs all iterations on the calling thread. The
+   *          MacroCommand uses the ThreadManager of the host application.
+   *
+   * @param   executor  The Executor
+   */
+  void set_executor(Future::Executor executor);
+  /**
+   * @brief  The Executor that runs the async calls and the workers of the
+   *         parallel ast::loop::For instances
+   *
+   * @return the Executor
+   */
+  const Future::Executor& executor() const;
+  /**
+   * @brief   Sets the maximum number of threads that execute the iterations of
+   *          a parallel ast::loop::For
+   * @details The calling thread is one of them, the others are started with
+   *          the Executor. The default is the number of hardware threads.
+   *
+   * @param   workers  The number of threads, at least one is used
+   */
+  void set_workers(std::size_t workers);
+  /**
+   * @brief  The maximum number of threads that execute the iterations of a
+   *         parallel ast::loop::For
+   *
+   * @return the number of threads
+   */
+  std::size_t workers() const;
+  /**
+   * @brief   Invalidates the core::Command instances that were linked to the
+   *          call sites of compiled macros
+   * @details Has to be called if core::Command instances or batch functions
+   *          are registered or unregistered after a macro was run. The macros
+   *          that were compiled by this Interpreter, or a copy of it, link
+   *          their call sites again at their next run.
+   */
+  void invalidate_commands() const;
+
   /**
    * @brief  Interprets a given macro
    *
@@ -661,6 +788,7 @@ public:
    *                                 started in, to get the right core::Command
    *                                 instances
    * @param  file_name               The file name / name of the macro.
+   * @param  cancellation            The Cancellation that stops the run
    *
    * @return result of the interpretation
    *
@@ -673,7 +801,67 @@ public:
    * @throws Exc<parser::InternalE,  parser::InternalE::MISSING_OPERATOR>
    */
   linb::any interpret(std::string macro, Arguments args, std::string scope = "",
-                      std::string file_name = "Anonymous") const;
+                      std::string file_name = "Anonymous",
+                      const Cancellation& cancellation = Cancellation()) const;
+  /**
+   * @brief  Interprets a given, already compiled, macro
+   *
+   * @param  macro   The compiled macro to interpret
+   * @param  args    The arguments to interpret the macro with
+   * @param  scope   The scope from which the interpretation was started in, to
+   *                 get the right core::Command instances
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @return result of the interpretation
+   *
+   * @throws Exc<E,  E::BAD_BOOL_CAST>
+   * @throws Exc<E,  E::MISSING_FUNCTION>
+   * @throws Exc<E,  E::TAIL>
+   */
+  linb::any interpret(const CompiledMacro& macro, Arguments args,
+                      std::string scope = "",
+                      const Cancellation& cancellation = Cancellation()) const;
+  /**
+   * @brief   Interprets a given, already compiled, macro and prints to the
+   *          given std::ostream
+   * @details Runs on different threads should print to different streams,
+   *          the output of the runs would interleave otherwise
+   *
+   * @param   macro   The compiled macro to interpret
+   * @param   args    The arguments to interpret the macro with
+   * @param   scope   The scope from which the interpretation was started in,
+   *                  to get the right core::Command instances
+   * @param   out     The output stream of the run
+   * @param   cancellation  The Cancellation that stops the run
+   *
+   * @return  result of the interpretation
+   *
+   * @throws  Exc<E,  E::BAD_BOOL_CAST>
+   * @throws  Exc<E,  E::MISSING_FUNCTION>
+   * @throws  Exc<E,  E::TAIL>
+   */
+  linb::any interpret(const CompiledMacro& macro, Arguments args,
+                      std::string scope, std::ostream& out,
+                      const Cancellation& cancellation = Cancellation()) const;
+
+  /**
+   * @brief   Parses and analyses the given macro once so that it can be
+   *          executed many times
+   * @details The returned CompiledMacro keeps a copy of this Interpreter and
+   *          can be shared between threads
+   *
+   * @param   macro                   The macro to compile
+   * @param   file_name               The file name / name of the macro.
+   *
+   * @return  the compiled macro
+   *
+   * @throws  Exc<parser::UserE,      parser::UserE::SOURCE>
+   * @throws  Exc<parser::UserE,      parser::UserE::TAIL>
+   * @throws  Exc<parser::InternalE,  parser::InternalE::BAD_CONVERSION>
+   * @throws  Exc<parser::InternalE,  parser::InternalE::MISSING_OPERATOR>
+   */
+  std::shared_ptr<const CompiledMacro>
+  compile(std::string macro, std::string file_name = "Anonymous") const;
 };
 }
 }
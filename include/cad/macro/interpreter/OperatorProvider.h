@@ -1,20 +1,27 @@
 #ifndef cad_macro_interpreter_OperatorProvider_h
 #define cad_macro_interpreter_OperatorProvider_h
 
+#include "cad/macro/interpreter/Value.h"
+
 #include <p3/common/module_system/BaseProvider.h>
 
+#include <deque>
 #include <functional>
 
 #include <any.hpp>
 #include <typeindex>
+#include <unordered_map>
 #include <vector>
 
 namespace cad {
 namespace macro {
 namespace interpreter {
 /**
- * @brief  The OperatorProvider is a class that provides Interpreter instances
- *         with functions to interpret ast::Operator instances
+ * @brief   The OperatorProvider is a class that provides Interpreter instances
+ *          with functions to interpret ast::Operator instances
+ * @details The operator tables are only read by the eval methods, runs on many
+ *          threads can share one instance. The operators have to be added
+ *          before the first run starts - add is not synchronised.
  */
 class OperatorProvider : public p3::common::module_system::BaseProvider {
 public:
@@ -70,29 +77,320 @@ protected:
   template <UnaryOperation O1, UnaryOperation O2>
   using UnSame = Same<UnaryOperation, O1, O2>;
 
-  template <typename T1, typename T2>
-  using VecMap = std::vector<std::pair<T1, T2>>;
   using BiOp = std::function<linb::any(const linb::any&, const linb::any&)>;
-  using BiMap = VecMap<std::tuple<std::type_index, std::type_index>, BiOp>;
   using UnOp = std::function<linb::any(const linb::any&)>;
-  using UnMap = VecMap<std::type_index, UnOp>;
-
-  BiMap divide_;
-  BiMap multiply_;
-  BiMap modulo_;
-  BiMap add_;
-  BiMap subtract_;
-  BiMap smaller_;
-  BiMap smaller_equal_;
-  BiMap greater_;
-  BiMap greater_equal_;
-  BiMap equal_;
-  BiMap not_equal_;
-  UnMap bool_;
-  UnMap print_;
-  UnMap type_of_;
-  UnMap negative_;
-  UnMap positive_;
+
+  /**
+   * @brief   A binary operator function in a table
+   * @details A plain function pointer and the context it is called with. The
+   *          operator functions add<LHS, RHS, OPs...>() registers need no
+   *          context, the std::function instances that were added are the
+   *          context of a function that calls them.
+   */
+  struct BiCall {
+    linb::any (*function)(const void*, const linb::any&, const linb::any&);
+    const void* context;
+
+    explicit operator bool() const {
+      return function != nullptr;
+    }
+    linb::any operator()(const linb::any& lhs, const linb::any& rhs) const {
+      return function(context, lhs, rhs);
+    }
+  };
+  /**
+   * @brief   A unary operator function in a table, the same as BiCall
+   */
+  struct UnCall {
+    linb::any (*function)(const void*, const linb::any&);
+    const void* context;
+
+    explicit operator bool() const {
+      return function != nullptr;
+    }
+    linb::any operator()(const linb::any& rhs) const {
+      return function(context, rhs);
+    }
+  };
+
+  /**
+   * @brief   The operator functions of one binary operation
+   * @details The functions are stored in a square table that is indexed by the
+   *          type ids of the left and right hand side. The table doubles its
+   *          size when it grows.
+   */
+  class BiTable {
+    std::vector<BiCall> table_;
+    std::size_t size_ = 0;
+    bool primitives_ = false;
+
+  public:
+    /**
+     * @brief  Finds the operator function for the given type ids
+     *
+     * @param  lhs   The type id of the left hand side
+     * @param  rhs   The type id of the right hand side
+     *
+     * @return the operator function or nullptr if there is none
+     */
+    const BiCall* find(std::size_t lhs, std::size_t rhs) const {
+      if(lhs < size_ && rhs < size_ && table_[lhs * size_ + rhs]) {
+        return &table_[lhs * size_ + rhs];
+      }
+      return nullptr;
+    }
+    /**
+     * @brief  Sets the operator function for the given type ids
+     *
+     * @param  lhs      The type id of the left hand side
+     * @param  rhs      The type id of the right hand side
+     * @param  operato  The operator function
+     */
+    void set(std::size_t lhs, std::size_t rhs, BiCall operato);
+    /**
+     * @brief  Marks that the table holds the builtin operator functions for
+     *         bool, int and double, these can be evaluated without calling them
+     */
+    void set_primitives() {
+      primitives_ = true;
+    }
+    /**
+     * @brief  Checks if the builtin operator functions for bool, int and
+     *         double can be evaluated without calling them
+     *
+     * @return true if they can, false otherwise
+     */
+    bool primitives() const {
+      return primitives_;
+    }
+    /**
+     * @brief  Removes all operator functions
+     */
+    void clear() {
+      table_.clear();
+      size_ = 0;
+      primitives_ = false;
+    }
+  };
+  /**
+   * @brief  The operator functions of one unary operation, indexed by the type
+   *         id of the right hand side. The table doubles its size when it
+   *         grows.
+   */
+  class UnTable {
+    std::vector<UnCall> table_;
+    bool primitives_ = false;
+
+  public:
+    /**
+     * @brief  Finds the operator function for the given type id
+     *
+     * @param  rhs   The type id of the right hand side
+     *
+     * @return the operator function or nullptr if there is none
+     */
+    const UnCall* find(std::size_t rhs) const {
+      if(rhs < table_.size() && table_[rhs]) {
+        return &table_[rhs];
+      }
+      return nullptr;
+    }
+    /**
+     * @brief  Sets the operator function for the given type id
+     *
+     * @param  rhs      The type id of the right hand side
+     * @param  operato  The operator function
+     */
+    void set(std::size_t rhs, UnCall operato);
+    /**
+     * @brief  Marks that the table holds the builtin operator functions for
+     *         bool, int and double, these can be evaluated without calling them
+     */
+    void set_primitives() {
+      primitives_ = true;
+    }
+    /**
+     * @brief  Checks if the builtin operator functions for bool, int and
+     *         double can be evaluated without calling them
+     *
+     * @return true if they can, false otherwise
+     */
+    bool primitives() const {
+      return primitives_;
+    }
+    /**
+     * @brief  Removes all operator functions
+     */
+    void clear() {
+      table_.clear();
+      primitives_ = false;
+    }
+  };
+
+  // dense ids of all types operators were added for, the builtin types have
+  // the ids of Value::Type
+  std::unordered_map<std::type_index, std::size_t> type_ids_;
+  BiTable divide_;
+  BiTable multiply_;
+  BiTable modulo_;
+  BiTable add_;
+  BiTable subtract_;
+  BiTable smaller_;
+  BiTable smaller_equal_;
+  BiTable greater_;
+  BiTable greater_equal_;
+  BiTable equal_;
+  BiTable not_equal_;
+  UnTable bool_;
+  UnTable print_;
+  UnTable type_of_;
+  UnTable negative_;
+  UnTable positive_;
+  // the operator functions that were added as std::function, the tables point
+  // to them, a std::deque does not move them when it grows
+  std::deque<BiOp> bi_functions_;
+  std::deque<UnOp> un_functions_;
+
+  /**
+   * @brief  Calls an operator function that was added as std::function
+   *
+   * @param  function  The BiOp
+   * @param  lhs       The left hand side for the operation
+   * @param  rhs       The right hand side for the operation
+   *
+   * @return result of the operator function
+   */
+  static linb::any call(const void* function, const linb::any& lhs,
+                        const linb::any& rhs);
+  /**
+   * @brief  Calls an operator function that was added as std::function
+   *
+   * @param  function  The UnOp
+   * @param  rhs       The right hand side for the operation
+   *
+   * @return result of the operator function
+   */
+  static linb::any call(const void* function, const linb::any& rhs);
+  /**
+   * @brief  Calls the C++ operator function of the BiHelper
+   *
+   * @param  context  Not used
+   * @param  lhs      The left hand side for the operation
+   * @param  rhs      The right hand side for the operation
+   *
+   * @return result of the operator function
+   */
+  template <typename LHS, typename RHS, BinaryOperation op>
+  static linb::any call_helper(const void*, const linb::any& lhs,
+                               const linb::any& rhs) {
+    return BiHelper<LHS, RHS, op>()()(lhs, rhs);
+  }
+  /**
+   * @brief  Calls the C++ operator function of the UnHelper
+   *
+   * @param  context  Not used
+   * @param  rhs      The right hand side for the operation
+   *
+   * @return result of the operator function
+   */
+  template <typename RHS, UnaryOperation op>
+  static linb::any call_helper(const void*, const linb::any& rhs) {
+    return UnHelper<RHS, op>()()(rhs);
+  }
+  /**
+   * @brief  Adds the given operator function for the given types
+   *
+   * @param  operati  The operation to perform with the function
+   * @param  lhs      The left hand side type
+   * @param  rhs      The right hand side type
+   * @param  operato  The function that performs the operation
+   *
+   * @throws Exc<E,   E::OPERATOR_EXISTS>
+   */
+  void add(const BinaryOperation operati, std::type_index lhs,
+           std::type_index rhs, BiCall operato);
+  /**
+   * @brief  Adds the given operator function for the given type
+   *
+   * @param  operati  The operation to perform with the function
+   * @param  rhs      The right hand side type
+   * @param  operato  The function that performs the operation
+   *
+   * @throws Exc<E,   E::OPERATOR_EXISTS>
+   */
+  void add(const UnaryOperation operati, std::type_index rhs, UnCall operato);
+
+  /**
+   * @brief  The dense id of the given type, the id is created if the type has
+   *         none yet
+   *
+   * @param  type  The type
+   *
+   * @return id of the type
+   */
+  std::size_t add_type(const std::type_index& type);
+  /**
+   * @brief  The dense id of the given type
+   *
+   * @param  type  The type
+   *
+   * @return id of the type or an id no operator is registered for if the type
+   *         is unknown
+   */
+  std::size_t type_id(const std::type_index& type) const;
+  /**
+   * @brief  The dense id of the type of the given Value
+   *
+   * @param  value  The Value
+   *
+   * @return id of the type or an id no operator is registered for if the type
+   *         is unknown
+   */
+  std::size_t type_id(const Value& value) const;
+  /**
+   * @brief  The table of the given operation
+   *
+   * @param  op    The operation, not AND or OR
+   *
+   * @return table of the operator functions
+   */
+  const BiTable& table(const BinaryOperation op) const;
+  /**
+   * @brief  The table of the given operation
+   *
+   * @param  op    The operation, not NOT
+   *
+   * @return table of the operator functions
+   */
+  const UnTable& table(const UnaryOperation op) const;
+
+  /**
+   * @brief   Evaluates the builtin operator functions for bool, int and double
+   *          without calling them
+   * @details Only the type pairs the Ctor registered are evaluated, all others
+   *          have to use the operator functions of the tables
+   *
+   * @param   op   operation to perform with the Value instances
+   * @param   lhs  The left hand side for the operation
+   * @param   rhs  The right hand side for the operation
+   * @param   ret  The result of the evaluation
+   *
+   * @return  true if the operation was evaluated, false otherwise
+   */
+  bool eval_primitive(const BinaryOperation op, const Value& lhs,
+                      const Value& rhs, Value& ret) const;
+  /**
+   * @brief   Evaluates the builtin operator functions for bool, int and double
+   *          without calling them
+   *
+   * @param   op   operation to perform with the Value instance
+   * @param   rhs  The right hand side for the operation
+   * @param   ret  The result of the evaluation
+   *
+   * @return  true if the operation was evaluated, false otherwise
+   */
+  bool eval_primitive(const UnaryOperation op, const Value& rhs,
+                      Value& ret) const;
 
   //////////////////////////////////////////
   /// Binary
@@ -334,6 +632,25 @@ public:
    * @brief  Ctor
    */
   OperatorProvider();
+  /**
+   * @brief  The tables point to the operator functions of this instance, it
+   *         can not be copied
+   */
+  OperatorProvider(const OperatorProvider&) = delete;
+  OperatorProvider& operator=(const OperatorProvider&) = delete;
+
+  /**
+   * @brief  Converts the given Value to bool with the 'bool' operator, the
+   *         same as && and || convert their operands
+   *
+   * @param  value  The Value to convert
+   *
+   * @return the bool value
+   *
+   * @throws Exc<E,  E::MISSING_OPERATOR>
+   * @throws Exc<E,  E::BAD_BOOL_CAST>
+   */
+  bool to_bool(const Value& value) const;
 
   /**
    * @brief  Adds the given operation function for the given types as given
@@ -385,7 +702,9 @@ public:
     // https://isocpp.org/blog/2015/01/for-each-argument-sean-parent
     (void)(  // avoid warnings of unused result
         std::initializer_list<int>{
-            (add(OPs, lhs, rhs, BiHelper<LHS, RHS, OPs>()()), 0)...});
+            (add(OPs, lhs, rhs,
+                 BiCall{&call_helper<LHS, RHS, OPs>, nullptr}),
+             0)...});
   }
   /**
    * @brief   Magic template function that registers the C++ operator functions
@@ -409,7 +728,7 @@ public:
     // https://isocpp.org/blog/2015/01/for-each-argument-sean-parent
     (void)(  // avoid warnings of unused result
         std::initializer_list<int>{
-            (add(OPs, rhs, UnHelper<RHS, OPs>()()), 0)...});
+            (add(OPs, rhs, UnCall{&call_helper<RHS, OPs>, nullptr}), 0)...});
   }
 
   /**
@@ -580,6 +899,32 @@ public:
    * @throws Exc<E,  E::BAD_BOOL_CAST>
    */
   linb::any eval(const UnaryOperation op, const linb::any& rhs) const;
+  /**
+   * @brief  Evaluates the given operation for the given Value instances
+   *
+   * @param  op      operation to perform with the Value instances
+   * @param  lhs     The left hand side for the operation
+   * @param  rhs     The right hand side for the operation
+   *
+   * @return result of the evaluation
+   *
+   * @throws Exc<E,  E::MISSING_OPERATOR>
+   * @throws Exc<E,  E::BAD_BOOL_CAST>
+   */
+  Value eval(const BinaryOperation op, const Value& lhs,
+             const Value& rhs) const;
+  /**
+   * @brief  Evaluates the given operation for the given Value instance
+   *
+   * @param  op      operation to perform with the Value instance
+   * @param  rhs     The right hand side for the operation
+   *
+   * @return result of the evaluation
+   *
+   * @throws Exc<E,  E::MISSING_OPERATOR>
+   * @throws Exc<E,  E::BAD_BOOL_CAST>
+   */
+  Value eval(const UnaryOperation op, const Value& rhs) const;
 };
 
 //////////////////////////////////////////////////////////////////////
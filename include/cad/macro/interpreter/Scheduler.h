@@ -0,0 +1,53 @@
+#ifndef cad_macro_interpreter_Scheduler_h
+#define cad_macro_interpreter_Scheduler_h
+
+#include "cad/macro/interpreter/Future.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Scheduler runs the iterations of a parallel ast::loop::For
+ * @details Every worker owns a contiguous range of the iterations and takes
+ *          them from the front. A worker that runs out of iterations steals
+ *          the back half of the range of another worker. The calling thread
+ *          is the first worker, the others are started with the
+ *          Future::Executor - a worker that is started after all iterations
+ *          are done returns immediately, therefore the Executor may run the
+ *          workers at any time or on a limited number of threads.
+ */
+class Scheduler {
+public:
+  /**
+   * @brief  Executes one iteration
+   *
+   * @param  worker     The index of the worker that executes the iteration
+   * @param  iteration  The index of the iteration
+   */
+  using Task = std::function<void(std::size_t worker, std::size_t iteration)>;
+
+  /**
+   * @brief   Executes the given number of iterations with the given number of
+   *          workers and waits for them
+   * @details No more iterations are started after an iteration threw, the
+   *          exception of the failed iteration with the lowest index is
+   *          rethrown.
+   *
+   * @param   executor    The Executor that starts the additional workers
+   * @param   workers     The maximum number of workers, the calling thread
+   *                      included
+   * @param   iterations  The number of iterations
+   * @param   task        The function that executes an iteration
+   *
+   * @throws  the exception of the failed iteration
+   */
+  static void run(const Future::Executor& executor, std::size_t workers,
+                  std::size_t iterations, const Task& task);
+};
+}
+}
+}
+#endif
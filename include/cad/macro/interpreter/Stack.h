@@ -1,13 +1,17 @@
 #ifndef cad_macro_interpreter_Stack_h
 #define cad_macro_interpreter_Stack_h
 
+#include "cad/macro/ast/Scope.h"
 #include "cad/macro/ast/ValueProducer.h"
 #include "cad/macro/ast/callable/Callable.h"
 #include "cad/macro/ast/callable/Function.h"
+#include "cad/macro/interpreter/Value.h"
 
 #include <any.hpp>
 #include <exception.h>
 
+#include <experimental/string_view>
+
 #include <algorithm>
 #include <memory>
 #include <vector>
@@ -32,141 +36,143 @@ namespace interpreter {
  * @details Each Stack instance is responsible for one ast::Scope. The Pointer
  *          to the parent Stack instance creates a non-navigateable tree where
  *          the cildren know their parents. This pointer is used to ask for
- *          definitions of ast::Variable or ast::Function.
+ *          definitions of ast::Variable or ast::Function. The parent has to
+ *          outlive its children, the Interpreter and VM allocate the Stack
+ *          instances of one run from a FrameArena.
  */
-class Stack : public std::enable_shared_from_this<Stack> {
-  template <typename T1, typename T2>
-  using VecMap = std::vector<std::pair<T1, T2>>;
+class Stack {
+public:
+  // the name of a variable, the text of its parser::Token or a std::string
+  using Name = std::experimental::string_view;
+
+private:
   using FunctionRef = std::reference_wrapper<const ast::callable::Function>;
 
   /**
-   * @brief  Finds a given key in the VecMap
-   *
-   * @param  map   The map
-   * @param  key   The key
-   *
-   * @return iterator to the found element or the end of the map
+   * @brief  A variable that is accessed by index, it is only visible once it
+   *         is defined
    */
-  template <typename T1, typename T2>
-  auto find(VecMap<T1, T2>& map, const T1& key) {
-    return std::find_if(map.begin(), map.end(),
-                        [&key](auto& pair) { return pair.first == key; });
-  }
+  struct Slot {
+    Value value;
+    bool defined = false;
+  };
   /**
-   * @brief  Finds a given key in the VecMap
+   * @brief  A variable of the Interpreter that is accessed by index, a
+   *         parameter or a shadowed outer variable refers to the variable of
+   *         another Stack until it is assigned
+   */
+  struct Variable {
+    linb::any value;
+    linb::any* alias = nullptr;
+    bool defined = false;
+  };
+
+  /**
+   * @brief  Finds the first function of the added functions and ast::Scope
+   *         function tables that fulfils the predicate
    *
-   * @param  map   The map
-   * @param  key   The key
+   * @param  pred  The predicate
+   *
+   * @tparam PRED  Lambda function [](const Function& fun) -> bool
    *
-   * @return iterator to the found element or the end of the map
+   * @return the function or nullptr
    */
-  template <typename T1, typename T2>
-  auto find(const VecMap<T1, T2>& map, const T1& key) const {
-    return std::find_if(map.begin(), map.end(),
-                        [&key](const auto& pair) { return pair.first == key; });
-  }
+  template <typename PRED>
+  const ast::callable::Function* find_function_if(PRED pred) const {
+    for(const auto& fun : functions_) {
+      if(pred(fun.get())) {
+        return &fun.get();
+      }
+    }
+    for(const auto* scope : scopes_) {
+      for(std::size_t i = 0; i < scope->functions.size(); ++i) {
+        const auto& fun = scope->function(i);
 
+        if(pred(fun)) {
+          return &fun;
+        }
+      }
+    }
+    return nullptr;
+  }
   /**
-   * @brief  Finds function in the function vector
+   * @brief  Finds function in the function vector and function tables
    *
    * @param  key   The key
    *
-   * @return iterator to the found element or the end of the map
+   * @return the function or nullptr
    */
-  auto find_function(const ast::callable::Callable& key) const {
-    return std::find_if(
-        functions_.begin(), functions_.end(), [&key](const auto& fun) {
-          if(fun.get().token.token == key.token.token &&
-             fun.get().parameter.size() == key.parameter.size()) {
-            for(const auto& fp : fun.get().parameter) {
-              bool found = false;
-              for(const auto& cp : key.parameter) {
-                if(fp.token.token == cp.first.token.token) {
-                  found = true;
-                  break;
-                }
-              }
-              if(!found) {
-                return false;
-              }
+  const ast::callable::Function*
+  find_function(const ast::callable::Callable& key) const {
+    return find_function_if([&key](const ast::callable::Function& fun) {
+      if(fun.token.text() == key.token.text() &&
+         fun.parameter.size() == key.parameter.size()) {
+        for(const auto& fp : fun.parameter) {
+          bool found = false;
+          for(const auto& cp : key.parameter) {
+            if(fp.token.text() == cp.first.token.text()) {
+              found = true;
+              break;
             }
-          } else {
+          }
+          if(!found) {
             return false;
           }
-          return true;
-        });
+        }
+      } else {
+        return false;
+      }
+      return true;
+    });
   }
   /**
-   * @brief  Finds function in the function vector
+   * @brief  Finds function in the function vector and function tables
    *
    * @param  key   The key
    *
    * @return true if found else false
    */
   bool exists_function(const ast::callable::Function& key) {
-    return std::find_if(
-               functions_.begin(), functions_.end(), [&key](const auto& fun) {
-                 if(fun.get().token.token == key.token.token &&
-                    fun.get().parameter.size() == key.parameter.size()) {
-                   for(const auto& fp : fun.get().parameter) {
-                     bool found = false;
-                     for(const auto& cp : key.parameter) {
-                       if(fp.token.token == cp.token.token) {
-                         found = true;
-                         break;
-                       }
-                     }
-                     if(!found) {
-                       return false;
-                     }
-                   }
-                 } else {
-                   return false;
-                 }
-                 return true;
-               }) != functions_.end();
+    return find_function_if([&key](const ast::callable::Function& fun) {
+      if(fun.token.text() == key.token.text() &&
+         fun.parameter.size() == key.parameter.size()) {
+        for(const auto& fp : fun.parameter) {
+          bool found = false;
+          for(const auto& cp : key.parameter) {
+            if(fp.token.text() == cp.token.text()) {
+              found = true;
+              break;
+            }
+          }
+          if(!found) {
+            return false;
+          }
+        }
+      } else {
+        return false;
+      }
+      return true;
+    }) != nullptr;
   }
   /**
-   * @brief  Finds function in the function vector
+   * @brief  Finds function in the function vector and function tables
    *
    * @param  key   The key
    *
    * @return true if found else false
    */
   auto exists_function(const ast::callable::Callable& key) {
-    return find_function(key) != functions_.end();
-  }
-  /**
-   * @brief  Finds function in the function vector by name only
-   *
-   * @param  name   The name
-   *
-   * @return true if found else false
-   */
-  auto exists_function(const std::string& name) {
-    return functions_.end() !=
-           std::find_if(functions_.begin(), functions_.end(),
-                        [&name](const auto& fun) {
-                          return fun.get().token.token == name;
-                        });
-  }
-  /**
-   * @brief  Finds variable in the variables vector by name only
-   *
-   * @param  name   The name
-   *
-   * @return true if found else false
-   */
-  auto exists_variable(const std::string& name) const {
-    return find(variables_, name) != variables_.end();
+    return find_function(key) != nullptr;
   }
 
 protected:
-  std::shared_ptr<Stack> parent_;
+  Stack* parent_;
 
-  VecMap<std::string, linb::any> variables_;
-  VecMap<std::string, std::reference_wrapper<linb::any>> aliases_;
+  std::vector<Variable> variables_;
   std::vector<FunctionRef> functions_;
+  // function tables of the entered ast::Scope instances
+  std::vector<const ast::Scope*> scopes_;
+  std::vector<Slot> slots_;
 
 public:
   enum class E {
@@ -183,35 +189,47 @@ public:
   /**
    * @brief  Ctor
    *
-   * @param  parent  The parent Stack
+   * @param  parent  The parent Stack, has to outlive this Stack
    */
-  Stack(std::shared_ptr<Stack> parent);
-
+  Stack(Stack* parent);
   /**
-   * @brief  Adds an alias / reference to a variable from another Stack
+   * @brief  Ctor
    *
-   * @param  name      The name of the ast::Variable in this Stack
-   * @param  variable  The any instance representing the ast::Variable
+   * @param  parent  The parent Stack, has to outlive this Stack
+   * @param  slots   The number of variables that are accessed by index
+   */
+  Stack(Stack* parent, std::size_t slots);
+
+  /**
+   * @brief  Removes all definitions and sets a new parent so the Stack can be
+   *         reused without allocating new memory
    *
-   * @throws Exc<E,    E::VARIABLE_EXISTS>
+   * @param  parent     The parent Stack, has to outlive this Stack
+   * @param  slots      The number of variables that are accessed by index
+   * @param  variables  The number of variables of the Interpreter
    */
-  void add_alias(std::string name, linb::any& variable);
+  void reset(Stack* parent, std::size_t slots, std::size_t variables = 0);
+
   /**
-   * @brief  Removes an alias / reference
+   * @brief  Defines the variable of the Interpreter in the given slot
    *
-   * @param  name    The name of the ast::Variable to remove
+   * @param  slot    The index of the variable
+   * @param  name    The name of the ast::Variable, used for error messages
    *
-   * @throws Exc<E,  E::NOT_A_VARIABLE>
+   * @throws Exc<E,  E::VARIABLE_EXISTS>
    */
-  void remove_alias(std::string name);
+  void add_variable(std::size_t slot, Name name);
   /**
-   * @brief  Adds a any instance to represent the ast::Variable of given name
+   * @brief  Defines the variable of the Interpreter in the given slot as an
+   *         alias / reference to a variable from another Stack
    *
-   * @param  name    The name of the ast::Variable
+   * @param  slot      The index of the variable
+   * @param  name      The name of the ast::Variable, used for error messages
+   * @param  variable  The any instance representing the ast::Variable
    *
-   * @throws Exc<E,  E::VARIABLE_EXISTS>
+   * @throws Exc<E,    E::VARIABLE_EXISTS>
    */
-  void add_variable(std::string name);
+  void add_alias(std::size_t slot, Name name, linb::any& variable);
   /**
    * @brief  Adds a ast::Function to the function definitions
    *
@@ -222,33 +240,81 @@ public:
   void add_function(FunctionRef fun);
 
   /**
-   * @brief  Checks if the given name is the name of an alias / reference
+   * @brief   Adds the function table of the given ast::Scope
+   * @details Adding the same ast::Scope again does nothing, so entering a
+   *          ast::Scope (again) is cheap. The ast::callable::Function instances
+   *          are not checked for duplicates - that was done by the analysis.
    *
-   * @param  name  The name to check
+   * @param   scope  The ast::Scope that is entered, it has to outlive the
+   *                 Stack
+   */
+  void add_functions(const ast::Scope& scope) {
+    if(!scope.functions.empty() &&
+       std::find(scopes_.begin(), scopes_.end(), &scope) == scopes_.end()) {
+      scopes_.push_back(&scope);
+    }
+  }
+
+  /**
+   * @brief  Checks if the variable of the Interpreter in the given slot is
+   *         defined
+   *
+   * @param  slot  The index of the variable
    *
-   * @return true if alias, false otherwise.
+   * @return true if defined, false otherwise
    */
-  bool is_alias(const std::string& name) const;
+  bool has_variable(std::size_t slot) const {
+    return variables_[slot].defined;
+  }
   /**
-   * @brief  Checks if this Stack owns an any instance that represents a
-   *         ast::Variable
+   * @brief  Checks if this Stack owns the any instance of the variable in the
+   *         given slot
    *
-   * @param  name  The name of the ast::Variable to check
+   * @param  slot  The index of the variable
    *
-   * @return true if this stack has the any instance, false if it is a reference
-   *         or from a parent Stack.
+   * @return true if defined and not an alias / reference, false otherwise
    */
-  bool owns_variable(const std::string& name) const;
-
+  bool owns_variable(std::size_t slot) const {
+    return variables_[slot].defined && !variables_[slot].alias;
+  }
   /**
-   * @brief  Checks if this Stack has access to an any instance representing a
-   *         ast::Variable of given name
+   * @brief  Access to the variable of the Interpreter in the given slot
+   *
+   * @param  slot  The index of the variable, it has to be defined
+   *
+   * @return the any instance representing the ast::Variable
+   */
+  linb::any& variable(std::size_t slot) {
+    auto& var = variables_[slot];
+    return var.alias ? *var.alias : var.value;
+  }
+  /**
+   * @brief  Access to the variable of the Interpreter at the given position
+   *
+   * @param  address  The position relative to this Stack
+   * @param  name     The name of the ast::Variable, used for error messages
    *
-   * @param  name  The name of the ast::Variable to check
+   * @return the any instance representing the ast::Variable
    *
-   * @return True if has variable, False otherwise.
+   * @throws Exc<E,   E::NOT_A_VARIABLE>
    */
-  bool has_variable(const std::string& name) const;
+  linb::any& variable(const ast::Address& address, Name name);
+  /**
+   * @brief  Access to the variable of the Interpreter in the given slot for
+   *         an assignment, it is defined if it isn't and an alias / reference
+   *         is replaced by an own variable
+   *
+   * @param  slot  The index of the variable
+   *
+   * @return the any instance representing the ast::Variable
+   */
+  linb::any& assign(std::size_t slot) {
+    auto& var = variables_[slot];
+    var.alias = nullptr;
+    var.defined = true;
+    return var.value;
+  }
+
   /**
    * @brief  Checks if this Stack has access to a function of given name.
    *
@@ -257,58 +323,104 @@ public:
    * @return True if has function, False otherwise.
    */
   bool has_function(const ast::callable::Callable& call) const;
-
   /**
-   * @brief  parent
+   * @brief  Finds the ast::callable::Function the given call calls -
+   *         has_function and function in one search
    *
-   * @return parent
+   * @param  call     The ast::callable::Callable to find the function for
+   * @param  defined  Set to the Stack the function was defined in
+   *
+   * @return the function or nullptr if there is none in this or any parent
+   *         Stack
    */
-  std::shared_ptr<Stack> parent() const;
+  const ast::callable::Function*
+  resolve_function(const ast::callable::Callable& call, Stack*& defined);
 
   /**
-   * @brief  Function to access an any instance that represents a ast::Variable
+   * @brief  Defines the variable in the given slot
+   *
+   * @param  slot    The index of the slot
+   * @param  name    The name of the ast::Variable, used for error messages
    *
-   * @param  name    The name of the ast::Variable to access
-   * @param  fun     The function to execute if the variable exists
+   * @throws Exc<E,  E::VARIABLE_EXISTS>
+   */
+  void add_slot(std::size_t slot, const std::string& name);
+  /**
+   * @brief  Checks if the variable in the given slot is defined
    *
-   * @tparam FUN     Lambda function [](linb::any& var) {...}
+   * @param  slot  The index of the slot
    *
-   * @throws Exc<E,  E::NOT_A_VARIABLE>
+   * @return true if defined, false otherwise
    */
-  template <typename FUN,
-            typename std::enable_if<
-                std::is_same<std::result_of_t<FUN(linb::any&)>, void>::value,
-                bool>::type = false>
-  void variable(const std::string& name, FUN fun) {
-    auto alias_it = find(aliases_, name);
-
-    if(alias_it != aliases_.end()) {
-      fun(alias_it->second);
-    } else {
-      auto own_it = find(variables_, name);
+  bool has_slot(std::size_t slot) const {
+    return slots_[slot].defined;
+  }
+  /**
+   * @brief  Access to the variable in the given slot
+   *
+   * @param  slot  The index of the slot
+   *
+   * @return the Value representing the ast::Variable
+   */
+  Value& slot(std::size_t slot) {
+    return slots_[slot].value;
+  }
 
-      if(own_it == variables_.end()) {
-        if(parent_) {
-          return parent_->variable(name, std::move(fun));
-        } else {
-          Exc<E, E::NOT_A_VARIABLE> e(__FILE__, __LINE__, "Not a variable");
-          e << "The is no variable '" << name
-            << "' in this or any parent stacks.";
-          throw e;
+  /**
+   * @brief  Calls the given function with every variable this Stack has access
+   *         to - the defined variables and slots of this and all parent Stack
+   *         instances
+   *
+   * @param  fun   The function to call
+   *
+   * @tparam FUN   Lambda function [](auto& var) {...}, var is a linb::any or a
+   *               Value
+   */
+  template <typename FUN>
+  void each_variable(FUN fun) {
+    for(auto* stack = this; stack; stack = stack->parent_) {
+      for(std::size_t i = 0; i < stack->variables_.size(); ++i) {
+        if(stack->variables_[i].defined) {
+          fun(stack->variable(i));
+        }
+      }
+      for(auto& s : stack->slots_) {
+        if(s.defined) {
+          fun(s.value);
         }
-      } else {
-        fun(own_it->second);
       }
     }
   }
+
+  /**
+   * @brief  parent
+   *
+   * @return parent
+   */
+  Stack* parent() const;
+  /**
+   * @brief  The Stack the given number of parents up
+   *
+   * @param  depth  The number of parents to walk up, 0 is this Stack
+   *
+   * @return the Stack or nullptr if there are not enough parents
+   */
+  Stack* ancestor(std::size_t depth) {
+    auto* stack = this;
+    for(; stack && depth > 0; --depth) {
+      stack = stack->parent_;
+    }
+    return stack;
+  }
+
   /**
    * @brief  Function to access a ast::Function
    *
    * @param  call    The ast:callable::Callable to get the function for
    * @param  fun     The function to execute if the function exists
    *
-   * @tparam FUN     Lambda function [&](const Function& fun, auto stack) {...}
-   *                 the stack will be the pointer the function was defined in
+   * @tparam FUN     Lambda function [&](const Function& fun, Stack& s) {...}
+   *                 s will be the Stack the function was defined in
    *
    * @throws Exc<E,  E::NOT_A_FUNCTION>
    */
@@ -316,34 +428,34 @@ public:
       typename FUN,
       typename std::enable_if<
           std::is_same<std::result_of_t<FUN(const ast::callable::Function&,
-                                            std::shared_ptr<Stack>)>,
+                                            Stack&)>,
                        void>::value,
           bool>::type = false>
   void function(const ast::callable::Callable& call, FUN fun) {
-    auto it = find_function(call);
+    const auto* it = find_function(call);
 
-    if(it == functions_.end()) {
+    if(!it) {
       if(parent_) {
         parent_->function(call, std::move(fun));
       } else {
         bool first = true;
 
         Exc<E, E::NOT_A_FUNCTION> e(__FILE__, __LINE__, "Not a function");
-        e << "The is no function '" << call.token.token
+        e << "The is no function '" << call.token.text()
           << "', with the parameter signature '(";
         for(const auto& p : call.parameter) {
           if(first) {
-            e << p.first.token.token;
+            e << p.first.token.text();
             first = false;
           } else {
-            e << ", " << p.first.token.token;
+            e << ", " << p.first.token.text();
           }
         }
         e << ")' in this or any parent stacks.";
         throw e;
       }
     } else {
-      fun(*it, shared_from_this());
+      fun(*it, *this);
     }
   }
 };
@@ -0,0 +1,246 @@
+#ifndef cad_macro_interpreter_VM_h
+#define cad_macro_interpreter_VM_h
+
+#include "cad/macro/interpreter/Bytecode.h"
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/interpreter/Value.h"
+
+#include <any.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+class BatchQueue;
+class FrameArena;
+class Futures;
+class Stack;
+struct CommandLink;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The VM executes bytecode::Bytecode produced by the Compiler
+ * @details The VM uses the providers and the output of the Interpreter it was
+ *          created from and throws the same exceptions as the Interpreter.
+ */
+class VM {
+  friend class Execution;
+
+  using Arguments = cad::core::command::argument::Arguments;
+  using E = Interpreter::E;
+
+  /**
+   * @brief  The information that is the same for all chunks of one run
+   */
+  struct Context {
+    const bytecode::Bytecode& code;
+    const std::string& file;
+    const std::string& scope;
+    FrameArena& frames;
+    const CommandLink* commands;
+    BatchQueue& batches;
+    Futures& futures;
+    std::ostream& out;
+    Cancellation::Probe& probe;
+  };
+
+  /**
+   * @brief  A chunk in execution
+   */
+  struct Activation {
+    std::uint32_t chunk;
+    std::size_t pc;
+    Stack* stack;
+    // the ast::callable::Function of the chunk, nullptr for the root chunk and
+    // the body of a parallel ast::loop::For
+    const ast::callable::Function* function;
+    bool main;         // true if the function is the main function
+    bool frame;        // true if the Stack is popped with the Activation
+    std::size_t base;  // index of the first operand of the Activation
+    Value result;
+    std::vector<Value> iterations;
+  };
+
+  /**
+   * @brief   The explicit continuation of a run
+   * @details Calls of ast::callable::Function instances push an Activation
+   *          instead of recursing on the C++ stack, a run can be stopped
+   *          between any two instructions and continued later.
+   */
+  struct Continuation {
+    // from the outermost to the innermost chunk
+    std::vector<Activation> activations;
+    // the operands of all activations
+    std::vector<Value> values;
+    // the result register of the outermost chunk once it is done
+    Value result;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  const Interpreter& interpreter_;
+
+  /**
+   * @brief  Converts the given Value to bool, the OperatorProvider is only
+   *         asked if the Value isn't a bool already
+   *
+   * @param  value  The Value to convert
+   *
+   * @return the bool value
+   *
+   * @throws Exc<E, E::BAD_BOOL_CAST>
+   */
+  bool to_bool(const Value& value) const;
+  /**
+   * @brief  Executes the given chunk to the end
+   *
+   * @param  context  The context of the run
+   * @param  chunk    The index of the chunk to execute
+   * @param  stack    The Stack the chunk is executed with, it has to be pushed
+   *                  to the FrameArena of the context
+   *
+   * @return the result register of the chunk
+   *
+   * @throws Exc<E,   E::BAD_BOOL_CAST>
+   * @throws Exc<E,   E::MISSING_FUNCTION>
+   * @throws Exc<E,   E::TAIL>
+   */
+  Value execute(const Context& context, std::uint32_t chunk,
+                Stack& stack) const;
+  /**
+   * @brief   Executes the instructions of the given Continuation
+   * @details The Continuation is empty once it is done or after an error
+   *
+   * @param   context       The context of the run
+   * @param   continuation  The Continuation to execute
+   * @param   steps         The number of instructions after which the
+   *                        execution stops, 0 for no limit
+   * @param   deadline      The point in time after which the execution
+   *                        stops, Clock::time_point::max() for no limit
+   * @param   executed      Set to the number of executed instructions, only
+   *                        counted if there is a limit
+   *
+   * @return  true if the Continuation is done, false if it was stopped
+   *
+   * @throws  Exc<E,        E::BAD_BOOL_CAST>
+   * @throws  Exc<E,        E::MISSING_FUNCTION>
+   * @throws  Exc<E,        E::TAIL>
+   */
+  bool step(const Context& context, Continuation& continuation,
+            std::size_t steps, Clock::time_point deadline,
+            std::size_t& executed) const;
+  /**
+   * @brief  Adds the source locations of all activations of the given
+   *         Continuation to the current exception and clears the Continuation
+   *
+   * @param  context       The context of the run
+   * @param  continuation  The Continuation that failed
+   *
+   * @throws Exc<E,        E::TAIL>
+   */
+  [[noreturn]] void unwind(const Context& context,
+                           Continuation& continuation) const;
+  /**
+   * @brief  Pops all activations and their Stack instances
+   *
+   * @param  context       The context of the run
+   * @param  continuation  The Continuation to clear
+   */
+  void clear(const Context& context, Continuation& continuation) const;
+  /**
+   * @brief  Looks up the main function in the root Stack and pushes its
+   *         Activation
+   *
+   * @param  context       The context of the run
+   * @param  continuation  The Continuation to push the main function to
+   * @param  root          The root Stack, the root chunk has to be executed
+   * @param  args          The Arguments to execute the main function with
+   *
+   * @throws Exc<Stack::E, Stack::E::NOT_A_FUNCTION>
+   * @throws Exc<E,        E::TAIL>
+   */
+  void enter_main(const Context& context, Continuation& continuation,
+                  Stack& root, Arguments args) const;
+  /**
+   * @brief  Calls the core::Command the given call site represents
+   *
+   * @param  context    The context of the run
+   * @param  call       The index of the call site to call
+   * @param  args       The values of the parameter in the order of the call
+   * @param  discarded  true if the result isn't used, a batched core::Command
+   *                    is queued in that case
+   *
+   * @return result of the call, a Future for an async call
+   *
+   * @throws Exc<E,     E::MISSING_FUNCTION>
+   */
+  Value command(const Context& context, std::uint32_t call, Value* args,
+                bool discarded) const;
+  /**
+   * @brief   Executes the iterations of the given parallel ast::loop::For
+   * @details Each iteration executes the chunk of the body on its own Stack
+   *          with its own Context. The output of the iterations, the
+   *          reduction variables and the rows of the batched calls are
+   *          combined afterwards in the order of the iterations.
+   *
+   * @param   context     The context of the run
+   * @param   parallel    The index of the bytecode::Parallel
+   * @param   stack       The Stack of the chunk the loop is in
+   * @param   iterations  The values of the loop variable, one per iteration
+   *
+   * @throws  Exc<E,      E::BAD_BOOL_CAST>
+   * @throws  Exc<E,      E::MISSING_FUNCTION>
+   * @throws  Exc<E,      E::TAIL>
+   */
+  void parallel(const Context& context, std::uint32_t parallel, Stack& stack,
+                const std::vector<Value>& iterations) const;
+
+public:
+  /**
+   * @brief  Ctor
+   *
+   * @param  interpreter  The Interpreter that provides the OperatorProvider
+   *                      and CommandProvider
+   */
+  VM(const Interpreter& interpreter);
+
+  /**
+   * @brief  Executes the root chunk and the main function afterwards
+   *
+   * @param  code    The Bytecode to execute
+   * @param  file    The file name / name of the macro.
+   * @param  args    The Arguments to execute the main function with
+   * @param  scope     The scope from which the interpretation was started in,
+   *                   to get the right core::Command instances
+   * @param  out       The output stream of the run
+   * @param  commands  The core::Command instances linked to the call sites
+   *                   in the scope, may be nullptr
+   * @param  cancellation  The Cancellation that stops the run
+   *
+   * @return result of the main function
+   *
+   * @throws Exc<E,  E::BAD_BOOL_CAST>
+   * @throws Exc<E,  E::MISSING_FUNCTION>
+   * @throws Exc<E,  E::TAIL>
+   */
+  linb::any run(const bytecode::Bytecode& code, const std::string& file,
+                Arguments args, const std::string& scope, std::ostream& out,
+                const CommandLink* commands,
+                const Cancellation& cancellation) const;
+};
+}
+}
+}
+#endif
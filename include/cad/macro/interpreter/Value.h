@@ -0,0 +1,172 @@
+#ifndef cad_macro_interpreter_Value_h
+#define cad_macro_interpreter_Value_h
+
+#include <any.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+/**
+ * @brief   The Value class holds the values the VM works with
+ * @details bool, int and double are stored inline, strings are shared and
+ *          immutable so that copies don't allocate. All other types are boxed
+ *          in a shared, immutable linb::any. Values are only converted from and
+ *          to linb::any where the OperatorProvider or the CommandProvider and
+ *          Arguments need them.
+ */
+class Value {
+public:
+  enum class Type : std::uint8_t { EMPTY, BOOL, INT, DOUBLE, STRING, BOXED };
+
+private:
+  Type type_;
+  union {
+    bool bool_;
+    int int_;
+    double double_;
+  };
+  // const std::string for STRING, const linb::any for BOXED
+  std::shared_ptr<const void> shared_;
+
+public:
+  /**
+   * @brief  Ctor - an empty Value
+   */
+  Value()
+      : type_(Type::EMPTY)
+      , int_(0) {
+  }
+  /**
+   * @brief  Ctor
+   *
+   * @param  value  The value
+   */
+  explicit Value(bool value)
+      : type_(Type::BOOL)
+      , bool_(value) {
+  }
+  /**
+   * @brief  Ctor
+   *
+   * @param  value  The value
+   */
+  explicit Value(int value)
+      : type_(Type::INT)
+      , int_(value) {
+  }
+  /**
+   * @brief  Ctor
+   *
+   * @param  value  The value
+   */
+  explicit Value(double value)
+      : type_(Type::DOUBLE)
+      , double_(value) {
+  }
+  /**
+   * @brief  Ctor
+   *
+   * @param  value  The value
+   */
+  explicit Value(std::string value)
+      : type_(Type::STRING)
+      , int_(0)
+      , shared_(std::make_shared<const std::string>(std::move(value))) {
+  }
+
+  /**
+   * @brief  Converts the given any instance to a Value
+   *
+   * @param  any   The any instance
+   *
+   * @return the Value holding the value of the any instance
+   */
+  static Value from_any(const linb::any& any);
+  /**
+   * @brief  Converts the given any instance to a Value
+   *
+   * @param  any   The any instance, it will be moved from
+   *
+   * @return the Value holding the value of the any instance
+   */
+  static Value from_any(linb::any&& any);
+  /**
+   * @brief  Converts this Value to a any instance
+   *
+   * @return any instance holding a copy of this Value
+   */
+  linb::any to_any() const;
+
+  /**
+   * @brief  The type of the value
+   *
+   * @return type
+   */
+  Type type() const {
+    return type_;
+  }
+  /**
+   * @brief  The type of the value as it would be reported by linb::any
+   *
+   * @return type_info of the value
+   */
+  const std::type_info& type_info() const;
+  /**
+   * @brief  Checks if the Value holds no value
+   *
+   * @return true if empty, false otherwise
+   */
+  bool empty() const {
+    return type_ == Type::EMPTY;
+  }
+
+  /**
+   * @brief  Access to the value, the Value has to be of Type::BOOL
+   *
+   * @return the value
+   */
+  bool as_bool() const {
+    return bool_;
+  }
+  /**
+   * @brief  Access to the value, the Value has to be of Type::INT
+   *
+   * @return the value
+   */
+  int as_int() const {
+    return int_;
+  }
+  /**
+   * @brief  Access to the value, the Value has to be of Type::DOUBLE
+   *
+   * @return the value
+   */
+  double as_double() const {
+    return double_;
+  }
+  /**
+   * @brief  Access to the value, the Value has to be of Type::STRING
+   *
+   * @return the value
+   */
+  const std::string& as_string() const {
+    return *static_cast<const std::string*>(shared_.get());
+  }
+  /**
+   * @brief  Access to the value, the Value has to be of Type::BOXED
+   *
+   * @return the value
+   */
+  const linb::any& as_boxed() const {
+    return *static_cast<const linb::any*>(shared_.get());
+  }
+};
+}
+}
+}
+#endif
@@ -313,6 +313,18 @@ private:
    *         variable
    */
   void op_assign_var();
+  /**
+   * @brief  Checks that async ast::callable::Callable instances are statements
+   *         or the right hand side of an assignment, the future they return
+   *         is only joined when it is read from a variable
+   */
+  void async_call();
+  /**
+   * @brief  Checks that the iterations of a parallel ast::loop::For are
+   *         independent - they only assign their own variables and the
+   *         reduction variables and don't leave the loop early
+   */
+  void parallel_for();
   /**
    * @brief  Checks that the ast::callable::Function instance has a scope - not
    *         needed but better safe than sorry
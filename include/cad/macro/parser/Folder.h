@@ -0,0 +1,36 @@
+#ifndef cad_macro_parser_Folder_h
+#define cad_macro_parser_Folder_h
+
+namespace cad {
+namespace macro {
+namespace ast {
+struct Scope;
+}
+namespace interpreter {
+class OperatorProvider;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace parser {
+/**
+ * @brief   Folds all ast::Operator instances that only have ast::Literal
+ *          operands into a single ast::Literal
+ *
+ * @details The operators are evaluated with the given OperatorProvider, it has
+ *          to be the OperatorProvider that will interpret the ast so that the
+ *          folded values are the same the Interpreter would produce. Operators
+ *          with side effects (print and assignments), operators that would
+ *          throw and operators that produce a value that can't be represented
+ *          by a ast::Literal are not folded.
+ *
+ * @param   root       The analysed root ast::Scope of a macro
+ * @param   operators  The OperatorProvider to evaluate the operators with
+ */
+void fold(ast::Scope& root, const interpreter::OperatorProvider& operators);
+}
+}
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef cad_macro_parser_Indexer_h
+#define cad_macro_parser_Indexer_h
+
+namespace cad {
+namespace macro {
+namespace ast {
+struct Scope;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace parser {
+/**
+ * @brief   Sets ast::Scope::functions of the given and all nested ast::Scope
+ *          instances
+ *
+ * @details The function definitions don't change after the analysis, the
+ *          Interpreter and the Compiler use the indices instead of searching
+ *          the nodes every time a ast::Scope is entered.
+ *
+ * @param   root  The analysed root ast::Scope of a macro
+ */
+void index_functions(ast::Scope& root);
+}
+}
+}
+#endif
@@ -8,6 +8,9 @@ namespace macro {
 namespace ast {
 struct Scope;
 }
+namespace interpreter {
+class OperatorProvider;
+}
 }
 }
 
@@ -22,6 +25,8 @@ enum class InternalE { BAD_CONVERSION, MISSING_OPERATOR };
  *
  * @param  macro                   The macro
  * @param  file_name               The file name / macro name
+ * @param  operators               The OperatorProvider to fold constant
+ *                                 expressions with, nullptr disables folding
  *
  * @return ast that can be consumed by the Interpreter
  *
@@ -30,7 +35,8 @@ enum class InternalE { BAD_CONVERSION, MISSING_OPERATOR };
  * @throws Exc<parser::InternalE,  parser::InternalE::BAD_CONVERSION>
  * @throws Exc<parser::InternalE,  parser::InternalE::MISSING_OPERATOR>
  */
-ast::Scope parse(std::string macro, std::string file_name = "Anonymous");
+ast::Scope parse(std::string macro, std::string file_name = "Anonymous",
+                 const interpreter::OperatorProvider* operators = nullptr);
 }
 }
 }
@@ -1,36 +1,302 @@
 #ifndef cad_macro_parser_Token_h
 #define cad_macro_parser_Token_h
 
+#include <experimental/string_view>
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace cad {
 namespace macro {
 namespace parser {
 /**
- * @brief  The Token struct represents a collection of characters of the macro
- *         that are a token.
+ * @brief   The Source holds the characters of the Token instances of a macro
+ * @details The offsets of the lines are indexed once, the line, the column and
+ *          the source line of a Token are looked up by its offset. The
+ *          tokenizer stores the decoded contents of the string literals in it.
+ *          A Token that is made without a macro gets a Source of its own, that
+ *          holds its text, line, column and source line. The Token instances
+ *          count the references to their Source and delete it with the last
+ *          one.
+ */
+class Source {
+  friend struct Token;
+
+  std::string text_;
+  // the offsets of the first characters of the lines, empty for the Source of
+  // a single Token
+  std::vector<std::uint32_t> lines_;
+  std::uint32_t line_;    // of the single Token
+  std::uint32_t column_;  // of the single Token
+  std::shared_ptr<const std::string> source_line_;  // of the single Token
+  // the contents of the STRING Token instances, only added by the tokenizer
+  // before the Token instances are shared
+  mutable std::vector<std::string> contents_;
+  mutable std::atomic<std::size_t> references_;
+
+  /**
+   * @brief  Ctor of the Source of a macro
+   *
+   * @param  macro  The macro
+   */
+  explicit Source(std::string macro);
+  /**
+   * @brief  Ctor of the Source of a single Token
+   *
+   * @param  line         The line of the Token
+   * @param  column       The column of the Token
+   * @param  text         The text of the Token
+   * @param  source_line  The source line, nullptr if there is none
+   */
+  Source(std::size_t line, std::size_t column, std::string text,
+         std::shared_ptr<const std::string> source_line);
+
+  /**
+   * @brief  Finds the line the character at the given offset is in
+   *
+   * @param  offset  The offset of the character
+   *
+   * @return index into lines_
+   */
+  std::size_t line_index(std::size_t offset) const;
+
+public:
+  /**
+   * @brief  The line of the character at the given offset
+   *
+   * @param  offset  The offset of the character
+   *
+   * @return the line, starting at 1
+   */
+  std::size_t line(std::size_t offset) const;
+  /**
+   * @brief  The column of the character at the given offset
+   *
+   * @param  offset  The offset of the character
+   *
+   * @return the column, starting at 1
+   */
+  std::size_t column(std::size_t offset) const;
+  /**
+   * @brief  The line of the character at the given offset
+   *
+   * @param  offset  The offset of the character
+   *
+   * @return the source line without line break, empty if there is none
+   */
+  std::string source_line(std::size_t offset) const;
+  /**
+   * @brief  Checks if there is a source line that messages can show
+   *
+   * @return true if there is one
+   */
+  bool has_source_line() const;
+  /**
+   * @brief  The characters of the Source
+   *
+   * @return the macro or the text of the single Token
+   */
+  const std::string& text() const {
+    return text_;
+  }
+};
+
+/**
+ * @brief   The Token struct represents a collection of characters of the macro
+ *          that are a token.
+ * @details All Token instances of a macro share the Source of the macro, a
+ *          Token only stores where its characters are in it. The tokenizer
+ *          classifies every Token and decodes the value of the literals, so
+ *          that the parser does not have to look at the characters of a Token
+ *          again. The decoded content of a string literal is in the Source,
+ *          the Token only stores its index.
  */
 struct Token {
-  size_t line;
-  size_t column;
-  std::string token;
-  std::shared_ptr<std::string> source_line;
+  /**
+   * @brief  The kinds of Token
+   */
+  enum class Kind : std::uint8_t {
+    OTHER,        // none of the other kinds, e.g. `Abc`, `1a` or `"a`
+    IDENTIFIER,   // [a-z][a-z0-9_]* that is no keyword
+    KEYWORD,      // e.g. `if`, `true` or `print`
+    INT,          // [0-9]+
+    DOUBLE,       // [0-9]*\.[0-9]+
+    STRING,       // "..."
+    OPERATOR,     // e.g. `+`, `<=` or `&&`
+    PUNCTUATION,  // one of `(`, `)`, `{`, `}`, `,`, `:` and `;`
+  };
+  /**
+   * @brief  The keywords, a Token of the Kind::KEYWORD is one of them
+   */
+  enum class Keyword : std::uint8_t {
+    NONE,
+    IF,
+    ELSE,
+    DO,
+    WHILE,
+    FOR,
+    VAR,
+    DEF,
+    CONTINUE,
+    MAIN,
+    BREAK,
+    RETURN,
+    TRUE,
+    FALSE,
+    TYPEOF,
+    PRINT,
+    ASYNC,
+    PARALLEL,
+    REDUCE,
+  };
+
+private:
+  const Source* source_;
+
+  /**
+   * @brief  Counts another reference to the given Source
+   *
+   * @param  source  The Source, may be nullptr
+   *
+   * @return the Source
+   */
+  static const Source* retain(const Source* source);
+
+public:
+  std::uint32_t offset;  // of the first character in the Source
+  std::uint32_t length;  // of the text
+  Kind kind;
+  Keyword keyword;
+  union {
+    std::int64_t integer;  // of an INT, saturates above the range of int
+    double number;         // of a DOUBLE
+    std::uint32_t string;  // of a STRING, index of the content in the Source
+  };
 
   /**
    * @brief  Ctor
    */
   Token();
   /**
-   * @brief  Ctor
+   * @brief  Ctor of a Token that is not part of a macro
    *
    * @param  line         The line
    * @param  column       The column
-   * @param  token        The token
-   * @param  source_line  The source line
+   * @param  text         The text
+   * @param  source_line  The source line, the Token starts at the column in it
+   */
+  Token(size_t line, size_t column, std::string text,
+        std::shared_ptr<const std::string> source_line = nullptr);
+  /**
+   * @brief  Ctor of a Token that spans the whole macro, the Token instances of
+   *         the macro are made from it and share its Source
+   *
+   * @param  macro  The macro
+   */
+  explicit Token(std::string macro);
+  /**
+   * @brief  Ctor of a Token in the Source of another Token
+   *
+   * @param  other   The Token whose Source is shared
+   * @param  offset  The offset of the first character in the Source
+   * @param  length  The number of characters
+   */
+  Token(const Token& other, std::size_t offset, std::size_t length);
+  /**
+   * @brief  Copy ctor
+   *
+   * @param  other  The Token to copy
+   */
+  Token(const Token& other);
+  /**
+   * @brief  Move ctor
+   *
+   * @param  other  The Token to move, it has no Source afterwards
+   */
+  Token(Token&& other) noexcept;
+  /**
+   * @brief  Dtor - deletes the Source with its last Token
+   */
+  ~Token();
+
+  /**
+   * @brief  Copy assignment
+   *
+   * @param  other  The Token to copy
+   *
+   * @return this
+   */
+  Token& operator=(const Token& other);
+  /**
+   * @brief  Move assignment
+   *
+   * @param  other  The Token to move, it has no Source afterwards
+   *
+   * @return this
+   */
+  Token& operator=(Token&& other) noexcept;
+
+  /**
+   * @brief  The characters of the Token
+   *
+   * @return view into the Source, valid as long as a Token of the Source is
+   */
+  std::experimental::string_view text() const {
+    if(!source_) {
+      return {};
+    }
+    return std::experimental::string_view(source_->text_).substr(offset,
+                                                                 length);
+  }
+  /**
+   * @brief  The content of a STRING
+   *
+   * @return the characters between the quotes with the escape sequences
+   *         replaced
+   */
+  const std::string& content() const;
+  /**
+   * @brief  Stores the content of a STRING in its Source, only the tokenizer
+   *         does this
+   *
+   * @param  content  The characters between the quotes with the escape
+   *                  sequences replaced
+   */
+  void set_content(std::string content);
+  /**
+   * @brief  The Source the Token is in
+   *
+   * @return the Source, nullptr for a default constructed Token
+   */
+  const Source* source() const;
+  /**
+   * @brief  The line the Token starts in
+   *
+   * @return the line
+   */
+  std::size_t line() const;
+  /**
+   * @brief  The column the Token starts in
+   *
+   * @return the column
+   */
+  std::size_t column() const;
+  /**
+   * @brief  Checks if there is a source line that messages can show
+   *
+   * @return true if there is one
+   */
+  bool has_source_line() const;
+  /**
+   * @brief  The line of the source the Token starts in
+   *
+   * @return the source line without line break, empty without source
    */
-  Token(size_t line, size_t column, std::string token,
-        std::shared_ptr<std::string> source_line = nullptr);
+  std::string source_line() const;
 
   /**
    * @brief  Equality comparison
@@ -0,0 +1,87 @@
+#ifndef cad_macro_parser_analyser_Frame_h
+#define cad_macro_parser_analyser_Frame_h
+
+#include "cad/macro/ast/Variable.h"
+
+#include <experimental/string_view>
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace cad {
+namespace macro {
+namespace ast {
+struct Scope;
+}
+}
+}
+
+namespace cad {
+namespace macro {
+namespace parser {
+namespace analyser {
+/**
+ * @brief   The Frame struct is a helper for the Analyser, it assigns the slots
+ *          of one ast::Scope::Frame
+ *
+ * @details All Stack instances of a function share one Frame, like all
+ *          ast::Scope instances of a function share one interpreter::Stack.
+ *          The slots are written to the ast::Scope the Frame was created for.
+ */
+struct Frame {
+private:
+  using Name = std::experimental::string_view;
+
+  const ast::Scope& body_;
+  // name -> slot
+  std::unordered_map<Name, std::uint32_t> slots_;
+  // name -> slot of the shadowed outer variables
+  std::unordered_map<Name, std::uint32_t> shadows_;
+
+public:
+  /**
+   * @brief  Ctor, clears the ast::Scope::Frame of the body
+   *
+   * @param  body  The root ast::Scope or the body of a function or parallel
+   *               loop, it has to outlive the Frame
+   */
+  Frame(const ast::Scope& body);
+
+  /**
+   * @brief  The slot of the given name, the slot is allocated if it doesn't
+   *         exist yet
+   *
+   * @param  name  The name of the variable
+   *
+   * @return index of the slot
+   */
+  std::uint32_t slot(Name name);
+  /**
+   * @brief  Adds a ast::Scope::Shadow for the outer variable of the given name
+   *
+   * @param  name   The name of the variable
+   * @param  outer  The position of the outer variable relative to this Frame
+   */
+  void shadow(Name name, ast::Address outer);
+  /**
+   * @brief  The slot of the shadow of the given name
+   *
+   * @param  name  The name of the variable
+   *
+   * @return pointer to the slot or nullptr if the name is not shadowed
+   */
+  const std::uint32_t* shadowed(Name name) const;
+  /**
+   * @brief  The slot of the given name
+   *
+   * @param  name  The name of the variable, it has a slot
+   *
+   * @return index of the slot
+   */
+  std::uint32_t at(Name name) const;
+};
+}
+}
+}
+}
+#endif
@@ -1,15 +1,20 @@
 #ifndef cad_macro_parser_analyser_Stack_h
 #define cad_macro_parser_analyser_Stack_h
 
+#include "cad/macro/ast/Variable.h"
+
 #include <experimental/optional>
+#include <experimental/string_view>
 
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace cad {
 namespace macro {
 namespace ast {
-struct Variable;
 namespace callable {
 struct Function;
 }
@@ -21,23 +26,51 @@ namespace cad {
 namespace macro {
 namespace parser {
 namespace analyser {
+struct Frame;
+
 /**
  * @brief   The Stack struct is a helper for the Analyser.
  *
  * @details This Stack is very similar to the one used by the Interpreter. The
  *          difference is that this Stack does not allocate memory for variables
- *          but only stores the names.
+ *          but only stores the names. The names are indexed, add variables
+ *          and functions with add_var() and add_fun() to keep the lookups
+ *          from scanning every entry. Every variable gets a slot in the Frame
+ *          of the Stack.
  */
 struct Stack {
   using RV = std::reference_wrapper<const ast::Variable>;
   using RF = std::reference_wrapper<const ast::callable::Function>;
+  // name -> index into variables or functions
+  using Index =
+      std::unordered_multimap<std::experimental::string_view, std::size_t>;
 
 public:
   std::vector<RV> variables;
   std::vector<RF> functions;
   Stack* parent = nullptr;
+  // the Frame of the function the Stack is in
+  Frame* frame = nullptr;
+
+private:
+  Index variable_index_;
+  Index function_index_;
 
 public:
+  /**
+   * @brief  Adds a variable
+   *
+   * @param  var  The variable, it has to outlive the Stack
+   *
+   * @return the slot of the variable in the Frame
+   */
+  std::uint32_t add_var(RV var);
+  /**
+   * @brief  Adds a function
+   *
+   * @param  fun  The function, it has to outlive the Stack
+   */
+  void add_fun(RF fun);
   /**
    * @brief  Determine if it has var
    *
@@ -45,7 +78,28 @@ public:
    *
    * @return true if has the variable, false otherwise
    */
-  bool has_var(const std::string& name) const;
+  bool has_var(std::experimental::string_view name) const;
+  /**
+   * @brief  Determine if it or a parent up to the given Stack has var
+   *
+   * @param  name  The name of the variable to check
+   * @param  last  The last Stack to check, has to be this or a parent
+   *
+   * @return true if has the variable, false otherwise
+   */
+  bool has_var(std::experimental::string_view name, const Stack& last) const;
+  /**
+   * @brief  The position of the definition of the given variable that is
+   *         visible in this Stack, a shadow of the Frame of this or a parent
+   *         Stack hides the outer variables
+   *
+   * @param  name  The name of the variable
+   *
+   * @return the position relative to the Frame of this Stack or nothing if
+   *         there is no such variable
+   */
+  std::experimental::optional<ast::Address>
+  address(std::experimental::string_view name) const;
   /**
    * @brief  Determine if it has fucntion
    *
@@ -53,7 +107,7 @@ public:
    *
    * @return true if has the fcuntion, false otherwise.
    */
-  bool has_fun(const std::string& name) const;
+  bool has_fun(std::experimental::string_view name) const;
   /**
    * @return an optional pair where the first instance is the variable that was
    *         first declared and the second the variable that was declared last
@@ -28,6 +28,11 @@ public:
   std::reference_wrapper<const ast::Scope> scope;
   bool loop;
   bool root_scope;
+  // the Stack of the body of the innermost parallel ast::loop::For, nullptr
+  // outside of them - the iterations must not assign the variables above it
+  const Stack* parallel;
+  // true if the innermost loop is a parallel ast::loop::For
+  bool parallel_loop;
 
 public:
   /**
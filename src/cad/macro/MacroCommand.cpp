@@ -13,10 +13,12 @@ using Command = cad::core::command::Command;
 
 MacroCommand::MacroCommand(
     std::weak_ptr<interpreter::OperatorProvider> op_provider,
-    std::weak_ptr<CommandProvider> command_provider)
+    std::weak_ptr<CommandProvider> command_provider,
+    interpreter::Future::Executor executor)
     : Command("eval_macro", command_provider)
     , op_provider_(op_provider)
-    , command_provider_(command_provider) {
+    , command_provider_(command_provider)
+    , executor_(std::move(executor)) {
   set_description("MacroCommand");
 
   Arguments args;
@@ -25,6 +27,8 @@ MacroCommand::MacroCommand(
   args.add("Output", "Output stream.",
            std::reference_wrapper<std::ostream>(std::cout), true);
   args.add("Arguments", "Arguments for the macro", Arguments(), true);
+  args.add("Cancellation", "Cancellation and deadline of the macro.",
+           interpreter::Cancellation(), true);
   set_arguments(args);
 
   set_modifying(false);
@@ -57,15 +61,25 @@ linb::any MacroCommand::execute(Arguments args) {
       return interpreter::Interpreter(com_pro, op_pro);
     }
   }();
+  inter.set_executor(executor_);
+
+  const auto cancellation = [&] {
+    if(auto c = args.get<interpreter::Cancellation>("Cancellation")) {
+      return *c;
+    } else {
+      return interpreter::Cancellation();
+    }
+  }();
 
   return [&] {
     if(auto file = args.get<std::string>("Macroname")) {
       return inter.interpret(*args.get<std::string>("Makro"),
                              *args.get<Arguments>("Arguments"), get_scope(),
-                             *file);
+                             *file, cancellation);
     } else {
       return inter.interpret(*args.get<std::string>("Makro"),
-                             *args.get<Arguments>("Arguments"), get_scope());
+                             *args.get<Arguments>("Arguments"), get_scope(),
+                             "Anonymous", cancellation);
     }
   }();
 }
@@ -0,0 +1,222 @@
+#include "cad/macro/MacroExecutor.h"
+
+#include "cad/macro/interpreter/CompiledMacro.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace cad {
+namespace macro {
+namespace {
+using Job = MacroExecutor::Job;
+using Result = MacroExecutor::Result;
+using Callback = MacroExecutor::Callback;
+
+linb::any run(Job& job) {
+  if(job.out) {
+    return job.macro->run(std::move(job.args), std::move(job.scope), *job.out,
+                          job.cancellation);
+  }
+  return job.macro->run(std::move(job.args), std::move(job.scope),
+                        job.cancellation);
+}
+
+/**
+ * @brief  The state of a batch that was submitted with a Callback
+ */
+struct Batch {
+  std::vector<Result> results;
+  std::atomic<std::size_t> left;
+  Callback done;
+
+  Batch(std::size_t jobs, Callback done)
+      : results(jobs)
+      , left(jobs)
+      , done(std::move(done)) {
+  }
+};
+}
+
+MacroExecutor::MacroExecutor(interpreter::Future::Executor executor)
+    : MacroExecutor(std::move(executor),
+                    std::max(std::thread::hardware_concurrency(), 1u)) {
+}
+
+MacroExecutor::MacroExecutor(interpreter::Future::Executor executor,
+                             std::size_t workers)
+    : executor_(std::move(executor))
+    , next_(0)
+    , pending_(0)
+    , active_(0) {
+  workers = std::max<std::size_t>(workers, 1);
+
+  for(std::size_t i = 0; i < workers; ++i) {
+    queues_.emplace_back(new Queue());
+  }
+  running_.resize(workers, false);
+}
+
+MacroExecutor::~MacroExecutor() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return active_ == 0; });
+}
+
+std::size_t MacroExecutor::workers() const {
+  return queues_.size();
+}
+
+void MacroExecutor::enqueue(std::vector<std::function<void()>> tasks) {
+  if(tasks.empty()) {
+    return;
+  }
+
+  // counted first, a worker must not take a task that isn't counted yet
+  pending_ += tasks.size();
+
+  // small batches start on different workers
+  const auto queues = queues_.size();
+  const auto first = next_++;
+
+  for(std::size_t q = 0; q < queues; ++q) {
+    const auto begin = tasks.size() * q / queues;
+    const auto end = tasks.size() * (q + 1) / queues;
+    if(begin == end) {
+      continue;
+    }
+
+    auto& queue = *queues_[(first + q) % queues];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    for(auto i = begin; i < end; ++i) {
+      queue.tasks.push_back(std::move(tasks[i]));
+    }
+  }
+
+  for(std::size_t w = 0; w < queues; ++w) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(running_[w]) {
+        continue;
+      }
+      running_[w] = true;
+      ++active_;
+    }
+    try {
+      executor_([this, w]() { work(w); });
+    } catch(...) {
+      // the worker can't be started, the calling thread does its work
+      work(w);
+    }
+  }
+}
+
+bool MacroExecutor::take(std::size_t worker, std::function<void()>& task) {
+  {
+    auto& own = *queues_[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if(!own.tasks.empty()) {
+      task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  for(std::size_t i = 1; i < queues_.size(); ++i) {
+    auto& victim = *queues_[(worker + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+
+    if(!victim.tasks.empty()) {
+      task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void MacroExecutor::work(std::size_t worker) {
+  std::function<void()> task;
+
+  while(true) {
+    if(take(worker, task)) {
+      --pending_;
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // a task that is counted after this check starts the worker again
+      if(pending_ == 0) {
+        running_[worker] = false;
+        --active_;
+        idle_.notify_all();
+        return;
+      }
+    }
+    // counted but not queued yet
+    std::this_thread::yield();
+  }
+}
+
+std::vector<std::future<linb::any>>
+MacroExecutor::submit(std::vector<Job> jobs) {
+  std::vector<std::future<linb::any>> futures;
+  std::vector<std::function<void()>> tasks;
+
+  futures.reserve(jobs.size());
+  tasks.reserve(jobs.size());
+  for(auto& j : jobs) {
+    auto promise = std::make_shared<std::promise<linb::any>>();
+    auto job = std::make_shared<Job>(std::move(j));
+
+    futures.push_back(promise->get_future());
+    tasks.push_back([promise, job]() {
+      try {
+        promise->set_value(run(*job));
+      } catch(...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+  }
+  enqueue(std::move(tasks));
+
+  return futures;
+}
+
+void MacroExecutor::submit(std::vector<Job> jobs, Callback done) {
+  if(jobs.empty()) {
+    try {
+      done({});
+    } catch(...) {
+    }
+    return;
+  }
+
+  auto batch = std::make_shared<Batch>(jobs.size(), std::move(done));
+  std::vector<std::function<void()>> tasks;
+
+  tasks.reserve(jobs.size());
+  for(std::size_t i = 0; i < jobs.size(); ++i) {
+    auto job = std::make_shared<Job>(std::move(jobs[i]));
+
+    tasks.push_back([batch, job, i]() {
+      auto& result = batch->results[i];
+      try {
+        result.value = run(*job);
+      } catch(...) {
+        result.error = std::current_exception();
+      }
+
+      if(--batch->left == 0) {
+        try {
+          batch->done(std::move(batch->results));
+        } catch(...) {
+        }
+      }
+    });
+  }
+  enqueue(std::move(tasks));
+}
+}
+}
@@ -1,6 +1,7 @@
 #include "cad/macro/MacroInitializer.h"
 
 #include "cad/macro/MacroCommand.h"
+#include "cad/macro/MacroExecutor.h"
 #include "cad/macro/interpreter/OperatorProvider.h"
 
 #include <cad/core/command/CommandProvider.h>
@@ -14,17 +15,39 @@ namespace {
 using OperatorProvider = interpreter::OperatorProvider;
 
 using SignalProvider = p3::common::module_system::SignalProvider;
+using ThreadManager = p3::common::module_system::ThreadManager;
 
 using CommandProvider = cad::core::command::CommandProvider;
 using MenuFilter = cad::core::command::MenuFilter;
 
+using Executor = interpreter::Future::Executor;
+
 using namespace macro_initializer;
+
+/**
+ * @brief  An Executor that runs the tasks with the given ThreadManager, the
+ *         tasks run on the calling thread once the ThreadManager is gone
+ *
+ * @param  manager  The ThreadManager
+ *
+ * @return the Executor
+ */
+Executor make_executor(std::weak_ptr<ThreadManager> manager) {
+  return [manager](std::function<void()> task) {
+    if(auto m = manager.lock()) {
+      m->add_task(std::move(task));
+    } else {
+      task();
+    }
+  };
+}
 }
 
 MacroInitializer::MacroInitializer(const std::weak_ptr<ModuleLoader>& loader,
                                    const std::weak_ptr<PProvider>& provider,
                                    const std::weak_ptr<ThreadManager>& manager)
-    : cad::core::CoreInitializerBase<STEPS>(loader, provider, manager) {
+    : cad::core::CoreInitializerBase<STEPS>(loader, provider, manager)
+    , executor_(make_executor(manager)) {
 }
 
 void MacroInitializer::initialize() {
@@ -32,12 +55,13 @@ void MacroInitializer::initialize() {
     auto com_pro = obtain_provider<CommandProvider>();
     auto op_pro =
         add_get_provider<STEPS::OPERATOR_PROVIDER, OperatorProvider>();
+    add_get_provider<STEPS::MACRO_EXECUTOR, MacroExecutor>(executor_);
 
     add_command<STEPS::MACRO_COMMAND>()
         .name("ExecuteMakro")
         .scope("")
         .weight(1000)
-        .add<MacroCommand>(op_pro, com_pro);
+        .add<MacroCommand>(op_pro, com_pro, executor_);
 
   } catch(std::exception& e) {
     emit_exception(e);
@@ -19,7 +19,7 @@ Operator::Operator(const Operator& other)
                         : nullptr)
     , operation(other.operation) {
 }
-Operator::Operator(Operator&& other) {
+Operator::Operator(Operator&& other) noexcept {
   swap(*this, other);
 }
 Operator& Operator::operator=(Operator other) {
@@ -11,6 +11,15 @@ Scope::Scope(parser::Token token)
     : AST(std::move(token)) {
 }
 
+const callable::Function& Scope::function(const std::size_t index) const {
+  const auto& def = nodes[functions[index]].target<Define>()->definition;
+
+  if(const auto* fun = def.target<callable::Function>()) {
+    return *fun;
+  }
+  return *def.target<callable::EntryFunction>();
+}
+
 void Scope::print_internals(std::ostream& os) const {
   IndentStream indent_os(os);
   for(auto& v : nodes) {
@@ -0,0 +1,80 @@
+#include "cad/macro/ast/ScopeArena.h"
+
+#include <cassert>
+#include <limits>
+
+namespace cad {
+namespace macro {
+namespace ast {
+namespace {
+std::shared_ptr<ScopeArena> share(ScopeArena* arena) {
+  return arena ? arena->shared_from_this() : nullptr;
+}
+}
+
+ScopeRef::ScopeRef(ScopeArena& arena, const std::uint32_t index) noexcept
+    : arena_(&arena)
+    , index_(index) {
+}
+
+ScopeRef::ScopeRef() noexcept
+    : arena_(nullptr)
+    , index_(0) {
+}
+
+ScopeRef::ScopeRef(std::nullptr_t) noexcept
+    : ScopeRef() {
+}
+
+ScopeRef::ScopeRef(std::unique_ptr<Scope> scope)
+    : ScopeRef() {
+  if(scope) {
+    owner_ = std::make_shared<ScopeArena>();
+    arena_ = owner_.get();
+    index_ = arena_->add(std::move(*scope)).index_;
+  }
+}
+
+ScopeRef::ScopeRef(const ScopeRef& other)
+    : arena_(other.arena_)
+    , owner_(share(other.arena_))
+    , index_(other.index_) {
+}
+
+ScopeRef& ScopeRef::operator=(const ScopeRef& other) {
+  owner_ = share(other.arena_);
+  arena_ = other.arena_;
+  index_ = other.index_;
+  return *this;
+}
+
+Scope* ScopeRef::get() const {
+  return arena_ ? &arena_->at(index_) : nullptr;
+}
+
+Scope& ScopeRef::operator*() const {
+  assert(arena_);
+  return arena_->at(index_);
+}
+
+Scope* ScopeRef::operator->() const {
+  assert(arena_);
+  return &arena_->at(index_);
+}
+
+ScopeRef ScopeArena::add(Scope scope) {
+  assert(scopes_.size() < std::numeric_limits<std::uint32_t>::max());
+  scopes_.push_back(std::move(scope));
+  return ScopeRef(*this, static_cast<std::uint32_t>(scopes_.size() - 1));
+}
+
+Scope& ScopeArena::at(const std::uint32_t index) {
+  return scopes_[index];
+}
+
+std::size_t ScopeArena::size() const {
+  return scopes_.size();
+}
+}
+}
+}
@@ -6,17 +6,21 @@ namespace cad {
 namespace macro {
 namespace ast {
 namespace callable {
-Callable::Callable() {
+Callable::Callable()
+    : async(false) {
 }
 Callable::Callable(const Callable& other)
     : AST(other)
-    , parameter(other.parameter) {
+    , parameter(other.parameter)
+    , async(other.async) {
 }
-Callable::Callable(Callable&& other) {
+Callable::Callable(Callable&& other) noexcept
+    : async(false) {
   swap(*this, other);
 }
 Callable::Callable(parser::Token token)
-    : AST(std::move(token)) {
+    : AST(std::move(token))
+    , async(false) {
 }
 Callable& Callable::operator=(Callable other) {
   swap(*this, other);
@@ -24,11 +28,14 @@ Callable& Callable::operator=(Callable other) {
 }
 
 void Callable::print_internals(IndentStream& os) const {
+  if(async) {
+    os << "async: true\n";
+  }
   os << "parameter:\n";
   if(!parameter.empty()) {
     os.indent();
     for(const auto& v : parameter) {
-      os << v.first.token.token << ": ";
+      os << v.first.token.text() << ": ";
       eggs::match(v.second.value,
                   [&os](const callable::Callable& o) { os << o; },
                   [&os](const Variable& o) { os << o; },
@@ -46,7 +53,7 @@ bool Callable::operator==(const Callable& other) const {
   if(this == &other) {
     return true;
   } else if(AST::operator==(other)) {
-    return parameter == other.parameter;
+    return async == other.async && parameter == other.parameter;
   }
   return false;
 }
@@ -54,12 +61,13 @@ bool Callable::operator==(const Callable& other) const {
 bool Callable::operator!=(const Callable& other) const {
   return !(*this == other);
 }
-void swap(Callable& first, Callable& second) {
+void swap(Callable& first, Callable& second) noexcept {
   // enable ADL
   using std::swap;
 
   swap(static_cast<AST&>(first), static_cast<AST&>(second));
   swap(first.parameter, second.parameter);
+  swap(first.async, second.async);
 }
 }
 }
@@ -13,9 +13,9 @@ Function::Function() {
 Function::Function(const Function& other)
     : AST(other)
     , parameter(other.parameter)
-    , scope((other.scope) ? std::make_unique<Scope>(*other.scope) : nullptr) {
+    , scope(other.scope) {
 }
-Function::Function(Function&& other) {
+Function::Function(Function&& other) noexcept {
   swap(*this, other);
 }
 Function::Function(parser::Token token)
@@ -13,7 +13,7 @@ Return::Return(const Return& other)
     , output((other.output) ? std::make_unique<ValueProducer>(*other.output)
                             : nullptr) {
 }
-Return::Return(Return&& other) {
+Return::Return(Return&& other) noexcept {
   swap(*this, other);
 }
 Return::Return(parser::Token token)
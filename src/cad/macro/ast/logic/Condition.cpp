@@ -14,7 +14,7 @@ Condition::Condition(const Condition& other)
                     ? std::make_unique<ValueProducer>(*other.condition)
                     : nullptr) {
 }
-Condition::Condition(Condition&& other) {
+Condition::Condition(Condition&& other) noexcept {
   swap(*this, other);
 }
 Condition::Condition(parser::Token token)
@@ -27,13 +27,10 @@ If::If(parser::Token token)
 }
 If::If(const If& other)
     : cad::macro::ast::logic::Condition(other)
-    , true_scope((other.true_scope) ? std::make_unique<Scope>(*other.true_scope)
-                                    : nullptr)
-    , false_scope((other.false_scope)
-                      ? std::make_unique<Scope>(*other.false_scope)
-                      : nullptr) {
+    , true_scope(other.true_scope)
+    , false_scope(other.false_scope) {
 }
-If::If(If&& other) {
+If::If(If&& other) noexcept {
   swap(*this, other);
 }
 If::~If() {
@@ -7,7 +7,26 @@ namespace cad {
 namespace macro {
 namespace ast {
 namespace loop {
+namespace {
+const char* to_string(const For::Reduction::Kind kind) {
+  switch(kind) {
+  case For::Reduction::Kind::SUM:
+    return "sum";
+  case For::Reduction::Kind::MIN:
+    return "min";
+  case For::Reduction::Kind::MAX:
+    return "max";
+  case For::Reduction::Kind::COLLECT:
+    return "collect";
+  }
+  return "";
+}
+}
+
 void For::print_internals(IndentStream& os) const {
+  if(parallel) {
+    os << "parallel: true\n";
+  }
   os << "Define:\n";
   if(define) {
     os.indent() << *define;
@@ -26,18 +45,46 @@ void For::print_internals(IndentStream& os) const {
     os.indent() << *operation;
     os.dedent();
   }
+
+  if(!reductions.empty()) {
+    os << "Reductions:\n";
+    os.indent();
+    for(const auto& r : reductions) {
+      os << to_string(r.kind) << ":\n";
+      os.indent() << r.variable;
+      os.dedent();
+    }
+    os.dedent();
+  }
 }
 
 For::For(parser::Token token)
     : While(std::move(token)) {
 }
 
+const Variable* For::loop_variable() const {
+  if(define) {
+    if(const auto* var = define->definition.target<Variable>()) {
+      return var;
+    }
+  }
+  if(variable) {
+    const auto* op = variable->value.target<Operator>();
+
+    if(op && op->operation == Operation::ASSIGNMENT && op->left_operand) {
+      return op->left_operand->value.target<Variable>();
+    }
+  }
+  return nullptr;
+}
+
 bool For::operator==(const For& other) const {
   if(this == &other) {
     return true;
   } else if(While::operator==(other)) {
-    return define == other.define && variable == other.variable &&
-           operation == other.operation;
+    return parallel == other.parallel && define == other.define &&
+           variable == other.variable && operation == other.operation &&
+           reductions == other.reductions;
   }
   return false;
 }
@@ -21,9 +21,9 @@ While::While() {
 }
 While::While(const While& other)
     : Condition(other)
-    , scope((other.scope) ? std::make_unique<Scope>(*other.scope) : nullptr) {
+    , scope(other.scope) {
 }
-While::While(While&& other) {
+While::While(While&& other) noexcept {
   swap(*this, other);
 }
 While::While(parser::Token token)
@@ -0,0 +1,98 @@
+#include "cad/macro/interpreter/BatchProvider.h"
+
+#include <exception.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+BatchProvider::BatchProvider(std::size_t chunk_size)
+    : chunk_size_(std::max<std::size_t>(chunk_size, 1)) {
+}
+
+void BatchProvider::add(const std::string& scope, const std::string& name,
+                        Batch batch) {
+  auto& batches = batches_[scope];
+
+  if(batches.find(name) != batches.end()) {
+    Exc<E, E::BATCH_EXISTS> e(__FILE__, __LINE__, "Batch exists");
+    e << "The command '" << name << "' in the scope '" << scope
+      << "' has already a batch function.";
+    throw e;
+  }
+  batches.emplace(name, std::move(batch));
+}
+
+const BatchProvider::Batch*
+BatchProvider::find(const std::string& scope, const std::string& name) const {
+  const auto sit = batches_.find(scope);
+
+  if(sit != batches_.end()) {
+    const auto it = sit->second.find(name);
+
+    if(it != sit->second.end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+std::size_t BatchProvider::chunk_size() const {
+  return chunk_size_;
+}
+
+BatchQueue::BatchQueue(std::size_t chunk_size)
+    : batch_(nullptr)
+    , chunk_size_(chunk_size) {
+}
+
+BatchQueue::BatchQueue()
+    : batch_(nullptr)
+    , chunk_size_(0) {
+}
+
+void BatchQueue::add(const Batch& batch, Arguments row) {
+  if(chunk_size_ == 0) {
+    if(recorded_.empty() || recorded_.back().first != &batch) {
+      recorded_.emplace_back(&batch, std::vector<Arguments>());
+    }
+    recorded_.back().second.push_back(std::move(row));
+    return;
+  }
+  if(batch_ != &batch) {
+    flush();
+    batch_ = &batch;
+  }
+  rows_.push_back(std::move(row));
+  if(rows_.size() >= chunk_size_) {
+    flush();
+  }
+}
+
+void BatchQueue::flush() {
+  // the rows are gone even if the batch function throws
+  const auto* batch = batch_;
+  auto rows = std::move(rows_);
+
+  batch_ = nullptr;
+  rows_.clear();
+  if(!rows.empty()) {
+    (*batch)(rows);
+  }
+}
+
+void BatchQueue::replay(BatchQueue& queue) {
+  auto recorded = std::move(recorded_);
+
+  recorded_.clear();
+  for(auto& r : recorded) {
+    for(auto& row : r.second) {
+      queue.add(*r.first, std::move(row));
+    }
+  }
+}
+}
+}
+}
@@ -0,0 +1,54 @@
+#include "cad/macro/interpreter/Cancellation.h"
+
+#include "cad/macro/parser/Token.h"
+
+#include <exception.h>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+template <typename EXC>
+void add_location(const parser::Token& token, const std::string& file,
+                  EXC& e) {
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
+}
+}
+
+Cancellation::Cancellation()
+    : Cancellation(Clock::time_point::max()) {
+}
+
+Cancellation::Cancellation(Clock::time_point deadline)
+    : cancelled_(std::make_shared<std::atomic<bool>>(false))
+    , deadline_(deadline) {
+}
+
+void Cancellation::cancel() const {
+  cancelled_->store(true, std::memory_order_relaxed);
+}
+
+bool Cancellation::is_cancelled() const {
+  return cancelled_->load(std::memory_order_relaxed);
+}
+
+Cancellation::Clock::time_point Cancellation::deadline() const {
+  return deadline_;
+}
+
+void Cancellation::stop(const parser::Token& token,
+                        const std::string& file) const {
+  if(is_cancelled()) {
+    Exc<E, E::CANCELLED> e(__FILE__, __LINE__, "Cancelled");
+    add_location(token, file, e);
+    e << "The run was cancelled at the '" << token.text() << "'.";
+    throw e;
+  }
+  Exc<E, E::DEADLINE> e(__FILE__, __LINE__, "Deadline");
+  add_location(token, file, e);
+  e << "The deadline of the run passed at the '" << token.text() << "'.";
+  throw e;
+}
+}
+}
+}
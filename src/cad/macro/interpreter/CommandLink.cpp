@@ -0,0 +1,135 @@
+#include "cad/macro/interpreter/CommandLink.h"
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/Interpreter.h"
+
+#include <cad/core/command/CommandInvoker.h>
+#include <cad/core/command/argument/Arguments.h>
+
+#include <mutex>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+using namespace ast::callable;
+
+using E = Interpreter::E;
+
+template <typename FUN>
+void add_exception_info(const parser::Token& token, const std::string& file,
+                        Exc<E, E::TAIL>& e, FUN fun) {
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
+  fun();
+  if(token.has_source_line()) {
+    e << '\n'
+      << token.source_line() << '\n'
+      << std::string(token.column() - 1, ' ') << "^";
+  }
+}
+
+void add_signature(Exc<E, E::MISSING_FUNCTION>& e, const Callable& call) {
+  bool once = true;
+
+  e << "'" << call.token.text() << "(";
+  for(const auto& p : call.parameter) {
+    if(once) {
+      once = false;
+      e << p.first.token.text();
+    } else {
+      e << ", " << p.first.token.text();
+    }
+  }
+  e << ")'";
+}
+
+std::mutex& lookup_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+}
+
+CommandLink::Invoker CommandLink::lookup(CommandProvider& provider,
+                                         const std::string& scope,
+                                         const std::string& name) {
+  std::lock_guard<std::mutex> lock(lookup_mutex());
+  return provider.get_command(scope, name);
+}
+
+std::shared_ptr<const CommandLink>
+CommandLink::link(CommandProvider& provider, const BatchProvider* batches,
+                  std::size_t generation, const bytecode::Bytecode& code,
+                  const std::string& file, const std::string& scope) {
+  auto link = std::make_shared<CommandLink>();
+  std::vector<const Callable*> missing;
+
+  link->provider = &provider;
+  link->batches = batches;
+  link->generation = generation;
+  link->calls.resize(code.calls.size());
+
+  for(std::size_t i = 0; i < code.calls.size(); ++i) {
+    const auto& site = code.calls[i];
+    const auto& call = site.callable.get();
+
+    // a call site with a candidate is resolved when it is called
+    if(!site.candidates.empty()) {
+      continue;
+    }
+    try {
+      auto com = lookup(provider, scope, call.token.text().to_string());
+      const auto& command_args = com.arguments();
+      std::vector<bool> accepted;
+
+      accepted.reserve(call.parameter.size());
+      for(const auto& p : call.parameter) {
+        accepted.push_back(
+            command_args.has(p.first.token.text().to_string()));
+      }
+      const auto* batch =
+          batches ? batches->find(scope, call.token.text().to_string())
+                  : nullptr;
+      auto command = std::unique_ptr<Command>(
+          new Command{std::move(com), std::move(accepted), batch});
+
+      link->callables.emplace(&call, command.get());
+      link->calls[i] = std::move(command);
+    } catch(...) {
+      missing.push_back(&call);
+    }
+  }
+
+  if(!missing.empty()) {
+    try {
+      Exc<E, E::MISSING_FUNCTION> e(__FILE__, __LINE__, "Missing function");
+      e << "There was no matching function ";
+      for(std::size_t i = 0; i < missing.size(); ++i) {
+        if(i != 0) {
+          e << ", ";
+        }
+        add_signature(e, *missing[i]);
+      }
+      e << " in the scope '" << scope << "'.";
+      throw e;
+    } catch(std::exception&) {
+      const auto& token = missing.front()->token;
+
+      Exc<E, E::TAIL> e;
+      add_exception_info(token, file, e, [&e, &token]() {
+        e << "At the '" << token.text() << "' defined here";
+      });
+      std::throw_with_nested(e);
+    }
+  }
+  return link;
+}
+
+const CommandLink::Command*
+CommandLink::find(const ast::callable::Callable& call) const {
+  const auto it = callables.find(&call);
+
+  return it == callables.end() ? nullptr : it->second;
+}
+}
+}
+}
@@ -0,0 +1,66 @@
+#include "cad/macro/interpreter/CompiledMacro.h"
+
+#include "cad/macro/interpreter/Compiler.h"
+
+#include <cad/core/command/argument/Arguments.h>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+CompiledMacro::CompiledMacro(Interpreter interpreter, ast::Scope scope,
+                             std::string file_name)
+    : interpreter_(std::move(interpreter))
+    , scope_(std::move(scope))
+    , file_(std::move(file_name))
+    , bytecode_(Compiler().compile(scope_)) {
+}
+
+const ast::Scope& CompiledMacro::scope() const {
+  return scope_;
+}
+const std::string& CompiledMacro::file_name() const {
+  return file_;
+}
+const bytecode::Bytecode& CompiledMacro::bytecode() const {
+  return bytecode_;
+}
+const Interpreter& CompiledMacro::interpreter() const {
+  return interpreter_;
+}
+
+std::shared_ptr<const CommandLink>
+CompiledMacro::link(CommandProvider& provider, const BatchProvider* batches,
+                    std::size_t generation, const std::string& scope) const {
+  {
+    std::lock_guard<std::mutex> lock(links_mutex_);
+    const auto it = links_.find(scope);
+
+    if(it != links_.end() && it->second->provider == &provider
+       && it->second->batches == batches
+       && it->second->generation == generation) {
+      return it->second;
+    }
+  }
+  // linking asks the CommandProvider, this shouldn't block the other runs
+  auto link = CommandLink::link(provider, batches, generation, bytecode_, file_,
+                                scope);
+
+  std::lock_guard<std::mutex> lock(links_mutex_);
+  links_[scope] = link;
+  return link;
+}
+
+linb::any CompiledMacro::run(Arguments args, std::string scope,
+                             const Cancellation& cancellation) const {
+  return interpreter_.interpret(*this, std::move(args), std::move(scope),
+                                cancellation);
+}
+linb::any CompiledMacro::run(Arguments args, std::string scope,
+                             std::ostream& out,
+                             const Cancellation& cancellation) const {
+  return interpreter_.interpret(*this, std::move(args), std::move(scope), out,
+                                cancellation);
+}
+}
+}
+}
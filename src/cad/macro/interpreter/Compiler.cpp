@@ -0,0 +1,580 @@
+#include "cad/macro/interpreter/Compiler.h"
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+using namespace ast;
+using namespace ast::callable;
+using namespace ast::loop;
+using namespace ast::logic;
+
+using OpCode = bytecode::OpCode;
+using BiOp = OperatorProvider::BinaryOperation;
+using UnOp = OperatorProvider::UnaryOperation;
+
+std::uint32_t to_argument(const BiOp op) {
+  return static_cast<std::uint32_t>(op);
+}
+std::uint32_t to_argument(const UnOp op) {
+  return static_cast<std::uint32_t>(op);
+}
+
+/**
+ * @brief  Checks if the given call can call the given function - same as
+ *         Stack::find_function
+ */
+bool matches(const Callable& call, const Function& fun) {
+  if(fun.token.text() != call.token.text() ||
+     fun.parameter.size() != call.parameter.size()) {
+    return false;
+  }
+  for(const auto& fp : fun.parameter) {
+    auto it = std::find_if(call.parameter.begin(), call.parameter.end(),
+                           [&fp](const auto& cp) {
+                             return fp.token.text() == cp.first.token.text();
+                           });
+    if(it == call.parameter.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+bytecode::Bytecode Compiler::compile(const Scope& root) {
+  code_ = bytecode::Bytecode();
+  names_.clear();
+  loops_.clear();
+  parents_.clear();
+  definitions_.clear();
+  call_chunks_.clear();
+
+  chunk(0, root);
+
+  compile_shared(0, root);
+  emit(0, OpCode::END, 0, root.token);
+  resolve_calls();
+
+  return std::move(code_);
+}
+
+//////////////////////////////////////////
+/// Helper
+//////////////////////////////////////////
+std::uint32_t Compiler::name(const std::string& name) {
+  auto it = names_.find(name);
+
+  if(it == names_.end()) {
+    it = names_.emplace(name, code_.names.size()).first;
+    code_.names.push_back(name);
+  }
+  return it->second;
+}
+std::uint32_t Compiler::chunk(std::uint32_t parent, const Scope& body) {
+  const std::uint32_t chunk = code_.chunks.size();
+  code_.chunks.emplace_back();
+  parents_.push_back(parent);
+  definitions_.emplace_back();
+
+  // the Analyser assigned the slots of the variables
+  for(const auto name : body.frame.slots) {
+    code_.chunks[chunk].slots.push_back(name.to_string());
+  }
+  return chunk;
+}
+std::uint32_t Compiler::lookup(const Variable& var) {
+  return lookup(var.token.text().to_string(), var.address);
+}
+std::uint32_t Compiler::lookup(const std::string& name,
+                               const ast::Address& address) {
+  code_.lookups.push_back({this->name(name), {address.depth, address.slot}});
+  return code_.lookups.size() - 1;
+}
+std::uint32_t Compiler::definition(std::uint32_t chunk, const Function& fun) {
+  // the slot comes after the slots of the variables, they can't access it
+  auto& slots = code_.chunks[chunk].slots;
+  const std::uint32_t slot = slots.size();
+  slots.push_back(fun.token.text().to_string());
+
+  code_.definitions.push_back({fun, slot});
+  definitions_[chunk].push_back(code_.definitions.size() - 1);
+  return code_.definitions.size() - 1;
+}
+void Compiler::resolve_calls() {
+  for(std::size_t i = 0; i < code_.calls.size(); ++i) {
+    auto& call = code_.calls[i];
+    const auto& callable = call.callable.get();
+    auto chunk = call_chunks_[i];
+
+    for(std::uint32_t depth = 0;; ++depth) {
+      for(auto d : definitions_[chunk]) {
+        const auto& def = code_.definitions[d];
+        const auto& fun = def.function.get();
+
+        if(matches(callable, fun)) {
+          bytecode::Binding binding{depth, def.slot,
+                                    code_.function_chunks.at(&fun), {}, &fun};
+
+          for(const auto& p : callable.parameter) {
+            auto it = std::find_if(fun.parameter.begin(), fun.parameter.end(),
+                                   [&p](const Variable& var) {
+                                     return p.first.token.text() ==
+                                            var.token.text();
+                                   });
+            binding.parameter.push_back(it - fun.parameter.begin());
+          }
+          call.candidates.push_back(std::move(binding));
+        }
+      }
+      if(chunk == 0) {
+        break;
+      }
+      chunk = parents_[chunk];
+    }
+  }
+}
+std::uint32_t Compiler::constant(Value value) {
+  code_.constants.push_back(std::move(value));
+  return code_.constants.size() - 1;
+}
+std::size_t Compiler::emit(std::uint32_t chunk, OpCode code,
+                           std::uint32_t argument, const parser::Token& token) {
+  code_.tokens.push_back(token);
+
+  auto& instructions = code_.chunks[chunk].code;
+  instructions.push_back({code, argument,
+                          static_cast<std::uint32_t>(code_.tokens.size() - 1)});
+  return instructions.size() - 1;
+}
+std::uint32_t Compiler::here(std::uint32_t chunk) const {
+  return code_.chunks[chunk].code.size();
+}
+void Compiler::patch(std::uint32_t chunk, std::size_t instruction,
+                     std::uint32_t target) {
+  code_.chunks[chunk].code[instruction].argument = target;
+}
+void Compiler::compile_function(std::uint32_t parent, const Function& fun) {
+  if(code_.function_chunks.find(&fun) != code_.function_chunks.end()) {
+    return;
+  }
+  assert(fun.scope);
+
+  // the parameter are the first slots
+  const auto chunk = this->chunk(parent, *fun.scope);
+  code_.function_chunks.emplace(&fun, chunk);
+
+  // the outer variables the function assigns are copied on entry
+  const auto& slots = code_.chunks[chunk].slots;
+  for(const auto& s : fun.scope->frame.shadows) {
+    code_.shadows.push_back({lookup(slots[s.slot], s.outer), s.slot});
+    emit(chunk, OpCode::SHADOW, code_.shadows.size() - 1, fun.token);
+  }
+
+  // break and continue can't leave the function
+  std::vector<Loop> outer_loops;
+  std::swap(outer_loops, loops_);
+
+  compile_shared(chunk, *fun.scope);
+  emit(chunk, OpCode::END, 0, fun.token);
+
+  std::swap(outer_loops, loops_);
+}
+std::uint32_t Compiler::compile_parallel(std::uint32_t parent,
+                                         const For& foor) {
+  assert(foor.scope);
+  assert(foor.loop_variable()); /* analyser checked */
+
+  // the loop and the reduction variables are the first slots
+  const auto chunk = this->chunk(parent, *foor.scope);
+
+  bytecode::Parallel parallel{foor, chunk, {}, {}};
+  for(const auto& r : foor.reductions) {
+    parallel.lookups.push_back(lookup(r.variable));
+    parallel.stores.push_back(r.variable.address.slot);
+  }
+
+  // break and continue can't leave an iteration
+  std::vector<Loop> outer_loops;
+  std::swap(outer_loops, loops_);
+
+  compile_shared(chunk, *foor.scope);
+  emit(chunk, OpCode::END, 0, foor.token);
+
+  std::swap(outer_loops, loops_);
+
+  code_.parallels.push_back(std::move(parallel));
+  return code_.parallels.size() - 1;
+}
+
+//////////////////////////////////////////
+/// Compile values
+//////////////////////////////////////////
+void Compiler::compile(std::uint32_t chunk, const ValueProducer& vp) {
+  eggs::match(vp.value,
+              [&](const callable::Callable& o) { compile(chunk, o); },
+              [&](const Operator& o) { compile(chunk, o); },
+              [&](const Variable& o) {
+                emit(chunk, OpCode::LOAD, lookup(o), o.token);
+              },
+              [&](const Literal<Literals::BOOL>& o) {
+                emit(chunk, OpCode::CONSTANT, constant(Value(o.data)),
+                     o.token);
+              },
+              [&](const Literal<Literals::INT>& o) {
+                emit(chunk, OpCode::CONSTANT, constant(Value(o.data)),
+                     o.token);
+              },
+              [&](const Literal<Literals::DOUBLE>& o) {
+                emit(chunk, OpCode::CONSTANT, constant(Value(o.data)),
+                     o.token);
+              },
+              [&](const Literal<Literals::STRING>& o) {
+                emit(chunk, OpCode::CONSTANT, constant(Value(o.data)),
+                     o.token);
+              });
+}
+
+void Compiler::compile(std::uint32_t chunk, const Operator& op) {
+  auto binary = [&](const BiOp bi) {
+    assert(op.left_operand);
+    assert(op.right_operand);
+
+    compile(chunk, *op.left_operand);
+    compile(chunk, *op.right_operand);
+    emit(chunk, OpCode::BINARY, to_argument(bi), op.token);
+  };
+  // && and || only evaluate the right operand if it decides the result
+  auto logic = [&](const OpCode test) {
+    assert(op.left_operand);
+    assert(op.right_operand);
+
+    compile(chunk, *op.left_operand);
+    const auto to_end = emit(chunk, test, 0, op.token);
+    compile(chunk, *op.right_operand);
+    emit(chunk, OpCode::TO_BOOL, 0, op.token);
+    patch(chunk, to_end, here(chunk));
+  };
+  auto unary = [&](const UnOp un) {
+    assert(op.right_operand);
+
+    compile(chunk, *op.right_operand);
+    emit(chunk, OpCode::UNARY, to_argument(un), op.token);
+  };
+
+  switch(op.operation) {
+  case Operation::NONE:
+    assert(false); /* analyser checked */
+    break;
+  case Operation::DIVIDE:
+    binary(BiOp::DIVIDE);
+    break;
+  case Operation::MULTIPLY:
+    binary(BiOp::MULTIPLY);
+    break;
+  case Operation::MODULO:
+    binary(BiOp::MODULO);
+    break;
+  case Operation::ADD:
+    binary(BiOp::ADD);
+    break;
+  case Operation::SUBTRACT:
+    binary(BiOp::SUBTRACT);
+    break;
+  case Operation::SMALLER:
+    binary(BiOp::SMALLER);
+    break;
+  case Operation::SMALLER_EQUAL:
+    binary(BiOp::SMALLER_EQUAL);
+    break;
+  case Operation::GREATER:
+    binary(BiOp::GREATER);
+    break;
+  case Operation::GREATER_EQUAL:
+    binary(BiOp::GREATER_EQUAL);
+    break;
+  case Operation::EQUAL:
+    binary(BiOp::EQUAL);
+    break;
+  case Operation::NOT_EQUAL:
+    binary(BiOp::NOT_EQUAL);
+    break;
+  case Operation::AND:
+    logic(OpCode::JUMP_IF_FALSE_OR_POP);
+    break;
+  case Operation::OR:
+    logic(OpCode::JUMP_IF_TRUE_OR_POP);
+    break;
+  case Operation::ASSIGNMENT:
+    assert(op.left_operand);
+    assert(op.right_operand);
+
+    compile(chunk, *op.right_operand);
+    eggs::match(op.left_operand->value,
+                [&](const Variable& o) {
+                  // the Analyser resolved it to a slot of this Stack
+                  emit(chunk, OpCode::STORE, o.address.slot, op.token);
+                },
+                [&](const callable::Callable&) {
+                  assert(false); /* analyser checked */
+                },
+                [&](const Operator&) {
+                  assert(false); /* analyser checked */
+                },
+                [&](const Literal<Literals::BOOL>&) {
+                  assert(false); /* analyser checked */
+                },
+                [&](const Literal<Literals::INT>&) {
+                  assert(false); /* analyser checked */
+                },
+                [&](const Literal<Literals::DOUBLE>&) {
+                  assert(false); /* analyser checked */
+                },
+                [&](const Literal<Literals::STRING>&) {
+                  assert(false); /* analyser checked */
+                });
+    break;
+  case Operation::NOT:
+    unary(UnOp::NOT);
+    break;
+  case Operation::TYPEOF:
+    unary(UnOp::TYPEOF);
+    break;
+  case Operation::PRINT:
+    assert(op.right_operand);
+
+    compile(chunk, *op.right_operand);
+    emit(chunk, OpCode::PRINT, 0, op.token);
+    break;
+  case Operation::NEGATIVE:
+    unary(UnOp::NEGATIVE);
+    break;
+  case Operation::POSITIVE:
+    unary(UnOp::POSITIVE);
+    break;
+  }
+}
+
+void Compiler::compile(std::uint32_t chunk, const Callable& call) {
+  for(const auto& p : call.parameter) {
+    compile(chunk, p.second);
+  }
+  code_.calls.push_back({call, {}});
+  call_chunks_.push_back(chunk);
+  emit(chunk, OpCode::CALL, code_.calls.size() - 1, call.token);
+}
+
+//////////////////////////////////////////
+/// Compile statements
+//////////////////////////////////////////
+void Compiler::compile(std::uint32_t chunk, const loop::Break& br) {
+  assert(!loops_.empty()); /* analyser checked */
+  loops_.back().breaks.push_back(emit(chunk, OpCode::JUMP, 0, br.token));
+}
+void Compiler::compile(std::uint32_t chunk, const loop::Continue& con) {
+  assert(!loops_.empty()); /* analyser checked */
+  loops_.back().continues.push_back(emit(chunk, OpCode::JUMP, 0, con.token));
+}
+void Compiler::compile(std::uint32_t chunk, const If& iff) {
+  assert(iff.condition);
+  assert(iff.true_scope);
+
+  compile(chunk, *iff.condition);
+  auto to_false = emit(chunk, OpCode::JUMP_IF_FALSE, 0, iff.token);
+
+  compile(chunk, *iff.true_scope);
+  auto to_end = emit(chunk, OpCode::JUMP, 0, iff.token);
+
+  patch(chunk, to_false, here(chunk));
+  if(iff.false_scope) {
+    compile(chunk, *iff.false_scope);
+  } else {
+    emit(chunk, OpCode::CLEAR_RESULT, 0, iff.token);
+  }
+  patch(chunk, to_end, here(chunk));
+}
+void Compiler::compile(std::uint32_t chunk, const DoWhile& whi) {
+  assert(whi.condition);
+  assert(whi.scope);
+
+  loops_.emplace_back();
+
+  const auto body = here(chunk);
+  compile(chunk, *whi.scope);
+
+  const auto condition = here(chunk);
+  compile(chunk, *whi.condition);
+  auto to_end = emit(chunk, OpCode::JUMP_IF_FALSE, 0, whi.token);
+  emit(chunk, OpCode::JUMP, body, whi.token);
+
+  const auto end = here(chunk);
+  patch(chunk, to_end, end);
+  for(auto b : loops_.back().breaks) {
+    patch(chunk, b, end);
+  }
+  for(auto c : loops_.back().continues) {
+    patch(chunk, c, condition);
+  }
+  loops_.pop_back();
+}
+void Compiler::compile(std::uint32_t chunk, const For& foor) {
+  assert(foor.scope);
+
+  if(foor.define) {
+    eggs::match(foor.define->definition,
+                [&](const Variable& var) {
+                  emit(chunk, OpCode::DEFINE_VARIABLE, var.address.slot,
+                       var.token);
+                },
+                [&](const Function&) {}, [&](const EntryFunction&) {});
+  }
+  if(foor.variable) {
+    compile(chunk, *foor.variable);
+    emit(chunk, OpCode::POP, 0, foor.token);
+  }
+  emit(chunk, OpCode::CLEAR_RESULT, 0, foor.token);
+
+  if(foor.parallel) {
+    // the values of the loop variable are collected before the iterations
+    // are executed
+    assert(foor.condition); /* analyser checked */
+
+    const auto parallel = compile_parallel(chunk, foor);
+    const auto& var = *foor.loop_variable();
+    const auto condition = here(chunk);
+    compile(chunk, *foor.condition);
+    const auto to_end = emit(chunk, OpCode::JUMP_IF_FALSE, 0, foor.token);
+
+    emit(chunk, OpCode::LOAD, lookup(var), var.token);
+    emit(chunk, OpCode::ITERATION, 0, foor.token);
+    if(foor.operation) {
+      compile(chunk, *foor.operation);
+      emit(chunk, OpCode::POP, 0, foor.token);
+    }
+    emit(chunk, OpCode::JUMP, condition, foor.token);
+
+    patch(chunk, to_end, here(chunk));
+    emit(chunk, OpCode::PARALLEL, parallel, foor.token);
+    return;
+  }
+
+  loops_.emplace_back();
+
+  const auto condition = here(chunk);
+  std::size_t to_end = 0;
+  if(foor.condition) {
+    compile(chunk, *foor.condition);
+    to_end = emit(chunk, OpCode::JUMP_IF_FALSE, 0, foor.token);
+  }
+
+  compile(chunk, *foor.scope);
+
+  const auto operation = here(chunk);
+  if(foor.operation) {
+    compile(chunk, *foor.operation);
+    emit(chunk, OpCode::SET_RESULT, 0, foor.token);
+  }
+  emit(chunk, OpCode::JUMP, condition, foor.token);
+
+  const auto end = here(chunk);
+  if(foor.condition) {
+    patch(chunk, to_end, end);
+  }
+  for(auto b : loops_.back().breaks) {
+    patch(chunk, b, end);
+  }
+  for(auto c : loops_.back().continues) {
+    patch(chunk, c, operation);
+  }
+  loops_.pop_back();
+}
+void Compiler::compile(std::uint32_t chunk, const While& whi) {
+  assert(whi.condition);
+  assert(whi.scope);
+
+  emit(chunk, OpCode::CLEAR_RESULT, 0, whi.token);
+
+  loops_.emplace_back();
+
+  const auto condition = here(chunk);
+  compile(chunk, *whi.condition);
+  auto to_end = emit(chunk, OpCode::JUMP_IF_FALSE, 0, whi.token);
+
+  compile(chunk, *whi.scope);
+  emit(chunk, OpCode::JUMP, condition, whi.token);
+
+  const auto end = here(chunk);
+  patch(chunk, to_end, end);
+  for(auto b : loops_.back().breaks) {
+    patch(chunk, b, end);
+  }
+  for(auto c : loops_.back().continues) {
+    patch(chunk, c, condition);
+  }
+  loops_.pop_back();
+}
+void Compiler::compile(std::uint32_t chunk, const callable::Return& ret) {
+  assert(ret.output);
+
+  compile(chunk, *ret.output);
+  emit(chunk, OpCode::RETURN, 0, ret.token);
+}
+void Compiler::compile(std::uint32_t chunk, const Scope& scope) {
+  emit(chunk, OpCode::CLEAR_RESULT, 0, scope.token);
+  compile_shared(chunk, scope);
+}
+void Compiler::compile_shared(std::uint32_t chunk, const Scope& scope) {
+  // functions are defined before anything else in the scope is executed, their
+  // bodies see the variables that are defined before them
+  for(std::size_t i = 0; i < scope.functions.size(); ++i) {
+    const auto& fun = scope.function(i);
+
+    emit(chunk, OpCode::DEFINE_FUNCTION, definition(chunk, fun), fun.token);
+  }
+
+  for(const auto& n : scope.nodes) {
+    eggs::match(
+        n,
+        [&](const Define& e) {
+          eggs::match(e.definition,
+                      [&](const Variable& var) {
+                        emit(chunk, OpCode::DEFINE_VARIABLE, var.address.slot,
+                             var.token);
+                      },
+                      [&](const Function& fun) { compile_function(chunk, fun); },
+                      [&](const EntryFunction& fun) {
+                        compile_function(chunk, fun);
+                      });
+        },
+        [&](const Operator& e) {
+          compile(chunk, e);
+          emit(chunk, OpCode::POP, 0, e.token);
+        },
+        [&](const loop::Break& e) { compile(chunk, e); },
+        [&](const loop::Continue& e) { compile(chunk, e); },
+        [&](const Callable& e) {
+          compile(chunk, e);
+          emit(chunk, OpCode::POP, 0, e.token);
+        },
+        [&](const DoWhile& e) { compile(chunk, e); },
+        [&](const For& e) { compile(chunk, e); },
+        [&](const If& e) { compile(chunk, e); },
+        [&](const Literal<Literals::BOOL>&) { /* ignore */ },
+        [&](const Literal<Literals::DOUBLE>&) { /* ignore */ },
+        [&](const Literal<Literals::INT>&) { /* ignore */ },
+        [&](const Literal<Literals::STRING>&) { /* ignore */ },
+        [&](const callable::Return& e) { compile(chunk, e); },
+        [&](const Scope& e) { compile(chunk, e); },
+        [&](const While& e) { compile(chunk, e); },
+        [&](const Variable&) { /* ignore */ });
+  }
+}
+}
+}
+}
@@ -0,0 +1,154 @@
+#include "cad/macro/interpreter/Execution.h"
+
+#include "cad/macro/interpreter/CommandLink.h"
+#include "cad/macro/interpreter/CompiledMacro.h"
+
+#include <exception.h>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+Execution::Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+                     std::string scope)
+    : Execution(std::move(macro), std::move(args), std::move(scope), Budget()) {
+}
+
+Execution::Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+                     std::string scope, Budget budget,
+                     Cancellation cancellation)
+    : Execution(macro, std::move(args), std::move(scope), budget,
+                macro->interpreter().out_.get(), std::move(cancellation)) {
+}
+
+Execution::Execution(std::shared_ptr<const CompiledMacro> macro, Arguments args,
+                     std::string scope, Budget budget, std::ostream& out,
+                     Cancellation cancellation)
+    : macro_(std::move(macro))
+    , interpreter_(macro_->interpreter())
+    , budget_(budget)
+    , scope_(std::move(scope))
+    , out_(out)
+    , args_(std::move(args))
+    , cancellation_(std::move(cancellation))
+    , probe_(cancellation_)
+    // missing core::Command instances are reported before anything is executed
+    , commands_(interpreter_.command_provider_
+                    ? macro_->link(*interpreter_.command_provider_,
+                                   interpreter_.batch_provider_.get(),
+                                   *interpreter_.command_generation_, scope_)
+                    : nullptr)
+    , batches_(interpreter_.batch_provider_
+                   ? interpreter_.batch_provider_->chunk_size()
+                   : 1)
+    , root_(frames_, nullptr, macro_->bytecode().chunks[0].slots.size())
+    , vm_(interpreter_)
+    , context_{macro_->bytecode(),
+               macro_->file_name(),
+               scope_,
+               frames_,
+               commands_.get(),
+               batches_,
+               futures_,
+               out_.get(),
+               probe_}
+    , phase_(Phase::ROOT) {
+  if(interpreter_.backend_ == Interpreter::Backend::BYTECODE) {
+    continuation_.activations.push_back(
+        {0, 0, &root_.stack(), nullptr, false, false, 0, Value(), {}});
+  }
+}
+
+Execution::~Execution() {
+  if(phase_ != Phase::DONE) {
+    vm_.clear(context_, continuation_);
+    // the calls before the abandonment were made
+    futures_.wait();
+    try {
+      batches_.flush();
+    } catch(...) {
+    }
+  }
+}
+
+void Execution::fail() {
+  error_ = std::current_exception();
+  phase_ = Phase::DONE;
+  // the calls before the error were made
+  futures_.wait();
+  try {
+    batches_.flush();
+  } catch(...) {
+  }
+}
+
+bool Execution::resume() {
+  if(phase_ == Phase::DONE) {
+    return true;
+  }
+  if(interpreter_.backend_ == Interpreter::Backend::TREE) {
+    try {
+      result_ = interpreter_.interpret(*macro_, std::move(args_), scope_,
+                                       out_.get(), cancellation_);
+      phase_ = Phase::DONE;
+    } catch(...) {
+      error_ = std::current_exception();
+      phase_ = Phase::DONE;
+    }
+    return true;
+  }
+
+  const auto deadline =
+      budget_.time.count() == 0
+          ? VM::Clock::time_point::max()
+          : VM::Clock::now()
+                + std::chrono::duration_cast<VM::Clock::duration>(budget_.time);
+  std::size_t executed = 0;
+
+  try {
+    if(!vm_.step(context_, continuation_, budget_.steps, deadline, executed)) {
+      return false;
+    }
+    if(phase_ == Phase::ROOT) {
+      phase_ = Phase::MAIN;
+      vm_.enter_main(context_, continuation_, root_.stack(), std::move(args_));
+      // the main function gets what the root chunk left of the budget
+      if(budget_.steps != 0 && executed == budget_.steps) {
+        return false;
+      }
+      const auto steps = budget_.steps == 0 ? 0 : budget_.steps - executed;
+
+      if(!vm_.step(context_, continuation_, steps, deadline, executed)) {
+        return false;
+      }
+    }
+
+    result_ = continuation_.result.to_any();
+    Future::join(result_);
+    futures_.join(macro_->file_name());
+    batches_.flush();
+    phase_ = Phase::DONE;
+  } catch(...) {
+    fail();
+  }
+  return true;
+}
+
+bool Execution::is_done() const {
+  return phase_ == Phase::DONE;
+}
+
+const linb::any& Execution::result() const {
+  if(phase_ != Phase::DONE) {
+    Exc<E, E::NOT_DONE> e(__FILE__, __LINE__, "Not done");
+    e << "The execution of '" << macro_->file_name()
+      << "' has to be resumed until it is done before its result can be read.";
+    throw e;
+  }
+  if(error_) {
+    std::rethrow_exception(error_);
+  }
+  return result_;
+}
+}
+}
+}
@@ -0,0 +1,29 @@
+#include "cad/macro/interpreter/FrameArena.h"
+
+#include <cassert>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+FrameArena::FrameArena()
+    : size_(0) {
+}
+
+Stack& FrameArena::push(Stack* parent, std::size_t slots,
+                        std::size_t variables) {
+  if(size_ == frames_.size()) {
+    frames_.emplace_back();  // deque - the other frames don't move
+  }
+  auto& stack = frames_[size_++];
+  stack.reset(parent, slots, variables);
+  return stack;
+}
+
+void FrameArena::pop(Stack& stack) {
+  assert(size_ > 0 && &frames_[size_ - 1] == &stack && "Not LIFO");
+  --size_;
+  stack.reset(nullptr, 0);  // release the values now, not on the next push
+}
+}
+}
+}
@@ -0,0 +1,99 @@
+#include "cad/macro/interpreter/Future.h"
+
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/parser/Token.h"
+
+#include <exception.h>
+
+#include <memory>
+#include <typeinfo>
+#include <utility>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+template <typename FUN>
+void add_exception_info(const parser::Token& token, const std::string& file,
+                        Exc<Interpreter::E, Interpreter::E::TAIL>& e, FUN fun) {
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
+  fun();
+  if(token.has_source_line()) {
+    e << '\n'
+      << token.source_line() << '\n'
+      << std::string(token.column() - 1, ' ') << "^";
+  }
+}
+}
+
+Future::Future(std::shared_future<linb::any> future)
+    : future_(std::move(future)) {
+}
+
+linb::any Future::get() const {
+  return future_.get();
+}
+
+void Future::join(linb::any& any) {
+  if(any.type() == typeid(Future)) {
+    any = linb::any_cast<const Future&>(any).get();
+  }
+}
+
+void Future::join(Value& value) {
+  if(value.type() == Value::Type::BOXED
+     && value.type_info() == typeid(Future)) {
+    const auto& future = linb::any_cast<const Future&>(value.as_boxed());
+    value = Value::from_any(future.get());
+  }
+}
+
+Future Futures::launch(const Future::Executor& executor,
+                       const parser::Token& token,
+                       std::function<linb::any()> task) {
+  auto promise = std::make_shared<std::promise<linb::any>>();
+  std::shared_future<linb::any> future = promise->get_future().share();
+
+  pending_.push_back({future, token});
+  executor([promise, task]() {
+    try {
+      promise->set_value(task());
+    } catch(...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return Future(std::move(future));
+}
+
+void Futures::wait() noexcept {
+  for(const auto& p : pending_) {
+    p.future.wait();
+  }
+  pending_.clear();
+}
+
+void Futures::join(const std::string& file) {
+  // all tasks have to be done before an error is reported
+  auto pending = std::move(pending_);
+  pending_.clear();
+
+  for(const auto& p : pending) {
+    p.future.wait();
+  }
+  for(const auto& p : pending) {
+    try {
+      p.future.get();
+    } catch(std::exception&) {
+      const auto& token = p.token.get();
+
+      Exc<Interpreter::E, Interpreter::E::TAIL> e;
+      add_exception_info(token, file, e, [&e, &token]() {
+        e << "In the async call '" << token.text() << "' defined here";
+      });
+      std::throw_with_nested(e);
+    }
+  }
+}
+}
+}
+}
@@ -1,15 +1,25 @@
 #include "cad/macro/interpreter/Interpreter.h"
 
 #include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/BatchProvider.h"
+#include "cad/macro/interpreter/CommandLink.h"
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/FrameArena.h"
 #include "cad/macro/interpreter/OperatorProvider.h"
+#include "cad/macro/interpreter/Scheduler.h"
 #include "cad/macro/interpreter/Stack.h"
+#include "cad/macro/interpreter/VM.h"
 #include "cad/macro/parser/Parser.h"
 
 #include <cad/core/command/CommandInvoker.h>
 #include <cad/core/command/CommandProvider.h>
 #include <cad/core/command/argument/Arguments.h>
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
+#include <sstream>
+#include <thread>
 
 namespace cad {
 namespace macro {
@@ -23,38 +33,103 @@ using namespace ast::logic;
 template <typename FUN>
 void add_exception_info(const parser::Token& token, const std::string& file,
                         Exc<Interpreter::E, Interpreter::E::TAIL>& e, FUN fun) {
-  e << file << ':' << token.line << ':' << token.column << ": ";
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
   fun();
-  if(token.source_line) {
+  if(token.has_source_line()) {
     e << '\n'
-      << *token.source_line << '\n'
-      << std::string(token.column - 1, ' ') << "^";
+      << token.source_line() << '\n'
+      << std::string(token.column() - 1, ' ') << "^";
   }
 }
+
+// The value the reduction variable of an iteration starts with - a sum
+// starts at the zero of the type of the outer variable, the minimum and the
+// maximum at the outer variable. Both leave the combined result unchanged.
+linb::any seed(For::Reduction::Kind kind, const linb::any& outer) {
+  using Kind = For::Reduction::Kind;
+
+  switch(kind) {
+  case Kind::SUM:
+    if(outer.type() == typeid(int)) {
+      return 0;
+    } else if(outer.type() == typeid(double)) {
+      return 0.0;
+    } else if(outer.type() == typeid(std::string)) {
+      return std::string();
+    }
+    return {};
+  case Kind::MIN:
+  case Kind::MAX:
+    return outer;
+  case Kind::COLLECT:
+    break;
+  }
+  return {};
 }
 
+// Checks if the iterations can start the reduction independently - a sum of
+// a type without a zero, e.g. bool or a user type, can only continue the sum
+// of the previous iteration like the sequential loop does
+bool split(For::Reduction::Kind kind, const linb::any& outer) {
+  return kind != For::Reduction::Kind::SUM || outer.type() == typeid(int) ||
+         outer.type() == typeid(double) ||
+         outer.type() == typeid(std::string);
+}
+
+// a function reads the outer variables it assigns through its own slots until
+// it assigns them
+void shadow(Stack& stack, const Scope& body) {
+  for(const auto& s : body.frame.shadows) {
+    const auto name = body.frame.slots[s.slot];
+    stack.add_alias(s.slot, name, stack.variable(s.outer, name));
+  }
+}
+}
+
+// Copied for every ast::Scope, the strings are owned by the caller of
+// interpret(const CompiledMacro&, ...) and the Stack by the FrameArena
 struct Interpreter::State {
-  std::shared_ptr<Stack> stack;
-  std::string scope;
-  std::string file;
+  FrameArena& frames;
+  Stack* stack;
+  const std::string& scope;
+  const std::string& file;
+  const CommandLink* commands;
+  BatchQueue& batches;
+  Futures& futures;
+  std::ostream& out;
+  Cancellation::Probe& probe;
   bool breaking;
   bool continuing;
   bool loopscope;
   bool returning;
 
-  State(std::string s, std::string f)
-      : stack(std::make_shared<Stack>())
-      , scope(std::move(s))
-      , file(std::move(f))
+  State(FrameArena& a, Stack& s, const std::string& sc, const std::string& f,
+        const CommandLink* c, BatchQueue& b, Futures& fu, std::ostream& o,
+        Cancellation::Probe& p)
+      : frames(a)
+      , stack(&s)
+      , scope(sc)
+      , file(f)
+      , commands(c)
+      , batches(b)
+      , futures(fu)
+      , out(o)
+      , probe(p)
       , breaking(false)
       , continuing(false)
       , loopscope(false)
       , returning(false) {
   }
-  State(const State& other, std::shared_ptr<Stack> s)
-      : stack(std::move(s))
+  State(const State& other, Stack& s)
+      : frames(other.frames)
+      , stack(&s)
       , scope(other.scope)
       , file(other.file)
+      , commands(other.commands)
+      , batches(other.batches)
+      , futures(other.futures)
+      , out(other.out)
+      , probe(other.probe)
       , breaking(other.breaking)
       , continuing(other.continuing)
       , loopscope(other.loopscope)
@@ -79,17 +154,112 @@ Interpreter::Interpreter(std::shared_ptr<CommandProvider> command_provider,
                          std::ostream& out)
     : command_provider_(std::move(command_provider))
     , operator_provider_(std::move(operator_provider))
-    , out_(out) {
+    , executor_([](std::function<void()> task) { task(); })
+    , workers_(std::max(std::thread::hardware_concurrency(), 1u))
+    , command_generation_(std::make_shared<std::atomic<std::size_t>>(0))
+    , out_(out)
+    , backend_(Backend::BYTECODE)
+    , folding_(true) {
+}
+
+void Interpreter::set_backend(Backend backend) {
+  backend_ = backend;
+}
+Interpreter::Backend Interpreter::backend() const {
+  return backend_;
+}
+void Interpreter::set_folding(bool folding) {
+  folding_ = folding;
+}
+bool Interpreter::folding() const {
+  return folding_;
+}
+void Interpreter::set_batch_provider(
+    std::shared_ptr<BatchProvider> batch_provider) {
+  batch_provider_ = std::move(batch_provider);
+}
+const std::shared_ptr<BatchProvider>& Interpreter::batch_provider() const {
+  return batch_provider_;
+}
+void Interpreter::set_executor(Future::Executor executor) {
+  executor_ = std::move(executor);
+}
+const Future::Executor& Interpreter::executor() const {
+  return executor_;
+}
+void Interpreter::set_workers(std::size_t workers) {
+  workers_ = std::max<std::size_t>(workers, 1);
+}
+std::size_t Interpreter::workers() const {
+  return workers_;
+}
+void Interpreter::invalidate_commands() const {
+  ++*command_generation_;
 }
 
 linb::any Interpreter::interpret(std::string macro, Arguments args,
                                  std::string command_scope,
-                                 std::string file_name) const {
-  auto scope = parser::parse(macro, file_name);
-  State state(std::move(command_scope), file_name);
+                                 std::string file_name,
+                                 const Cancellation& cancellation) const {
+  return compile(std::move(macro), std::move(file_name))
+      ->run(std::move(args), std::move(command_scope), cancellation);
+}
+
+linb::any Interpreter::interpret(const CompiledMacro& macro, Arguments args,
+                                 std::string command_scope,
+                                 const Cancellation& cancellation) const {
+  return interpret(macro, std::move(args), std::move(command_scope),
+                   out_.get(), cancellation);
+}
+
+linb::any Interpreter::interpret(const CompiledMacro& macro, Arguments args,
+                                 std::string command_scope, std::ostream& out,
+                                 const Cancellation& cancellation) const {
+  // missing core::Command instances are reported before anything is executed
+  std::shared_ptr<const CommandLink> commands;
+  if(command_provider_) {
+    commands = macro.link(*command_provider_, batch_provider_.get(),
+                          *command_generation_, command_scope);
+  }
+
+  if(backend_ == Backend::BYTECODE) {
+    return VM(*this).run(macro.bytecode(), macro.file_name(), std::move(args),
+                         command_scope, out, commands.get(), cancellation);
+  }
+
+  FrameArena frames;
+  FrameArena::Frame root(frames, nullptr, 0,
+                         macro.scope().frame.slots.size());
+  BatchQueue batches(batch_provider_ ? batch_provider_->chunk_size() : 1);
+  Futures futures;
+  Cancellation::Probe probe(cancellation);
+  State state(frames, root.stack(), command_scope, macro.file_name(),
+              commands.get(), batches, futures, out, probe);
+
+  linb::any ret;
+  try {
+    interpret(state, macro.scope());
+    ret = interpret_main(state, std::move(args));
+    Future::join(ret);
+    futures.join(macro.file_name());
+  } catch(...) {
+    // the calls before the error were made
+    futures.wait();
+    batches.flush();
+    throw;
+  }
+  batches.flush();
+  return ret;
+}
 
-  interpret(state, scope);
-  return interpret_main(state, std::move(args));
+std::shared_ptr<const CompiledMacro>
+Interpreter::compile(std::string macro, std::string file_name) const {
+  // folding uses the same OperatorProvider the macro will be interpreted with
+  auto scope = parser::parse(std::move(macro), file_name,
+                             folding_ ? operator_provider_.get() : nullptr);
+
+  return std::make_shared<const CompiledMacro>(*this, std::move(scope),
+                                               std::move(file_name));
 }
 
 //////////////////////////////////////////
@@ -117,37 +287,14 @@ bool Interpreter::any_to_bool(const linb::any& any) const {
 /// define
 //////////////////////////////////////////
 void Interpreter::define_functions(State& state, const Scope& scope) const {
-  for(const auto& n : scope.nodes) {
-    eggs::match(n, [this, &state](
-                       const Define& def) { define_function(state, def); },  //
-                [this](const loop::Continue&) {},                            //
-                [this](const loop::Break&) {},                               //
-                [this](const Callable&) {},                                  //
-                [this](const DoWhile&) {},                                   //
-                [this](const For&) {},                                       //
-                [this](const If&) {},                                        //
-                [this](const Literal<Literals::BOOL>&) {},                   //
-                [this](const Literal<Literals::DOUBLE>&) {},                 //
-                [this](const Literal<Literals::INT>&) {},                    //
-                [this](const Literal<Literals::STRING>&) {},                 //
-                [this](const callable::Return&) {},                          //
-                [this](const Scope&) {},                                     //
-                [this](const Operator&) {},                                  //
-                [this](const While&) {},                                     //
-                [this](const Variable&) {}                                   //
-                );                                                           //
-  }
-}
-void Interpreter::define_function(State& state, const Define& def) const {
-  eggs::match(def.definition,
-              [&](const Function& fun) { state.stack->add_function(fun); },
-              [&](const EntryFunction& fun) { state.stack->add_function(fun); },
-              [&](const Variable&) {});
+  state.stack->add_functions(scope);
 }
 void Interpreter::define_variable(State& state, const Define& def) const {
   eggs::match(
       def.definition,
-      [&](const Variable& var) { state.stack->add_variable(var.token.token); },
+      [&](const Variable& var) {
+        state.stack->add_variable(var.address.slot, var.token.text());
+      },
       [&](const Function&) {}, [&](const EntryFunction&) {});
 }
 
@@ -248,18 +395,18 @@ linb::any Interpreter::interpret_not_equal(State& state,
   return operator_provider_->eval(BiOp::NOT_EQUAL, lhs, rhs);
 }
 linb::any Interpreter::interpret_and(State& state, const Operator& op) const {
-  auto lhs = interpret(state, *op.left_operand);
-  auto rhs = interpret(state, *op.right_operand);
-
-  using BiOp = OperatorProvider::BinaryOperation;
-  return operator_provider_->eval(BiOp::AND, lhs, rhs);
+  // same conversion as OperatorProvider::eval_and but short-circuiting
+  return operator_provider_->to_bool(
+             Value::from_any(interpret(state, *op.left_operand))) &&
+         operator_provider_->to_bool(
+             Value::from_any(interpret(state, *op.right_operand)));
 }
 linb::any Interpreter::interpret_or(State& state, const Operator& op) const {
-  auto lhs = interpret(state, *op.left_operand);
-  auto rhs = interpret(state, *op.right_operand);
-
-  using BiOp = OperatorProvider::BinaryOperation;
-  return operator_provider_->eval(BiOp::OR, lhs, rhs);
+  // same conversion as OperatorProvider::eval_or but short-circuiting
+  return operator_provider_->to_bool(
+             Value::from_any(interpret(state, *op.left_operand))) ||
+         operator_provider_->to_bool(
+             Value::from_any(interpret(state, *op.right_operand)));
 }
 linb::any Interpreter::interpret_assignment(State& state,
                                             const Operator& op) const {
@@ -269,12 +416,9 @@ linb::any Interpreter::interpret_assignment(State& state,
               [&](const callable::Callable& o) { rh = interpret(state, o); },
               [&](const Operator& o) { rh = interpret(state, o); },
               [&](const Variable& o) {
-                if(state.stack->has_variable(o.token.token)) {
-                  state.stack->variable(o.token.token,
-                                        [&](linb::any& var) { rh = var; });
-                } else {
-                  assert(false); /* analyser checked */
-                }
+                auto& var = state.stack->variable(o.address, o.token.text());
+                Future::join(var);
+                rh = var;
               },
               [&](const Literal<Literals::BOOL>& o) { rh = o.data; },
               [&](const Literal<Literals::INT>& o) { rh = o.data; },
@@ -289,15 +433,8 @@ linb::any Interpreter::interpret_assignment(State& state,
                 assert(false); /* analyser checked */
               },
               [&](const Variable& o) {
-                // TODO improve check for owning. at the moment we check if this
-                // scope owns the variable. But we should check if any stack up
-                // to the point where the returning stops owns the variable
-                if(!state.stack->owns_variable(o.token.token)) {
-                  state.stack->remove_alias(o.token.token);
-                  state.stack->add_variable(o.token.token);
-                }
-                state.stack->variable(o.token.token,
-                                      [&](linb::any& var) { var = rh; });
+                // the Analyser resolved it to a slot of this Stack
+                state.stack->assign(o.address.slot) = rh;
               },
               [&](const Literal<Literals::BOOL>&) {
                 assert(false); /* analyser checked */
@@ -361,7 +498,7 @@ linb::any Interpreter::interpret(State& state, const Operator& op) const {
   } catch(std::exception&) {
     Exc<E, E::TAIL> e;
     add_exception_info(op.token, state.file, e, [&e, &op]() {
-      e << "At the operator '" << op.token.token << "' defined here";
+      e << "At the operator '" << op.token.text() << "' defined here";
     });
     std::throw_with_nested(e);
   }
@@ -390,7 +527,8 @@ linb::any Interpreter::interpret_print(State& state, const Operator& op) const {
   using UnOp = OperatorProvider::UnaryOperation;
   auto res =
       linb::any_cast<std::string>(operator_provider_->eval(UnOp::PRINT, rhs));
-  out_.get() << res;
+  state.batches.flush();
+  state.out << res;
   return res;
 }
 linb::any Interpreter::interpret_negative(State& state,
@@ -421,12 +559,9 @@ Interpreter::SmartRef Interpreter::interpret(State& state,
       [&](const callable::Callable& o) { f.value = interpret(state, o); },
       [&](const Operator& o) { f.value = interpret(state, o); },
       [&](const Variable& o) {
-        if(state.stack->has_variable(o.token.token)) {
-          return state.stack->variable(o.token.token,
-                                       [&](linb::any& var) { f.ref = var; });
-        } else {
-          assert(false); /* analyser checked */
-        }
+        auto& var = state.stack->variable(o.address, o.token.text());
+        Future::join(var);
+        f.ref = var;
       },
       [&](const Literal<Literals::BOOL>& o) { f.value = linb::any(o.data); },
       [&](const Literal<Literals::INT>& o) { f.value = linb::any(o.data); },
@@ -489,6 +624,9 @@ linb::any Interpreter::interpret(State& state,
     State inner(state);
     inner.loopscope = true;
     auto ret = interpret_shared(inner, *whi.scope);
+    if(inner.continuing) {
+      inner.continuing = false;
+    }
 
     while(!inner.returning && !inner.breaking &&
           any_to_bool(interpret(inner, *whi.condition))) {
@@ -496,6 +634,7 @@ linb::any Interpreter::interpret(State& state,
       if(inner.continuing) {
         inner.continuing = false;
       }
+      inner.probe.check(whi.token, state.file);
     }
     if(inner.returning) {
       state.returning = true;
@@ -510,6 +649,9 @@ linb::any Interpreter::interpret(State& state,
 }
 linb::any Interpreter::interpret(State& state,
                                  const ast::loop::For& foor) const {
+  if(foor.parallel) {
+    return interpret_parallel(state, foor);
+  }
   try {
     State inner(state);
     inner.loopscope = true;
@@ -525,10 +667,14 @@ linb::any Interpreter::interpret(State& state,
     while(!inner.returning && !inner.breaking &&
           any_to_bool(interpret(inner, *foor.condition))) {
       ret = interpret_shared(inner, *foor.scope);
+      if(inner.returning || inner.breaking) {
+        break;
+      }
       ret = interpret(inner, *foor.operation);
       if(inner.continuing) {
         inner.continuing = false;
       }
+      inner.probe.check(foor.token, state.file);
     }
     if(inner.returning) {
       state.returning = true;
@@ -541,6 +687,191 @@ linb::any Interpreter::interpret(State& state,
     std::throw_with_nested(e);
   }
 }
+linb::any Interpreter::interpret_parallel(State& state,
+                                          const ast::loop::For& foor) const {
+  using Kind = For::Reduction::Kind;
+  using BiOp = OperatorProvider::BinaryOperation;
+
+  struct Worker {
+    FrameArena frames;
+    Futures futures;
+    Cancellation::Probe probe;
+
+    Worker(const Cancellation& cancellation)
+        : probe(cancellation) {
+    }
+  };
+  struct Iteration {
+    std::string out;
+    BatchQueue batches;
+    std::vector<linb::any> reductions;
+  };
+
+  assert(foor.loop_variable()); /* analyser checked */
+  assert(foor.condition);       /* analyser checked */
+
+  try {
+    State inner(state);
+    const auto& loop_variable = *foor.loop_variable();
+    std::vector<linb::any> values;
+
+    // the iterations only see their copy of the loop variable
+    if(foor.define) {
+      define_variable(inner, *foor.define);
+    }
+    if(foor.variable) {
+      interpret(inner, *foor.variable);
+    }
+    while(any_to_bool(interpret(inner, *foor.condition))) {
+      auto& var = inner.stack->variable(loop_variable.address,
+                                        loop_variable.token.text());
+      Future::join(var);
+      values.push_back(var);
+      if(foor.operation) {
+        interpret(inner, *foor.operation);
+      }
+      inner.probe.check(foor.token, state.file);
+    }
+
+    // the iterations read the outer variables concurrently, they must not
+    // join them
+    inner.stack->each_variable([](auto& var) { Future::join(var); });
+    state.batches.flush();
+
+    std::vector<linb::any> seeds;
+    bool in_order = false;  // the sums continue from iteration to iteration
+    for(const auto& r : foor.reductions) {
+      const auto& var =
+          inner.stack->variable(r.variable.address, r.variable.token.text());
+      seeds.push_back(var);
+      in_order = in_order || !split(r.kind, var);
+    }
+    // in order the first iteration starts the sums at the outer variables
+    for(std::size_t r = 0; r < seeds.size(); ++r) {
+      const auto kind = foor.reductions[r].kind;
+
+      if(!in_order || kind != Kind::SUM) {
+        seeds[r] = seed(kind, seeds[r]);
+      }
+    }
+
+    std::deque<Worker> workers;
+    std::vector<Iteration> iterations(values.size());
+    // a single worker takes the iterations in order
+    const auto count = in_order ? 1 : std::min(workers_, values.size());
+    for(std::size_t i = 0; i < count; ++i) {
+      workers.emplace_back(state.probe.cancellation());
+    }
+    // the batched calls are passed on in the order of the iterations
+    const auto replay = [&state, &iterations]() {
+      for(auto& i : iterations) {
+        i.batches.replay(state.batches);
+      }
+      state.batches.flush();
+    };
+
+    try {
+      Scheduler::run(executor_, count, values.size(), [&](std::size_t w,
+                                                          std::size_t i) {
+        auto& worker = workers[w];
+        std::ostringstream out;
+        FrameArena::Frame frame(worker.frames, inner.stack, 0,
+                                foor.scope->frame.slots.size());
+        State body(worker.frames, frame.stack(), state.scope, state.file,
+                   state.commands, iterations[i].batches, worker.futures, out,
+                   worker.probe);
+
+        // the loop and the reduction variables are the first slots
+        body.stack->add_variable(0, loop_variable.token.text());
+        body.stack->variable(0) = values[i];
+        for(std::size_t r = 0; r < foor.reductions.size(); ++r) {
+          const auto& reduction = foor.reductions[r];
+
+          body.stack->add_variable(r + 1, reduction.variable.token.text());
+          body.stack->variable(r + 1) =
+              in_order && i > 0 && reduction.kind == Kind::SUM
+                  ? iterations[i - 1].reductions[r]
+                  : seeds[r];
+        }
+
+        interpret_shared(body, *foor.scope);
+
+        for(std::size_t r = 0; r < foor.reductions.size(); ++r) {
+          auto& var = body.stack->variable(r + 1);
+          Future::join(var);
+          iterations[i].reductions.push_back(std::move(var));
+        }
+        iterations[i].out = out.str();
+      });
+      for(auto& w : workers) {
+        w.futures.join(state.file);
+      }
+      replay();
+    } catch(...) {
+      // the calls before the error were made
+      for(auto& w : workers) {
+        w.futures.wait();
+      }
+      replay();
+      throw;
+    }
+
+    for(const auto& i : iterations) {
+      state.out << i.out;
+    }
+    // same as an assignment of the reduction variable after the loop
+    for(std::size_t r = 0; r < foor.reductions.size(); ++r) {
+      const auto& reduction = foor.reductions[r];
+      linb::any acc = inner.stack->variable(reduction.variable.address,
+                                            reduction.variable.token.text());
+
+      for(auto& i : iterations) {
+        auto& value = i.reductions[r];
+
+        if(value.empty()) {
+          continue;  // the iteration didn't contribute
+        }
+        switch(reduction.kind) {
+        case Kind::SUM:
+          if(in_order) {  // the last iteration has the whole sum
+            acc = std::move(value);
+          } else {
+            acc = acc.empty() ? std::move(value)
+                              : operator_provider_->eval(BiOp::ADD, acc, value);
+          }
+          break;
+        case Kind::MIN:
+          if(acc.empty() ||
+             any_to_bool(operator_provider_->eval(BiOp::SMALLER, value, acc))) {
+            acc = std::move(value);
+          }
+          break;
+        case Kind::MAX:
+          if(acc.empty() ||
+             any_to_bool(operator_provider_->eval(BiOp::GREATER, value, acc))) {
+            acc = std::move(value);
+          }
+          break;
+        case Kind::COLLECT:
+          if(acc.type() != typeid(std::vector<linb::any>)) {
+            acc = std::vector<linb::any>();
+          }
+          linb::any_cast<std::vector<linb::any>&>(acc).push_back(
+              std::move(value));
+          break;
+        }
+      }
+
+      inner.stack->assign(reduction.variable.address.slot) = std::move(acc);
+    }
+    return {};
+  } catch(std::exception&) {
+    Exc<E, E::TAIL> e;
+    add_exception_info(foor.token, state.file, e,
+                       [&e]() { e << "In the parallel for defined here"; });
+    std::throw_with_nested(e);
+  }
+}
 linb::any Interpreter::interpret(State& state,
                                  const ast::loop::While& whi) const {
   assert(whi.condition);
@@ -556,6 +887,7 @@ linb::any Interpreter::interpret(State& state,
       if(inner.continuing) {
         inner.continuing = false;
       }
+      inner.probe.check(whi.token, state.file);
     }
     if(inner.returning) {
       state.returning = true;
@@ -579,12 +911,13 @@ linb::any Interpreter::interpret(State& state,
         [&](const callable::Callable& o) { out = interpret(state, o); },
         [&](const Operator& o) { out = interpret(state, o); },
         [&](const Variable& o) {
-          if(state.stack->owns_variable(o.token.token)) {
-            state.stack->variable(
-                o.token.token, [&](linb::any& var) { out = std::move(var); });
+          auto& var = state.stack->variable(o.address, o.token.text());
+          Future::join(var);
+          if(o.address.depth == 0 &&
+             state.stack->owns_variable(o.address.slot)) {
+            out = std::move(var);
           } else {
-            state.stack->variable(o.token.token,
-                                  [&](const linb::any& var) { out = var; });
+            out = var;
           }
         },
         [&](const Literal<Literals::BOOL>& c) { out = c.data; },
@@ -625,7 +958,7 @@ linb::any Interpreter::interpret_shared(State& state,
         [this, &state](const Operator& e) { interpret(state, e); },
         [this, &state](const loop::Break& e) { interpret(state, e); },
         [this, &state](const loop::Continue& e) { interpret(state, e); },
-        [this, &state](const Callable& e) { interpret(state, e); },
+        [this, &state](const Callable& e) { interpret(state, e, true); },
         [this, &state, &ret](const DoWhile& e) { ret = interpret(state, e); },
         [this, &state, &ret](const For& e) { ret = interpret(state, e); },
         [this, &state, &ret](const If& e) { ret = interpret(state, e); },
@@ -656,11 +989,11 @@ Interpreter::args_from_call(State& state, const Callable& call,
   Arguments args;
 
   for(const auto& p : call.parameter) {
-    const auto& name = p.first.token.token;
+    const auto name = p.first.token.text().to_string();
 
     if(command_args.has(name)) {
       auto val = interpret(state, p.second);
-      args.add(p.first.token.token, "macro_call", val.ref.get());
+      args.add(p.first.token.text().to_string(), "macro_call", val.ref.get());
     } else {
       assert(false && "Too many arguments!");  // Should not happen
     }
@@ -670,24 +1003,18 @@ Interpreter::args_from_call(State& state, const Callable& call,
 
 void Interpreter::add_parameter(State& state, State& outer,
                                 const ValueProducer& val,
-                                const std::string& par) const {
-  auto ret_par = [this](State& s, State& o, const std::string& p,
-                        const auto& v) {
-    s.stack->add_variable(p);
-    s.stack->variable(p, [&](linb::any& var) { var = interpret(o, v); });
+                                const Variable& par) const {
+  auto ret_par = [this](State& s, State& o, const Variable& p, const auto& v) {
+    s.stack->add_variable(p.address.slot, p.token.text());
+    s.stack->variable(p.address.slot) = interpret(o, v);
   };
-  auto lit_par = [this](State& s, const std::string& p, const auto& v) {
-    s.stack->add_variable(p);
-    s.stack->variable(p, [&](linb::any& var) { var = v.data; });
+  auto lit_par = [this](State& s, const Variable& p, const auto& v) {
+    s.stack->add_variable(p.address.slot, p.token.text());
+    s.stack->variable(p.address.slot) = v.data;
   };
-  auto var_par = [this](State& s, State& o, const std::string& p, auto v) {
-    if(o.stack->has_variable(v.token.token)) {
-      o.stack->variable(v.token.token, [&s, &p](linb::any& var) {
-        s.stack->add_alias(p, var);
-      });
-    } else {
-      assert(false); /* analyser checked */
-    }
+  auto var_par = [this](State& s, State& o, const Variable& p, const auto& v) {
+    s.stack->add_alias(p.address.slot, p.token.text(),
+                       o.stack->variable(v.address, v.token.text()));
   };
   eggs::match(
       val.value,
@@ -707,13 +1034,13 @@ void Interpreter::add_parameter(State& state, State& outer,
     assert(false);  // Should not happen
   }
   for(const auto& p : call.parameter) {
-    auto& par = p.first.token.token;
+    const auto par = p.first.token.text().to_string();
     auto it = std::find_if(
         fun.parameter.begin(), fun.parameter.end(),
-        [&par](const Variable& var) { return par == var.token.token; });
+        [&par](const Variable& var) { return par == var.token.text(); });
 
     if(fun.parameter.end() != it) {
-      add_parameter(state, outer, p.second, par);
+      add_parameter(state, outer, p.second, *it);
     } else {
       assert(false);  // Should not happen
     }
@@ -726,8 +1053,10 @@ void Interpreter::add_arguments(State& state, Arguments& args,
     assert(false);  // Should not happen
   }
   for(const auto& p : fun.parameter) {
-    if(args.has(p.token.token)) {
-      state.stack->add_alias(p.token.token, args[p.token.token]);
+    const auto name = p.token.text().to_string();
+
+    if(args.has(name)) {
+      state.stack->add_alias(p.address.slot, p.token.text(), args[name]);
     } else {
       assert(false);  // Should not happen
     }
@@ -735,41 +1064,74 @@ void Interpreter::add_arguments(State& state, Arguments& args,
 }
 
 linb::any Interpreter::interpret(State& state,
-                                 const ast::callable::Callable& call) const {
+                                 const ast::callable::Callable& call,
+                                 bool discarded) const {
   linb::any ret;
-  if(state.stack->has_function(call)) {
-    state.stack->function(call, [&](const Function& fun, auto stack) {
-      try {
-        State inner(state, std::make_shared<Stack>(std::move(stack)));
-        inner.loopscope = false;
-
-        // FIXME gcc 5.3 needs the this pointer...
-        this->add_parameter(inner, state, call, fun);
+  Stack* defined = nullptr;
 
-        // FIXME gcc 5.3 needs the this pointer...
-        ret = this->interpret_shared(inner, *fun.scope);
-      } catch(std::exception&) {
-        Exc<E, E::TAIL> e;
-        add_exception_info(fun.token, state.file, e, [&e, &fun]() {
-          e << "In the '" << fun.token.token << "' function defined here";
-        });
-        std::throw_with_nested(e);
+  if(const auto* fun = state.stack->resolve_function(call, defined)) {
+    state.probe.check(call.token, state.file);
+    try {
+      FrameArena::Frame frame(state.frames, defined, 0,
+                              fun->scope->frame.slots.size());
+      State inner(state, frame.stack());
+      inner.loopscope = false;
+
+      add_parameter(inner, state, call, *fun);
+      shadow(*inner.stack, *fun->scope);
+      ret = interpret_shared(inner, *fun->scope);
+    } catch(std::exception&) {
+      Exc<E, E::TAIL> e;
+      add_exception_info(fun->token, state.file, e, [&e, fun]() {
+        e << "In the '" << fun->token.text() << "' function defined here";
+      });
+      std::throw_with_nested(e);
+    }
+  } else if(const auto* linked =
+                state.commands ? state.commands->find(call) : nullptr) {
+    Arguments args;
+
+    for(std::size_t i = 0; i < call.parameter.size(); ++i) {
+      const auto& p = call.parameter[i];
+
+      if(linked->accepted[i]) {
+        auto val = interpret(state, p.second);
+        args.add(p.first.token.text().to_string(), "macro_call", val.ref.get());
+      } else {
+        assert(false && "Too many arguments!");  // Should not happen
       }
-    });
+    }
+    if(call.async) {
+      auto com = linked->prototype;
+
+      state.batches.flush();
+      ret = state.futures.launch(executor_, call.token, [com, args]() mutable {
+        return com.execute(args);
+      });
+    } else if(discarded && linked->batch) {
+      state.batches.add(*linked->batch, std::move(args));
+    } else {
+      auto com = linked->prototype;
+
+      state.batches.flush();
+      ret = com.execute(args);
+    }
   } else {
+    state.batches.flush();
     try {
-      auto com = command_provider_->get_command(state.scope, call.token.token);
+      auto com = CommandLink::lookup(*command_provider_, state.scope,
+                                     call.token.text().to_string());
       ret = com.execute(args_from_call(state, call, com.arguments()));
     } catch(...) {
       bool once = true;
       Exc<E, E::MISSING_FUNCTION> e(__FILE__, __LINE__, "Missing function");
-      e << "There was no matching function '" << call.token.token << "(";
+      e << "There was no matching function '" << call.token.text() << "(";
       for(const auto& p : call.parameter) {
         if(once) {
           once = false;
-          e << p.first.token.token;
+          e << p.first.token.text();
         } else {
-          e << ", " << p.first.token.token;
+          e << ", " << p.first.token.text();
         }
       }
       e << ")'.";
@@ -788,12 +1150,15 @@ linb::any Interpreter::interpret_main(State& state, Arguments args) const {
     call.parameter.emplace_back(Variable({0, 0, p.name()}), Variable());
   }
 
-  state.stack->function(call, [&](const Function& fun, auto stack) {
+  state.stack->function(call, [&](const Function& fun, Stack& defined) {
     try {
-      State inner(state, std::make_shared<Stack>(std::move(stack)));
+      FrameArena::Frame frame(state.frames, &defined, 0,
+                              fun.scope->frame.slots.size());
+      State inner(state, frame.stack());
 
       // FIXME gcc 5.3 needs the this pointer...
       this->add_arguments(inner, args, fun);
+      shadow(*inner.stack, *fun.scope);
       // FIXME gcc 5.3 needs the this pointer...
       ret = this->interpret_shared(inner, *fun.scope);
     } catch(std::exception&) {
@@ -4,138 +4,517 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
 
 namespace cad {
 namespace macro {
 namespace interpreter {
 namespace {
-template <typename T1, typename T2>
-using VecMap = std::vector<std::pair<T1, T2>>;
+using BinaryOperation = OperatorProvider::BinaryOperation;
+using UnaryOperation = OperatorProvider::UnaryOperation;
 
-template <typename T1, typename T2>
-auto find(VecMap<T1, T2>& map, const T1& key) {
-  return std::find_if(map.begin(), map.end(),
-                      [&key](const auto& pair) { return pair.first == key; });
+// type ids that are never registered
+constexpr std::size_t unknown_type = std::numeric_limits<std::size_t>::max();
+
+bool is_primitive(const std::size_t type) {
+  return type == static_cast<std::size_t>(Value::Type::BOOL) ||
+         type == static_cast<std::size_t>(Value::Type::INT) ||
+         type == static_cast<std::size_t>(Value::Type::DOUBLE);
+}
+
+// the given any instance has to hold the builtin type with the given type id
+Value primitive(const linb::any& any, const std::size_t type) {
+  switch(static_cast<Value::Type>(type)) {
+  case Value::Type::BOOL:
+    return Value(*linb::any_cast<bool>(&any));
+  case Value::Type::INT:
+    return Value(*linb::any_cast<int>(&any));
+  case Value::Type::DOUBLE:
+    return Value(*linb::any_cast<double>(&any));
+  default:
+    return Value();
+  }
+}
+
+// the any instance an operator function is called with, boxed values are not
+// copied
+const linb::any& any_of(const Value& value, linb::any& storage) {
+  if(value.type() == Value::Type::BOXED) {
+    return value.as_boxed();
+  }
+  storage = value.to_any();
+  return storage;
+}
+
+// the name of the operator in error messages
+const char* name(const BinaryOperation op) {
+  switch(op) {
+  case BinaryOperation::DIVIDE:
+    return "'divide'(/)";
+  case BinaryOperation::MULTIPLY:
+    return "'multiply'(*)";
+  case BinaryOperation::MODULO:
+    return "'modulo'(%)";
+  case BinaryOperation::ADD:
+    return "'add'(+)";
+  case BinaryOperation::SUBTRACT:
+    return "'subtract'(-)";
+  case BinaryOperation::SMALLER:
+    return "'smaller'(<)";
+  case BinaryOperation::SMALLER_EQUAL:
+    return "'smaller_equal'(<=)";
+  case BinaryOperation::GREATER:
+    return "'greater'(>)";
+  case BinaryOperation::GREATER_EQUAL:
+    return "'greater_equal'(>=)";
+  case BinaryOperation::EQUAL:
+    return "'equal'(==)";
+  case BinaryOperation::NOT_EQUAL:
+    return "'not_equal'(!=)";
+  case BinaryOperation::AND:
+    return "'and'(&&)";
+  case BinaryOperation::OR:
+    return "'or'(||)";
+  }
+  return "";
+}
+const char* name(const UnaryOperation op) {
+  switch(op) {
+  case UnaryOperation::NOT:
+    return "'!'(not)";
+  case UnaryOperation::BOOL:
+    return "' bool'";
+  case UnaryOperation::TYPEOF:
+    return "'typeof'";
+  case UnaryOperation::PRINT:
+    return "'print'";
+  case UnaryOperation::NEGATIVE:
+    return "'-' (negative)";
+  case UnaryOperation::POSITIVE:
+    return "'+' (positive)";
+  }
+  return "";
+}
+
+//////////////////////////////////////////
+/// Primitives - same as the BiHelper and UnHelper functions
+//////////////////////////////////////////
+template <typename LHS, typename RHS>
+bool modulo(LHS, RHS, Value&) {
+  return false;  // only registered for int and int, bool and int
+}
+bool modulo(int lhs, int rhs, Value& ret) {
+  ret = Value(lhs % rhs);
+  return true;
+}
+bool modulo(bool lhs, int rhs, Value& ret) {
+  ret = Value(lhs % rhs);
+  return true;
+}
+
+template <typename LHS, typename RHS>
+bool binary(const BinaryOperation op, const LHS lhs, const RHS rhs,
+            Value& ret) {
+  switch(op) {
+  case BinaryOperation::DIVIDE:
+    ret = Value(lhs / rhs);
+    return true;
+  case BinaryOperation::MULTIPLY:
+    ret = Value(lhs * rhs);
+    return true;
+  case BinaryOperation::MODULO:
+    return modulo(lhs, rhs, ret);
+  case BinaryOperation::ADD:
+    ret = Value(lhs + rhs);
+    return true;
+  case BinaryOperation::SUBTRACT:
+    ret = Value(lhs - rhs);
+    return true;
+  case BinaryOperation::SMALLER:
+    ret = Value(lhs < rhs);
+    return true;
+  case BinaryOperation::SMALLER_EQUAL:
+    ret = Value(lhs <= rhs);
+    return true;
+  case BinaryOperation::GREATER:
+    ret = Value(lhs > rhs);
+    return true;
+  case BinaryOperation::GREATER_EQUAL:
+    ret = Value(lhs >= rhs);
+    return true;
+  case BinaryOperation::EQUAL:
+    ret = Value(lhs == rhs);
+    return true;
+  case BinaryOperation::NOT_EQUAL:
+    ret = Value(lhs != rhs);
+    return true;
+  case BinaryOperation::AND:
+  case BinaryOperation::OR:
+    return false;
+  }
+  return false;
+}
+
+template <typename RHS>
+bool unary(const UnaryOperation op, const RHS rhs, Value& ret) {
+  switch(op) {
+  case UnaryOperation::NOT:
+    ret = Value(!rhs);
+    return true;
+  case UnaryOperation::BOOL:
+    ret = Value(!!rhs);
+    return true;
+  case UnaryOperation::NEGATIVE:
+    ret = Value(-rhs);
+    return true;
+  case UnaryOperation::POSITIVE:
+    ret = Value(+rhs);
+    return true;
+  case UnaryOperation::PRINT:
+  case UnaryOperation::TYPEOF:
+    return false;
+  }
+  return false;
+}
+}
+
+void OperatorProvider::BiTable::set(std::size_t lhs, std::size_t rhs,
+                                    BiCall operato) {
+  const auto needed = std::max(lhs, rhs) + 1;
+
+  if(needed > size_) {  // double the table, the old entries keep their position
+    const auto size = std::max(needed, 2 * size_);
+
+    table_.resize(size * size, BiCall{nullptr, nullptr});
+    // the rows move to higher indices, the last one first
+    for(std::size_t l = size_; l-- > 0;) {
+      const auto row = table_.begin() + l * size;
+
+      std::copy_backward(table_.begin() + l * size_,
+                         table_.begin() + (l + 1) * size_, row + size_);
+      std::fill(row + size_, row + size, BiCall{nullptr, nullptr});
+    }
+    size_ = size;
+  }
+  table_[lhs * size_ + rhs] = operato;
+}
+void OperatorProvider::UnTable::set(std::size_t rhs, UnCall operato) {
+  if(rhs >= table_.size()) {
+    table_.resize(std::max(rhs + 1, 2 * table_.size()),
+                  UnCall{nullptr, nullptr});
+  }
+  table_[rhs] = operato;
+}
+
+linb::any OperatorProvider::call(const void* function, const linb::any& lhs,
+                                 const linb::any& rhs) {
+  return (*static_cast<const BiOp*>(function))(lhs, rhs);
+}
+linb::any OperatorProvider::call(const void* function, const linb::any& rhs) {
+  return (*static_cast<const UnOp*>(function))(rhs);
+}
+
+std::size_t OperatorProvider::add_type(const std::type_index& type) {
+  return type_ids_.emplace(type, type_ids_.size()).first->second;
+}
+std::size_t OperatorProvider::type_id(const std::type_index& type) const {
+  // the builtin types are the most common ones and don't need to be hashed
+  if(type == typeid(int)) {
+    return static_cast<std::size_t>(Value::Type::INT);
+  } else if(type == typeid(double)) {
+    return static_cast<std::size_t>(Value::Type::DOUBLE);
+  } else if(type == typeid(bool)) {
+    return static_cast<std::size_t>(Value::Type::BOOL);
+  } else if(type == typeid(std::string)) {
+    return static_cast<std::size_t>(Value::Type::STRING);
+  } else if(type == typeid(void)) {
+    return static_cast<std::size_t>(Value::Type::EMPTY);
+  }
+  const auto it = type_ids_.find(type);
+  return it != type_ids_.end() ? it->second : unknown_type;
 }
 
-template <typename T1, typename T2>
-auto find(const VecMap<T1, T2>& map, const T1& key) {
-  return std::find_if(map.begin(), map.end(),
-                      [&key](const auto& pair) { return pair.first == key; });
+std::size_t OperatorProvider::type_id(const Value& value) const {
+  if(value.type() == Value::Type::BOXED) {
+    return type_id(value.as_boxed().type());
+  }
+  return static_cast<std::size_t>(value.type());
 }
 
-template <typename T1, typename T2>
-auto exists(const VecMap<T1, T2>& map, const T1& key) {
-  return find(map, key) != map.end();
+const OperatorProvider::BiTable&
+OperatorProvider::table(const BinaryOperation op) const {
+  switch(op) {
+  case BinaryOperation::DIVIDE:
+    return divide_;
+  case BinaryOperation::MULTIPLY:
+    return multiply_;
+  case BinaryOperation::MODULO:
+    return modulo_;
+  case BinaryOperation::ADD:
+    return add_;
+  case BinaryOperation::SUBTRACT:
+    return subtract_;
+  case BinaryOperation::SMALLER:
+    return smaller_;
+  case BinaryOperation::SMALLER_EQUAL:
+    return smaller_equal_;
+  case BinaryOperation::GREATER:
+    return greater_;
+  case BinaryOperation::GREATER_EQUAL:
+    return greater_equal_;
+  case BinaryOperation::EQUAL:
+    return equal_;
+  case BinaryOperation::NOT_EQUAL:
+    return not_equal_;
+  case BinaryOperation::AND:
+  case BinaryOperation::OR:
+    break;
+  }
+  assert(false && "AND and OR have no operator functions");
+  return equal_;
+}
+const OperatorProvider::UnTable&
+OperatorProvider::table(const UnaryOperation op) const {
+  switch(op) {
+  case UnaryOperation::BOOL:
+    return bool_;
+  case UnaryOperation::TYPEOF:
+    return type_of_;
+  case UnaryOperation::PRINT:
+    return print_;
+  case UnaryOperation::NEGATIVE:
+    return negative_;
+  case UnaryOperation::POSITIVE:
+    return positive_;
+  case UnaryOperation::NOT:
+    break;
+  }
+  assert(false && "NOT has no operator functions");
+  return bool_;
 }
 
-auto make_indexes(const linb::any& lhs, const linb::any& rhs) {
-  return std::make_tuple(std::type_index(lhs.type()),
-                         std::type_index(rhs.type()));
+bool OperatorProvider::eval_primitive(const BinaryOperation op,
+                                      const Value& lhs, const Value& rhs,
+                                      Value& ret) const {
+  const auto primitives = [this, op]() {
+    switch(op) {
+    case BinaryOperation::DIVIDE:
+      return divide_.primitives();
+    case BinaryOperation::MULTIPLY:
+      return multiply_.primitives();
+    case BinaryOperation::MODULO:
+      return modulo_.primitives();
+    case BinaryOperation::ADD:
+      return add_.primitives();
+    case BinaryOperation::SUBTRACT:
+      return subtract_.primitives();
+    case BinaryOperation::SMALLER:
+      return smaller_.primitives();
+    case BinaryOperation::SMALLER_EQUAL:
+      return smaller_equal_.primitives();
+    case BinaryOperation::GREATER:
+      return greater_.primitives();
+    case BinaryOperation::GREATER_EQUAL:
+      return greater_equal_.primitives();
+    case BinaryOperation::EQUAL:
+      return equal_.primitives();
+    case BinaryOperation::NOT_EQUAL:
+      return not_equal_.primitives();
+    case BinaryOperation::AND:
+    case BinaryOperation::OR:
+      return false;
+    }
+    return false;
+  };
+
+  if(!primitives()) {
+    return false;
+  }
+
+  switch(lhs.type()) {
+  case Value::Type::BOOL:
+    switch(rhs.type()) {
+    case Value::Type::INT:
+      return binary(op, lhs.as_bool(), rhs.as_int(), ret);
+    case Value::Type::DOUBLE:
+      return binary(op, lhs.as_bool(), rhs.as_double(), ret);
+    default:
+      return false;  // bool and bool is not registered
+    }
+  case Value::Type::INT:
+    switch(rhs.type()) {
+    case Value::Type::BOOL:
+      return binary(op, lhs.as_int(), rhs.as_bool(), ret);
+    case Value::Type::INT:
+      return binary(op, lhs.as_int(), rhs.as_int(), ret);
+    case Value::Type::DOUBLE:
+      return binary(op, lhs.as_int(), rhs.as_double(), ret);
+    default:
+      return false;
+    }
+  case Value::Type::DOUBLE:
+    switch(rhs.type()) {
+    case Value::Type::BOOL:
+      return binary(op, lhs.as_double(), rhs.as_bool(), ret);
+    case Value::Type::INT:
+      return binary(op, lhs.as_double(), rhs.as_int(), ret);
+    case Value::Type::DOUBLE:
+      return binary(op, lhs.as_double(), rhs.as_double(), ret);
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
 }
+bool OperatorProvider::eval_primitive(const UnaryOperation op,
+                                      const Value& rhs, Value& ret) const {
+  const auto primitives = [this, op]() {
+    switch(op) {
+    case UnaryOperation::NOT:
+    case UnaryOperation::BOOL:
+      return bool_.primitives();
+    case UnaryOperation::NEGATIVE:
+      return negative_.primitives();
+    case UnaryOperation::POSITIVE:
+      return positive_.primitives();
+    case UnaryOperation::PRINT:
+    case UnaryOperation::TYPEOF:
+      return false;
+    }
+    return false;
+  };
+
+  if(!primitives()) {
+    return false;
+  }
+
+  switch(rhs.type()) {
+  case Value::Type::BOOL:
+    return unary(op, rhs.as_bool(), ret);
+  case Value::Type::INT:
+    return unary(op, rhs.as_int(), ret);
+  case Value::Type::DOUBLE:
+    return unary(op, rhs.as_double(), ret);
+  default:
+    return false;
+  }
 }
 
 void OperatorProvider::add(const BinaryOperation operati, std::type_index lhs,
                            std::type_index rhs, BiOp operato) {
+  bi_functions_.push_back(std::move(operato));
+  try {
+    add(operati, lhs, rhs, BiCall{&call, &bi_functions_.back()});
+  } catch(...) {
+    bi_functions_.pop_back();
+    throw;
+  }
+}
+void OperatorProvider::add(const BinaryOperation operati, std::type_index lhs,
+                           std::type_index rhs, BiCall operato) {
+  const auto l = add_type(lhs);
+  const auto r = add_type(rhs);
+
   switch(operati) {
   case BinaryOperation::DIVIDE:
-    if(exists(divide_, std::make_tuple(lhs, rhs))) {
+    if(divide_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'divide'(/) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    divide_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    divide_.set(l, r, operato);
     break;
   case BinaryOperation::MULTIPLY:
-    if(exists(multiply_, std::make_tuple(lhs, rhs))) {
+    if(multiply_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'multiply'(*) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    multiply_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    multiply_.set(l, r, operato);
     break;
   case BinaryOperation::MODULO:
-    if(exists(modulo_, std::make_tuple(lhs, rhs))) {
+    if(modulo_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'modulo'(%) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    modulo_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    modulo_.set(l, r, operato);
     break;
   case BinaryOperation::ADD:
-    if(exists(add_, std::make_tuple(lhs, rhs))) {
+    if(add_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'add'(+) already exists for the types '" << lhs.name()
         << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    add_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    add_.set(l, r, operato);
     break;
   case BinaryOperation::SUBTRACT:
-    if(exists(subtract_, std::make_tuple(lhs, rhs))) {
+    if(subtract_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'subtract'(-) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    subtract_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    subtract_.set(l, r, operato);
     break;
   case BinaryOperation::SMALLER:
-    if(exists(smaller_, std::make_tuple(lhs, rhs))) {
+    if(smaller_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'smaller'(<) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    smaller_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    smaller_.set(l, r, operato);
     break;
   case BinaryOperation::SMALLER_EQUAL:
-    if(exists(smaller_equal_, std::make_tuple(lhs, rhs))) {
+    if(smaller_equal_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'smaller_equal'(<=) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    smaller_equal_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    smaller_equal_.set(l, r, operato);
     break;
   case BinaryOperation::GREATER:
-    if(exists(greater_, std::make_tuple(lhs, rhs))) {
+    if(greater_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'greater'(>) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    greater_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    greater_.set(l, r, operato);
     break;
   case BinaryOperation::GREATER_EQUAL:
-    if(exists(greater_equal_, std::make_tuple(lhs, rhs))) {
+    if(greater_equal_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'greater_equal'(>=) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    greater_equal_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    greater_equal_.set(l, r, operato);
     break;
   case BinaryOperation::EQUAL:
-    if(exists(equal_, std::make_tuple(lhs, rhs))) {
+    if(equal_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'equal'(==) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    equal_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    equal_.set(l, r, operato);
     break;
   case BinaryOperation::NOT_EQUAL:
-    if(exists(not_equal_, std::make_tuple(lhs, rhs))) {
+    if(not_equal_.find(l, r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'not_equal'(!=) already exists for the types '"
         << lhs.name() << "' and '" << rhs.name() << "'.";
       throw e;
     }
-    not_equal_.emplace_back(std::make_tuple(lhs, rhs), std::move(operato));
+    not_equal_.set(l, r, operato);
     break;
   case BinaryOperation::AND:
     assert(false && "AND can not be added - it is free :)");
@@ -145,119 +524,103 @@ void OperatorProvider::add(const BinaryOperation operati, std::type_index lhs,
 }
 void OperatorProvider::add(const UnaryOperation operati, std::type_index rhs,
                            UnOp operato) {
+  un_functions_.push_back(std::move(operato));
+  try {
+    add(operati, rhs, UnCall{&call, &un_functions_.back()});
+  } catch(...) {
+    un_functions_.pop_back();
+    throw;
+  }
+}
+void OperatorProvider::add(const UnaryOperation operati, std::type_index rhs,
+                           UnCall operato) {
+  const auto r = add_type(rhs);
+
   switch(operati) {
   case UnaryOperation::NOT:
     assert(false && "NOT can not be added - it is free :)");
   case UnaryOperation::BOOL:
-    if(exists(bool_, rhs)) {
+    if(bool_.find(r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'bool' already exists for the type '" << rhs.name()
         << "'.";
       throw e;
     }
-    bool_.emplace_back(rhs, std::move(operato));
+    bool_.set(r, operato);
     break;
   case UnaryOperation::TYPEOF:
-    if(exists(type_of_, rhs)) {
+    if(type_of_.find(r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'typeof' already exists for the type '" << rhs.name()
         << "'.";
       throw e;
     }
-    type_of_.emplace_back(rhs, std::move(operato));
+    type_of_.set(r, operato);
     break;
   case UnaryOperation::PRINT:
-    if(exists(print_, rhs)) {
+    if(print_.find(r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator 'print' already exists for the type '" << rhs.name()
         << "'.";
       throw e;
     }
-    print_.emplace_back(rhs, std::move(operato));
+    print_.set(r, operato);
     break;
   case UnaryOperation::NEGATIVE:
-    if(exists(negative_, rhs)) {
+    if(negative_.find(r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator '-' (negative) already exists for the type '"
         << rhs.name() << "'.";
       throw e;
     }
-    negative_.emplace_back(rhs, std::move(operato));
+    negative_.set(r, operato);
     break;
   case UnaryOperation::POSITIVE:
-    if(exists(positive_, rhs)) {
+    if(positive_.find(r)) {
       Exc<E, E::OPERATOR_EXISTS> e(__FILE__, __LINE__, "Operator exists");
       e << "The operator '+' (positive) already exists for the type '"
         << rhs.name() << "'.";
       throw e;
     }
-    positive_.emplace_back(rhs, std::move(operato));
+    positive_.set(r, operato);
   }
 }
 
 bool OperatorProvider::has(const BinaryOperation op, const linb::any& lhs,
                            const linb::any& rhs) const {
-  switch(op) {
-  case BinaryOperation::DIVIDE:
-    return exists(divide_, make_indexes(lhs, rhs));
-  case BinaryOperation::MULTIPLY:
-    return exists(multiply_, make_indexes(lhs, rhs));
-  case BinaryOperation::MODULO:
-    return exists(modulo_, make_indexes(lhs, rhs));
-  case BinaryOperation::ADD:
-    return exists(add_, make_indexes(lhs, rhs));
-  case BinaryOperation::SUBTRACT:
-    return exists(subtract_, make_indexes(lhs, rhs));
-  case BinaryOperation::SMALLER:
-    return exists(smaller_, make_indexes(lhs, rhs));
-  case BinaryOperation::SMALLER_EQUAL:
-    return exists(smaller_equal_, make_indexes(lhs, rhs));
-  case BinaryOperation::GREATER:
-    return exists(greater_, make_indexes(lhs, rhs));
-  case BinaryOperation::GREATER_EQUAL:
-    return exists(greater_equal_, make_indexes(lhs, rhs));
-  case BinaryOperation::EQUAL:
-    return exists(equal_, make_indexes(lhs, rhs));
-  case BinaryOperation::NOT_EQUAL:
-    return exists(not_equal_, make_indexes(lhs, rhs));
-  case BinaryOperation::AND:
-    return exists(bool_, std::type_index(lhs.type())) &&
-           exists(bool_, std::type_index(rhs.type()));
-  case BinaryOperation::OR:
-    return exists(bool_, std::type_index(lhs.type())) &&
-           exists(bool_, std::type_index(rhs.type()));
-  }
-  assert(false && "Reached by access after free and similar");
+  return has(op, std::type_index(lhs.type()), std::type_index(rhs.type()));
 }
 bool OperatorProvider::has(const BinaryOperation op, const std::type_index& lhs,
                            const std::type_index& rhs) const {
   switch(op) {
   case BinaryOperation::DIVIDE:
-    return exists(divide_, std::make_tuple(lhs, rhs));
+    return divide_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::MULTIPLY:
-    return exists(multiply_, std::make_tuple(lhs, rhs));
+    return multiply_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::MODULO:
-    return exists(modulo_, std::make_tuple(lhs, rhs));
+    return modulo_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::ADD:
-    return exists(add_, std::make_tuple(lhs, rhs));
+    return add_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::SUBTRACT:
-    return exists(subtract_, std::make_tuple(lhs, rhs));
+    return subtract_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::SMALLER:
-    return exists(smaller_, std::make_tuple(lhs, rhs));
+    return smaller_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::SMALLER_EQUAL:
-    return exists(smaller_equal_, std::make_tuple(lhs, rhs));
+    return smaller_equal_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::GREATER:
-    return exists(greater_, std::make_tuple(lhs, rhs));
+    return greater_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::GREATER_EQUAL:
-    return exists(greater_equal_, std::make_tuple(lhs, rhs));
+    return greater_equal_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::EQUAL:
-    return exists(equal_, std::make_tuple(lhs, rhs));
+    return equal_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::NOT_EQUAL:
-    return exists(not_equal_, std::make_tuple(lhs, rhs));
+    return not_equal_.find(type_id(lhs), type_id(rhs)) != nullptr;
   case BinaryOperation::AND:
-    return exists(bool_, lhs) && exists(bool_, rhs);
+    return bool_.find(type_id(lhs)) != nullptr &&
+           bool_.find(type_id(rhs)) != nullptr;
   case BinaryOperation::OR:
-    return exists(bool_, lhs) && exists(bool_, rhs);
+    return bool_.find(type_id(lhs)) != nullptr &&
+           bool_.find(type_id(rhs)) != nullptr;
   }
   assert(false && "Reached by access after free and similar");
 }
@@ -266,37 +629,23 @@ bool OperatorProvider::has(const UnaryOperation op,
                            const std::type_index& rhs) const {
   switch(op) {
   case UnaryOperation::NOT:
-    return exists(bool_, rhs);
+    return bool_.find(type_id(rhs)) != nullptr;
   case UnaryOperation::BOOL:
-    return exists(bool_, rhs);
+    return bool_.find(type_id(rhs)) != nullptr;
   case UnaryOperation::TYPEOF:
-    return exists(type_of_, rhs);
+    return type_of_.find(type_id(rhs)) != nullptr;
   case UnaryOperation::PRINT:
-    return exists(print_, rhs);
+    return print_.find(type_id(rhs)) != nullptr;
   case UnaryOperation::NEGATIVE:
-    return exists(negative_, rhs);
+    return negative_.find(type_id(rhs)) != nullptr;
   case UnaryOperation::POSITIVE:
-    return exists(positive_, rhs);
+    return positive_.find(type_id(rhs)) != nullptr;
   }
   assert(false && "Reached by access after free and similar");
 }
 bool OperatorProvider::has(const UnaryOperation op,
                            const linb::any& rhs) const {
-  switch(op) {
-  case UnaryOperation::NOT:
-    return exists(bool_, std::type_index(rhs.type()));
-  case UnaryOperation::BOOL:
-    return exists(bool_, std::type_index(rhs.type()));
-  case UnaryOperation::TYPEOF:
-    return exists(type_of_, std::type_index(rhs.type()));
-  case UnaryOperation::PRINT:
-    return exists(print_, std::type_index(rhs.type()));
-  case UnaryOperation::NEGATIVE:
-    return exists(negative_, std::type_index(rhs.type()));
-  case UnaryOperation::POSITIVE:
-    return exists(positive_, std::type_index(rhs.type()));
-  }
-  assert(false && "Reached by access after free and similar");
+  return has(op, std::type_index(rhs.type()));
 }
 
 //////////////////////////////////////////
@@ -304,9 +653,9 @@ bool OperatorProvider::has(const UnaryOperation op,
 //////////////////////////////////////////
 linb::any OperatorProvider::eval_divide(const linb::any& lhs,
                                         const linb::any& rhs) const {
-  auto it = find(divide_, make_indexes(lhs, rhs));
-  if(it != divide_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = divide_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'divide'(/) is missing for the types '"
@@ -315,9 +664,9 @@ linb::any OperatorProvider::eval_divide(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_multiply(const linb::any& lhs,
                                           const linb::any& rhs) const {
-  auto it = find(multiply_, make_indexes(lhs, rhs));
-  if(it != multiply_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = multiply_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'multiply'(*) is missing for the types '"
@@ -326,9 +675,9 @@ linb::any OperatorProvider::eval_multiply(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_modulo(const linb::any& lhs,
                                         const linb::any& rhs) const {
-  auto it = find(modulo_, make_indexes(lhs, rhs));
-  if(it != modulo_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = modulo_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'modulo'(%) is missing for the types '"
@@ -337,9 +686,9 @@ linb::any OperatorProvider::eval_modulo(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_add(const linb::any& lhs,
                                      const linb::any& rhs) const {
-  auto it = find(add_, make_indexes(lhs, rhs));
-  if(it != add_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = add_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'add'(+) is missing for the types '" << lhs.type().name()
@@ -348,9 +697,9 @@ linb::any OperatorProvider::eval_add(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_subtract(const linb::any& lhs,
                                           const linb::any& rhs) const {
-  auto it = find(subtract_, make_indexes(lhs, rhs));
-  if(it != subtract_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = subtract_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'subtract'(-) is missing for the types '"
@@ -359,9 +708,9 @@ linb::any OperatorProvider::eval_subtract(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_smaller(const linb::any& lhs,
                                          const linb::any& rhs) const {
-  auto it = find(smaller_, make_indexes(lhs, rhs));
-  if(it != smaller_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = smaller_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'smaller'(<) is missing for the types '"
@@ -370,9 +719,10 @@ linb::any OperatorProvider::eval_smaller(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_smaller_equal(const linb::any& lhs,
                                                const linb::any& rhs) const {
-  auto it = find(smaller_equal_, make_indexes(lhs, rhs));
-  if(it != smaller_equal_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op =
+      smaller_equal_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'smaller_equal'(<=) is missing for the types '"
@@ -381,9 +731,9 @@ linb::any OperatorProvider::eval_smaller_equal(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_greater(const linb::any& lhs,
                                          const linb::any& rhs) const {
-  auto it = find(greater_, make_indexes(lhs, rhs));
-  if(it != greater_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = greater_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'greater'(>) is missing for the types '"
@@ -392,9 +742,10 @@ linb::any OperatorProvider::eval_greater(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_greater_equal(const linb::any& lhs,
                                                const linb::any& rhs) const {
-  auto it = find(greater_equal_, make_indexes(lhs, rhs));
-  if(it != greater_equal_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op =
+      greater_equal_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'greater_equal'(>=) is missing for the types '"
@@ -403,9 +754,9 @@ linb::any OperatorProvider::eval_greater_equal(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_equal(const linb::any& lhs,
                                        const linb::any& rhs) const {
-  auto it = find(equal_, make_indexes(lhs, rhs));
-  if(it != equal_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = equal_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'equal'(==) is missing for the types '"
@@ -414,9 +765,9 @@ linb::any OperatorProvider::eval_equal(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval_not_equal(const linb::any& lhs,
                                            const linb::any& rhs) const {
-  auto it = find(not_equal_, make_indexes(lhs, rhs));
-  if(it != not_equal_.end()) {
-    return it->second(lhs, rhs);
+  const auto* op = not_equal_.find(type_id(lhs.type()), type_id(rhs.type()));
+  if(op) {
+    return (*op)(lhs, rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'not_equal'(!=) is missing for the types '"
@@ -467,6 +818,15 @@ linb::any OperatorProvider::eval_or(const linb::any& lhs,
 }
 linb::any OperatorProvider::eval(const BinaryOperation op, const linb::any& lhs,
                                  const linb::any& rhs) const {
+  const auto l = type_id(lhs.type());
+  const auto r = type_id(rhs.type());
+
+  Value ret;
+  if(is_primitive(l) && is_primitive(r) &&
+     eval_primitive(op, primitive(lhs, l), primitive(rhs, r), ret)) {
+    return ret.to_any();
+  }
+
   switch(op) {
   case BinaryOperation::DIVIDE:
     return eval_divide(lhs, rhs);
@@ -512,9 +872,9 @@ linb::any OperatorProvider::eval_not(const linb::any& rhs) const {
   throw e;
 }
 linb::any OperatorProvider::eval_bool(const linb::any& rhs) const {
-  auto it = find(bool_, std::type_index(rhs.type()));
-  if(it != bool_.end()) {
-    return it->second(rhs);
+  const auto* op = bool_.find(type_id(rhs.type()));
+  if(op) {
+    return (*op)(rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator ' bool' is missing for the type '" << rhs.type().name()
@@ -522,9 +882,9 @@ linb::any OperatorProvider::eval_bool(const linb::any& rhs) const {
   throw e;
 }
 linb::any OperatorProvider::eval_type_of(const linb::any& rhs) const {
-  auto it = find(type_of_, std::type_index(rhs.type()));
-  if(it != type_of_.end()) {
-    return it->second(rhs);
+  const auto* op = type_of_.find(type_id(rhs.type()));
+  if(op) {
+    return (*op)(rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'typeof' is missing for the type '" << rhs.type().name()
@@ -532,9 +892,9 @@ linb::any OperatorProvider::eval_type_of(const linb::any& rhs) const {
   throw e;
 }
 linb::any OperatorProvider::eval_print(const linb::any& rhs) const {
-  auto it = find(print_, std::type_index(rhs.type()));
-  if(it != print_.end()) {
-    return it->second(rhs);
+  const auto* op = print_.find(type_id(rhs.type()));
+  if(op) {
+    return (*op)(rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator 'print' is missing for the type '" << rhs.type().name()
@@ -542,9 +902,9 @@ linb::any OperatorProvider::eval_print(const linb::any& rhs) const {
   throw e;
 }
 linb::any OperatorProvider::eval_negative(const linb::any& rhs) const {
-  auto it = find(negative_, std::type_index(rhs.type()));
-  if(it != negative_.end()) {
-    return it->second(rhs);
+  const auto* op = negative_.find(type_id(rhs.type()));
+  if(op) {
+    return (*op)(rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator '-' (negative) is missing for the type '"
@@ -552,9 +912,9 @@ linb::any OperatorProvider::eval_negative(const linb::any& rhs) const {
   throw e;
 }
 linb::any OperatorProvider::eval_positive(const linb::any& rhs) const {
-  auto it = find(positive_, std::type_index(rhs.type()));
-  if(it != positive_.end()) {
-    return it->second(rhs);
+  const auto* op = positive_.find(type_id(rhs.type()));
+  if(op) {
+    return (*op)(rhs);
   }
   Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
   e << "The operator '+' (positive) is missing for the type '"
@@ -563,6 +923,13 @@ linb::any OperatorProvider::eval_positive(const linb::any& rhs) const {
 }
 linb::any OperatorProvider::eval(const UnaryOperation op,
                                  const linb::any& rhs) const {
+  const auto r = type_id(rhs.type());
+
+  Value ret;
+  if(is_primitive(r) && eval_primitive(op, primitive(rhs, r), ret)) {
+    return ret.to_any();
+  }
+
   switch(op) {
   case UnaryOperation::NOT:
     return eval_not(rhs);
@@ -580,7 +947,89 @@ linb::any OperatorProvider::eval(const UnaryOperation op,
   assert(false && "Reached by access after free and similar");
 }
 
-OperatorProvider::OperatorProvider() {
+bool OperatorProvider::to_bool(const Value& value) const {
+  if(value.type() == Value::Type::BOOL) {  // no need to convert
+    return value.as_bool();
+  }
+
+  const auto b = eval(UnaryOperation::BOOL, value);
+  if(b.type() != Value::Type::BOOL) {  // not a bool type ...
+    Exc<E, E::BAD_BOOL_CAST> e(__FILE__, __LINE__, "Bad bool cast");
+    e << "Tried cast '" << value.type_info().name()
+      << "' to bool but the operator returned '" << b.type_info().name()
+      << "'.";
+    throw e;
+  }
+  return b.as_bool();
+}
+
+Value OperatorProvider::eval(const BinaryOperation op, const Value& lhs,
+                             const Value& rhs) const {
+  Value ret;
+  if(eval_primitive(op, lhs, rhs, ret)) {
+    return ret;
+  }
+
+  switch(op) {
+  case BinaryOperation::AND:
+    return Value(to_bool(lhs) && to_bool(rhs));
+  case BinaryOperation::OR:
+    return Value(to_bool(lhs) || to_bool(rhs));
+  default:
+    break;
+  }
+
+  const auto* operato = table(op).find(type_id(lhs), type_id(rhs));
+  if(!operato) {
+    Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
+    e << "The operator " << name(op) << " is missing for the types '"
+      << lhs.type_info().name() << "' and '" << rhs.type_info().name()
+      << "'.";
+    throw e;
+  }
+  // only the operator functions work on linb::any
+  linb::any l;
+  linb::any r;
+  return Value::from_any((*operato)(any_of(lhs, l), any_of(rhs, r)));
+}
+
+Value OperatorProvider::eval(const UnaryOperation op, const Value& rhs) const {
+  Value ret;
+  if(eval_primitive(op, rhs, ret)) {
+    return ret;
+  }
+
+  if(op == UnaryOperation::NOT) {
+    const auto b = eval(UnaryOperation::BOOL, rhs);
+    if(b.type() != Value::Type::BOOL) {
+      Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
+      e << "The operator " << name(op) << " is missing for the type '"
+        << rhs.type_info().name() << "'.";
+      throw e;
+    }
+    return Value(!b.as_bool());
+  }
+
+  const auto* operato = table(op).find(type_id(rhs));
+  if(!operato) {
+    Exc<E, E::MISSING_OPERATOR> e(__FILE__, __LINE__, "Missing Operator");
+    e << "The operator " << name(op) << " is missing for the type '"
+      << rhs.type_info().name() << "'.";
+    throw e;
+  }
+  // only the operator functions work on linb::any
+  linb::any r;
+  return Value::from_any((*operato)(any_of(rhs, r)));
+}
+
+OperatorProvider::OperatorProvider()
+    : type_ids_({{typeid(void), static_cast<std::size_t>(Value::Type::EMPTY)},
+                 {typeid(bool), static_cast<std::size_t>(Value::Type::BOOL)},
+                 {typeid(int), static_cast<std::size_t>(Value::Type::INT)},
+                 {typeid(double),
+                  static_cast<std::size_t>(Value::Type::DOUBLE)},
+                 {typeid(std::string),
+                  static_cast<std::size_t>(Value::Type::STRING)}}) {
   using BiOp = BinaryOperation;
   using UnOp = UnaryOperation;
 
@@ -669,6 +1118,17 @@ OperatorProvider::OperatorProvider() {
       [](const linb::any& a) { return a; });
   add(UnOp::PRINT, std::type_index(typeid(void)),
       [this](const linb::any&) { return std::string("none"); });
+
+  // the operator functions for bool, int and double registered above are
+  // evaluated by eval_primitive without calling them
+  for(auto* table : {&divide_, &multiply_, &modulo_, &add_, &subtract_,
+                     &smaller_, &smaller_equal_, &greater_, &greater_equal_,
+                     &equal_, &not_equal_}) {
+    table->set_primitives();
+  }
+  for(auto* table : {&bool_, &negative_, &positive_}) {
+    table->set_primitives();
+  }
 }
 }
 }
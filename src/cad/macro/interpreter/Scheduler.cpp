@@ -0,0 +1,161 @@
+#include "cad/macro/interpreter/Scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+/**
+ * @brief  The iterations [begin, end) a worker still has to execute
+ */
+struct Range {
+  std::mutex mutex;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+};
+
+/**
+ * @brief   The state of one Scheduler::run
+ * @details The started workers hold it until they return, they may return
+ *          after run did.
+ */
+struct Shared {
+  std::vector<Range> ranges;
+  std::atomic<bool> failed;
+
+  std::mutex mutex;
+  std::condition_variable done;
+  std::size_t active = 0;  // started workers that didn't return yet
+  bool closed = false;     // set once run waits for the workers
+  std::exception_ptr error;
+  std::size_t error_iteration = std::numeric_limits<std::size_t>::max();
+
+  Shared(std::size_t workers)
+      : ranges(workers)
+      , failed(false) {
+  }
+
+  /**
+   * @brief  Takes the next iteration of the given worker, steals from the
+   *         other workers if the own range is empty
+   *
+   * @param  worker     The index of the worker
+   * @param  iteration  Set to the index of the taken iteration
+   *
+   * @return true if an iteration was taken, false if there are none left
+   */
+  bool next(std::size_t worker, std::size_t& iteration) {
+    {
+      auto& own = ranges[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+
+      if(own.begin < own.end) {
+        iteration = own.begin++;
+        return true;
+      }
+    }
+    for(std::size_t i = 1; i < ranges.size(); ++i) {
+      auto& victim = ranges[(worker + i) % ranges.size()];
+      std::size_t begin;
+      std::size_t end;
+      {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if(victim.begin >= victim.end) {
+          continue;
+        }
+        end = victim.end;
+        begin = end - (end - victim.begin + 1) / 2;
+        victim.end = begin;
+      }
+
+      auto& own = ranges[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      own.begin = begin + 1;
+      own.end = end;
+      iteration = begin;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief  Executes iterations until there are none left or one failed
+   *
+   * @param  worker  The index of the worker
+   * @param  task    The function that executes an iteration
+   */
+  void work(std::size_t worker, const Scheduler::Task& task) {
+    std::size_t iteration = 0;
+
+    try {
+      while(!failed && next(worker, iteration)) {
+        task(worker, iteration);
+      }
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      if(iteration < error_iteration) {
+        error = std::current_exception();
+        error_iteration = iteration;
+      }
+      failed = true;
+    }
+  }
+};
+}
+
+void Scheduler::run(const Future::Executor& executor, std::size_t workers,
+                    std::size_t iterations, const Task& task) {
+  workers = std::max<std::size_t>(std::min(workers, iterations), 1);
+  if(iterations == 0) {
+    return;
+  }
+
+  auto shared = std::make_shared<Shared>(workers);
+  for(std::size_t i = 0; i < workers; ++i) {
+    shared->ranges[i].begin = iterations * i / workers;
+    shared->ranges[i].end = iterations * (i + 1) / workers;
+  }
+
+  for(std::size_t i = 1; i < workers; ++i) {
+    try {
+      executor([shared, &task, i]() {
+        {
+          std::lock_guard<std::mutex> lock(shared->mutex);
+          if(shared->closed) {
+            return;  // run returned, the task may be gone
+          }
+          ++shared->active;
+        }
+        shared->work(i, task);
+
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        --shared->active;
+        shared->done.notify_all();
+      });
+    } catch(...) {
+      // the range of the worker is stolen by the others
+    }
+  }
+  shared->work(0, task);
+
+  std::unique_lock<std::mutex> lock(shared->mutex);
+  shared->closed = true;
+  shared->done.wait(lock, [&shared]() { return shared->active == 0; });
+
+  if(shared->error) {
+    std::rethrow_exception(shared->error);
+  }
+}
+}
+}
+}
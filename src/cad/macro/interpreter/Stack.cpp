@@ -7,26 +7,19 @@ namespace cad {
 namespace macro {
 namespace interpreter {
 namespace {
-[[noreturn]] void throw_function_exists(const char* const file,
-                                        const size_t line,
-                                        const std::string& name) {
-  Exc<Stack::E, Stack::E::FUNCTION_EXISTS> e(file, line, "The function exists");
-  e << "The function '" << name << "' already exists.";
-  throw e;
-}
 [[noreturn]] void throw_function_exists(const char* const file,
                                         const size_t line,
                                         const ast::callable::Function& fun) {
   bool first = true;
   Exc<Stack::E, Stack::E::FUNCTION_EXISTS> e(file, line, "The function exists");
-  e << "The function '" << fun.token.token
+  e << "The function '" << fun.token.text()
     << "', with the parameter signature '(";
   for(const auto& p : fun.parameter) {
     if(first) {
-      e << p.token.token;
+      e << p.token.text();
       first = false;
     } else {
-      e << ", " << p.token.token;
+      e << ", " << p.token.text();
     }
   }
   e << ")' already exists.";
@@ -34,90 +27,90 @@ namespace {
 }
 [[noreturn]] void throw_variable_exists(const char* const file,
                                         const size_t line,
-                                        const std::string& name) {
+                                        Stack::Name name) {
   Exc<Stack::E, Stack::E::VARIABLE_EXISTS> e(file, line, "The variable exists");
   e << "The variable '" << name << "' already exists.";
   throw e;
 }
 }
 
-Stack::Stack() {
+Stack::Stack()
+    : parent_(nullptr) {
+}
+Stack::Stack(Stack* parent)
+    : parent_(parent) {
 }
-Stack::Stack(std::shared_ptr<Stack> parent)
-    : parent_(std::move(parent)) {
+Stack::Stack(Stack* parent, std::size_t slots)
+    : parent_(parent)
+    , slots_(slots) {
+}
+
+void Stack::reset(Stack* parent, std::size_t slots, std::size_t variables) {
+  parent_ = parent;
+  functions_.clear();
+  scopes_.clear();
+  // clear and resize keep the capacity
+  variables_.clear();
+  variables_.resize(variables);
+  slots_.clear();
+  slots_.resize(slots);
 }
 
-std::shared_ptr<Stack> Stack::parent() const {
+Stack* Stack::parent() const {
   return parent_;
 }
 
-void Stack::add_variable(std::string name) {
-  if(exists_function(name)) {
-    throw_function_exists(__FILE__, __LINE__, name);
-  } else if(exists_variable(name)) {
+void Stack::add_variable(std::size_t slot, Name name) {
+  auto& var = variables_[slot];
+
+  if(var.defined) {
     throw_variable_exists(__FILE__, __LINE__, name);
   }
-  variables_.emplace_back(std::move(name), linb::any());
+  var.defined = true;
+}
+void Stack::add_alias(std::size_t slot, Name name, linb::any& variable) {
+  add_variable(slot, name);
+  variables_[slot].alias = &variable;
 }
 
-void Stack::add_function(FunctionRef fun) {
-  if(exists_function(fun.get())) {
-    throw_function_exists(__FILE__, __LINE__, fun);
-  } else if(exists_variable(fun.get().token.token)) {
-    throw_variable_exists(__FILE__, __LINE__, fun.get().token.token);
+linb::any& Stack::variable(const ast::Address& address, Name name) {
+  auto* stack = ancestor(address.depth);
+
+  if(!stack || !stack->has_variable(address.slot)) {
+    Exc<E, E::NOT_A_VARIABLE> e(__FILE__, __LINE__, "Not a variable");
+    e << "The is no variable '" << name << "' in this or any parent stacks.";
+    throw e;
   }
-  functions_.emplace_back(std::move(fun));
+  return stack->variable(address.slot);
 }
 
-void Stack::add_alias(std::string name, linb::any& variable) {
-  if(exists_function(name)) {
-    throw_function_exists(__FILE__, __LINE__, name);
-  } else if(exists_variable(name)) {
+void Stack::add_slot(std::size_t slot, const std::string& name) {
+  if(slots_[slot].defined) {
     throw_variable_exists(__FILE__, __LINE__, name);
   }
-  aliases_.emplace_back(std::move(name), variable);
+  slots_[slot].defined = true;
 }
-void Stack::remove_alias(std::string alias) {
-  auto it = find(aliases_, alias);
 
-  if(it != aliases_.end()) {
-    aliases_.erase(it);
+void Stack::add_function(FunctionRef fun) {
+  if(exists_function(fun.get())) {
+    throw_function_exists(__FILE__, __LINE__, fun);
   }
+  functions_.emplace_back(std::move(fun));
 }
-bool Stack::is_alias(const std::string& name) const {
-  auto it = find(aliases_, name);
-
-  return it != aliases_.end();
-}
-bool Stack::owns_variable(const std::string& name) const {
-  auto it = find(variables_, name);
-
-  return it != variables_.end();
-}
-
-bool Stack::has_variable(const std::string& name) const {
-  auto alias_it = find(aliases_, name);
 
-  if(alias_it != aliases_.end()) {
-    return true;
-  } else {
-    auto own_it = find(variables_, name);
-
-    if(own_it == variables_.end()) {
-      if(parent_) {
-        return parent_->has_variable(name);
-      }
-      return false;
-    } else {
-      return true;
+const ast::callable::Function*
+Stack::resolve_function(const ast::callable::Callable& call, Stack*& defined) {
+  for(auto* stack = this; stack; stack = stack->parent_) {
+    if(const auto* fun = stack->find_function(call)) {
+      defined = stack;
+      return fun;
     }
   }
+  return nullptr;
 }
 
 bool Stack::has_function(const ast::callable::Callable& call) const {
-  auto it = find_function(call);
-
-  if(it == functions_.end()) {
+  if(!find_function(call)) {
     if(parent_) {
       return parent_->has_function(call);
     }
@@ -0,0 +1,734 @@
+#include "cad/macro/interpreter/VM.h"
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/BatchProvider.h"
+#include "cad/macro/interpreter/CommandLink.h"
+#include "cad/macro/interpreter/FrameArena.h"
+#include "cad/macro/interpreter/Future.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+#include "cad/macro/interpreter/Scheduler.h"
+#include "cad/macro/interpreter/Stack.h"
+
+#include <cad/core/command/CommandInvoker.h>
+#include <cad/core/command/CommandProvider.h>
+#include <cad/core/command/argument/Arguments.h>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+namespace {
+using namespace ast;
+using namespace ast::callable;
+using namespace ast::loop;
+
+using OpCode = bytecode::OpCode;
+using BiOp = OperatorProvider::BinaryOperation;
+using UnOp = OperatorProvider::UnaryOperation;
+
+Value* find_variable(Stack& stack, const bytecode::Lookup& lookup) {
+  auto* frame = stack.ancestor(lookup.address.depth);
+
+  if(frame && frame->has_slot(lookup.address.slot)) {
+    auto& value = frame->slot(lookup.address.slot);
+
+    Future::join(value);  // the first read of an async call waits for it
+    return &value;
+  }
+  return nullptr;
+}
+
+Value& variable(Stack& stack, const bytecode::Bytecode& code,
+                const bytecode::Lookup& lookup) {
+  if(auto* value = find_variable(stack, lookup)) {
+    return *value;
+  }
+  // a function was called before the variable it reads was defined
+  Exc<Stack::E, Stack::E::NOT_A_VARIABLE> e(__FILE__, __LINE__,
+                                            "Not a variable");
+  e << "There is no variable '" << code.names[lookup.name]
+    << "' in this or any parent stacks.";
+  throw e;
+}
+
+// The value the reduction variable of an iteration starts with - a sum
+// starts at the zero of the type of the outer variable, the minimum and the
+// maximum at the outer variable. Both leave the combined result unchanged.
+Value seed(For::Reduction::Kind kind, const Value& outer) {
+  using Kind = For::Reduction::Kind;
+
+  switch(kind) {
+  case Kind::SUM:
+    switch(outer.type()) {
+    case Value::Type::INT:
+      return Value(0);
+    case Value::Type::DOUBLE:
+      return Value(0.0);
+    case Value::Type::STRING:
+      return Value(std::string());
+    default:
+      return Value();
+    }
+  case Kind::MIN:
+  case Kind::MAX:
+    return outer;
+  case Kind::COLLECT:
+    break;
+  }
+  return Value();
+}
+
+// Checks if the iterations can start the reduction independently - a sum of
+// a type without a zero, e.g. bool or a user type, can only continue the sum
+// of the previous iteration like the sequential loop does
+bool split(For::Reduction::Kind kind, const Value& outer) {
+  return kind != For::Reduction::Kind::SUM ||
+         outer.type() == Value::Type::INT ||
+         outer.type() == Value::Type::DOUBLE ||
+         outer.type() == Value::Type::STRING;
+}
+
+template <typename FUN>
+void add_exception_info(const parser::Token& token, const std::string& file,
+                        Exc<Interpreter::E, Interpreter::E::TAIL>& e, FUN fun) {
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
+  fun();
+  if(token.has_source_line()) {
+    e << '\n'
+      << token.source_line() << '\n'
+      << std::string(token.column() - 1, ' ') << "^";
+  }
+}
+}
+
+VM::VM(const Interpreter& interpreter)
+    : interpreter_(interpreter) {
+}
+
+linb::any VM::run(const bytecode::Bytecode& code, const std::string& file,
+                  Arguments args, const std::string& scope,
+                  std::ostream& out, const CommandLink* commands,
+                  const Cancellation& cancellation) const {
+  const auto& batch_provider = interpreter_.batch_provider_;
+  FrameArena frames;
+  BatchQueue batches(batch_provider ? batch_provider->chunk_size() : 1);
+  Futures futures;
+  Cancellation::Probe probe(cancellation);
+  const Context context{code,    file,    scope, frames, commands,
+                        batches, futures, out,   probe};
+  FrameArena::Frame root(frames, nullptr, code.chunks[0].slots.size());
+  linb::any ret;
+
+  try {
+    execute(context, 0, root.stack());
+
+    Continuation continuation;
+    std::size_t executed = 0;
+
+    enter_main(context, continuation, root.stack(), std::move(args));
+    step(context, continuation, 0, Clock::time_point::max(), executed);
+
+    ret = continuation.result.to_any();
+    Future::join(ret);
+    futures.join(file);
+  } catch(...) {
+    // the calls before the error were made
+    futures.wait();
+    batches.flush();
+    throw;
+  }
+  batches.flush();
+  return ret;
+}
+
+void VM::enter_main(const Context& context, Continuation& continuation,
+                    Stack& root, Arguments args) const {
+  const auto& code = context.code;
+  const Function* main = nullptr;
+  Stack* defined = nullptr;
+
+  Callable call({0, 0, "main"});
+  for(const auto& p : args) {
+    call.parameter.emplace_back(Variable({0, 0, p.name()}), Variable());
+  }
+  root.function(call, [&main, &defined](const Function& fun, Stack& s) {
+    main = &fun;
+    defined = &s;
+  });
+
+  try {
+    const auto chunk = code.function_chunks.at(main);
+    auto& inner =
+        context.frames.push(defined, code.chunks[chunk].slots.size());
+
+    continuation.activations.push_back({chunk, 0, &inner, main, true, true,
+                                        continuation.values.size(), Value(),
+                                        {}});
+    // the parameter are the first slots
+    for(std::size_t i = 0; i < main->parameter.size(); ++i) {
+      const auto name = main->parameter[i].token.text().to_string();
+
+      inner.add_slot(i, name);
+      inner.slot(i) = Value::from_any(std::move(args[name]));
+    }
+  } catch(std::exception&) {
+    clear(context, continuation);
+
+    Exc<E, E::TAIL> e;
+    add_exception_info(main->token, context.file, e, [&e]() {
+      e << "In the 'main' function defined here";
+    });
+    std::throw_with_nested(e);
+  }
+}
+
+bool VM::to_bool(const Value& value) const {
+  if(value.type() == Value::Type::BOOL) {  // no need to convert
+    return value.as_bool();
+  }
+  return interpreter_.any_to_bool(value.to_any());
+}
+
+Value VM::execute(const Context& context, std::uint32_t chunk,
+                  Stack& stack) const {
+  Continuation continuation;
+  std::size_t executed = 0;
+
+  continuation.activations.push_back(
+      {chunk, 0, &stack, nullptr, false, false, 0, Value(), {}});
+  step(context, continuation, 0, Clock::time_point::max(), executed);
+
+  return std::move(continuation.result);
+}
+
+bool VM::step(const Context& context, Continuation& continuation,
+              std::size_t steps, Clock::time_point deadline,
+              std::size_t& executed) const {
+  auto& activations = continuation.activations;
+  auto& values = continuation.values;
+  const bool timed = deadline != Clock::time_point::max();
+
+  executed = 0;
+
+  try {
+    while(!activations.empty()) {
+      // references into the Activation are invalid once another is pushed
+      auto& act = activations.back();
+      const auto chunk = act.chunk;
+      const auto& slots = context.code.chunks[chunk].slots;
+      const auto& code = context.code.chunks[chunk].code;
+      auto& stack = *act.stack;
+      auto& pc = act.pc;
+      bool switched = false;
+
+      while(!switched) {
+        // checked before the instruction, a stopped run continues with it
+        if(steps != 0 || timed) {
+          if((steps != 0 && executed == steps) ||
+             (timed && executed != 0 && executed % 64 == 0 &&
+              Clock::now() >= deadline)) {
+            return false;
+          }
+          ++executed;
+        }
+
+        const auto& in = code[pc++];
+
+        switch(in.code) {
+        case OpCode::CONSTANT:
+          values.push_back(context.code.constants[in.argument]);
+          break;
+        case OpCode::LOAD:
+          values.push_back(variable(stack, context.code,
+                                    context.code.lookups[in.argument]));
+          break;
+        case OpCode::SHADOW: {
+          const auto& shadow = context.code.shadows[in.argument];
+          const auto* outer =
+              find_variable(stack, context.code.lookups[shadow.lookup]);
+
+          // an undefined outer variable stays undefined until it is assigned
+          if(outer) {
+            stack.add_slot(shadow.slot, slots[shadow.slot]);
+            stack.slot(shadow.slot) = *outer;
+          }
+        } break;
+        case OpCode::STORE:
+          // always a slot of this stack, same as the Interpreter an
+          // assignment of a variable this stack doesn't own defines it - the
+          // outer variables a function assigns were copied by SHADOW
+          if(!stack.has_slot(in.argument)) {
+            stack.add_slot(in.argument, slots[in.argument]);
+          }
+          stack.slot(in.argument) = values.back();
+          break;
+        case OpCode::DEFINE_VARIABLE:
+          stack.add_slot(in.argument, slots[in.argument]);
+          break;
+        case OpCode::DEFINE_FUNCTION: {
+          const auto& def = context.code.definitions[in.argument];
+
+          // the slot belongs to this definition, loops enter the scope again
+          if(!stack.has_slot(def.slot)) {
+            stack.add_slot(def.slot,
+                           def.function.get().token.text().to_string());
+            if(chunk == 0) {  // run looks up main by its arguments
+              stack.add_function(def.function);
+            }
+          }
+        } break;
+        case OpCode::POP:
+          values.pop_back();
+          break;
+        case OpCode::BINARY: {
+          auto rhs = std::move(values.back());
+          values.pop_back();
+          auto& lhs = values.back();
+          lhs = interpreter_.operator_provider_->eval(
+              static_cast<BiOp>(in.argument), lhs, rhs);
+        } break;
+        case OpCode::UNARY: {
+          auto& rhs = values.back();
+          rhs = interpreter_.operator_provider_->eval(
+              static_cast<UnOp>(in.argument), rhs);
+        } break;
+        case OpCode::PRINT: {
+          auto& rhs = values.back();
+          rhs = interpreter_.operator_provider_->eval(UnOp::PRINT, rhs);
+          if(rhs.type() != Value::Type::STRING) {
+            throw linb::bad_any_cast();
+          }
+          context.batches.flush();
+          context.out << rhs.as_string();
+        } break;
+        case OpCode::JUMP:
+          if(in.argument < pc) {  // the back edge of a loop
+            context.probe.check(context.code.tokens[in.token].get(),
+                                context.file);
+          }
+          pc = in.argument;
+          break;
+        case OpCode::JUMP_IF_FALSE: {
+          auto con = std::move(values.back());
+          values.pop_back();
+          if(!to_bool(con)) {
+            pc = in.argument;
+          }
+        } break;
+        case OpCode::JUMP_IF_FALSE_OR_POP:
+          if(interpreter_.operator_provider_->to_bool(values.back())) {
+            values.pop_back();
+          } else {
+            values.back() = Value(false);
+            pc = in.argument;
+          }
+          break;
+        case OpCode::JUMP_IF_TRUE_OR_POP:
+          if(interpreter_.operator_provider_->to_bool(values.back())) {
+            values.back() = Value(true);
+            pc = in.argument;
+          } else {
+            values.pop_back();
+          }
+          break;
+        case OpCode::TO_BOOL:
+          values.back() =
+              Value(interpreter_.operator_provider_->to_bool(values.back()));
+          break;
+        case OpCode::CALL: {
+          const auto& site = context.code.calls[in.argument];
+          const auto& call = site.callable.get();
+          const auto first = values.size() - call.parameter.size();
+          const bytecode::Binding* binding = nullptr;
+          Stack* defined = nullptr;
+
+          for(const auto& b : site.candidates) {
+            defined = stack.ancestor(b.depth);
+
+            if(defined && defined->has_slot(b.slot)) {
+              binding = &b;
+              break;
+            }
+          }
+
+          if(binding) {
+            context.probe.check(call.token, context.file);
+
+            auto& inner = context.frames.push(
+                defined, context.code.chunks[binding->chunk].slots.size());
+
+            activations.push_back({binding->chunk, 0, &inner,
+                                   binding->function, false, true, first,
+                                   Value(), {}});
+            // the parameter are the first slots
+            for(std::size_t i = 0; i < call.parameter.size(); ++i) {
+              const auto slot = binding->parameter[i];
+
+              inner.add_slot(
+                  slot, call.parameter[i].first.token.text().to_string());
+              inner.slot(slot) = std::move(values[first + i]);
+            }
+            values.resize(first);
+            switched = true;
+          } else {
+            const bool discarded = code[pc].code == OpCode::POP;
+            auto ret =
+                command(context, in.argument, values.data() + first, discarded);
+
+            values.resize(first);
+            values.push_back(std::move(ret));
+          }
+        } break;
+        case OpCode::SET_RESULT:
+          act.result = std::move(values.back());
+          values.pop_back();
+          break;
+        case OpCode::CLEAR_RESULT:
+          act.result = Value();
+          break;
+        case OpCode::ITERATION:
+          act.iterations.push_back(std::move(values.back()));
+          values.pop_back();
+          break;
+        case OpCode::PARALLEL:
+          parallel(context, in.argument, stack, act.iterations);
+          act.iterations.clear();
+          break;
+        case OpCode::RETURN:
+          act.result = std::move(values.back());
+        // fall through
+        case OpCode::END: {
+          auto ret = std::move(act.result);
+
+          values.resize(act.base);
+          if(act.frame) {
+            context.frames.pop(stack);
+          }
+          activations.pop_back();
+
+          if(activations.empty()) {
+            continuation.result = std::move(ret);
+          } else {  // the result of the CALL
+            values.push_back(std::move(ret));
+          }
+          switched = true;
+        } break;
+        }
+      }
+    }
+  } catch(...) {
+    unwind(context, continuation);
+  }
+  return true;
+}
+
+void VM::unwind(const Context& context, Continuation& continuation) const {
+  auto error = std::current_exception();
+  auto wrap = [&error, &context](const parser::Token& token, auto message) {
+    try {
+      std::rethrow_exception(error);
+    } catch(...) {
+      try {
+        Exc<E, E::TAIL> e;
+        add_exception_info(token, context.file, e,
+                           [&e, &message]() { message(e); });
+        std::throw_with_nested(e);
+      } catch(...) {
+        error = std::current_exception();
+      }
+    }
+  };
+
+  bool located = false;  // only std::exception instances get the locations
+  try {
+    std::rethrow_exception(error);
+  } catch(std::exception&) {
+    located = true;
+  } catch(...) {
+  }
+
+  for(auto it = continuation.activations.rbegin();
+      located && it != continuation.activations.rend(); ++it) {
+    const auto& code = context.code.chunks[it->chunk].code;
+    const auto& token = context.code.tokens[code[it->pc - 1].token].get();
+
+    wrap(token, [&token](Exc<E, E::TAIL>& e) {
+      e << "At the '" << token.text() << "' defined here";
+    });
+    if(it->main) {
+      wrap(it->function->token, [](Exc<E, E::TAIL>& e) {
+        e << "In the 'main' function defined here";
+      });
+    } else if(it->function) {
+      const auto& fun = *it->function;
+
+      wrap(fun.token, [&fun](Exc<E, E::TAIL>& e) {
+        e << "In the '" << fun.token.text() << "' function defined here";
+      });
+    }
+  }
+  clear(context, continuation);
+  std::rethrow_exception(error);
+}
+
+void VM::clear(const Context& context, Continuation& continuation) const {
+  auto& activations = continuation.activations;
+
+  while(!activations.empty()) {
+    if(activations.back().frame) {
+      context.frames.pop(*activations.back().stack);
+    }
+    activations.pop_back();
+  }
+  continuation.values.clear();
+}
+
+Value VM::command(const Context& context, std::uint32_t index, Value* args,
+                  bool discarded) const {
+  const auto& call = context.code.calls[index].callable.get();
+  const auto* linked =
+      context.commands ? context.commands->calls[index].get() : nullptr;
+  Value ret;
+
+  if(linked) {
+    Arguments call_args;
+
+    for(std::size_t i = 0; i < call.parameter.size(); ++i) {
+      if(linked->accepted[i]) {
+        const linb::any val = args[i].to_any();
+        call_args.add(call.parameter[i].first.token.text().to_string(),
+                      "macro_call", val);
+      } else {
+        assert(false && "Too many arguments!");  // Should not happen
+      }
+    }
+    if(call.async) {
+      auto com = linked->prototype;
+
+      context.batches.flush();
+      ret = Value::from_any(context.futures.launch(
+          interpreter_.executor_, call.token,
+          [com, call_args]() mutable { return com.execute(call_args); }));
+    } else if(discarded && linked->batch) {
+      context.batches.add(*linked->batch, std::move(call_args));
+    } else {
+      auto com = linked->prototype;
+
+      context.batches.flush();
+      ret = Value::from_any(com.execute(call_args));
+    }
+  } else {
+    context.batches.flush();
+    try {
+      auto com =
+          CommandLink::lookup(*interpreter_.command_provider_, context.scope,
+                              call.token.text().to_string());
+      const auto& command_args = com.arguments();
+      Arguments call_args;
+
+      for(std::size_t i = 0; i < call.parameter.size(); ++i) {
+        const auto name = call.parameter[i].first.token.text().to_string();
+
+        if(command_args.has(name)) {
+          const linb::any val = args[i].to_any();
+          call_args.add(name, "macro_call", val);
+        } else {
+          assert(false && "Too many arguments!");  // Should not happen
+        }
+      }
+      ret = Value::from_any(com.execute(call_args));
+    } catch(...) {
+      bool once = true;
+      Exc<E, E::MISSING_FUNCTION> e(__FILE__, __LINE__, "Missing function");
+      e << "There was no matching function '" << call.token.text() << "(";
+      for(const auto& p : call.parameter) {
+        if(once) {
+          once = false;
+          e << p.first.token.text();
+        } else {
+          e << ", " << p.first.token.text();
+        }
+      }
+      e << ")'.";
+      throw e;
+    }
+  }
+  return ret;
+}
+
+void VM::parallel(const Context& context, std::uint32_t index, Stack& stack,
+                  const std::vector<Value>& iterations) const {
+  using Kind = For::Reduction::Kind;
+
+  struct Worker {
+    FrameArena frames;
+    Futures futures;
+    Cancellation::Probe probe;
+
+    Worker(const Cancellation& cancellation)
+        : probe(cancellation) {
+    }
+  };
+  struct Iteration {
+    std::string out;
+    BatchQueue batches;
+    std::vector<Value> reductions;
+  };
+
+  const auto& par = context.code.parallels[index];
+  const auto& foor = par.loop.get();
+  const auto& slots = context.code.chunks[par.chunk].slots;
+
+  // the iterations read the outer variables concurrently, they must not join
+  // them
+  stack.each_variable([](auto& var) { Future::join(var); });
+  context.batches.flush();
+
+  std::vector<Value> seeds;
+  bool in_order = false;  // the sums continue from iteration to iteration
+  for(std::size_t r = 0; r < par.stores.size(); ++r) {
+    seeds.push_back(
+        variable(stack, context.code, context.code.lookups[par.lookups[r]]));
+    in_order = in_order || !split(foor.reductions[r].kind, seeds.back());
+  }
+  // in order the first iteration starts the sums at the outer variables
+  for(std::size_t r = 0; r < seeds.size(); ++r) {
+    const auto kind = foor.reductions[r].kind;
+
+    if(!in_order || kind != Kind::SUM) {
+      seeds[r] = seed(kind, seeds[r]);
+    }
+  }
+
+  std::deque<Worker> workers;
+  std::vector<Iteration> results(iterations.size());
+  // a single worker takes the iterations in order
+  const auto count =
+      in_order ? 1 : std::min(interpreter_.workers_, iterations.size());
+  for(std::size_t i = 0; i < count; ++i) {
+    workers.emplace_back(context.probe.cancellation());
+  }
+  // the batched calls are passed on in the order of the iterations
+  const auto replay = [&context, &results]() {
+    for(auto& i : results) {
+      i.batches.replay(context.batches);
+    }
+    context.batches.flush();
+  };
+
+  try {
+    Scheduler::run(interpreter_.executor_, count, iterations.size(),
+                   [&](std::size_t w, std::size_t i) {
+                     auto& worker = workers[w];
+                     std::ostringstream out;
+                     const Context inner{context.code,       context.file,
+                                         context.scope,      worker.frames,
+                                         context.commands,   results[i].batches,
+                                         worker.futures,     out,
+                                         worker.probe};
+                     FrameArena::Frame frame(worker.frames, &stack,
+                                             slots.size());
+                     auto& body = frame.stack();
+
+                     // the loop variable and the reduction variables are the
+                     // first slots
+                     body.add_slot(0, slots[0]);
+                     body.slot(0) = iterations[i];
+                     for(std::size_t r = 1; r <= par.stores.size(); ++r) {
+                       body.add_slot(r, slots[r]);
+                       body.slot(r) =
+                           in_order && i > 0 &&
+                                   foor.reductions[r - 1].kind == Kind::SUM
+                               ? results[i - 1].reductions[r - 1]
+                               : seeds[r - 1];
+                     }
+
+                     execute(inner, par.chunk, body);
+
+                     for(std::size_t r = 1; r <= par.stores.size(); ++r) {
+                       Future::join(body.slot(r));
+                       results[i].reductions.push_back(
+                           std::move(body.slot(r)));
+                     }
+                     results[i].out = out.str();
+                   });
+    for(auto& w : workers) {
+      w.futures.join(context.file);
+    }
+    replay();
+  } catch(...) {
+    // the calls before the error were made
+    for(auto& w : workers) {
+      w.futures.wait();
+    }
+    replay();
+    throw;
+  }
+
+  for(const auto& i : results) {
+    context.out << i.out;
+  }
+  // same as an assignment of the reduction variable after the loop
+  for(std::size_t r = 0; r < par.stores.size(); ++r) {
+    const auto kind = foor.reductions[r].kind;
+    Value acc =
+        variable(stack, context.code, context.code.lookups[par.lookups[r]]);
+    std::vector<linb::any> list;
+
+    if(kind == Kind::COLLECT && acc.type() == Value::Type::BOXED &&
+       acc.type_info() == typeid(std::vector<linb::any>)) {
+      list = linb::any_cast<const std::vector<linb::any>&>(acc.as_boxed());
+    }
+    for(auto& i : results) {
+      auto& value = i.reductions[r];
+
+      if(value.empty()) {
+        continue;  // the iteration didn't contribute
+      }
+      switch(kind) {
+      case Kind::SUM:
+        if(in_order) {  // the last iteration has the whole sum
+          acc = std::move(value);
+        } else {
+          acc = acc.empty() ? std::move(value)
+                            : interpreter_.operator_provider_->eval(
+                                  BiOp::ADD, acc, value);
+        }
+        break;
+      case Kind::MIN:
+        if(acc.empty() || to_bool(interpreter_.operator_provider_->eval(
+                              BiOp::SMALLER, value, acc))) {
+          acc = std::move(value);
+        }
+        break;
+      case Kind::MAX:
+        if(acc.empty() || to_bool(interpreter_.operator_provider_->eval(
+                              BiOp::GREATER, value, acc))) {
+          acc = std::move(value);
+        }
+        break;
+      case Kind::COLLECT:
+        list.push_back(value.to_any());
+        break;
+      }
+    }
+    if(kind == Kind::COLLECT) {
+      acc = Value::from_any(linb::any(std::move(list)));
+    }
+
+    const auto slot = par.stores[r];
+    if(!stack.has_slot(slot)) {
+      stack.add_slot(slot,
+                     foor.reductions[r].variable.token.text().to_string());
+    }
+    stack.slot(slot) = std::move(acc);
+  }
+}
+}
+}
+}
@@ -0,0 +1,75 @@
+#include "cad/macro/interpreter/Value.h"
+
+namespace cad {
+namespace macro {
+namespace interpreter {
+Value Value::from_any(const linb::any& any) {
+  if(any.empty()) {
+    return Value();
+  } else if(any.type() == typeid(bool)) {
+    return Value(linb::any_cast<bool>(any));
+  } else if(any.type() == typeid(int)) {
+    return Value(linb::any_cast<int>(any));
+  } else if(any.type() == typeid(double)) {
+    return Value(linb::any_cast<double>(any));
+  } else if(any.type() == typeid(std::string)) {
+    return Value(linb::any_cast<std::string>(any));
+  }
+
+  Value value;
+  value.type_ = Type::BOXED;
+  value.shared_ = std::make_shared<const linb::any>(any);
+  return value;
+}
+Value Value::from_any(linb::any&& any) {
+  if(any.type() == typeid(std::string)) {
+    return Value(std::move(*linb::any_cast<std::string>(&any)));
+  } else if(any.empty() || any.type() == typeid(bool) ||
+            any.type() == typeid(int) || any.type() == typeid(double)) {
+    return from_any(static_cast<const linb::any&>(any));
+  }
+
+  Value value;
+  value.type_ = Type::BOXED;
+  value.shared_ = std::make_shared<const linb::any>(std::move(any));
+  return value;
+}
+
+linb::any Value::to_any() const {
+  switch(type_) {
+  case Type::EMPTY:
+    return {};
+  case Type::BOOL:
+    return bool_;
+  case Type::INT:
+    return int_;
+  case Type::DOUBLE:
+    return double_;
+  case Type::STRING:
+    return as_string();
+  case Type::BOXED:
+    return as_boxed();
+  }
+  return {};
+}
+
+const std::type_info& Value::type_info() const {
+  switch(type_) {
+  case Type::EMPTY:
+    return typeid(void);
+  case Type::BOOL:
+    return typeid(bool);
+  case Type::INT:
+    return typeid(int);
+  case Type::DOUBLE:
+    return typeid(double);
+  case Type::STRING:
+    return typeid(std::string);
+  case Type::BOXED:
+    return as_boxed().type();
+  }
+  return typeid(void);
+}
+}
+}
+}
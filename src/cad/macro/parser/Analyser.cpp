@@ -2,6 +2,7 @@
 
 #include "cad/macro/ast/Scope.h"
 #include "cad/macro/parser/Message.h"
+#include "cad/macro/parser/analyser/Frame.h"
 #include "cad/macro/parser/analyser/State.h"
 
 #include <algorithm>
@@ -43,6 +44,159 @@ std::reference_wrapper<const Token> node_to_token(const ast::Scope::Node& n) {
 
   return ret;
 }
+
+/**
+ * @brief  The variables a function defines and assigns, the bodies of the
+ *         functions and parallel loops in it are other frames and skipped
+ */
+struct Assignments {
+  using Name = std::experimental::string_view;
+
+  std::vector<Name> defined;
+  std::vector<Name> assigned;
+
+  void add(std::vector<Name>& names, Name name) {
+    if(std::find(names.begin(), names.end(), name) == names.end()) {
+      names.push_back(name);
+    }
+  }
+
+  void collect(const ast::ValueProducer& vp) {
+    using namespace ast;
+
+    eggs::match(vp.value, [&](const callable::Callable& o) { collect(o); },
+                [&](const Operator& o) { collect(o); },
+                [](const Variable&) {}, [](const Literal<Literals::BOOL>&) {},
+                [](const Literal<Literals::INT>&) {},
+                [](const Literal<Literals::DOUBLE>&) {},
+                [](const Literal<Literals::STRING>&) {});
+  }
+  void collect(const ast::Operator& op) {
+    if(op.left_operand) {
+      const auto* var = op.left_operand->value.target<ast::Variable>();
+
+      if(var && op.operation == ast::Operation::ASSIGNMENT) {
+        add(assigned, var->token.text());
+      } else {
+        collect(*op.left_operand);
+      }
+    }
+    if(op.right_operand) {
+      collect(*op.right_operand);
+    }
+  }
+  void collect(const ast::callable::Callable& call) {
+    for(const auto& p : call.parameter) {
+      collect(p.second);
+    }
+  }
+  void collect(const ast::Define& def) {
+    if(const auto* var = def.definition.target<ast::Variable>()) {
+      add(defined, var->token.text());
+    }
+  }
+  void collect(const ast::loop::For& foor) {
+    if(foor.define) {
+      collect(*foor.define);
+    }
+    if(foor.variable) {
+      collect(*foor.variable);
+    }
+    if(foor.condition) {
+      collect(*foor.condition);
+    }
+    if(foor.operation) {
+      collect(*foor.operation);
+    }
+    if(foor.parallel) {  // the reductions are assigned after the loop
+      for(const auto& r : foor.reductions) {
+        add(assigned, r.variable.token.text());
+      }
+    } else if(foor.scope) {
+      collect(*foor.scope);
+    }
+  }
+  void collect(const ast::Scope& scope) {
+    using namespace ast;
+
+    for(const auto& n : scope.nodes) {
+      eggs::match(n, [&](const Define& e) { collect(e); },
+                  [&](const Operator& e) { collect(e); },
+                  [&](const callable::Callable& e) { collect(e); },
+                  [&](const loop::For& e) { collect(e); },
+                  [&](const logic::If& e) {
+                    if(e.condition) {
+                      collect(*e.condition);
+                    }
+                    if(e.true_scope) {
+                      collect(*e.true_scope);
+                    }
+                    if(e.false_scope) {
+                      collect(*e.false_scope);
+                    }
+                  },
+                  [&](const loop::DoWhile& e) {
+                    if(e.condition) {
+                      collect(*e.condition);
+                    }
+                    if(e.scope) {
+                      collect(*e.scope);
+                    }
+                  },
+                  [&](const loop::While& e) {
+                    if(e.condition) {
+                      collect(*e.condition);
+                    }
+                    if(e.scope) {
+                      collect(*e.scope);
+                    }
+                  },
+                  [&](const callable::Return& e) {
+                    if(e.output) {
+                      collect(*e.output);
+                    }
+                  },
+                  [&](const Scope& e) { collect(e); },
+                  [](const loop::Break&) {}, [](const loop::Continue&) {},
+                  [](const Literal<Literals::BOOL>&) {},
+                  [](const Literal<Literals::DOUBLE>&) {},
+                  [](const Literal<Literals::INT>&) {},
+                  [](const Literal<Literals::STRING>&) {},
+                  [](const Variable&) {});
+    }
+  }
+};
+
+/**
+ * @brief  Enters the Frame of the given function: the parameter get the first
+ *         slots and the outer variables the function assigns are shadowed
+ *
+ * @param  outer  The State the function is defined in
+ * @param  inner  The State of the body of the function
+ * @param  frame  The Frame of the body of the function
+ * @param  fun    The function
+ */
+void enter(const State& outer, State& inner, analyser::Frame& frame,
+           const ast::callable::Function& fun) {
+  inner.stack.frame = &frame;
+  for(const auto& p : fun.parameter) {
+    p.address = {0, inner.stack.add_var(p)};
+  }
+
+  Assignments assignments;
+  assignments.collect(*fun.scope);
+
+  const auto& defined = assignments.defined;
+  for(const auto name : assignments.assigned) {
+    if(inner.stack.has_var(name, inner.stack) ||
+       std::find(defined.begin(), defined.end(), name) != defined.end()) {
+      continue;
+    }
+    if(auto address = outer.stack.address(name)) {
+      frame.shadow(name, {address->depth + 1, address->slot});
+    }
+  }
+}
 }
 
 //////////////////////////////////////////
@@ -51,13 +205,19 @@ std::reference_wrapper<const Token> node_to_token(const ast::Scope::Node& n) {
 void Analyser::analyse(State& state, const ast::Operator& e) {
   {
     Message m(e.token, file_);
-    m << "At the operator '" << e.token.token << "' defined here";
+    m << "At the operator '" << e.token.text() << "' defined here";
     current_message_.push_back(std::move(m));
   }
   biop.emit(*this, SignalType::START, state, e);
 
   if(e.left_operand) {
     analyse(state, *e.left_operand);
+
+    const auto* lhs = e.left_operand->value.target<ast::Variable>();
+    if(lhs && e.operation == ast::Operation::ASSIGNMENT) {
+      // an assignment writes the frame it runs in
+      lhs->address = {0, state.stack.frame->slot(lhs->token.text())};
+    }
   }
   if(e.right_operand) {
     analyse(state, *e.right_operand);
@@ -86,9 +246,10 @@ void Analyser::analyse(State& state, const ast::callable::EntryFunction& e) {
     State inner(state, *e.scope);
     inner.loop = false;        // we mark a new start
     inner.root_scope = false;  // we are not part of the root - we can return
-    for(const auto& p : e.parameter) {
-      inner.stack.variables.push_back(p);
-    }
+    inner.parallel = nullptr;  // the function assigns its own variables
+    inner.parallel_loop = false;
+    analyser::Frame frame(*e.scope);
+    enter(state, inner, frame, e);
 
     analyse(inner, *e.scope);
   }
@@ -100,9 +261,10 @@ void Analyser::analyse(State& state, const ast::callable::Function& e) {
     State inner(state, *e.scope);
     inner.loop = false;        // we mark a new start
     inner.root_scope = false;  // we are not part of the root - we can return
-    for(const auto& p : e.parameter) {
-      inner.stack.variables.push_back(p);
-    }
+    inner.parallel = nullptr;  // the function assigns its own variables
+    inner.parallel_loop = false;
+    analyser::Frame frame(*e.scope);
+    enter(state, inner, frame, e);
     analyse(inner, *e.scope);
   }
   fun.emit(*this, SignalType::END, state, e);
@@ -117,24 +279,26 @@ void Analyser::analyse(State& state, const ast::Define& e) {
                   current_message_.push_back(std::move(m));
                 }
                 analyse(state, e);
-                state.stack.functions.push_back(e);
+                state.stack.add_fun(e);
               },
               [this, &state](const ast::callable::Function& e) {
                 {
                   Message m(e.token, file_);
-                  m << "In the '" << e.token.token << "' function defined here";
+                  m << "In the '" << e.token.text()
+                    << "' function defined here";
                   current_message_.push_back(std::move(m));
                 }
                 analyse(state, e);
-                state.stack.functions.push_back(e);
+                state.stack.add_fun(e);
               },
               [this, &state](const ast::Variable& e) {
                 {
                   Message m(e.token, file_);
-                  m << "At the variable '" << e.token.token << "' defined here";
+                  m << "At the variable '" << e.token.text()
+                    << "' defined here";
                   current_message_.push_back(std::move(m));
                 }
-                state.stack.variables.push_back(e);
+                e.address = {0, state.stack.add_var(e)};
                 // We are good - if a variable is declared twice can be checked
                 // on the
                 // end signal
@@ -228,7 +392,27 @@ void Analyser::analyse(State& state, const ast::loop::For& e) {
   if(e.operation) {
     analyse(inner, *e.operation);
   }
-  if(e.scope) {
+  for(const auto& r : e.reductions) {
+    analyse(inner, r.variable);
+    // the reduction assigns the variable after the loop
+    r.variable.address = {0, inner.stack.frame->slot(r.variable.token.text())};
+  }
+  if(e.scope && e.parallel) {
+    // every iteration has its own frame with the loop and reduction variables
+    // in the first slots
+    analyser::Frame frame(*e.scope);
+    State body(inner, *e.scope, true);
+    body.stack.frame = &frame;
+    body.parallel = &body.stack;
+    body.parallel_loop = true;
+    if(const auto* var = e.loop_variable()) {
+      body.stack.add_var(*var);
+    }
+    for(const auto& r : e.reductions) {
+      body.stack.add_var(r.variable);
+    }
+    analyse(body, *e.scope);
+  } else if(e.scope) {
     analyse(inner, *e.scope);
   }
   forr.emit(*this, SignalType::END, state, e);
@@ -298,6 +482,9 @@ void Analyser::analyse(State& state, const ast::Scope& e) {
 }
 void Analyser::analyse(State& state, const ast::Variable& e) {
   var.emit(*this, SignalType::START, state, e);
+  if(auto address = state.stack.address(e.token.text())) {
+    e.address = *address;
+  }
   var.emit(*this, SignalType::END, state, e);
 }
 void Analyser::analyse(State& state, const ast::ValueProducer& e) {
@@ -347,8 +534,8 @@ void Analyser::continue_last_node() {
 void Analyser::return_last_node() {
   ret.connect([](Analyser& ana, SignalType t, const State& s, const auto& ret) {
     if(t == SignalType::START) {
-      // TODO missing !=
-      if(!(s.scope.get().nodes.back() == ast::Scope::Node(ret))) {
+      // the Return itself is the last node, not an equal one before it
+      if(s.scope.get().nodes.back().target<ast::callable::Return>() != &ret) {
         auto stack = ana.current_message_;
         Message m(node_to_token(s.scope.get().nodes.back()), ana.file_);
         m << "Statement after return";
@@ -402,11 +589,11 @@ void Analyser::unique_callable_parameter() {
     if(t == SignalType::START) {
       for(auto i = call.parameter.begin(); i != call.parameter.end(); ++i) {
         for(auto j = i + 1; j != call.parameter.end(); ++j) {
-          if(i->first.token.token == j->first.token.token) {
+          if(i->first.token.text() == j->first.token.text()) {
             auto stack = ana.current_message_;
             Message m1(i->first.token, ana.file_);
             m1 << "Parameter have to be uniquely named, but '"
-               << i->first.token.token << "' was defined here";
+               << i->first.token.text() << "' was defined here";
             Message m2(j->first.token, ana.file_);
             m2 << "and here";
             stack.push_back(std::move(m2));
@@ -423,11 +610,11 @@ void Analyser::unique_function_parameter() {
     if(t == SignalType::START) {
       for(auto i = fun.parameter.begin(); i != fun.parameter.end(); ++i) {
         for(auto j = i + 1; j != fun.parameter.end(); ++j) {
-          if(i->token.token == j->token.token) {
+          if(i->token.text() == j->token.text()) {
             auto stack = ana.current_message_;
             Message m1(i->token, ana.file_);
-            m1 << "Parameter have to be uniquely named, but '" << i->token.token
-               << "' was defined here";
+            m1 << "Parameter have to be uniquely named, but '"
+               << i->token.text() << "' was defined here";
             Message m2(j->token, ana.file_);
             m2 << "and here";
             stack.push_back(std::move(m2));
@@ -445,11 +632,11 @@ void Analyser::unique_main_parameter() {
     if(t == SignalType::START) {
       for(auto i = enfun.parameter.begin(); i != enfun.parameter.end(); ++i) {
         for(auto j = i + 1; j != enfun.parameter.end(); ++j) {
-          if(i->token.token == j->token.token) {
+          if(i->token.text() == j->token.text()) {
             auto stack = ana.current_message_;
             Message m1(i->token, ana.file_);
-            m1 << "Parameter have to be uniquely named, but '" << i->token.token
-               << "' was defined here";
+            m1 << "Parameter have to be uniquely named, but '"
+               << i->token.text() << "' was defined here";
             Message m2(j->token, ana.file_);
             m2 << "and here";
             stack.push_back(std::move(m2));
@@ -467,7 +654,7 @@ void Analyser::unique_main() {
         if(t == SignalType::START) {
           auto it = std::find_if(
               s.stack.functions.begin(), s.stack.functions.end(),
-              [](const auto& fun) { return fun.get().token.token == "main"; });
+              [](const auto& fun) { return fun.get().token.text() == "main"; });
           if(s.stack.functions.end() != it) {
             auto stack = ana.current_message_;
             Message m1(enfun.token, ana.file_);
@@ -509,10 +696,10 @@ void Analyser::main_in_root() {
 void Analyser::variable_available() {
   var.connect([](Analyser& ana, SignalType t, const State& s, const auto& var) {
     if(t == SignalType::START) {
-      if(!s.stack.has_var(var.token.token)) {
+      if(!s.stack.has_var(var.token.text())) {
         auto stack = ana.current_message_;
         Message m(var.token, ana.file_);
-        m << "Undefined variable '" << var.token.token << "'";
+        m << "Undefined variable '" << var.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -525,7 +712,7 @@ void Analyser::no_double_def_variable() {
       if(auto var = s.stack.has_double_var()) {
         auto stack = ana.current_message_;
         Message m1(var->second.get().token, ana.file_);
-        m1 << "Redefinition of variable '" << var->second.get().token.token
+        m1 << "Redefinition of variable '" << var->second.get().token.text()
            << "' here";
         Message m2(var->first.get().token, ana.file_);
         m2 << "and here";
@@ -542,7 +729,7 @@ void Analyser::no_double_def_function() {
       if(auto fun = s.stack.has_double_fun()) {
         auto stack = ana.current_message_;
         Message m1(fun->second.get().token, ana.file_);
-        m1 << "Redefinition of function '" << fun->second.get().token.token
+        m1 << "Redefinition of function '" << fun->second.get().token.text()
            << "' here";
         Message m2(fun->first.get().token, ana.file_);
         m2 << "and here";
@@ -563,14 +750,14 @@ void Analyser::op_operands() {
          biop.operation != ast::Operation::POSITIVE && !biop.left_operand) {
         auto stack = ana.current_message_;
         Message m(biop.token, ana.file_);
-        m << "Missing left operand '" << biop.token.token << "'";
+        m << "Missing left operand '" << biop.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
       if(!biop.right_operand) {
         auto stack = ana.current_message_;
         Message m(biop.token, ana.file_);
-        m << "Missing right operand '" << biop.token.token << "'";
+        m << "Missing right operand '" << biop.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -583,7 +770,7 @@ void Analyser::op_operator() {
       if(biop.operation == ast::Operation::NONE) {
         auto stack = ana.current_message_;
         Message m(biop.token, ana.file_);
-        m << "Missing operator '" << biop.token.token << "'";
+        m << "Missing operator '" << biop.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -595,7 +782,7 @@ void Analyser::op_assign_var() {
     auto stack = ana.current_message_;
     Message m(t, ana.file_);
     m << "Left hand side  has to be a variable, but was a " << type << " '"
-      << t.token << "'";
+      << t.text() << "'";
     stack.push_back(std::move(m));
     ana.messages_.push_back(std::move(stack));
   };
@@ -631,13 +818,155 @@ void Analyser::op_assign_var() {
         }
       });
 }
+void Analyser::async_call() {
+  auto check = [](Analyser& ana, const ast::ValueProducer* vp) {
+    const auto* call =
+        vp ? vp->value.target<ast::callable::Callable>() : nullptr;
+
+    if(call && call->async) {
+      auto stack = ana.current_message_;
+      Message m(call->token, ana.file_);
+      m << "The async call '" << call->token.text()
+        << "' has to be a statement or assigned to a variable";
+      stack.push_back(std::move(m));
+      ana.messages_.push_back(std::move(stack));
+    }
+  };
+
+  biop.connect([check](Analyser& ana, SignalType t, const State&,
+                       const auto& biop) {
+    if(t == SignalType::START) {
+      check(ana, biop.left_operand.get());
+      if(biop.operation != ast::Operation::ASSIGNMENT) {
+        check(ana, biop.right_operand.get());
+      }
+    }
+  });
+  call.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& call) {
+        if(t == SignalType::START) {
+          for(const auto& p : call.parameter) {
+            check(ana, &p.second);
+          }
+        }
+      });
+  ret.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& ret) {
+        if(t == SignalType::START) {
+          check(ana, ret.output.get());
+        }
+      });
+  iff.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& iff) {
+        if(t == SignalType::START) {
+          check(ana, iff.condition.get());
+        }
+      });
+  whi.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& whi) {
+        if(t == SignalType::START) {
+          check(ana, whi.condition.get());
+        }
+      });
+  dowhile.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& whi) {
+        if(t == SignalType::START) {
+          check(ana, whi.condition.get());
+        }
+      });
+  forr.connect(
+      [check](Analyser& ana, SignalType t, const State&, const auto& foor) {
+        if(t == SignalType::START) {
+          check(ana, foor.condition.get());
+        }
+      });
+}
+void Analyser::parallel_for() {
+  auto message = [](Analyser& ana, const Token& t, const auto& fun) {
+    auto stack = ana.current_message_;
+    Message m(t, ana.file_);
+    fun(m);
+    stack.push_back(std::move(m));
+    ana.messages_.push_back(std::move(stack));
+  };
+
+  forr.connect([message](Analyser& ana, SignalType t, const State& s,
+                         const auto& foor) {
+    if(t == SignalType::START && foor.parallel) {
+      if(!foor.loop_variable()) {
+        message(ana, foor.token, [](Message& m) {
+          m << "The parallel for needs a loop variable";
+        });
+      }
+      if(!foor.condition) {
+        message(ana, foor.token, [](Message& m) {
+          m << "The parallel for needs a condition";
+        });
+      }
+      for(auto i = foor.reductions.begin(); i != foor.reductions.end(); ++i) {
+        const auto& var = i->variable.token;
+
+        for(auto j = foor.reductions.begin(); j != i; ++j) {
+          if(j->variable.token.text() == var.text()) {
+            message(ana, var, [&var](Message& m) {
+              m << "The variable '" << var.text() << "' is reduced twice";
+            });
+          }
+        }
+        // the reduction assigns the variable after the loop
+        if(s.parallel && !s.stack.has_var(var.text(), *s.parallel)) {
+          message(ana, var, [&var](Message& m) {
+            m << "The parallel for can't reduce the outer variable '"
+              << var.text() << "'";
+          });
+        }
+      }
+    }
+  });
+  biop.connect([message](Analyser& ana, SignalType t, const State& s,
+                         const auto& biop) {
+    if(t == SignalType::START && s.parallel &&
+       biop.operation == ast::Operation::ASSIGNMENT && biop.left_operand) {
+      const auto* var =
+          biop.left_operand->value.template target<ast::Variable>();
+
+      if(var && !s.stack.has_var(var->token.text(), *s.parallel)) {
+        message(ana, var->token, [var](Message& m) {
+          m << "The parallel for can't assign the outer variable '"
+            << var->token.text() << "', it has to be a reduction";
+        });
+      }
+    }
+  });
+  br.connect(
+      [message](Analyser& ana, SignalType t, const State& s, const auto& br) {
+        if(t == SignalType::START && s.loop && s.parallel_loop) {
+          message(ana, br.token,
+                  [](Message& m) { m << "Break in parallel for"; });
+        }
+      });
+  con.connect(
+      [message](Analyser& ana, SignalType t, const State& s, const auto& con) {
+        if(t == SignalType::START && s.loop && s.parallel_loop) {
+          message(ana, con.token,
+                  [](Message& m) { m << "Continue in parallel for"; });
+        }
+      });
+  ret.connect(
+      [message](Analyser& ana, SignalType t, const State& s, const auto& ret) {
+        if(t == SignalType::START && s.parallel) {
+          message(ana, ret.token,
+                  [](Message& m) { m << "Return in parallel for"; });
+        }
+      });
+}
 void Analyser::function_scope() {
   fun.connect([](Analyser& ana, SignalType t, const State&, const auto& fun) {
     if(t == SignalType::START) {
       if(!fun.scope) {
         auto stack = ana.current_message_;
         Message m(fun.token, ana.file_);
-        m << "Missing scope '" << fun.token.token << "'";
+        m << "Missing scope '" << fun.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -651,7 +980,7 @@ void Analyser::main_scope() {
           if(!enfun.scope) {
             auto stack = ana.current_message_;
             Message m(enfun.token, ana.file_);
-            m << "Missing scope '" << enfun.token.token << "'";
+            m << "Missing scope '" << enfun.token.text() << "'";
             stack.push_back(std::move(m));
             ana.messages_.push_back(std::move(stack));
           }
@@ -664,7 +993,7 @@ void Analyser::if_scope() {
       if(!iff.true_scope) {
         auto stack = ana.current_message_;
         Message m(iff.token, ana.file_);
-        m << "Missing scope '" << iff.token.token << "'";
+        m << "Missing scope '" << iff.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -678,7 +1007,7 @@ void Analyser::do_while_scope() {
           if(!dowhile.scope) {
             auto stack = ana.current_message_;
             Message m(dowhile.token, ana.file_);
-            m << "Missing scope '" << dowhile.token.token << "'";
+            m << "Missing scope '" << dowhile.token.text() << "'";
             stack.push_back(std::move(m));
             ana.messages_.push_back(std::move(stack));
           }
@@ -691,7 +1020,7 @@ void Analyser::while_scope() {
       if(!whi.scope) {
         auto stack = ana.current_message_;
         Message m(whi.token, ana.file_);
-        m << "Missing scope '" << whi.token.token << "'";
+        m << "Missing scope '" << whi.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -704,7 +1033,7 @@ void Analyser::if_con() {
       if(!iff.condition) {
         auto stack = ana.current_message_;
         Message m(iff.token, ana.file_);
-        m << "Missing condition '" << iff.token.token << "'";
+        m << "Missing condition '" << iff.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -718,7 +1047,7 @@ void Analyser::do_while_con() {
           if(!dowhile.condition) {
             auto stack = ana.current_message_;
             Message m(dowhile.token, ana.file_);
-            m << "Missing condition '" << dowhile.token.token << "'";
+            m << "Missing condition '" << dowhile.token.text() << "'";
             stack.push_back(std::move(m));
             ana.messages_.push_back(std::move(stack));
           }
@@ -731,7 +1060,7 @@ void Analyser::while_con() {
       if(!whi.condition) {
         auto stack = ana.current_message_;
         Message m(whi.token, ana.file_);
-        m << "Missing condition '" << whi.token.token << "'";
+        m << "Missing condition '" << whi.token.text() << "'";
         stack.push_back(std::move(m));
         ana.messages_.push_back(std::move(stack));
       }
@@ -759,6 +1088,8 @@ Analyser::Analyser(std::string file)
   no_double_def_variable();
   no_double_def_function();
   op_assign_var();
+  async_call();
+  parallel_for();
   op_operands();     // Should not be needed - better safe than sorry
   op_operator();     // Should not be needed - better safe than sorry
   function_scope();  // Should not be needed - better safe than sorry
@@ -772,8 +1103,10 @@ Analyser::Analyser(std::string file)
 }
 
 std::vector<std::vector<Message>> Analyser::analyse(const ast::Scope& scope) {
+  analyser::Frame frame(scope);
   State state(scope);
   state.root_scope = true;
+  state.stack.frame = &frame;
 
   analyse(state, scope);
 
@@ -0,0 +1,235 @@
+#include "cad/macro/parser/Folder.h"
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <experimental/optional>
+#include <limits>
+
+namespace cad {
+namespace macro {
+namespace parser {
+namespace {
+using namespace ast;
+using namespace ast::callable;
+using namespace ast::logic;
+using namespace ast::loop;
+
+using OperatorProvider = interpreter::OperatorProvider;
+using BiOp = OperatorProvider::BinaryOperation;
+using UnOp = OperatorProvider::UnaryOperation;
+using Folded = std::experimental::optional<linb::any>;
+
+void fold_scope(Scope& scope, const OperatorProvider& operators);
+void fold(ValueProducer& vp, const OperatorProvider& operators);
+
+//////////////////////////////////////////
+/// Helper
+//////////////////////////////////////////
+Folded literal(const ValueProducer& vp) {
+  Folded value;
+
+  eggs::match(vp.value,
+              [&value](const Literal<Literals::BOOL>& e) { value = e.data; },
+              [&value](const Literal<Literals::INT>& e) { value = e.data; },
+              [&value](const Literal<Literals::DOUBLE>& e) { value = e.data; },
+              [&value](const Literal<Literals::STRING>& e) { value = e.data; },
+              [](const Callable&) {}, [](const Variable&) {},
+              [](const Operator&) {});
+  return value;
+}
+
+template <Literals T>
+void replace(ValueProducer& vp, Token token, const linb::any& value) {
+  Literal<T> lit(std::move(token));
+  lit.data = linb::any_cast<typename Literal<T>::DataType>(value);
+  vp.value = std::move(lit);
+}
+
+/**
+ * @brief  Checks if the division can be done without undefined behaviour,
+ *         integer division by zero and the overflow of INT_MIN / -1 are left
+ *         to the runtime
+ */
+bool safe_division(const linb::any& lhs, const linb::any& rhs) {
+  if(rhs.type() == typeid(bool)) {
+    return linb::any_cast<bool>(rhs);
+  } else if(rhs.type() == typeid(int)) {
+    const auto r = linb::any_cast<int>(rhs);
+    return r != 0 &&
+           !(r == -1 && lhs.type() == typeid(int) &&
+             linb::any_cast<int>(lhs) == std::numeric_limits<int>::min());
+  }
+  return true;
+}
+
+Folded evaluate(const Operator& op, const OperatorProvider& operators) {
+  const auto lhs = op.left_operand ? literal(*op.left_operand) : Folded();
+  const auto rhs = op.right_operand ? literal(*op.right_operand) : Folded();
+
+  auto binary = [&](const BiOp bi) {
+    if(!lhs || !rhs) {
+      return Folded();
+    } else if((bi == BiOp::DIVIDE || bi == BiOp::MODULO) &&
+              !safe_division(*lhs, *rhs)) {
+      return Folded();
+    }
+    return Folded(operators.eval(bi, *lhs, *rhs));
+  };
+  auto unary = [&](const UnOp un) {
+    if(!rhs) {
+      return Folded();
+    }
+    return Folded(operators.eval(un, *rhs));
+  };
+
+  try {
+    switch(op.operation) {
+    case Operation::NONE:
+    case Operation::ASSIGNMENT:
+    case Operation::PRINT:
+      return Folded();  // side effects
+    case Operation::DIVIDE:
+      return binary(BiOp::DIVIDE);
+    case Operation::MULTIPLY:
+      return binary(BiOp::MULTIPLY);
+    case Operation::MODULO:
+      return binary(BiOp::MODULO);
+    case Operation::ADD:
+      return binary(BiOp::ADD);
+    case Operation::SUBTRACT:
+      return binary(BiOp::SUBTRACT);
+    case Operation::SMALLER:
+      return binary(BiOp::SMALLER);
+    case Operation::SMALLER_EQUAL:
+      return binary(BiOp::SMALLER_EQUAL);
+    case Operation::GREATER:
+      return binary(BiOp::GREATER);
+    case Operation::GREATER_EQUAL:
+      return binary(BiOp::GREATER_EQUAL);
+    case Operation::EQUAL:
+      return binary(BiOp::EQUAL);
+    case Operation::NOT_EQUAL:
+      return binary(BiOp::NOT_EQUAL);
+    case Operation::AND:
+      return binary(BiOp::AND);
+    case Operation::OR:
+      return binary(BiOp::OR);
+    case Operation::NOT:
+      return unary(UnOp::NOT);
+    case Operation::TYPEOF:
+      return unary(UnOp::TYPEOF);
+    case Operation::NEGATIVE:
+      return unary(UnOp::NEGATIVE);
+    case Operation::POSITIVE:
+      return unary(UnOp::POSITIVE);
+    }
+  } catch(std::exception&) {
+    // Missing operators and bad casts are reported by the Interpreter with
+    // the position in the macro
+  }
+  return Folded();
+}
+
+//////////////////////////////////////////
+/// Fold
+//////////////////////////////////////////
+void fold(Operator& op, const OperatorProvider& operators) {
+  if(op.left_operand) {
+    fold(*op.left_operand, operators);
+  }
+  if(op.right_operand) {
+    fold(*op.right_operand, operators);
+  }
+}
+void fold(Callable& call, const OperatorProvider& operators) {
+  for(auto& p : call.parameter) {
+    fold(p.second, operators);
+  }
+}
+void fold(Define& def, const OperatorProvider& operators) {
+  auto fun = [&operators](Function& fun) { fold_scope(*fun.scope, operators); };
+
+  eggs::match(def.definition, [&fun](Function& e) { fun(e); },
+              [&fun](EntryFunction& e) { fun(e); }, [](Variable&) {});
+}
+void fold(Condition& con, const OperatorProvider& operators) {
+  if(con.condition) {
+    fold(*con.condition, operators);
+  }
+}
+void fold(While& whi, const OperatorProvider& operators) {
+  fold(static_cast<Condition&>(whi), operators);
+  fold_scope(*whi.scope, operators);
+}
+void fold(For& foor, const OperatorProvider& operators) {
+  if(foor.variable) {
+    fold(*foor.variable, operators);
+  }
+  if(foor.operation) {
+    fold(*foor.operation, operators);
+  }
+  fold(static_cast<While&>(foor), operators);
+}
+void fold(If& iff, const OperatorProvider& operators) {
+  fold(static_cast<Condition&>(iff), operators);
+  fold_scope(*iff.true_scope, operators);
+  if(iff.false_scope) {
+    fold_scope(*iff.false_scope, operators);
+  }
+}
+void fold(Return& ret, const OperatorProvider& operators) {
+  if(ret.output) {
+    fold(*ret.output, operators);
+  }
+}
+
+void fold(ValueProducer& vp, const OperatorProvider& operators) {
+  if(auto* call = vp.value.target<Callable>()) {
+    fold(*call, operators);
+  } else if(auto* op = vp.value.target<Operator>()) {
+    fold(*op, operators);  // the operands first to fold the whole tree
+
+    if(const auto value = evaluate(*op, operators)) {
+      // op is destroyed by replace
+      auto token = op->token;
+
+      if(value->type() == typeid(bool)) {
+        replace<Literals::BOOL>(vp, std::move(token), *value);
+      } else if(value->type() == typeid(int)) {
+        replace<Literals::INT>(vp, std::move(token), *value);
+      } else if(value->type() == typeid(double)) {
+        replace<Literals::DOUBLE>(vp, std::move(token), *value);
+      } else if(value->type() == typeid(std::string)) {
+        replace<Literals::STRING>(vp, std::move(token), *value);
+      }
+    }
+  }
+}
+
+void fold_scope(Scope& scope, const OperatorProvider& operators) {
+  for(auto& n : scope.nodes) {
+    eggs::match(n, [&operators](Operator& e) { fold(e, operators); },
+                [&operators](Callable& e) { fold(e, operators); },
+                [&operators](Define& e) { fold(e, operators); },
+                [&operators](DoWhile& e) { fold(e, operators); },
+                [&operators](For& e) { fold(e, operators); },
+                [&operators](If& e) { fold(e, operators); },
+                [&operators](Return& e) { fold(e, operators); },
+                [&operators](Scope& e) { fold_scope(e, operators); },
+                [&operators](While& e) { fold(e, operators); },
+                [](Break&) {}, [](Continue&) {},
+                [](Literal<Literals::BOOL>&) {},
+                [](Literal<Literals::INT>&) {},
+                [](Literal<Literals::DOUBLE>&) {},
+                [](Literal<Literals::STRING>&) {}, [](Variable&) {});
+  }
+}
+}
+
+void fold(Scope& root, const OperatorProvider& operators) {
+  fold_scope(root, operators);
+}
+}
+}
+}
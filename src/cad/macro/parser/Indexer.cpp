@@ -0,0 +1,58 @@
+#include "cad/macro/parser/Indexer.h"
+
+#include "cad/macro/ast/Scope.h"
+
+namespace cad {
+namespace macro {
+namespace parser {
+namespace {
+using namespace ast;
+using namespace ast::callable;
+using namespace ast::logic;
+using namespace ast::loop;
+
+void index_scope(Scope& scope);
+
+void index(Define& def) {
+  eggs::match(def.definition, [](Function& e) { index_scope(*e.scope); },
+              [](EntryFunction& e) { index_scope(*e.scope); },
+              [](Variable&) {});
+}
+void index(If& iff) {
+  index_scope(*iff.true_scope);
+  if(iff.false_scope) {
+    index_scope(*iff.false_scope);
+  }
+}
+
+void index_scope(Scope& scope) {
+  scope.functions.clear();
+
+  for(std::size_t i = 0; i < scope.nodes.size(); ++i) {
+    auto& n = scope.nodes[i];
+
+    if(auto* def = n.target<Define>()) {
+      if(!def->definition.target<Variable>()) {
+        scope.functions.push_back(i);
+      }
+    }
+    eggs::match(n, [](Define& e) { index(e); },
+                [](DoWhile& e) { index_scope(*e.scope); },
+                [](For& e) { index_scope(*e.scope); },
+                [](If& e) { index(e); }, [](Scope& e) { index_scope(e); },
+                [](While& e) { index_scope(*e.scope); }, [](Operator&) {},
+                [](Callable&) {}, [](Return&) {}, [](Break&) {},
+                [](Continue&) {}, [](Literal<Literals::BOOL>&) {},
+                [](Literal<Literals::INT>&) {},
+                [](Literal<Literals::DOUBLE>&) {},
+                [](Literal<Literals::STRING>&) {}, [](Variable&) {});
+  }
+}
+}
+
+void index_functions(Scope& root) {
+  index_scope(root);
+}
+}
+}
+}
@@ -11,12 +11,12 @@ Message::Message(std::reference_wrapper<const Token> token, std::string file)
 std::string Message::message() const {
   std::stringstream ss;
 
-  ss << file_ << ':' << token_.get().line << ':' << token_.get().column << ": "
-     << message_;
-  if(token_.get().source_line) {
+  ss << file_ << ':' << token_.get().line() << ':' << token_.get().column()
+     << ": " << message_;
+  if(token_.get().has_source_line()) {
     ss << '\n'
-       << *token_.get().source_line << '\n'
-       << std::string(token_.get().column - 1, ' ') << "^\n";
+       << token_.get().source_line() << '\n'
+       << std::string(token_.get().column() - 1, ' ') << "^\n";
   }
 
   return ss.str();
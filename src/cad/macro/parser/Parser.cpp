@@ -2,16 +2,21 @@
 
 #include "cad/macro/ast/Literal.h"
 #include "cad/macro/ast/Scope.h"
+#include "cad/macro/ast/ScopeArena.h"
 #include "cad/macro/ast/ValueProducer.h"
 #include "cad/macro/parser/Analyser.h"
+#include "cad/macro/parser/Folder.h"
+#include "cad/macro/parser/Indexer.h"
 #include "cad/macro/parser/Message.h"
+#include "cad/macro/parser/Token.h"
 #include "cad/macro/parser/Tokenizer.h"
 
 #include <exception.h>
 
 #include <cassert>
 #include <experimental/optional>
-#include <regex>
+#include <limits>
+#include <memory>
 #include <string>
 
 namespace cad {
@@ -40,6 +45,7 @@ using is_Operator =
 struct Tokens {
   const std::vector<Token>& tokens;
   const std::string file;
+  ast::ScopeArena& arena;  // of the root, the bodies of the nodes are in it
 
   const Token& at(size_t i) const {
     return tokens.at(i);
@@ -50,10 +56,6 @@ struct Tokens {
   }
 };
 
-static std::vector<std::string> keywords{
-    "if",   "else",  "do",     "while", "for",   "var",    "def",  "continue",
-    "main", "break", "return", "true",  "false", "typeof", "print"};
-
 //////////////////////////////////////////
 /// Exception
 //////////////////////////////////////////
@@ -182,24 +184,29 @@ void expect_token(const Tokens& tokens, size_t& token,
 bool read_token(const Tokens& tokens, size_t& token,
                 const char* const token_literal);
 /**
- * @brief  Expects to find the given Token, else it throws
+ * @brief  Expects to find a Token of the given kind
  *
- * @param  tokens       The tokens that are being parsed
- * @param  token        The current token that is being reported
- * @param  token_regex  The regex that matches the token that is expected
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
+ * @param  kind    The kind of the token that is expected
  *
- * @return true if the regex had a match, else false
+ * @return true if the token is of the kind, else false
  */
-bool read_token(const Tokens& tokens, size_t& token,
-                const std::regex& token_regex);
+bool read_token(const Tokens& tokens, size_t& token, const Token::Kind kind);
+/**
+ * @brief  Expects to find a name - an identifier or a keyword, the keyword is
+ *         reported by the caller
+ *
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
+ *
+ * @return true if the token is a name, else false
+ */
+bool read_name(const Tokens& tokens, size_t& token);
 
 //////////////////////////////////////////
 /// Literal parsing
 //////////////////////////////////////////
-/**
- * @brief  Unescapes the parsed string Literal
- */
-void unescape_string(std::string& s);
 /**
  * @brief  Tries to parse the current token as a bool literal
  *
@@ -211,6 +218,8 @@ parse_literal_bool(const Tokens& tokens, size_t& token);
  * @brief  Tries to parse the current token as a int literal
  *
  * @return The optional parsed int literal
+ *
+ * @throws UserSourceExc if the literal does not fit into an int
  */
 std::experimental::optional<ast::Literal<ast::Literals::INT>>
 parse_literal_int(const Tokens& tokens, size_t& token);
@@ -232,12 +241,6 @@ parse_literal_string(const Tokens& tokens, size_t& token);
 //////////////////////////////////////////
 /// Definition parsing
 //////////////////////////////////////////
-/**
- * @param  token  The token
- *
- * @return True if keyword, False otherwise.
- */
-bool is_keyword(const std::string& token);
 /**
  * @brief  Expects that the current token is not a keyword
  *
@@ -485,6 +488,22 @@ parse_continue(const Tokens& tokens, size_t& token);
 //////////////////////////////////////////
 /// Operator parsing
 //////////////////////////////////////////
+/**
+ * @brief  The binding powers of the ast::Operation instances, from the weakest
+ *         to the strongest
+ */
+enum class Power {
+  NONE,
+  ASSIGNMENT,  // =, right to left
+  PRINT,       // print, its operand reaches up to an assignment
+  OR,          // ||
+  AND,         // &&
+  EQUALITY,    // == !=
+  RELATION,    // < <= > >=
+  SUM,         // + -
+  PRODUCT,     // * / %
+  PREFIX,      // - + ! typeof
+};
 /**
  * @brief  Expects that the ast:.Operator has a type
  *
@@ -497,16 +516,6 @@ parse_continue(const Tokens& tokens, size_t& token);
 template <typename T, typename is_Operator<T>::type = false>
 void expect_operator_type(const char* const file, const size_t line,
                           const T& op);
-/**
- * @brief  Determine if the given node is a ValueProducer
- *
- * @param  node  The node to check
- *
- * @return true if value, false otherwise.
- *
- * @throws UserSourceExc
- */
-bool is_value(const ast::Scope::Node& node);
 /**
  * @brief  Converts the given node to a ast::ValueProducer
  *
@@ -546,125 +555,45 @@ ast::Operator node_to_operator(const Tokens& tokens, ast::Scope::Node& node);
 std::experimental::optional<ast::Variable>
 extract_var_def(ast::Scope::Node& node);
 /**
- * @brief   Sets up the operator assemble workspace
- *
- * @details This method tries to extract a variable from a definition previously
- *          parsed or a previously parsed ast::ValueProducer and pushes it into
- *          the workspace vector, that way the operator can consume the
- *          ast::ValueProducer if needed.
- *
- * @param   workspace  The workspace that will be set up
- * @param   nodes      The previously parsed nodes
- * @param   op         The operator that will be assembled
+ * @brief  The binding power of a binary ast::Operation
  *
+ * @param  operation  The ast::Operation
  *
- * @throws OperatorExc
+ * @return the binding power, Power::NONE if the ast::Operation is not binary
  */
-void setup_operator_wokespace(std::vector<ast::Scope::Node>& workspace,
-                              std::vector<ast::Scope::Node>& nodes,
-                              ast::Operator& op);
+Power binding_power(const ast::Operation operation);
 /**
- * @brief  Expects that the operator has enough operands to be assembled
+ * @brief  Expects that no operand follows a parsed expression
  *
- * @param  token          The token of the Operator
- * @param  file           The file name / macro name
- * @param  previous       The previous node
- * @param  next           The next node
- * @param  end            The end end of the nodes vector
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The token after the expression
  *
  * @throws UserSourceExc
  */
-void expect_operatees(const Token& token, const std::string& file,
-                      const std::vector<ast::Scope::Node>::iterator& previous,
-                      const std::vector<ast::Scope::Node>::iterator& next,
-                      const std::vector<ast::Scope::Node>::iterator& end);
-/**
- * @brief  Assembles the unary Operators
- *
- * @param  file      The file name / macro name
- * @param  nodes     The nodes that have to be assembled
- * @param  previous  The previous node
- * @param  next      The next node
- * @param  op        The current ast:.Operator that is about to be assembled
- *
- * @return true if the operator was assembled, else false
- */
-bool assamble_unary(const std::string& file,
-                    std::vector<ast::Scope::Node>& nodes,
-                    std::vector<ast::Scope::Node>::iterator& previous,
-                    std::vector<ast::Scope::Node>::iterator& next,
-                    ast::Operator& op);
+void expect_expression_end(const Tokens& tokens, const size_t token);
 /**
- * @brief  Assembles the binary Operators
+ * @brief  Expects that the current token is no binary ast::Operator, which
+ *         would miss its left hand operand
  *
- * @param  file      The file name / macro name
- * @param  nodes     The nodes that have to be assembled
- * @param  index     The index that marks the current position in the nodes
- *                   vector, after the assembly of a binary operator it will be
- *                   decremented. That __will__ invalidate all iterators!
- * @param  previous  The previous node
- * @param  next      The next node
- * @param  op        The current ast:.Operator that is about to be assembled
- *
- * @return true if the operator was assembled, else false
- */
-void assamble_binary(const std::string& file,
-                     std::vector<ast::Scope::Node>& nodes, size_t& index,
-                     std::vector<ast::Scope::Node>::iterator& previous,
-                     std::vector<ast::Scope::Node>::iterator& next,
-                     ast::Operator& op);
-/**
- * @brief  Assembles the given Operator with the given nodes
- *
- * @param  file   The file name / macro name
- * @param  nodes  The nodes that have to be assembled
- * @param  index  The index that marks the current position in the nodes vector,
- *                after the assembly of a binary operator it will be
- *                decremented. That __will__ invalidate all iterators!
- * @param  op     The current ast:.Operator that is about to be assembled
- */
-void assamble_operator(const std::string& file,
-                       std::vector<ast::Scope::Node>& nodes, size_t& index,
-                       ast::Operator& op);
-/**
- * @brief  Calls the given function with the nodes read from left to right (from
- *         top to bottom)
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
  *
- * @param  file   The file name / macro name
- * @param  nodes  The nodes that have to be assembled
- * @param  fun    The function to be executed at each ast::Operator to indicate
- *                if the operator should be assembled ([](ast::Operator& op) ->
- *                bool)
+ * @throws UserSourceExc
  */
-template <typename FUN>
-void assamble_operators_left_to_right(const std::string& file,
-                                      std::vector<ast::Scope::Node>& nodes,
-                                      FUN fun);
+void expect_no_binary_operator(const Tokens& tokens, const size_t token);
+
 /**
- * @brief  Calls the given function with the nodes read from right to left (from
- *         bottom to top)
+ * @brief  Tries to parse a unary ast::Operator
  *
- * @param  file   The file name / macro name
- * @param  nodes  The nodes that have to be assembled
- * @param  fun    The function to be executed at each ast::Operator to indicate
- *                if the operator should be assembled ([](ast::Operator& op) ->
- *                bool)
- */
-template <typename FUN>
-void assamble_operators_right_to_left(const std::string& file,
-                                      std::vector<ast::Scope::Node>& nodes,
-                                      FUN fun);
-/**
- * @brief  Assembles all ast::Operator instances in the nodes vector
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
  *
- * @param  file   The file name / macro name
- * @param  nodes  The nodes that have to be assembled
+ * @return The optional parsed ast::Operator
  */
-void assamble_operator(const std::string& file,
-                       std::vector<ast::Scope::Node>& nodes);
-
+std::experimental::optional<ast::Operator>
+parse_unary_operator(const Tokens& tokens, size_t& token);
 /**
- * @brief  Tries to parse a unary ast::Operator
+ * @brief  Tries to parse a binary ast::Operator
  *
  * @param  tokens  The tokens that are being parsed
  * @param  token   The current token that is being reported
@@ -672,56 +601,76 @@ void assamble_operator(const std::string& file,
  * @return The optional parsed ast::Operator
  */
 std::experimental::optional<ast::Operator>
-parse_unary_operator(const Tokens& tokens, size_t& token);
+parse_binary_operator(const Tokens& tokens, size_t& token);
 /**
- * @brief  Parses the operantees
+ * @brief  Tries to parse an operand without binary operators - a bracketed
+ *         expression, a ast::callable::Callable, a ast::Literal or a
+ *         ast::Variable
+ *
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
  *
- * @param  tokens     The tokens that are being parsed
- * @param  token      The current token that is being reported
- * @param  workspace  The workspace
+ * @return The optional parsed operand
  *
  * @throws UserSourceExc
  * @throws UserTailExc
- * @throws OperatorExc
- * @throws ConversionExc
  */
-void parse_operants(const Tokens& tokens, size_t& token,
-                    std::vector<ast::Scope::Node>& workspace);
+std::experimental::optional<ast::ValueProducer>
+parse_primary(const Tokens& tokens, size_t& token);
 /**
- * @brief  Tries to parse a binary ast::Operator
+ * @brief  Tries to parse an operand with its unary operators
  *
  * @param  tokens  The tokens that are being parsed
  * @param  token   The current token that is being reported
  *
- * @return The optional parsed ast::Operator
+ * @return The optional parsed operand
  *
  * @throws UserSourceExc
  * @throws UserTailExc
- * @throws OperatorExc
- * @throws ConversionExc
  */
-std::experimental::optional<ast::Operator>
-parse_binary_operator(const Tokens& tokens, size_t& token);
+std::experimental::optional<ast::ValueProducer>
+parse_operand(const Tokens& tokens, size_t& token);
+/**
+ * @brief   Parses the binary operators that follow an operand
+ *
+ * @details The binary operators are parsed in one pass by precedence
+ *          climbing, the operators that bind at least with the given power
+ *          are assembled with the left operand. The right operand of each of
+ *          them is parsed with a stronger power, or the same for the right to
+ *          left ast::Operation::ASSIGNMENT.
+ *
+ * @param   tokens  The tokens that are being parsed
+ * @param   token   The current token that is being reported
+ * @param   left    The left operand, afterwards the assembled ast::Operator
+ * @param   power   The weakest binding power that is parsed
+ *
+ * @throws  UserSourceExc
+ * @throws  UserTailExc
+ */
+void parse_binary_operators(const Tokens& tokens, size_t& token,
+                            ast::ValueProducer& left, const Power power);
 /**
- * @brief  Tries to parse the internal ast::Operator (unary or binary)
+ * @brief  Tries to parse an operand and the binary operators that bind at
+ *         least with the given power
  *
  * @param  tokens  The tokens that are being parsed
  * @param  token   The current token that is being reported
+ * @param  power   The weakest binding power that is parsed
  *
- * @return The optional parsed ast::Operator
+ * @return The optional parsed expression
  *
  * @throws UserSourceExc
  * @throws UserTailExc
- * @throws OperatorExc
- * @throws ConversionExc
  */
-std::experimental::optional<ast::Operator>
-parse_operator_internals(const Tokens& tokens, size_t& token);
+std::experimental::optional<ast::ValueProducer>
+parse_expression(const Tokens& tokens, size_t& token, const Power power);
 /**
- * @brief  Tries to parse and assemble the ast::Operators
+ * @brief  Tries to parse the ast::Operators that continue the last of the
+ *         nodes, the node is consumed unless it is a definition
  *
  * @param  tokens  The tokens that are being parsed
  * @param  token   The current token that is being reported
+ * @param  nodes   The previously parsed nodes, not empty
  *
  * @return The optional parsed ast::Operator
  *
@@ -733,7 +682,6 @@ parse_operator_internals(const Tokens& tokens, size_t& token);
 std::experimental::optional<ast::Operator>
 parse_operator(const Tokens& tokens, size_t& token,
                std::vector<ast::Scope::Node>& nodes);
-
 //////////////////////////////////////////
 /// Condition parsing
 //////////////////////////////////////////
@@ -932,6 +880,17 @@ void parse_for_operation(const Tokens& tokens, size_t& token,
  * @throws ConversionExc
  */
 void parse_for_header(const Tokens& tokens, size_t& token, ast::loop::For& f);
+/**
+ * @brief  Parses the reductions of a parallel ast::For (reduce(sum: a, ...))
+ *
+ * @param  tokens  The tokens that are being parsed
+ * @param  token   The current token that is being reported
+ * @param  f       The for the reductions were parsed for
+ *
+ * @throws UserSourceExc
+ */
+void parse_for_reductions(const Tokens& tokens, size_t& token,
+                          ast::loop::For& f);
 /**
  * @brief  Tries to parse a ast::For
  *
@@ -982,11 +941,11 @@ Token node_to_token(const ast::Scope::Node& node) {
 template <typename FUN>
 void add_exception_info(const Token& token, const std::string& file, UserExc& e,
                         FUN fun, const size_t arrow_position) {
-  e << file << ':' << token.line << ':' << token.column << ": ";
+  e << file << ':' << token.line() << ':' << token.column() << ": ";
   fun();
-  if(token.source_line) {
+  if(token.has_source_line()) {
     e << '\n'
-      << *token.source_line << '\n'
+      << token.source_line() << '\n'
       << std::string(arrow_position, ' ') << "^";
   }
 }
@@ -994,13 +953,13 @@ void add_exception_info(const Token& token, const std::string& file, UserExc& e,
 template <typename FUN>
 void add_exception_info(const Token& token, const std::string& file, UserExc& e,
                         FUN fun) {
-  add_exception_info(token, file, e, fun, token.column - 1);
+  add_exception_info(token, file, e, fun, token.column() - 1);
 }
 
 template <typename FUN>
 void add_exception_info_end(const Token& token, const std::string& file,
                             UserExc& e, FUN fun) {
-  add_exception_info(token, file, e, fun, token.column + token.token.size());
+  add_exception_info(token, file, e, fun, token.column() + token.length);
 }
 
 template <typename FUN>
@@ -1026,15 +985,16 @@ void add_exception_info(const Tokens& tokens, const size_t token, UserExc& e,
                                           const size_t token) {
   UserSourceExc e;
   add_exception_info(tokens, token, e, [&] {
-    e << "Unexpected token '" << tokens.at(token).token << '\'';
+    e << "Unexpected token '" << tokens.at(token).text() << '\'';
   });
   throw e;
 }
 [[noreturn]] void throw_unexprected_token(const Token& token,
                                           const std::string& file) {
   UserSourceExc e;
-  add_exception_info(token, file, e,
-                     [&] { e << "Unexpected token '" << token.token << '\''; });
+  add_exception_info(token, file, e, [&] {
+    e << "Unexpected token '" << token.text() << '\'';
+  });
   throw e;
 }
 
@@ -1046,8 +1006,8 @@ void add_exception_info(const Tokens& tokens, const size_t token, UserExc& e,
 }
 
 void expect_no_space_between_bracket(const Tokens& tokens, const size_t token) {
-  if(tokens.at(token).column + tokens.at(token).token.length() !=
-     tokens.at(token + 1).column) {
+  if(tokens.at(token).offset + tokens.at(token).length !=
+     tokens.at(token + 1).offset) {
     UserSourceExc e;
     add_exception_info(tokens, token, e, [&] {
       e << "There my not be any space between the function identifier and "
@@ -1062,7 +1022,7 @@ void expect_no_space_between_bracket(const Tokens& tokens, const size_t token) {
 //////////////////////////////////////////
 void expect_token(const Tokens& tokens, size_t& token,
                   const char* const token_literal) {
-  if(token >= tokens.size() || tokens.at(token).token != token_literal) {
+  if(token >= tokens.size() || tokens.at(token).text() != token_literal) {
     UserSourceExc e;
     add_exception_info_end(tokens, token, e,
                            [&] { e << "Missing '" << token_literal << "'"; });
@@ -1073,24 +1033,26 @@ void expect_token(const Tokens& tokens, size_t& token,
 
 bool read_token(const Tokens& tokens, size_t& token,
                 const char* const token_literal) {
-  if(token >= tokens.size() || tokens.at(token).token != token_literal) {
+  if(token >= tokens.size() || tokens.at(token).text() != token_literal) {
     return false;
   }
   ++token;
   return true;
 }
 
-bool read_token(const Tokens& tokens, size_t& token,
-                const std::regex& token_regex) {
-  std::smatch match;
-  if(token >= tokens.size() ||
-     !std::regex_match(tokens.at(token).token, match, token_regex)) {
+bool read_token(const Tokens& tokens, size_t& token, const Token::Kind kind) {
+  if(token >= tokens.size() || tokens.at(token).kind != kind) {
     return false;
   }
   ++token;
   return true;
 }
 
+bool read_name(const Tokens& tokens, size_t& token) {
+  return read_token(tokens, token, Token::Kind::IDENTIFIER) ||
+         read_token(tokens, token, Token::Kind::KEYWORD);
+}
+
 //////////////////////////////////////////
 /// Literal parsing
 //////////////////////////////////////////
@@ -1116,12 +1078,19 @@ parse_literal_bool(const Tokens& tokens, size_t& token) {
 
 std::experimental::optional<ast::Literal<ast::Literals::INT>>
 parse_literal_int(const Tokens& tokens, size_t& token) {
-  const static std::regex regex("([0-9]+)");
   auto tmp = token;
 
-  if(read_token(tokens, tmp, regex)) {
+  if(read_token(tokens, tmp, Token::Kind::INT)) {
+    if(tokens.at(token).integer > std::numeric_limits<int>::max()) {
+      UserSourceExc e;
+      add_exception_info(tokens, token, e, [&] {
+        e << "The number '" << tokens.at(token).text()
+          << "' is too large for an int.";
+      });
+      throw e;
+    }
     ast::Literal<ast::Literals::INT> lit(tokens.at(token));
-    lit.data = std::stoi(tokens.at(token).token);
+    lit.data = static_cast<int>(tokens.at(token).integer);
 
     token = tmp;
     return lit;
@@ -1131,12 +1100,11 @@ parse_literal_int(const Tokens& tokens, size_t& token) {
 
 std::experimental::optional<ast::Literal<ast::Literals::DOUBLE>>
 parse_literal_double(const Tokens& tokens, size_t& token) {
-  const static std::regex regex("([0-9]?.[0-9]+)");
   auto tmp = token;
 
-  if(read_token(tokens, tmp, regex)) {
+  if(read_token(tokens, tmp, Token::Kind::DOUBLE)) {
     ast::Literal<ast::Literals::DOUBLE> lit(tokens.at(token));
-    lit.data = std::stod(lit.token.token);
+    lit.data = lit.token.number;
 
     token = tmp;
     return lit;
@@ -1144,41 +1112,13 @@ parse_literal_double(const Tokens& tokens, size_t& token) {
   return {};
 }
 
-void unescape_string(std::string& s) {
-  auto replace_all = [&s](const std::string& search,
-                          const std::string& replace) {
-    for(size_t pos = 0;; pos += replace.length()) {
-      pos = s.find(search, pos);
-
-      if(pos == std::string::npos) {
-        break;
-      }
-      s.erase(pos, search.length());
-      s.insert(pos, replace);
-    }
-  };
-
-  replace_all("\\/", "/");
-  replace_all("\\\"", "\"");
-  replace_all("\\\\", "\\");
-  replace_all("\\b", "\b");
-  replace_all("\\f", "\f");
-  replace_all("\\n", "\n");
-  replace_all("\\r", "\r");
-  replace_all("\\t", "\t");
-  replace_all("\\a", "\a");
-}
-
 std::experimental::optional<ast::Literal<ast::Literals::STRING>>
 parse_literal_string(const Tokens& tokens, size_t& token) {
-  const static std::regex regex("(\\\".*\\\")");
   auto tmp = token;
 
-  if(read_token(tokens, tmp, regex)) {
+  if(read_token(tokens, tmp, Token::Kind::STRING)) {
     ast::Literal<ast::Literals::STRING> lit(tokens.at(token));
-    lit.data = lit.token.token.substr(1, lit.token.token.size() - 2);
-
-    unescape_string(lit.data);
+    lit.data = lit.token.content();
 
     token = tmp;
     return lit;
@@ -1189,20 +1129,11 @@ parse_literal_string(const Tokens& tokens, size_t& token) {
 //////////////////////////////////////////
 /// Definition parsing
 //////////////////////////////////////////
-bool is_keyword(const std::string& token) {
-  for(const auto& w : keywords) {
-    if(token == w) {
-      return true;
-    }
-  }
-  return false;
-}
-
 void expect_not_keyword(const Tokens& tokens, const size_t token) {
-  if(is_keyword(tokens.at(token).token)) {
+  if(tokens.at(token).kind == Token::Kind::KEYWORD) {
     UserSourceExc e;
     add_exception_info(tokens, token, e, [&] {
-      e << "'" << tokens.at(token).token
+      e << "'" << tokens.at(token).text()
         << "' is a keyword an may not be used as qualifier.";
     });
     throw e;
@@ -1232,10 +1163,10 @@ T parse_function_internals(const Tokens& tokens, size_t& token, T&& fun) {
     add_exception_info(tokens, tmp, e, [&] { e << "Expected a scope."; });
     throw e;
   }
-  fun.scope = std::make_unique<ast::Scope>(*std::move(fun_scope));
+  fun.scope = tokens.arena.add(*std::move(fun_scope));
   token = tmp;
 
-  return fun;
+  return std::move(fun);
 }
 
 std::experimental::optional<ast::callable::EntryFunction>
@@ -1260,10 +1191,9 @@ parse_entry_function(const Tokens& tokens, size_t& token) {
 
 std::experimental::optional<ast::callable::Function>
 parse_function(const Tokens& tokens, size_t& token) {
-  const static std::regex regex("([a-z][a-z0-9_]*)");
   auto tmp = token;
   try {
-    if(read_token(tokens, tmp, regex) && read_token(tokens, tmp, "(")) {
+    if(read_name(tokens, tmp) && read_token(tokens, tmp, "(")) {
       expect_not_keyword(tokens, token);
       expect_no_space_between_bracket(tokens, token);
 
@@ -1276,7 +1206,7 @@ parse_function(const Tokens& tokens, size_t& token) {
   } catch(UserExc&) {
     UserTailExc e;
     add_exception_info(tokens, token, e, [&tokens, &token, &e] {
-      e << "In the '" << tokens.at(token).token << "' function defined here";
+      e << "In the '" << tokens.at(token).text() << "' function defined here";
     });
     std::throw_with_nested(e);
   }
@@ -1320,7 +1250,7 @@ parse_variable_definition(const Tokens& tokens, size_t& token) {
   } catch(UserExc&) {
     UserTailExc e;
     add_exception_info(tokens, token, e, [&tokens, &token, &e] {
-      e << "At the '" << tokens.at(token).token << "' variable defined here";
+      e << "At the '" << tokens.at(token).text() << "' variable defined here";
     });
     std::throw_with_nested(e);
   }
@@ -1334,7 +1264,7 @@ void expect_named_parameter(const Tokens& tokens, size_t& token) {
   if(!read_token(tokens, token, ":")) {
     UserSourceExc e;
     add_exception_info(tokens, token, e, [&] {
-      e << "Expected a ':' after '" << tokens.at(token - 1).token
+      e << "Expected a ':' after '" << tokens.at(token - 1).text()
         << "' followed by an expression as value.";
     });
     throw e;
@@ -1367,7 +1297,7 @@ parse_callable_parameter(const Tokens& tokens, size_t& token) {
       UserSourceExc e;
       add_exception_info(tokens, tmp, e, [&] {
         e << "Expected an expression, but found this unexpected token '"
-          << tokens.at(tmp).token << '\'';
+          << tokens.at(tmp).text() << '\'';
       });
       throw e;
     }
@@ -1379,14 +1309,16 @@ parse_callable_parameter(const Tokens& tokens, size_t& token) {
 
 std::experimental::optional<ast::callable::Callable>
 parse_callable(const Tokens& tokens, size_t& token) {
-  const static std::regex regex("([a-z][a-z0-9_]*)");
-
   auto tmp = token;
   try {
-    if(read_token(tokens, tmp, regex) && read_token(tokens, tmp, "(")) {
-      expect_no_space_between_bracket(tokens, token);
+    const bool async = read_token(tokens, tmp, "async");
+    const auto name = tmp;
+
+    if(read_name(tokens, tmp) && read_token(tokens, tmp, "(")) {
+      expect_no_space_between_bracket(tokens, name);
 
-      ast::callable::Callable call(tokens.at(token));
+      ast::callable::Callable call(tokens.at(name));
+      call.async = async;
 
       while(tmp < tokens.size()) {
         if(auto param = parse_callable_parameter(tokens, tmp)) {
@@ -1406,7 +1338,7 @@ parse_callable(const Tokens& tokens, size_t& token) {
   } catch(UserExc&) {
     UserTailExc e;
     add_exception_info(tokens, token, e, [&tokens, &token, &e] {
-      e << "In the function call '" << tokens.at(token).token
+      e << "In the function call '" << tokens.at(token).text()
         << "' defined here";
     });
     std::throw_with_nested(e);
@@ -1431,62 +1363,90 @@ bool parse_scope_internals(const Tokens& tokens, size_t& token,
     }
   };
 
-  if(auto br = parse_break(tokens, token)) {
-    expect_end();
-    nodes.push_back(std::move(*br));
-  } else if(auto con = parse_continue(tokens, token)) {
-    expect_end();
-    nodes.push_back(std::move(*con));
-  } else if(auto def = parse_function_definition(tokens, token)) {
-    nodes.push_back(std::move(*def));
-  } else if(auto var_def = parse_variable_definition(tokens, token)) {
-    nodes.push_back(std::move(*var_def));
-    if(auto op = parse_operator(tokens, token, nodes)) {
-      if(op->operation != ast::Operation::ASSIGNMENT) {
-        throw_unexprected_token(op->token, tokens.file);
+  if(token >= tokens.size()) {
+    return false;
+  }
+
+  // the first token decides which statement is tried, the statement parsers
+  // return nothing only if it is not their keyword
+  switch(tokens.at(token).keyword) {
+  case Token::Keyword::BREAK:
+    if(auto br = parse_break(tokens, token)) {
+      expect_end();
+      nodes.push_back(std::move(*br));
+      return true;
+    }
+    break;
+  case Token::Keyword::CONTINUE:
+    if(auto con = parse_continue(tokens, token)) {
+      expect_end();
+      nodes.push_back(std::move(*con));
+      return true;
+    }
+    break;
+  case Token::Keyword::DEF:
+    if(auto def = parse_function_definition(tokens, token)) {
+      nodes.push_back(std::move(*def));
+      return true;
+    }
+    break;
+  case Token::Keyword::VAR:
+    if(auto var_def = parse_variable_definition(tokens, token)) {
+      nodes.push_back(std::move(*var_def));
+      if(auto op = parse_operator(tokens, token, nodes)) {
+        if(op->operation != ast::Operation::ASSIGNMENT) {
+          throw_unexprected_token(op->token, tokens.file);
+        }
+        nodes.push_back(std::move(*op));
       }
-      nodes.push_back(std::move(*op));
+      expect_end();
+      return true;
     }
-    expect_end();
-  } else if(auto iff = parse_if(tokens, token)) {
-    nodes.push_back(std::move(*iff));
-  } else if(auto whi = parse_while(tokens, token)) {
-    nodes.push_back(std::move(*whi));
-  } else if(auto dwhi = parse_do_while(tokens, token)) {
-    nodes.push_back(std::move(*dwhi));
-    expect_end();
-  } else if(auto foor = parse_for(tokens, token)) {
-    nodes.push_back(std::move(*foor));
-  } else if(auto ret = parse_return(tokens, token)) {
-    nodes.push_back(std::move(*ret));
-    expect_end();
+    break;
+  case Token::Keyword::IF:
+    if(auto iff = parse_if(tokens, token)) {
+      nodes.push_back(std::move(*iff));
+      return true;
+    }
+    break;
+  case Token::Keyword::WHILE:
+    if(auto whi = parse_while(tokens, token)) {
+      nodes.push_back(std::move(*whi));
+      return true;
+    }
+    break;
+  case Token::Keyword::DO:
+    if(auto dwhi = parse_do_while(tokens, token)) {
+      nodes.push_back(std::move(*dwhi));
+      expect_end();
+      return true;
+    }
+    break;
+  case Token::Keyword::FOR:
+  case Token::Keyword::PARALLEL:
+    if(auto foor = parse_for(tokens, token)) {
+      nodes.push_back(std::move(*foor));
+      return true;
+    }
+    break;
+  case Token::Keyword::RETURN:
+    if(auto ret = parse_return(tokens, token)) {
+      nodes.push_back(std::move(*ret));
+      expect_end();
+      return true;
+    }
+    break;
+  default:
+    break;
+  }
+
+  // callables, literals and variables are expressions as well
+  if(auto scope = parse_scope(tokens, token)) {
+    nodes.push_back(std::move(*scope));
+  } else if(read_token(tokens, token, ";")) {
   } else if(auto condition = parse_condition(tokens, token)) {
     nodes.push_back(value_to_node(*condition));
     expect_end();
-  } else if(auto call = parse_callable(tokens, token)) {
-    nodes.push_back(std::move(*call));
-    expect_end();
-  } else if(auto lit_bool = parse_literal_bool(tokens, token)) {
-    nodes.push_back(std::move(*lit_bool));
-    expect_end();
-  } else if(auto lit_int = parse_literal_int(tokens, token)) {
-    nodes.push_back(std::move(*lit_int));
-    expect_end();
-  } else if(auto lit_double = parse_literal_double(tokens, token)) {
-    nodes.push_back(std::move(*lit_double));
-    expect_end();
-  } else if(auto lit_string = parse_literal_string(tokens, token)) {
-    nodes.push_back(std::move(*lit_string));
-    expect_end();
-  } else if(auto scope = parse_scope(tokens, token)) {
-    nodes.push_back(std::move(*scope));
-  } else if(auto var = parse_variable(tokens, token)) {
-    nodes.push_back(std::move(*var));
-    if(auto op = parse_operator(tokens, token, nodes)) {
-      nodes.push_back(std::move(*op));
-    }
-    expect_end();
-  } else if(read_token(tokens, token, ";")) {
   } else {
     return false;
   }
@@ -1524,10 +1484,9 @@ std::experimental::optional<ast::Scope> parse_scope(const Tokens& tokens,
 //////////////////////////////////////////
 std::experimental::optional<ast::Variable> parse_variable(const Tokens& tokens,
                                                           size_t& token) {
-  const static std::regex regex("([a-z][a-z0-9_]*)");
   auto tmp = token;
 
-  if(read_token(tokens, tmp, regex)) {
+  if(read_name(tokens, tmp)) {
     expect_not_keyword(tokens, token);
 
     ast::Variable var(Token(tokens.at(token)));
@@ -1724,301 +1683,200 @@ extract_var_def(ast::Scope::Node& node) {
   return ret;
 }
 
-void setup_operator_wokespace(std::vector<ast::Scope::Node>& workspace,
-                              std::vector<ast::Scope::Node>& nodes,
-                              ast::Operator& op) {
-  expect_operator_type(__FILE__, __LINE__, op);
-
-  if(nodes.size() > 0) {
-    if(auto var = extract_var_def(nodes.back())) {
-      workspace.push_back(std::move(*var));
-    } else {
-      workspace.push_back(std::move(nodes.back()));
-      nodes.erase(nodes.end() - 1);
+Power binding_power(const ast::Operation operation) {
+  switch(operation) {
+  case ast::Operation::ASSIGNMENT:
+    return Power::ASSIGNMENT;
+  case ast::Operation::OR:
+    return Power::OR;
+  case ast::Operation::AND:
+    return Power::AND;
+  case ast::Operation::EQUAL:
+  case ast::Operation::NOT_EQUAL:
+    return Power::EQUALITY;
+  case ast::Operation::SMALLER:
+  case ast::Operation::SMALLER_EQUAL:
+  case ast::Operation::GREATER:
+  case ast::Operation::GREATER_EQUAL:
+    return Power::RELATION;
+  case ast::Operation::ADD:
+  case ast::Operation::SUBTRACT:
+    return Power::SUM;
+  case ast::Operation::DIVIDE:
+  case ast::Operation::MULTIPLY:
+  case ast::Operation::MODULO:
+    return Power::PRODUCT;
+  default:
+    return Power::NONE;
+  }
+}
+
+void expect_expression_end(const Tokens& tokens, const size_t token) {
+  if(token >= tokens.size()) {
+    return;
+  }
+  const auto& next = tokens.at(token);
+
+  switch(next.kind) {
+  case Token::Kind::IDENTIFIER:
+  case Token::Kind::KEYWORD:
+  case Token::Kind::INT:
+  case Token::Kind::DOUBLE:
+  case Token::Kind::STRING:
+    throw_unexprected_token(tokens, token);
+  default:
+    if(next.text() == "(" || next.text() == "!") {
+      throw_unexprected_token(tokens, token);
     }
   }
-  workspace.push_back(std::move(op));
 }
 
-void parse_operants(const Tokens& tokens, size_t& token,
-                    std::vector<ast::Scope::Node>& workspace) {
+void expect_no_binary_operator(const Tokens& tokens, const size_t token) {
   auto tmp = token;
 
-  while(tmp < tokens.size()) {
+  if(auto bi = parse_binary_operator(tokens, tmp)) {
+    const bool right = static_cast<bool>(parse_operand(tokens, tmp));
+    UserSourceExc e;
+    add_exception_info(bi->token, tokens.file, e, [&] {
+      e << (right ? "Missing left hand token for binary operator '"
+                  : "Missing left and right hand token for binary operator '")
+        << bi->token.text() << '\'';
+    });
+    throw e;
+  }
+}
+
+std::experimental::optional<ast::ValueProducer>
+parse_primary(const Tokens& tokens, size_t& token) {
+  auto tmp = token;
+  std::experimental::optional<ast::ValueProducer> ret;
+
+  if(token >= tokens.size()) {
+    return ret;
+  }
+
+  switch(tokens.at(token).kind) {
+  case Token::Kind::INT:
+    if(auto lit_int = parse_literal_int(tokens, tmp)) {
+      ret.emplace(std::move(*lit_int));
+    }
+    break;
+  case Token::Kind::DOUBLE:
+    if(auto lit_double = parse_literal_double(tokens, tmp)) {
+      ret.emplace(std::move(*lit_double));
+    }
+    break;
+  case Token::Kind::STRING:
+    if(auto lit_string = parse_literal_string(tokens, tmp)) {
+      ret.emplace(std::move(*lit_string));
+    }
+    break;
+  case Token::Kind::IDENTIFIER:
+  case Token::Kind::KEYWORD:
+    if(auto exe = parse_callable(tokens, tmp)) {
+      ret.emplace(std::move(*exe));
+    } else if(auto lit_bool = parse_literal_bool(tokens, tmp)) {
+      ret.emplace(std::move(*lit_bool));
+    } else if(auto var = parse_variable(tokens, tmp)) {
+      ret.emplace(std::move(*var));
+    }
+    break;
+  case Token::Kind::PUNCTUATION:
     if(read_token(tokens, tmp, "(")) {
-      if(auto con = parse_condition(tokens, tmp)) {
-        workspace.push_back(value_to_node(*con));
-        expect_token(tokens, tmp, ")");
-      } else {
+      ret = parse_condition(tokens, tmp);
+      if(!ret) {
         UserSourceExc e;
         add_exception_info(tokens, tmp, e,
                            [&] { e << "Expected an expression."; });
         throw e;
       }
-    } else if(auto op = parse_operator_internals(tokens, tmp)) {
-      workspace.push_back(std::move(*op));
-    } else if(auto exe = parse_callable(tokens, tmp)) {
-      workspace.push_back(std::move(*exe));
-    } else if(auto lit_bool = parse_literal_bool(tokens, tmp)) {
-      workspace.push_back(std::move(*lit_bool));
-    } else if(auto lit_int = parse_literal_int(tokens, tmp)) {
-      workspace.push_back(std::move(*lit_int));
-    } else if(auto lit_double = parse_literal_double(tokens, tmp)) {
-      workspace.push_back(std::move(*lit_double));
-    } else if(auto lit_string = parse_literal_string(tokens, tmp)) {
-      workspace.push_back(std::move(*lit_string));
-    } else if(auto var = parse_variable(tokens, tmp)) {
-      workspace.push_back(std::move(*var));
-    } else {
-      break;  // We are done
+      expect_token(tokens, tmp, ")");
     }
+    break;
+  default:
+    break;
   }
 
-  token = tmp;
-}
-
-void expect_operatees(const Token& token, const std::string& file,
-                      const std::vector<ast::Scope::Node>::iterator& previous,
-                      const std::vector<ast::Scope::Node>::iterator& next,
-                      const std::vector<ast::Scope::Node>::iterator& end) {
-  if(previous == end && next == end) {
-    UserSourceExc e;
-    add_exception_info(token, file, e, [&] {
-      e << "Missing left and right hand token for binary operator '"
-        << token.token << '\'';
-    });
-    throw e;
-  }
-  if(previous == end) {
-    UserSourceExc e;
-    add_exception_info(token, file, e, [&] {
-      e << "Missing left hand token for binary operator '" << token.token
-        << '\'';
-    });
-    throw e;
-  }
-  if(next == end) {
-    UserSourceExc e;
-    add_exception_info(token, file, e, [&] {
-      e << "Missing right hand token for binary operator '" << token.token
-        << '\'';
-    });
-    throw e;
+  if(ret) {
+    token = tmp;
   }
-}
-
-bool is_value(const ast::Scope::Node& node) {
-  using namespace ast;
-
-  bool ret = false;
-
-  eggs::match(node, [&ret](const Operator&) { ret = false; },
-              [&ret](const loop::Break&) { ret = false; },
-              [&ret](const loop::Continue&) { ret = false; },
-              [&ret](const Variable&) { ret = true; },
-              [&ret](const Define&) { ret = false; },
-              [&ret](const callable::Callable&) { ret = true; },
-              [&ret](const callable::Return&) { ret = false; },
-              [&ret](const Scope&) { ret = false; },
-              [&ret](const logic::If&) { ret = false; },
-              [&ret](const loop::While&) { ret = false; },
-              [&ret](const loop::DoWhile&) { ret = false; },
-              [&ret](const loop::For&) { ret = false; },
-              [&ret](const Literal<Literals::BOOL>&) { ret = true; },
-              [&ret](const Literal<Literals::INT>&) { ret = true; },
-              [&ret](const Literal<Literals::DOUBLE>&) { ret = true; },
-              [&ret](const Literal<Literals::STRING>&) { ret = true; });
-
   return ret;
 }
 
-bool assamble_unary(const std::string& file,
-                    std::vector<ast::Scope::Node>& nodes,
-                    std::vector<ast::Scope::Node>::iterator& previous,
-                    std::vector<ast::Scope::Node>::iterator& next,
-                    ast::Operator& op) {
-  if(next == nodes.end()) {
-    UserSourceExc e;
-    add_exception_info(op.token, file, e, [&] {
-      e << "Missing token for unary operator '" << op.token.token << '\'';
-    });
-    throw e;
-  }
+std::experimental::optional<ast::ValueProducer>
+parse_operand(const Tokens& tokens, size_t& token) {
+  auto tmp = token;
 
-  if(op.operation == ast::Operation::NEGATIVE && previous != nodes.end() &&
-     is_value(*previous)) {
-    op.operation = ast::Operation::SUBTRACT;
-    return true;
-  } else if(op.operation == ast::Operation::POSITIVE &&
-            previous != nodes.end() && is_value(*previous)) {
-    op.operation = ast::Operation::ADD;
-    return true;
-  }
-
-  if(op.operation == ast::Operation::NOT ||
-     op.operation == ast::Operation::PRINT ||
-     op.operation == ast::Operation::TYPEOF ||
-     op.operation == ast::Operation::NEGATIVE ||
-     op.operation == ast::Operation::POSITIVE) {
-    op.right_operand =
-        std::make_unique<ast::ValueProducer>(node_to_value(*next));
-    nodes.erase(next);
-    return true;
-  }
-  return false;
-}
-
-void assamble_binary(const std::string& file,
-                     std::vector<ast::Scope::Node>& nodes, size_t& index,
-                     std::vector<ast::Scope::Node>::iterator& previous,
-                     std::vector<ast::Scope::Node>::iterator& next,
-                     ast::Operator& op) {
-  expect_operatees(op.token, file, previous, next, nodes.end());
-
-  op.left_operand =
-      std::make_unique<ast::ValueProducer>(node_to_value(*previous));
-  op.right_operand = std::make_unique<ast::ValueProducer>(node_to_value(*next));
-
-  --index;  // we used the left
-  nodes.erase(next);
-  // We changed the vector - get new, VALID iterator
-  previous = nodes.begin();
-  std::advance(previous, index);  // we decremented index already
-  nodes.erase(previous);
-}
-
-void assamble_operator(const std::string& file,
-                       std::vector<ast::Scope::Node>& nodes, size_t& index,
-                       ast::Operator& op) {
-  auto next = nodes.begin();
-  std::advance(next, index + 1);
-  auto previous = nodes.begin();
-  if(index == 0) {
-    previous = nodes.end();
-  } else {
-    std::advance(previous, index - 1);
-  }
+  if(auto un = parse_unary_operator(tokens, tmp)) {
+    const auto power =
+        un->operation == ast::Operation::PRINT ? Power::OR : Power::PREFIX;
+    auto operand = parse_expression(tokens, tmp, power);
 
-  if(!assamble_unary(file, nodes, previous, next, op)) {
-    assamble_binary(file, nodes, index, previous, next, op);
-  }
-}
+    if(!operand) {
+      UserSourceExc e;
+      add_exception_info(un->token, tokens.file, e, [&] {
+        e << "Missing token for unary operator '" << un->token.text() << '\'';
+      });
+      throw e;
+    }
+    un->right_operand =
+        std::make_unique<ast::ValueProducer>(std::move(*operand));
 
-template <typename FUN>
-void assamble_operators_left_to_right(const std::string& file,
-                                      std::vector<ast::Scope::Node>& nodes,
-                                      FUN fun) {
-  for(size_t i = 0; i < nodes.size(); ++i) {
-    eggs::match(nodes.at(i),
-                [&file, &nodes, &i, &fun](ast::Operator& op) {
-                  expect_operator_type(__FILE__, __LINE__, op);
-
-                  if(fun(op) && !op.left_operand && !op.right_operand) {
-                    assamble_operator(file, nodes, i, op);
-                  }
-                },
-                [](ast::loop::Break&) {},                      //
-                [](ast::loop::Continue&) {},                   //
-                [](ast::Variable&) {},                         //
-                [](ast::Define&) {},                           //
-                [](ast::callable::Callable&) {},               //
-                [](ast::callable::Return&) {},                 //
-                [](ast::Scope&) {},                            //
-                [](ast::logic::If&) {},                        //
-                [](ast::loop::While&) {},                      //
-                [](ast::loop::DoWhile&) {},                    //
-                [](ast::loop::For&) {},                        //
-                [](ast::Literal<ast::Literals::BOOL>&) {},     //
-                [](ast::Literal<ast::Literals::INT>&) {},      //
-                [](ast::Literal<ast::Literals::DOUBLE>&) {},   //
-                [](ast::Literal<ast::Literals::STRING>&) {});  //
+    token = tmp;
+    return ast::ValueProducer(std::move(*un));
   }
+  return parse_primary(tokens, token);
 }
 
-template <typename FUN>
-void assamble_operators_right_to_left(const std::string& file,
-                                      std::vector<ast::Scope::Node>& nodes,
-                                      FUN fun) {
-  auto i = nodes.size();
-  if(i > 0)
-    do {
-      --i;
-      eggs::match(nodes.at(i),
-                  [&file, &nodes, &i, &fun](ast::Operator& op) {
-                    expect_operator_type(__FILE__, __LINE__, op);
-
-                    if(fun(op) && !op.left_operand && !op.right_operand) {
-                      assamble_operator(file, nodes, i, op);
-                    }
-                  },
-                  [](ast::loop::Break&) {},                      //
-                  [](ast::loop::Continue&) {},                   //
-                  [](ast::Variable&) {},                         //
-                  [](ast::Define&) {},                           //
-                  [](ast::callable::Callable&) {},               //
-                  [](ast::callable::Return&) {},                 //
-                  [](ast::Scope&) {},                            //
-                  [](ast::logic::If&) {},                        //
-                  [](ast::loop::While&) {},                      //
-                  [](ast::loop::DoWhile&) {},                    //
-                  [](ast::loop::For&) {},                        //
-                  [](ast::Literal<ast::Literals::BOOL>&) {},     //
-                  [](ast::Literal<ast::Literals::INT>&) {},      //
-                  [](ast::Literal<ast::Literals::DOUBLE>&) {},   //
-                  [](ast::Literal<ast::Literals::STRING>&) {});  //
-    } while(i != 0);
-}
-
-void assamble_operator(const std::string& file,
-                       std::vector<ast::Scope::Node>& nodes) {
-  assamble_operators_right_to_left(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::NEGATIVE ||
-           op.operation == ast::Operation::POSITIVE;
-  });
-  assamble_operators_right_to_left(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::NOT;
-  });
-  assamble_operators_right_to_left(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::TYPEOF;
-  });
+void parse_binary_operators(const Tokens& tokens, size_t& token,
+                            ast::ValueProducer& left, const Power power) {
+  while(token < tokens.size()) {
+    auto tmp = token;
+    auto bi = parse_binary_operator(tokens, tmp);
 
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::DIVIDE ||
-           op.operation == ast::Operation::MULTIPLY ||
-           op.operation == ast::Operation::MODULO;
-  });
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::ADD ||
-           op.operation == ast::Operation::SUBTRACT;
-  });
+    if(!bi || binding_power(bi->operation) < power) {
+      break;  // the operator binds weaker, a caller assembles it
+    }
 
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::SMALLER ||
-           op.operation == ast::Operation::SMALLER_EQUAL ||
-           op.operation == ast::Operation::GREATER ||
-           op.operation == ast::Operation::GREATER_EQUAL;
-  });
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::EQUAL ||
-           op.operation == ast::Operation::NOT_EQUAL;
-  });
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::AND;
-  });
-  assamble_operators_left_to_right(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::OR;
-  });
+    try {
+      const auto right_power =
+          bi->operation == ast::Operation::ASSIGNMENT
+              ? Power::ASSIGNMENT
+              : static_cast<Power>(
+                    static_cast<int>(binding_power(bi->operation)) + 1);
+      auto right = parse_expression(tokens, tmp, right_power);
+
+      if(!right) {
+        UserSourceExc e;
+        add_exception_info(bi->token, tokens.file, e, [&] {
+          e << "Missing right hand token for binary operator '"
+            << bi->token.text() << '\'';
+        });
+        throw e;
+      }
+      bi->left_operand = std::make_unique<ast::ValueProducer>(std::move(left));
+      bi->right_operand =
+          std::make_unique<ast::ValueProducer>(std::move(*right));
+      left = std::move(*bi);
+    } catch(UserExc&) {
+      UserTailExc e;
+      add_exception_info(tokens, token, e, [&tokens, &token, &e] {
+        e << "At the operator '" << tokens.at(token).text() << "' defined here";
+      });
+      std::throw_with_nested(e);
+    }
+    token = tmp;
+  }
+}
 
-  assamble_operators_right_to_left(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::PRINT;
-  });
-  assamble_operators_right_to_left(file, nodes, [](const ast::Operator& op) {
-    return op.operation == ast::Operation::ASSIGNMENT;
-  });
+std::experimental::optional<ast::ValueProducer>
+parse_expression(const Tokens& tokens, size_t& token, const Power power) {
+  auto expression = parse_operand(tokens, token);
 
-  if(nodes.size() > 1) {
-    throw_unexprected_token(node_to_token(nodes.at(1)), file);
+  if(expression) {
+    parse_binary_operators(tokens, token, *expression, power);
   }
+  return expression;
 }
 
 std::experimental::optional<ast::Operator>
@@ -2058,9 +1916,9 @@ parse_binary_operator(const Tokens& tokens, size_t& token) {
   } else if(read_token(tokens, tmp, "%")) {
     op = ast::Operation::MODULO;
   } else if(read_token(tokens, tmp, "+")) {
-    op = ast::Operation::ADD;  // This is not reachable - see unary
+    op = ast::Operation::ADD;  // after an operand, else it is unary
   } else if(read_token(tokens, tmp, "-")) {
-    op = ast::Operation::SUBTRACT;  // This is not reachable - see unary
+    op = ast::Operation::SUBTRACT;  // after an operand, else it is unary
   } else if(read_token(tokens, tmp, "<")) {
     op = ast::Operation::SMALLER;
   } else if(read_token(tokens, tmp, "<=")) {
@@ -2091,50 +1949,38 @@ parse_binary_operator(const Tokens& tokens, size_t& token) {
 }
 
 std::experimental::optional<ast::Operator>
-parse_operator_internals(const Tokens& tokens, size_t& token) {
+parse_operator(const Tokens& tokens, size_t& token,
+               std::vector<ast::Scope::Node>& nodes) {
+  assert(!nodes.empty());
   auto tmp = token;
 
-  std::experimental::optional<ast::Operator> ret;
-
+  // the last node is the left operand, a unary operator can not follow it
   if(auto un = parse_unary_operator(tokens, tmp)) {
-    ret.emplace(std::move(*un));
-    token = tmp;
-  } else if(auto bi = parse_binary_operator(tokens, tmp)) {
-    ret.emplace(std::move(*bi));
-    token = tmp;
+    if(un->operation != ast::Operation::NEGATIVE &&
+       un->operation != ast::Operation::POSITIVE) {
+      throw_unexprected_token(un->token, tokens.file);
+    }
+  } else if(!parse_binary_operator(tokens, tmp)) {
+    return {};
   }
-  return ret;
-}
+  tmp = token;
 
-std::experimental::optional<ast::Operator>
-parse_operator(const Tokens& tokens, size_t& token,
-               std::vector<ast::Scope::Node>& nodes) {
-  auto tmp = token;
-  std::experimental::optional<ast::Operator> ret;
+  ast::ValueProducer left;
+  if(auto var = extract_var_def(nodes.back())) {
+    left = std::move(*var);
+  } else {
+    left = node_to_value(nodes.back());
+    nodes.erase(nodes.end() - 1);
+  }
 
-  try {
-    std::vector<ast::Scope::Node> workspace;
+  parse_binary_operators(tokens, tmp, left, Power::ASSIGNMENT);
+  expect_expression_end(tokens, tmp);
 
-    if(auto op = parse_operator_internals(tokens, tmp)) {
-      setup_operator_wokespace(workspace, nodes, *op);
-      parse_operants(tokens, tmp, workspace);
-      assamble_operator(tokens.file, workspace);
+  auto node = value_to_node(left);
+  auto op = node_to_operator(tokens, node);
 
-      if(workspace.size() == 1) {
-        ret = node_to_operator(tokens, workspace.front());
-      }
-    }
-  } catch(UserExc&) {
-    UserTailExc e;
-    add_exception_info(tokens, token, e, [&tokens, &token, &e] {
-      e << "At the operator '" << tokens.at(token).token << "' defined here";
-    });
-    std::throw_with_nested(e);
-  }
-  if(ret) {
-    token = tmp;
-  }
-  return ret;
+  token = tmp;
+  return op;
 }
 
 //////////////////////////////////////////
@@ -2142,46 +1988,17 @@ parse_operator(const Tokens& tokens, size_t& token,
 //////////////////////////////////////////
 std::experimental::optional<ast::ValueProducer>
 parse_condition(const Tokens& tokens, size_t& token) {
-  std::vector<ast::Scope::Node> conditions;
   auto tmp = token;
+  auto condition = parse_expression(tokens, tmp, Power::ASSIGNMENT);
 
-  while(tmp < tokens.size()) {
-    if(read_token(tokens, tmp, "(")) {
-      if(auto condition = parse_condition(tokens, tmp)) {
-        conditions.push_back(value_to_node(*condition));
-        expect_token(tokens, tmp, ")");
-      } else {
-        UserSourceExc e;
-        add_exception_info(tokens, tmp, e,
-                           [&] { e << "Expected an expression."; });
-        throw e;
-      }
-    } else if(auto op = parse_operator(tokens, tmp, conditions)) {
-      conditions.push_back(std::move(*op));
-    } else if(auto exe = parse_callable(tokens, tmp)) {
-      conditions.push_back(std::move(*exe));
-    } else if(auto lit_bool = parse_literal_bool(tokens, tmp)) {
-      conditions.push_back(std::move(*lit_bool));
-    } else if(auto lit_int = parse_literal_int(tokens, tmp)) {
-      conditions.push_back(std::move(*lit_int));
-    } else if(auto lit_double = parse_literal_double(tokens, tmp)) {
-      conditions.push_back(std::move(*lit_double));
-    } else if(auto lit_string = parse_literal_string(tokens, tmp)) {
-      conditions.push_back(std::move(*lit_string));
-    } else if(auto var = parse_variable(tokens, tmp)) {
-      conditions.push_back(std::move(*var));
-    } else {
-      break;  // We are done
-    }
-  }
-  if(!conditions.empty()) {
-    assamble_operator(tokens.file, conditions);
-    auto condition = node_to_value(conditions.front());
-    token = tmp;
-    return condition;
-  } else {
+  if(!condition) {
+    expect_no_binary_operator(tokens, tmp);
     return {};
   }
+  expect_expression_end(tokens, tmp);
+
+  token = tmp;
+  return condition;
 }
 
 //////////////////////////////////////////
@@ -2216,7 +2033,7 @@ void parse_true(const Tokens& tokens, size_t& token, ast::logic::If& iff) {
     throw e;
   }
   token = tmp;
-  iff.true_scope = std::make_unique<ast::Scope>(std::move(*true_scope));
+  iff.true_scope = tokens.arena.add(std::move(*true_scope));
 }
 
 void parse_false(const Tokens& tokens, size_t& token, ast::logic::If& iff) {
@@ -2233,7 +2050,7 @@ void parse_false(const Tokens& tokens, size_t& token, ast::logic::If& iff) {
       }
 
       token = tmp;
-      iff.false_scope = std::make_unique<ast::Scope>(std::move(*scope));
+      iff.false_scope = tokens.arena.add(std::move(*scope));
     } catch(UserExc&) {
       UserTailExc e;
       add_exception_info(tokens, token, e,
@@ -2298,7 +2115,7 @@ void parse_while_scope(const Tokens& tokens, size_t& token,
     add_exception_info(tokens, tmp, e, [&] { e << "Expected a scope."; });
     throw e;
   }
-  whi.scope = std::make_unique<ast::Scope>(std::move(*scope));
+  whi.scope = tokens.arena.add(std::move(*scope));
   token = tmp;
 }
 
@@ -2395,16 +2212,65 @@ void parse_for_header(const Tokens& tokens, size_t& token, ast::loop::For& f) {
   expect_token(tokens, tmp, ")");
   token = tmp;
 }
+void parse_for_reductions(const Tokens& tokens, size_t& token,
+                          ast::loop::For& f) {
+  using Kind = ast::loop::For::Reduction::Kind;
+  auto tmp = token;
+
+  if(read_token(tokens, tmp, "reduce")) {
+    expect_token(tokens, tmp, "(");
+    do {
+      ast::loop::For::Reduction reduction;
+
+      if(read_token(tokens, tmp, "sum")) {
+        reduction.kind = Kind::SUM;
+      } else if(read_token(tokens, tmp, "min")) {
+        reduction.kind = Kind::MIN;
+      } else if(read_token(tokens, tmp, "max")) {
+        reduction.kind = Kind::MAX;
+      } else if(read_token(tokens, tmp, "collect")) {
+        reduction.kind = Kind::COLLECT;
+      } else {
+        UserSourceExc e;
+        add_exception_info(tokens, tmp, e, [&] {
+          e << "Expected a reduction - 'sum', 'min', 'max' or 'collect'.";
+        });
+        throw e;
+      }
+      expect_token(tokens, tmp, ":");
+      auto var = parse_variable(tokens, tmp);
+      if(!var) {
+        UserSourceExc e;
+        add_exception_info(tokens, tmp, e,
+                           [&] { e << "Expected a variable."; });
+        throw e;
+      }
+      reduction.variable = std::move(*var);
+      f.reductions.push_back(std::move(reduction));
+    } while(read_token(tokens, tmp, ","));
+    expect_token(tokens, tmp, ")");
+    token = tmp;
+  }
+}
 
 std::experimental::optional<ast::loop::For> parse_for(const Tokens& tokens,
                                                       size_t& token) {
   auto tmp = token;
 
   try {
-    if(read_token(tokens, tmp, "for")) {
+    const bool parallel = read_token(tokens, tmp, "parallel");
+
+    if(parallel || read_token(tokens, tmp, "for")) {
       ast::loop::For f(tokens.at(token));
+      f.parallel = parallel;
 
+      if(parallel) {
+        expect_token(tokens, tmp, "for");
+      }
       parse_for_header(tokens, tmp, f);
+      if(parallel) {
+        parse_for_reductions(tokens, tmp, f);
+      }
       parse_while_scope(tokens, tmp, f);
 
       token = tmp;
@@ -2420,10 +2286,14 @@ std::experimental::optional<ast::loop::For> parse_for(const Tokens& tokens,
 }
 }
 
-ast::Scope parse(std::string macro, std::string file_name) {
-  Tokens tokens = {tokenizer::tokenize(macro), file_name};
+ast::Scope parse(std::string macro, std::string file_name,
+                 const interpreter::OperatorProvider* operators) {
+  auto arena = std::make_shared<ast::ScopeArena>();
+  Tokens tokens = {tokenizer::tokenize(macro), file_name, *arena};
   auto root = ast::Scope(Token(0, 0, ""));
 
+  root.arena = std::move(arena);
+
   for(size_t i = 0; i < tokens.size(); ++i) {
     parse_scope_internals(tokens, i, root);
   }
@@ -2439,6 +2309,10 @@ ast::Scope parse(std::string macro, std::string file_name) {
     }
     throw exc;
   }
+  if(operators) {
+    fold(root, *operators);
+  }
+  index_functions(root);
 
   return root;
 }
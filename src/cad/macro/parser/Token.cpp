@@ -1,33 +1,204 @@
 #include "cad/macro/parser/Token.h"
 
+#include <algorithm>
+#include <cassert>
+#include <limits>
 #include <ostream>
 
 namespace cad {
 namespace macro {
 namespace parser {
+Source::Source(std::string macro)
+    : text_(std::move(macro))
+    , line_(0)
+    , column_(0)
+    , references_(0) {
+  lines_.push_back(0);
+  for(std::size_t i = 0; i < text_.size(); ++i) {
+    // same as the tokenizer, \r\n are two line breaks
+    if(text_[i] == '\n' || text_[i] == '\r') {
+      lines_.push_back(static_cast<std::uint32_t>(i + 1));
+    }
+  }
+}
+
+Source::Source(std::size_t line, std::size_t column, std::string text,
+               std::shared_ptr<const std::string> source_line)
+    : text_(std::move(text))
+    , line_(static_cast<std::uint32_t>(line))
+    , column_(static_cast<std::uint32_t>(column))
+    , source_line_(std::move(source_line))
+    , references_(0) {
+}
+
+std::size_t Source::line_index(std::size_t offset) const {
+  const auto next = std::upper_bound(lines_.begin(), lines_.end(), offset);
+
+  return static_cast<std::size_t>(next - lines_.begin()) - 1;
+}
+
+std::size_t Source::line(std::size_t offset) const {
+  if(lines_.empty()) {
+    return line_;
+  }
+  return line_index(offset) + 1;
+}
+
+std::size_t Source::column(std::size_t offset) const {
+  if(lines_.empty()) {
+    return column_ + offset;
+  }
+  return offset - lines_[line_index(offset)] + 1;
+}
+
+std::string Source::source_line(std::size_t offset) const {
+  if(lines_.empty()) {
+    return source_line_ ? *source_line_ : "";
+  }
+  const auto index = line_index(offset);
+  const std::size_t begin = lines_[index];
+  // the line break is the character before the next line
+  const std::size_t end =
+      index + 1 < lines_.size() ? lines_[index + 1] - 1 : text_.size();
+
+  return text_.substr(begin, end - begin);
+}
+
+bool Source::has_source_line() const {
+  return !lines_.empty() || source_line_;
+}
+
+const Source* Token::retain(const Source* source) {
+  if(source) {
+    source->references_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return source;
+}
+
 Token::Token()
-    : line(0)
-    , column(0)
-    , token("") {
+    : source_(nullptr)
+    , offset(0)
+    , length(0)
+    , kind(Kind::OTHER)
+    , keyword(Keyword::NONE)
+    , integer(0) {
+}
+
+Token::Token(size_t l, size_t c, std::string t,
+             std::shared_ptr<const std::string> sl)
+    : source_(retain(new Source(l, c, std::move(t), std::move(sl))))
+    , offset(0)
+    , length(static_cast<std::uint32_t>(source_->text().size()))
+    , kind(Kind::OTHER)
+    , keyword(Keyword::NONE)
+    , integer(0) {
+}
+
+Token::Token(std::string macro)
+    : source_(retain(new Source(std::move(macro))))
+    , offset(0)
+    , length(static_cast<std::uint32_t>(source_->text().size()))
+    , kind(Kind::OTHER)
+    , keyword(Keyword::NONE)
+    , integer(0) {
 }
 
-Token::Token(size_t l, size_t c, std::string t, std::shared_ptr<std::string> sl)
-    : line(l)
-    , column(c)
-    , token(std::move(t))
-    , source_line(std::move(sl)) {
+Token::Token(const Token& other, std::size_t o, std::size_t l)
+    : source_(retain(other.source_))
+    , offset(static_cast<std::uint32_t>(o))
+    , length(static_cast<std::uint32_t>(l))
+    , kind(Kind::OTHER)
+    , keyword(Keyword::NONE)
+    , integer(0) {
+}
+
+Token::Token(const Token& other)
+    : source_(retain(other.source_))
+    , offset(other.offset)
+    , length(other.length)
+    , kind(other.kind)
+    , keyword(other.keyword)
+    , integer(other.integer) {
+}
+
+Token::Token(Token&& other) noexcept
+    : source_(other.source_)
+    , offset(other.offset)
+    , length(other.length)
+    , kind(other.kind)
+    , keyword(other.keyword)
+    , integer(other.integer) {
+  other.source_ = nullptr;
+}
+
+Token::~Token() {
+  if(source_ &&
+     source_->references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete source_;
+  }
+}
+
+Token& Token::operator=(const Token& other) {
+  Token copy(other);
+
+  return *this = std::move(copy);
+}
+
+Token& Token::operator=(Token&& other) noexcept {
+  std::swap(source_, other.source_);
+  offset = other.offset;
+  length = other.length;
+  kind = other.kind;
+  keyword = other.keyword;
+  integer = other.integer;
+  return *this;
+}
+
+const std::string& Token::content() const {
+  assert(kind == Kind::STRING && source_);
+  return source_->contents_[string];
+}
+
+void Token::set_content(std::string content) {
+  assert(kind == Kind::STRING && source_);
+  assert(source_->contents_.size() < std::numeric_limits<std::uint32_t>::max());
+  string = static_cast<std::uint32_t>(source_->contents_.size());
+  source_->contents_.push_back(std::move(content));
+}
+
+const Source* Token::source() const {
+  return source_;
+}
+
+std::size_t Token::line() const {
+  return source_ ? source_->line(offset) : 0;
+}
+
+std::size_t Token::column() const {
+  return source_ ? source_->column(offset) : 0;
+}
+
+bool Token::has_source_line() const {
+  return source_ && source_->has_source_line();
+}
+
+std::string Token::source_line() const {
+  return source_ ? source_->source_line(offset) : "";
 }
 
 bool Token::operator==(const Token& other) const {
   if(this == &other) {
     return true;
+  } else if(source_ == other.source_ && offset == other.offset &&
+            length == other.length) {
+    return true;  // the same characters, no need to rebuild the source line
   } else {
-    if(source_line && other.source_line) {
-      return line == other.line && column == other.column &&
-             token == other.token && *source_line == *other.source_line;
-    } else if(!source_line && !other.source_line) {
-      return line == other.line && column == other.column &&
-             token == other.token;
+    const bool listed = has_source_line();
+
+    if(listed == other.has_source_line()) {
+      return line() == other.line() && column() == other.column() &&
+             text() == other.text() &&
+             (!listed || source_line() == other.source_line());
     }
   }
   return false;
@@ -38,10 +209,10 @@ bool Token::operator!=(const Token& other) const {
 }
 
 std::ostream& operator<<(std::ostream& os, const Token& token) {
-  os << "@Token{line: " << token.line << " column: " << token.column
-     << " token: " << token.token;
-  if(token.source_line) {
-    os << " line: " << *token.source_line;
+  os << "@Token{line: " << token.line() << " column: " << token.column()
+     << " token: " << token.text();
+  if(token.has_source_line()) {
+    os << " line: " << token.source_line();
   }
   os << "}\n";
 
@@ -2,16 +2,144 @@
 
 #include "cad/macro/parser/Token.h"
 
+#include <array>
 #include <cassert>
-#include <regex>
-
-#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 
 namespace cad {
 namespace macro {
 namespace parser {
 namespace tokenizer {
 namespace {
+/**
+ * @brief  The classes of a character, a character can be in more than one
+ */
+enum Class : std::uint8_t {
+  OTHER = 0,
+  WORD = 1 << 0,         // [a-zA-Z0-9_] - identifier, keyword or integer number
+  DIGIT = 1 << 1,        // [0-9]
+  LOWER = 1 << 2,        // [a-z] - first character of an identifier
+  NAME = 1 << 3,         // [a-z0-9_] - character of an identifier
+  OPERATOR = 1 << 4,     // [-+*/%!<>=]
+  PUNCTUATION = 1 << 5,  // [(){},:;]
+};
+
+/**
+ * @brief  The Class of every character
+ */
+const std::array<std::uint8_t, 256> classes = [] {
+  std::array<std::uint8_t, 256> table{};
+
+  for(int c = 'a'; c <= 'z'; ++c) {
+    table[c] = WORD | LOWER | NAME;
+  }
+  for(int c = 'A'; c <= 'Z'; ++c) {
+    table[c] = WORD;
+  }
+  for(int c = '0'; c <= '9'; ++c) {
+    table[c] = WORD | DIGIT | NAME;
+  }
+  table['_'] = WORD | NAME;
+  for(const unsigned char c : std::string("-+*/%!<>=")) {
+    table[c] = OPERATOR;
+  }
+  for(const unsigned char c : std::string("(){},:;")) {
+    table[c] = PUNCTUATION;
+  }
+  return table;
+}();
+
+/**
+ * @brief  A keyword of the language
+ */
+struct Keyword {
+  const char* word;
+  Token::Keyword keyword;
+};
+
+/**
+ * @brief  Perfect hash of the keywords, no two of them share a hash
+ *
+ * @param  first   The first character of the word
+ * @param  last    The last character of the word
+ * @param  length  The length of the word
+ *
+ * @return the slot of the word in the keyword table
+ */
+std::size_t keyword_hash(const char first, const char last,
+                         const std::size_t length) {
+  return (static_cast<unsigned char>(first) +
+          13 * static_cast<unsigned char>(last) + 3 * length) &
+         31;
+}
+
+/**
+ * @brief  The keywords by their keyword_hash
+ */
+const std::array<Keyword, 32> keywords = [] {
+  const Keyword words[] = {{"if", Token::Keyword::IF},
+                           {"else", Token::Keyword::ELSE},
+                           {"do", Token::Keyword::DO},
+                           {"while", Token::Keyword::WHILE},
+                           {"for", Token::Keyword::FOR},
+                           {"var", Token::Keyword::VAR},
+                           {"def", Token::Keyword::DEF},
+                           {"continue", Token::Keyword::CONTINUE},
+                           {"main", Token::Keyword::MAIN},
+                           {"break", Token::Keyword::BREAK},
+                           {"return", Token::Keyword::RETURN},
+                           {"true", Token::Keyword::TRUE},
+                           {"false", Token::Keyword::FALSE},
+                           {"typeof", Token::Keyword::TYPEOF},
+                           {"print", Token::Keyword::PRINT},
+                           {"async", Token::Keyword::ASYNC},
+                           {"parallel", Token::Keyword::PARALLEL},
+                           {"reduce", Token::Keyword::REDUCE}};
+  std::array<Keyword, 32> table{};
+
+  for(const auto& w : words) {
+    const std::string word(w.word);
+    auto& slot = table[keyword_hash(word.front(), word.back(), word.size())];
+
+    assert(slot.word == nullptr && "The keyword hash is not perfect");
+    slot = w;
+  }
+  return table;
+}();
+
+/**
+ * @brief  Checks the Class of a character
+ *
+ * @param  c      The character
+ * @param  klass  The Class
+ *
+ * @return true if the character is of the Class
+ */
+bool is(const char c, const Class klass) {
+  return (classes[static_cast<unsigned char>(c)] & klass) != 0;
+}
+
+/**
+ * @brief  Looks a part of the macro up in the keyword table
+ *
+ * @param  macro   The macro
+ * @param  begin   The begin of the part
+ * @param  length  The length of the part, at least 1
+ *
+ * @return the keyword, Token::Keyword::NONE if the part is none
+ */
+Token::Keyword keyword(Macro macro, const size_t begin, const size_t length) {
+  const auto& slot =
+      keywords[keyword_hash(macro[begin], macro[begin + length - 1], length)];
+
+  if(slot.word && macro.compare(begin, length, slot.word) == 0) {
+    return slot.keyword;
+  }
+  return Token::Keyword::NONE;
+}
+
 /**
  * @brief  Helper struct that tracks the position information in the string
  */
@@ -19,8 +147,6 @@ struct Position {
   size_t line;
   size_t column;
   size_t string;
-  size_t line_start;
-  std::shared_ptr<std::string> source_line;
 };
 
 /**
@@ -44,10 +170,6 @@ void token_begin(Macro macro, Position& position) {
     case '\r':
       ++position.line;
       position.column = 1;
-      position.source_line->append(macro.substr(
-          position.line_start, position.string - position.line_start));
-      position.line_start = position.string + 1;
-      position.source_line = std::make_shared<std::string>();
       break;
     default:
       end = 0;  // We are done!
@@ -64,18 +186,26 @@ void token_begin(Macro macro, Position& position) {
  *
  * @param  macro     The macro
  * @param  position  The position
+ * @param  token     The Token that gets the kind
  *
  * @return true if the token was indeed a floating point number
  */
-bool float_token_end(Macro macro, Position& position) {
-  // TODO see http://en.cppreference.com/w/cpp/string/basic_string/stof
-  const static std::regex regex("^(\\d*\\.\\d+)");
-  std::smatch match;
-  std::regex_search(macro.begin() + position.string, macro.end(), match, regex);
-
-  if(!match.empty() && match.position(1) == 0) {
-    position.column += match[1].length();
-    position.string += match[1].length();
+bool float_token_end(Macro macro, Position& position, Token& token) {
+  const auto size = macro.size();
+  auto end = position.string;
+
+  // [0-9]*\.[0-9]+
+  while(end < size && is(macro[end], DIGIT)) {
+    ++end;
+  }
+  if(end + 1 < size && macro[end] == '.' && is(macro[end + 1], DIGIT)) {
+    end += 2;
+    while(end < size && is(macro[end], DIGIT)) {
+      ++end;
+    }
+    position.column += end - position.string;
+    position.string = end;
+    token.kind = Token::Kind::DOUBLE;
     return true;
   }
   return false;
@@ -86,25 +216,45 @@ bool float_token_end(Macro macro, Position& position) {
  *
  * @param  macro     The macro
  * @param  position  The position
+ * @param  token     The Token that gets the kind and the value of an integer
  */
-void normal_token_end(Macro macro, Position& position) {
-  // TODO see http://en.cppreference.com/w/cpp/string/basic_string/stol
-  const static std::regex regex("([^a-zA-Z0-9_])");
-  std::smatch match;
-  std::regex_search(macro.begin() + position.string, macro.end(), match, regex);
-
-  if(match.empty()) {
-    // We're done - with you, everything and life...
-    position.string = macro.size();
-  } else {
-    if(match.position(1) == 0) {
-      position.column += 1;
-      position.string += 1;
-    } else {
-      position.column += match.position(1);
-      position.string += match.position(1);
+void normal_token_end(Macro macro, Position& position, Token& token) {
+  const auto size = macro.size();
+  const auto begin = position.string;
+  auto end = begin;
+  std::int64_t integer = 0;
+
+  while(end < size && is(macro[end], DIGIT)) {
+    if(integer <= std::numeric_limits<int>::max()) {  // saturates
+      integer = integer * 10 + (macro[end] - '0');
     }
+    ++end;
   }
+  const auto digits = end;
+  bool name = begin < size && is(macro[begin], LOWER);
+
+  while(end < size && is(macro[end], WORD)) {
+    name = name && is(macro[end], NAME);
+    ++end;
+  }
+
+  if(end == begin) {  // any other character is a Token on its own
+    ++end;
+    token.kind = is(macro[begin], OPERATOR)
+                     ? Token::Kind::OPERATOR
+                     : is(macro[begin], PUNCTUATION) ? Token::Kind::PUNCTUATION
+                                                     : Token::Kind::OTHER;
+  } else if(end == digits) {
+    token.kind = Token::Kind::INT;
+    token.integer = integer;
+  } else if(name) {
+    token.keyword = keyword(macro, begin, end - begin);
+    token.kind = token.keyword != Token::Keyword::NONE
+                     ? Token::Kind::KEYWORD
+                     : Token::Kind::IDENTIFIER;
+  }
+  position.column += end - begin;
+  position.string = end;
 }
 
 /**
@@ -112,8 +262,9 @@ void normal_token_end(Macro macro, Position& position) {
  *
  * @param  macro     The macro
  * @param  position  The position
+ * @param  token     The Token that gets the kind and the value of an integer
  */
-void token_end(Macro macro, Position& position) {
+void token_end(Macro macro, Position& position, Token& token) {
   const auto current = macro[position.string];
   const auto next =
       (position.string + 1 <= macro.size()) ? macro[position.string + 1] : '\0';
@@ -123,74 +274,119 @@ void token_end(Macro macro, Position& position) {
      (current == '<' && next == '=') || (current == '>' && next == '=')) {
     position.column += 2;
     position.string += 2;
-  } else if(float_token_end(macro, position)) {
+    token.kind = Token::Kind::OPERATOR;
+  } else if(float_token_end(macro, position, token)) {
   } else {
-    normal_token_end(macro, position);
+    normal_token_end(macro, position, token);
   }
 }
 /**
- * @brief  The function tokenizes a string
+ * @brief  The function unescapes the character after a backslash
+ *
+ * @param  c       The escaped character
+ * @param  string  The unescaped string the character is appended to
+ */
+void unescape(const char c, std::string& string) {
+  switch(c) {
+  case '/':
+  case '"':
+  case '\\':
+    string += c;
+    break;
+  case 'b':
+    string += '\b';
+    break;
+  case 'f':
+    string += '\f';
+    break;
+  case 'n':
+    string += '\n';
+    break;
+  case 'r':
+    string += '\r';
+    break;
+  case 't':
+    string += '\t';
+    break;
+  case 'a':
+    string += '\a';
+    break;
+  default:  // no escape sequence, the backslash stays
+    string += '\\';
+    string += c;
+  }
+}
+
+/**
+ * @brief  The function unescapes the content of a string
+ *
+ * @param  macro  The macro
+ * @param  begin  The position of the first character after the opening quote
+ * @param  end    The position of the closing quote
+ *
+ * @return the content with the escape sequences replaced
+ */
+std::string unescape(Macro macro, std::size_t begin, std::size_t end) {
+  std::string string;
+  bool escape = false;
+
+  string.reserve(end - begin);
+  for(std::size_t i = begin; i < end; ++i) {
+    const auto c = macro[i];
+
+    if(escape) {
+      escape = false;
+      unescape(c, string);
+    } else if(c == '\\') {
+      escape = true;
+    } else {
+      string += c;
+    }
+  }
+  return string;
+}
+
+/**
+ * @brief  The function tokenizes a string and stores its unescaped content
  *
  * @param  macro     The macro
  * @param  position  The position
+ * @param  origin    The Token of the whole macro
  *
- * @return String Token
+ * @return String Token, of the kind Token::Kind::OTHER if it is not terminated
  */
-Token next_string_token(Macro macro, Position& position) {
+Token next_string_token(Macro macro, Position& position, const Token& origin) {
   auto start = position;
-  char last_token = '\0';
-  auto end = macro.size();
+  bool escape = false;
+  bool terminated = false;
 
-  while(position.string < end) {
-    ++position.string;
+  while(position.string < macro.size()) {
+    const auto c = macro[++position.string];
 
-    switch(macro[position.string]) {
-    case ' ':
-    case '\t':
-    case '\v':
-    case '\f':
-      ++position.column;
-      last_token = macro[position.string];
-      break;
-    case '\n':
-    case '\r':
+    if(c == '\n' || c == '\r') {
       ++position.line;
       position.column = 1;
-      last_token = macro[position.string];
-
-      position.source_line->append(macro.substr(
-          position.line_start, position.string - position.line_start));
-      position.line_start = position.string + 1;
-      position.source_line = std::make_shared<std::string>();
-      break;
-    case '"':
-      if(last_token != '\\') {
-        ++position.string;  // Move to the next character
-        ++position.column;  // Move to the next character
-        end = 0;
-      }
-      ++position.column;
-      last_token = macro[position.string];
-      break;
-    case '\\':
-      if(last_token != '\\') {
-        last_token = '\\';
-      } else {
-        last_token = '\0';  // We consumed the last escape
-      }
+    } else {
       ++position.column;
+    }
+
+    if(escape) {
+      escape = false;
+    } else if(c == '\\') {
+      escape = true;
+    } else if(c == '"') {
+      ++position.string;  // Move to the next character
+      ++position.column;  // Move to the next character
+      terminated = true;
       break;
-    default:
-      ++position.column;
-      last_token = macro[position.string];
-      continue;
     }
   }
 
-  const auto ret =
-      Token(start.line, start.column,
-            macro.substr(start.string, position.string - start.string),
-            start.source_line);
+  Token ret(origin, start.string, position.string - start.string);
+  if(terminated) {
+    ret.kind = Token::Kind::STRING;
+    ret.set_content(unescape(macro, start.string + 1, position.string - 1));
+  }
   return ret;
 }
 
@@ -216,11 +412,6 @@ bool ignore_in_line_comment(Macro macro, Position& position) {
       next = (position.string + 1 <= end) ? macro[position.string + 1] : '\0';
 
       if(current == '\n' || current == '\r') {
-        position.source_line->append(macro.substr(
-            position.line_start, position.string - position.line_start));
-        position.line_start = position.string + 1;
-        position.source_line = std::make_shared<std::string>();
-
         ++position.line;
         position.column = 0;  // will be advanced a few lines down
       } else if(current == '*' && next == '/') {
@@ -254,11 +445,6 @@ bool ignore_line_comment(Macro macro, Position& position) {
     position.string += 2;
     while(position.string < end) {
       if(macro[position.string] == '\n' || macro[position.string] == '\r') {
-        position.source_line->append(macro.substr(
-            position.line_start, position.string - position.line_start));
-        position.line_start = position.string + 1;
-        position.source_line = std::make_shared<std::string>();
-
         ++position.string;
         ++position.line;
         position.column = 1;
@@ -276,20 +462,24 @@ bool ignore_line_comment(Macro macro, Position& position) {
  *
  * @param  macro     The macro
  * @param  position  The position
+ * @param  origin    The Token of the whole macro
  *
  * @return Tokenized token
  */
-Token next_token(Macro macro, Position& position) {
+Token next_token(Macro macro, Position& position, const Token& origin) {
   if(macro[position.string] == '\"') {
-    return next_string_token(macro, position);
+    return next_string_token(macro, position, origin);
   } else {
     Position tmp = position;
+    Token ret(origin, position.string, 0);
+
+    token_end(macro, tmp, ret);
+    ret.length = static_cast<std::uint32_t>(tmp.string - position.string);
+    if(ret.kind == Token::Kind::DOUBLE) {
+      const auto digits = macro.substr(position.string, ret.length);
 
-    token_end(macro, tmp);
-    const auto ret =
-        Token(position.line, position.column,
-              macro.substr(position.string, tmp.string - position.string),
-              position.source_line);
+      ret.number = std::strtod(digits.c_str(), nullptr);
+    }
     position = tmp;
     return ret;
   }
@@ -298,18 +488,18 @@ Token next_token(Macro macro, Position& position) {
 
 std::vector<Token> tokenize(Macro macro) {
   std::vector<Token> tokens;
-  Position position = {1, 1, 0, 0, std::make_shared<std::string>()};
+  // the Token instances share the Source of the macro
+  const Token origin(macro);
+  Position position = {1, 1, 0};
   token_begin(macro, position);
 
   while(position.string < macro.size()) {
     if(!ignore_line_comment(macro, position) &&
        !ignore_in_line_comment(macro, position)) {
-      tokens.push_back(next_token(macro, position));
+      tokens.push_back(next_token(macro, position, origin));
     }
     token_begin(macro, position);
   }
-  position.source_line->append(
-      macro.substr(position.line_start, macro.size() - position.line_start));
 
   return tokens;
 }
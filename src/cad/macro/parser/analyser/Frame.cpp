@@ -0,0 +1,44 @@
+#include "cad/macro/parser/analyser/Frame.h"
+
+#include "cad/macro/ast/Scope.h"
+
+namespace cad {
+namespace macro {
+namespace parser {
+namespace analyser {
+Frame::Frame(const ast::Scope& body)
+    : body_(body) {
+  body_.frame.slots.clear();
+  body_.frame.shadows.clear();
+}
+
+std::uint32_t Frame::slot(Name name) {
+  const auto it = slots_.emplace(name, body_.frame.slots.size()).first;
+
+  if(it->second == body_.frame.slots.size()) {
+    body_.frame.slots.push_back(name);
+  }
+  return it->second;
+}
+
+void Frame::shadow(Name name, ast::Address outer) {
+  const auto s = slot(name);
+
+  if(shadows_.emplace(name, s).second) {
+    body_.frame.shadows.push_back({outer, s});
+  }
+}
+
+const std::uint32_t* Frame::shadowed(Name name) const {
+  const auto it = shadows_.find(name);
+
+  return it == shadows_.end() ? nullptr : &it->second;
+}
+
+std::uint32_t Frame::at(Name name) const {
+  return slots_.at(name);
+}
+}
+}
+}
+}
@@ -1,35 +1,77 @@
 #include "cad/macro/parser/analyser/Stack.h"
 
-#include "cad/macro/ast/Variable.h"
 #include "cad/macro/ast/callable/Function.h"
+#include "cad/macro/parser/analyser/Frame.h"
 
 #include <algorithm>
+#include <cassert>
 
 namespace cad {
 namespace macro {
 namespace parser {
 namespace analyser {
+namespace {
+/**
+ * @brief  Checks if the functions have the same parameter names
+ *
+ * @param  lhs  The first function
+ * @param  rhs  The second function
+ *
+ * @return true if they have the same, in any order
+ */
+bool same_parameter(const ast::callable::Function& lhs,
+                    const ast::callable::Function& rhs) {
+  if(lhs.parameter.size() != rhs.parameter.size()) {
+    return false;
+  }
+  for(const auto& lp : lhs.parameter) {
+    bool found = false;
+    for(const auto& rp : rhs.parameter) {
+      if(lp.token.text() == rp.token.text()) {
+        found = true;
+        break;
+      }
+    }
+    if(!found) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+std::uint32_t Stack::add_var(RV var) {
+  assert(frame);
+
+  variable_index_.emplace(var.get().token.text(), variables.size());
+  variables.push_back(var);
+  return frame->slot(var.get().token.text());
+}
+
+void Stack::add_fun(RF fun) {
+  function_index_.emplace(fun.get().token.text(), functions.size());
+  functions.push_back(fun);
+}
+
 std::experimental::optional<std::pair<Stack::RV, Stack::RV>>
 Stack::has_double_var() const {
   if(variables.size() > 1) {
     const auto& back = variables.back().get();
-    auto it = std::find_if(variables.begin(), variables.end() - 1,
-                           [&back](const auto& var) {
-                             return var.get().token.token == back.token.token;
-                           });
+    const auto range = variable_index_.equal_range(back.token.text());
+    auto first = variables.size() - 1;
 
-    if(variables.end() - 1 != it) {
-      return {{*it, back}};
+    for(auto it = range.first; it != range.second; ++it) {
+      first = std::min(first, it->second);
+    }
+    if(variables.size() - 1 != first) {
+      return {{variables[first], back}};
     }
   }
   return {};
 }
 
-bool Stack::has_var(const std::string& name) const {
-  if(variables.end() !=
-     std::find_if(variables.begin(), variables.end(), [&name](const auto& var) {
-       return var.get().token.token == name;
-     })) {
+bool Stack::has_var(std::experimental::string_view name) const {
+  if(variable_index_.count(name)) {
     return true;
   } else if(parent) {
     return parent->has_var(name);
@@ -37,11 +79,39 @@ bool Stack::has_var(const std::string& name) const {
   return false;
 }
 
-bool Stack::has_fun(const std::string& name) const {
-  if(functions.end() !=
-     std::find_if(functions.begin(), functions.end(), [&name](const auto& fun) {
-       return fun.get().token.token == name;
-     })) {
+bool Stack::has_var(std::experimental::string_view name,
+                    const Stack& last) const {
+  if(variable_index_.count(name)) {
+    return true;
+  } else if(parent && this != &last) {
+    return parent->has_var(name, last);
+  }
+  return false;
+}
+
+std::experimental::optional<ast::Address>
+Stack::address(std::experimental::string_view name) const {
+  const auto* current = frame;
+  std::uint32_t depth = 0;
+
+  for(const auto* stack = this; stack; stack = stack->parent) {
+    if(stack->frame != current) {
+      // leaving the Frame of a function, it may work on its own copy
+      if(const auto* slot = current->shadowed(name)) {
+        return ast::Address{depth, *slot};
+      }
+      current = stack->frame;
+      ++depth;
+    }
+    if(stack->variable_index_.count(name)) {
+      return ast::Address{depth, current->at(name)};
+    }
+  }
+  return {};
+}
+
+bool Stack::has_fun(std::experimental::string_view name) const {
+  if(function_index_.count(name)) {
     return true;
   } else if(parent) {
     return parent->has_var(name);
@@ -52,32 +122,19 @@ bool Stack::has_fun(const std::string& name) const {
 std::experimental::optional<std::pair<Stack::RF, Stack::RF>>
 Stack::has_double_fun() const {
   if(functions.size() > 1) {
-    auto& back = functions.back().get();
-    auto it = std::find_if(
-        functions.begin(), functions.end() - 1, [&back](const auto& fun) {
-          if(fun.get().token.token == back.token.token &&
-             fun.get().parameter.size() == back.parameter.size()) {
-            // Parameter
-            for(const auto& fp : fun.get().parameter) {
-              bool found = false;
-              for(const auto& cp : back.parameter) {
-                if(fp.token.token == cp.token.token) {
-                  found = true;
-                  break;
-                }
-              }
-              if(!found) {
-                return false;
-              }
-            }
-          } else {
-            return false;
-          }
-          return true;
-        });
+    const auto& back = functions.back().get();
+    const auto range = function_index_.equal_range(back.token.text());
+    auto first = functions.size() - 1;
 
-    if(functions.end() - 1 != it) {
-      return {{*it, back}};
+    // the first one that was declared, as the index is not ordered
+    for(auto it = range.first; it != range.second; ++it) {
+      if(it->second < first &&
+         same_parameter(functions[it->second].get(), back)) {
+        first = it->second;
+      }
+    }
+    if(functions.size() - 1 != first) {
+      return {{functions[first], back}};
     }
   }
   return {};
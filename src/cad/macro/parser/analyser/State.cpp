@@ -8,14 +8,19 @@ State::State(const ast::Scope& s)
     : stack()
     , scope(s)
     , loop(false)
-    , root_scope(false) {
+    , root_scope(false)
+    , parallel(nullptr)
+    , parallel_loop(false) {
 }
 State::State(State& parent, const ast::Scope& s, bool l)
     : stack()
     , scope(s)
     , loop(l ? l : parent.loop)
-    , root_scope(parent.root_scope) {
+    , root_scope(parent.root_scope)
+    , parallel(parent.parallel)
+    , parallel_loop(l ? false : parent.parallel_loop) {
   stack.parent = &parent.stack;
+  stack.frame = parent.stack.frame;
 }
 }
 }
@@ -2,9 +2,14 @@
 
 #include "cad/macro/ast/Literal.h"
 #include "cad/macro/ast/Scope.h"
+#include "cad/macro/ast/ScopeArena.h"
 #include "cad/macro/ast/ValueProducer.h"
 #include "cad/macro/ast/logic/Condition.h"
 
+#include <memory>
+#include <type_traits>
+#include <vector>
+
 using namespace cad::macro::parser;
 using namespace cad::macro::ast;
 using namespace cad::macro::ast::callable;
@@ -560,3 +565,68 @@ TEST_CASE("Break") {
   Break b({0, 0, ""});
   REQUIRE(a == b);
 }
+
+TEST_CASE("Move") {
+  SECTION("Nothrow") {
+    REQUIRE(std::is_nothrow_move_constructible<Scope::Node>::value);
+    REQUIRE(std::is_nothrow_move_constructible<ValueProducer>::value);
+    REQUIRE(std::is_nothrow_move_constructible<Define>::value);
+  }
+  SECTION("Growing Scope") {
+    Function fun({0, 0, ""});
+    fun.scope = std::make_unique<Scope>(Token(0, 0, ""));
+    const auto* const scope = fun.scope.get();
+    Define def({0, 0, ""});
+    def.definition = std::move(fun);
+    std::vector<Scope::Node> nodes;
+    nodes.push_back(std::move(def));
+
+    // the reallocations have to move the nodes, a copy would clone the scope
+    for(int i = 0; i < 100; ++i) {
+      nodes.push_back(Break({0, 0, ""}));
+    }
+    const auto& moved = *nodes.front().target<Define>();
+    REQUIRE(moved.definition.target<Function>()->scope.get() == scope);
+  }
+}
+
+TEST_CASE("Scope arena") {
+  SECTION("Copy") {
+    Function fun({0, 0, ""});
+    fun.scope = std::make_unique<Scope>(Token(0, 0, ""));
+    Define def({0, 0, ""});
+    def.definition = fun;
+
+    // the copies share the body instead of cloning it
+    const Define copy(def);
+    REQUIRE(copy.definition.target<Function>()->scope.get() ==
+            fun.scope.get());
+    REQUIRE(copy == def);
+  }
+  SECTION("Add") {
+    auto arena = std::make_shared<ScopeArena>();
+    const auto first = arena->add(Scope(Token(1, 1, "{")));
+    const auto second = arena->add(Scope(Token(2, 1, "{")));
+
+    REQUIRE(arena->size() == 2);
+    REQUIRE(first.get() == &arena->at(0));
+    REQUIRE(second->token == Token(2, 1, "{"));
+    for(int i = 0; i < 100; ++i) {
+      arena->add(Scope(Token(3, 1, "{")));
+    }
+    // the Scope instances do not move when the arena grows
+    REQUIRE(first.get() == &arena->at(0));
+
+    // the copies share the ownership of the arena, the one it hands out not
+    REQUIRE(arena.use_count() == 1);
+    const auto copy = first;
+    REQUIRE(arena.use_count() == 2);
+    REQUIRE(copy.get() == first.get());
+  }
+  SECTION("No-Scope") {
+    const ScopeRef ref;
+    REQUIRE_FALSE(ref);
+    REQUIRE(ref.get() == nullptr);
+    REQUIRE_FALSE(ScopeRef(std::unique_ptr<Scope>()));
+  }
+}
@@ -0,0 +1,53 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <cad/core/command/CommandProvider.h>
+#include <cad/core/command/argument/Arguments.h>
+
+using Interpreter = cad::macro::interpreter::Interpreter;
+using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+using CommandProvider = cad::core::command::CommandProvider;
+using Arguments = cad::core::command::argument::Arguments;
+
+TEST_CASE("Tree vs bytecode backend", "[.][benchmark]") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter tree(cp, op);
+  Interpreter byte(cp, op);
+  tree.set_backend(Interpreter::Backend::TREE);
+  byte.set_backend(Interpreter::Backend::BYTECODE);
+
+  const std::string loop = "def main(){"
+                           "  var s = 0;"
+                           "  for(var i = 0; i < 10000; i = i + 1) {"
+                           "    if(i % 2 == 0) {"
+                           "      s = s + i * 2;"
+                           "    } else {"
+                           "      s = s - 1;"
+                           "    }"
+                           "  }"
+                           "  return s;"
+                           "}";
+  const std::string fib = "def fib(n){"
+                          "  if(n < 2) {"
+                          "    return n;"
+                          "  }"
+                          "  return fib(n: n - 1) + fib(n: n - 2);"
+                          "}"
+                          "def main(){return fib(n: 15);}";
+
+  auto tree_loop = tree.compile(loop);
+  auto byte_loop = byte.compile(loop);
+  auto tree_fib = tree.compile(fib);
+  auto byte_fib = byte.compile(fib);
+
+  report("loop tree", measure(20, [&] { tree_loop->run(Arguments()); }));
+  report("loop bytecode", measure(20, [&] { byte_loop->run(Arguments()); }));
+  report("fib tree", measure(20, [&] { tree_fib->run(Arguments()); }));
+  report("fib bytecode", measure(20, [&] { byte_fib->run(Arguments()); }));
+}
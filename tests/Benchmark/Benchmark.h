@@ -0,0 +1,46 @@
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief  Measures the average time of one call of the given function
+ *
+ * @param  iterations  The number of times the function will be called
+ * @param  fun         The function to measure
+ *
+ * @tparam FUN         Function with the signature void()
+ *
+ * @return average nanoseconds per call
+ */
+template <typename FUN>
+double measure(const std::size_t iterations, FUN fun) {
+  fun();  // warm up
+
+  auto start = std::chrono::steady_clock::now();
+  for(std::size_t i = 0; i < iterations; ++i) {
+    fun();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         iterations;
+}
+
+/**
+ * @brief  Prints a measurement in a uniform format
+ *
+ * @param  name  The name of the measurement
+ * @param  ns    The average nanoseconds per call
+ */
+inline void report(const std::string& name, const double ns) {
+  std::cout << std::left << std::setw(48) << name << std::right
+            << std::setw(14) << std::fixed << std::setprecision(1) << ns
+            << " ns/op " << std::setw(14) << std::setprecision(0)
+            << (1e9 / ns) << " op/s\n";
+}
+#endif
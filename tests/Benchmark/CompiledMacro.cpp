@@ -0,0 +1,67 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <cad/core/command/CommandProvider.h>
+#include <cad/core/command/argument/Arguments.h>
+
+#include <exception.h>
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using Interpreter = cad::macro::interpreter::Interpreter;
+using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+using CommandProvider = cad::core::command::CommandProvider;
+using Arguments = cad::core::command::argument::Arguments;
+
+CATCH_TRANSLATE_EXCEPTION(std::exception& e) {
+  std::stringstream ss;
+  exception::print_exception(e, ss);
+  return ss.str();
+}
+
+namespace {
+// Macros taken from tests/Interpreter
+const std::vector<std::pair<std::string, std::string>> macros = {
+    {"Return global", "var a = 1; def main(){return a;}"},
+    {"Function return", "def fun(){return 1;} def main(){return fun();}"},
+    {"Operator", "def main(){return 1 + 4 * (2 - 1);}"},
+    {"If", "def main(){if(true){return true;}else{return false;}}"},
+    {"While", "def main(){var i = 0; while(i < 3){ i = i + 1; if(i == "
+              "2){break;}} return i;}"},
+    {"DoWhile", "def main(){var i = 0; do{ i = i +1;}while(i < 3); return i;}"},
+    {"For", "def main(){"
+            "  for(var i = 0; i < 4; i = i + 1) {"
+            "    if(i != 5) {"
+            "      continue;"
+            "    }"
+            "  }"
+            "}"},
+};
+}
+
+TEST_CASE("Compiled macro vs interpret", "[.][benchmark]") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+
+  const std::size_t iterations = 10000;
+
+  for(const auto& m : macros) {
+    auto interpret = measure(iterations, [&] {
+      in.interpret(m.second, Arguments());
+    });
+    auto macro = in.compile(m.second);
+    auto run = measure(iterations, [&] { macro->run(Arguments()); });
+
+    report(m.first + " interpret", interpret);
+    report(m.first + " compiled", run);
+    report(m.first + " saved per call", interpret - run);
+  }
+}
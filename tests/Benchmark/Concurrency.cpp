@@ -0,0 +1,60 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <cad/core/command/CommandProvider.h>
+#include <cad/core/command/argument/Arguments.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Interpreter = cad::macro::interpreter::Interpreter;
+using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+using CommandProvider = cad::core::command::CommandProvider;
+using Arguments = cad::core::command::argument::Arguments;
+
+TEST_CASE("Concurrent runs scaling", "[.][benchmark]") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+
+  auto macro = in.compile("def main(){"
+                          "  var s = 0;"
+                          "  for(var i = 0; i < 1000; i = i + 1) {"
+                          "    s = s + i * 2;"
+                          "  }"
+                          "  print s;"
+                          "  return s;"
+                          "}");
+
+  // the same number of runs is spread over the threads, the time per run
+  // should drop with every thread up to the number of cores
+  const std::size_t runs = 3200;
+
+  for(std::size_t threads = 1; threads <= 32; threads *= 2) {
+    const auto ns = measure(3, [&] {
+      std::vector<std::thread> workers;
+
+      for(std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&macro, runs, threads]() {
+          std::stringstream ss;
+
+          for(std::size_t r = 0; r < runs / threads; ++r) {
+            macro->run(Arguments(), "", ss);
+          }
+        });
+      }
+      for(auto& w : workers) {
+        w.join();
+      }
+    });
+
+    report(std::to_string(threads) + " threads per run", ns / runs);
+  }
+}
@@ -0,0 +1,74 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/MacroExecutor.h"
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/Interpreter.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
+
+#include <cad/core/command/CommandProvider.h>
+#include <cad/core/command/argument/Arguments.h>
+
+#include <future>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using Interpreter = cad::macro::interpreter::Interpreter;
+using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+using CommandProvider = cad::core::command::CommandProvider;
+using Arguments = cad::core::command::argument::Arguments;
+using MacroExecutor = cad::macro::MacroExecutor;
+
+TEST_CASE("Macro executor throughput", "[.][benchmark]") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream ss;
+  Interpreter in(cp, op, ss);
+  MacroExecutor executor([](std::function<void()> task) {
+    std::thread(std::move(task)).detach();
+  });
+
+  auto macro = in.compile("def main(n){"
+                          "  var s = 0;"
+                          "  for(var i = 0; i < n; i = i + 1) {"
+                          "    s = s + i;"
+                          "  }"
+                          "  return s;"
+                          "}");
+
+  const std::size_t jobs = 10000;
+  auto make_jobs = [&]() {
+    std::vector<MacroExecutor::Job> batch;
+    batch.reserve(jobs);
+    for(std::size_t i = 0; i < jobs; ++i) {
+      Arguments args;
+      args.add("n", "int", static_cast<int>(i % 32));
+      batch.push_back({macro, std::move(args), "", nullptr});
+    }
+    return batch;
+  };
+
+  const auto sequential = measure(3, [&] {
+    for(auto& job : make_jobs()) {
+      macro->run(std::move(job.args));
+    }
+  });
+  const auto futures = measure(3, [&] {
+    for(auto& f : executor.submit(make_jobs())) {
+      f.get();
+    }
+  });
+  const auto callback = measure(3, [&] {
+    std::promise<void> done;
+    executor.submit(make_jobs(), [&done](std::vector<MacroExecutor::Result>) {
+      done.set_value();
+    });
+    done.get_future().wait();
+  });
+
+  report("10k jobs sequential per job", sequential / jobs);
+  report("10k jobs futures per job", futures / jobs);
+  report("10k jobs callback per job", callback / jobs);
+}
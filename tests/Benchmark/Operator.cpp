@@ -0,0 +1,57 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/interpreter/OperatorProvider.h"
+#include "cad/macro/interpreter/Value.h"
+
+using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+using Value = cad::macro::interpreter::Value;
+using BiOp = OperatorProvider::BinaryOperation;
+
+namespace {
+/**
+ * @brief  OperatorProvider that registers the measured operators again, so
+ *         they are called through the generic std::function path
+ */
+class GenericOperatorProvider : public OperatorProvider {
+public:
+  GenericOperatorProvider()
+      : OperatorProvider() {
+    add_.clear();
+    multiply_.clear();
+    smaller_.clear();
+    // BiOp is the std::function of the OperatorProvider in here
+    using B = BinaryOperation;
+    add<int, int, B::ADD, B::MULTIPLY, B::SMALLER>();
+    add<double, double, B::ADD, B::MULTIPLY, B::SMALLER>();
+  }
+};
+
+template <typename T>
+void run(const std::string& name, const OperatorProvider& op, const BiOp o,
+         const T lhs, const T rhs) {
+  const std::size_t iterations = 1000000;
+  const linb::any l = lhs;
+  const linb::any r = rhs;
+  const Value vl(lhs);
+  const Value vr(rhs);
+  linb::any a;
+  Value v;
+
+  report(name + " any", measure(iterations, [&] { a = op.eval(o, l, r); }));
+  report(name + " Value", measure(iterations, [&] { v = op.eval(o, vl, vr); }));
+}
+}
+
+TEST_CASE("Primitive vs generic operators", "[.][benchmark]") {
+  const OperatorProvider primitive;
+  const GenericOperatorProvider generic;
+
+  run("int + int generic", generic, BiOp::ADD, 40, 2);
+  run("int + int primitive", primitive, BiOp::ADD, 40, 2);
+  run("double * double generic", generic, BiOp::MULTIPLY, 4.0, 2.5);
+  run("double * double primitive", primitive, BiOp::MULTIPLY, 4.0, 2.5);
+  run("int < int generic", generic, BiOp::SMALLER, 40, 2);
+  run("int < int primitive", primitive, BiOp::SMALLER, 40, 2);
+}
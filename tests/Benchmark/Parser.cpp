@@ -0,0 +1,116 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/ast/Scope.h"
+#include "cad/macro/parser/Parser.h"
+
+#include <cstddef>
+#include <string>
+
+namespace {
+/**
+ * @brief  Generates a macro that returns one expression of the given number of
+ *         terms, bracketed in groups of 100 terms to keep the tree shallow
+ *
+ * @param  terms  The number of terms
+ *
+ * @return the macro
+ */
+std::string generate_macro(const std::size_t terms) {
+  const char* const operators[] = {" + ", " * ", " - ", " / ", " < ",
+                                   " == ", " && ", " || ", " % ", " != "};
+  std::string expression = "(a";
+
+  for(std::size_t i = 1; i < terms; ++i) {
+    if(i % 100 == 0) {
+      expression += ") + (a";
+    } else {
+      expression += operators[i % 10];
+      expression += (i % 3 == 0) ? "-a" : std::to_string(i);
+    }
+  }
+  return "def main(a){ return " + expression + "); }";
+}
+
+/**
+ * @brief  Generates a macro that returns one flat expression of the given
+ *         number of terms, `a + 1 * a - 3 ...` without any brackets
+ *
+ * @param  terms  The number of terms
+ *
+ * @return the macro
+ */
+std::string generate_flat_macro(const std::size_t terms) {
+  const char* const operators[] = {" + ", " * ", " - "};
+  std::string expression = "a";
+
+  for(std::size_t i = 1; i < terms; ++i) {
+    expression += operators[(i - 1) % 3];
+    expression += (i % 2 == 0) ? "a" : std::to_string(i);
+  }
+  return "def main(a){ return " + expression + "; }";
+}
+
+/**
+ * @brief  Generates a macro with the given number of functions in its root
+ *         scope, each with a nested scope of a few statements
+ *
+ * @param  functions  The number of functions
+ *
+ * @return the macro
+ */
+std::string generate_functions(const std::size_t functions) {
+  std::string macro;
+
+  for(std::size_t i = 0; i < functions; ++i) {
+    const auto n = std::to_string(i);
+
+    macro += "def fun_" + n + "(a) {\n"
+             "  var b = a * " + n + ";\n"
+             "  while(b > 0) { b = b - 1; }\n"
+             "  if(a) { return b; } else { return a; }\n"
+             "}\n";
+  }
+  return macro + "def main(a){ return fun_0(a: a); }";
+}
+}
+
+TEST_CASE("Expression parsing", "[.][benchmark]") {
+  using namespace cad::macro;
+
+  for(const std::size_t terms : {100, 1000, 10000}) {
+    const auto macro = generate_macro(terms);
+
+    report("Parse " + std::to_string(terms) + " terms",
+           measure(5, [&] { parser::parse(macro); }));
+  }
+  for(const std::size_t terms : {100, 1000, 10000}) {
+    const auto macro = generate_flat_macro(terms);
+
+    report("Parse " + std::to_string(terms) + " flat terms",
+           measure(5, [&] { parser::parse(macro); }));
+  }
+}
+
+TEST_CASE("Scope parsing", "[.][benchmark]") {
+  using namespace cad::macro;
+
+  for(const std::size_t functions : {100, 1000, 10000}) {
+    const auto macro = generate_functions(functions);
+
+    report("Parse " + std::to_string(functions) + " functions",
+           measure(5, [&] { parser::parse(macro); }));
+  }
+}
+
+TEST_CASE("Scope copying", "[.][benchmark]") {
+  using namespace cad::macro;
+
+  for(const std::size_t functions : {100, 1000, 10000}) {
+    const auto root = parser::parse(generate_functions(functions));
+
+    report("Copy " + std::to_string(functions) + " functions",
+           measure(5, [&] { ast::Scope copy(root); }));
+  }
+}
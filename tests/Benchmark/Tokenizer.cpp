@@ -0,0 +1,58 @@
+#include <Catch/catch.hpp>
+
+#include "Benchmark.h"
+
+#include "cad/macro/parser/Token.h"
+#include "cad/macro/parser/Tokenizer.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+/**
+ * @brief  Generates a macro with the given number of functions that use every
+ *         kind of Token
+ *
+ * @param  functions  The number of functions
+ *
+ * @return the macro
+ */
+std::string generate_macro(const std::size_t functions) {
+  std::string macro;
+
+  for(std::size_t i = 0; i < functions; ++i) {
+    const auto n = std::to_string(i);
+
+    macro += "// function " + n + "\n"
+             "def fun_" + n + "(a, b) {\n"
+             "  var s = \"string \\\"" + n + "\\\"\";\n"
+             "  /* in-line comment */\n"
+             "  if(a <= b && b != 0.5 || !(a >= " + n + ")) {\n"
+             "    return a * 2.25 + b % 3 - .5;\n"
+             "  }\n"
+             "  return fun_" + n + "(a: a + 1, b: b);\n"
+             "}\n";
+  }
+  return macro;
+}
+}
+
+TEST_CASE("Tokenizer throughput", "[.][benchmark]") {
+  using namespace cad::macro::parser;
+
+  for(const std::size_t functions : {1000, 10000, 50000}) {
+    const auto macro = generate_macro(functions);
+    std::size_t tokens = 0;
+    const auto ns =
+        measure(5, [&] { tokens = tokenizer::tokenize(macro).size(); });
+    const auto mb = static_cast<double>(macro.size()) / (1024 * 1024);
+
+    report("Tokenize " + std::to_string(macro.size()) + " bytes", ns);
+    std::cout << std::left << std::setw(48)
+              << ("  " + std::to_string(tokens) + " tokens") << std::right
+              << std::setw(14) << std::fixed << std::setprecision(1)
+              << (mb / (ns / 1e9)) << " MB/s\n";
+  }
+}
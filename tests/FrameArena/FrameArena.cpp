@@ -0,0 +1,76 @@
+#include <Catch/catch.hpp>
+
+#include "cad/macro/interpreter/FrameArena.h"
+
+#include <memory>
+#include <vector>
+
+using FrameArena = cad::macro::interpreter::FrameArena;
+using Value = cad::macro::interpreter::Value;
+
+TEST_CASE("FrameArena") {
+  FrameArena arena;
+
+  REQUIRE(arena.size() == 0);
+  REQUIRE(arena.capacity() == 0);
+
+  SECTION("Push and pop") {
+    auto& root = arena.push(nullptr, 1);
+    auto& child = arena.push(&root, 2);
+
+    REQUIRE(arena.size() == 2);
+    REQUIRE(child.parent() == &root);
+    REQUIRE(child.ancestor(1) == &root);
+    REQUIRE_FALSE(child.has_slot(0));
+    REQUIRE_FALSE(child.has_slot(1));
+
+    arena.pop(child);
+    arena.pop(root);
+    REQUIRE(arena.size() == 0);
+    REQUIRE(arena.capacity() == 2);
+  }
+  SECTION("Reuse") {
+    auto& first = arena.push(nullptr, 1, 1);
+    first.add_slot(0, "foo");
+    first.slot(0) = Value(42);
+    first.add_variable(0, "bar");
+    first.variable(0) = 42;
+    arena.pop(first);
+
+    auto& second = arena.push(nullptr, 2, 1);
+    REQUIRE(&first == &second);
+    REQUIRE(arena.capacity() == 1);
+    REQUIRE_FALSE(second.has_slot(0));
+    REQUIRE(second.slot(0).empty());
+    REQUIRE_FALSE(second.has_variable(0));
+    REQUIRE(second.variable(0).empty());
+    arena.pop(second);
+  }
+  SECTION("Frames don't move") {
+    FrameArena::Frame root(arena, nullptr);
+    std::vector<std::unique_ptr<FrameArena::Frame>> frames;
+    auto* parent = &root.stack();
+
+    for(int i = 0; i < 1000; ++i) {
+      frames.push_back(std::make_unique<FrameArena::Frame>(arena, parent));
+      parent = &frames.back()->stack();
+    }
+    REQUIRE(arena.size() == 1001);
+    REQUIRE(parent->ancestor(1000) == &root.stack());
+
+    while(!frames.empty()) {
+      frames.pop_back();
+    }
+    REQUIRE(arena.size() == 1);
+  }
+  SECTION("Frame") {
+    {
+      FrameArena::Frame root(arena, nullptr);
+      FrameArena::Frame child(arena, &root.stack(), 1);
+
+      REQUIRE(arena.size() == 2);
+      REQUIRE(child.stack().parent() == &root.stack());
+    }
+    REQUIRE(arena.size() == 0);
+  }
+}
@@ -2,6 +2,11 @@
 
 #include "LCommand.h"
 
+#include "cad/macro/MacroExecutor.h"
+#include "cad/macro/interpreter/BatchProvider.h"
+#include "cad/macro/interpreter/Cancellation.h"
+#include "cad/macro/interpreter/CompiledMacro.h"
+#include "cad/macro/interpreter/Execution.h"
 #include "cad/macro/interpreter/Interpreter.h"
 #include "cad/macro/interpreter/OperatorProvider.h"
 
@@ -12,7 +17,17 @@
 
 #include <exception.h>
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
 using Interpreter = cad::macro::interpreter::Interpreter;
+using BatchProvider = cad::macro::interpreter::BatchProvider;
 using OperatorProvider = cad::macro::interpreter::OperatorProvider;
 using CommandProvider = cad::core::command::CommandProvider;
 using Arguments = cad::core::command::argument::Arguments;
@@ -32,6 +47,27 @@ CATCH_TRANSLATE_EXCEPTION(std::exception& e) {
   return ss.str();
 }
 
+namespace {
+/**
+ * @brief  Finds the exception the others are nested around
+ *
+ * @param  ptr  The outermost exception
+ *
+ * @return the innermost exception
+ */
+std::exception_ptr innermost(std::exception_ptr ptr) {
+  try {
+    std::rethrow_exception(ptr);
+  } catch(const std::nested_exception& e) {
+    if(e.nested_ptr()) {
+      return innermost(e.nested_ptr());
+    }
+  } catch(...) {
+  }
+  return ptr;
+}
+}
+
 TEST_CASE("Main literal return") {
   auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
   auto op = std::make_shared<OperatorProvider>();
@@ -234,6 +270,136 @@ TEST_CASE("Operator") {
   REQUIRE(linb::any_cast<int>(ret) == 0);
 }
 
+TEST_CASE("Short circuit") {
+  auto asp = std::make_shared<ApplicationSettingsProvider>();
+  auto cp = std::make_shared<CommandProvider>(asp, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+  int calls = 0;
+
+  cad::core::command::MenuAdder m(cp, [] {});
+  m.name("query").scope("").add<LCommand>("query", cp, [&calls](Arguments) {
+    ++calls;
+    return true;
+  });
+  // no 'bool' operator
+  m.name("none").scope("").add<LCommand>("none", cp, [](Arguments) {
+    return std::vector<int>();
+  });
+  // a 'bool' operator that returns no bool
+  m.name("not_bool").scope("").add<LCommand>("not_bool", cp, [](Arguments) {
+    return std::vector<double>();
+  });
+  op->add(OperatorProvider::UnaryOperation::BOOL,
+          std::type_index(typeid(std::vector<double>)),
+          [](const linb::any&) { return linb::any(1); });
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    in.set_backend(backend);
+    calls = 0;
+
+    auto ret =
+        in.interpret("def main(){return false && query();}", Arguments());
+    REQUIRE_FALSE(linb::any_cast<bool>(ret));
+    REQUIRE(calls == 0);
+
+    ret = in.interpret("def main(){return true || query();}", Arguments());
+    REQUIRE(linb::any_cast<bool>(ret));
+    REQUIRE(calls == 0);
+
+    ret = in.interpret("def main(){return true && query();}", Arguments());
+    REQUIRE(linb::any_cast<bool>(ret));
+    REQUIRE(calls == 1);
+
+    ret = in.interpret("def main(){return false || query();}", Arguments());
+    REQUIRE(linb::any_cast<bool>(ret));
+    REQUIRE(calls == 2);
+
+    // operands are converted with the bool operator
+    ret = in.interpret("def main(){return 1 && 0;}", Arguments());
+    REQUIRE(linb::any_cast<bool>(ret) == false);
+    ret = in.interpret("def main(){return 0 || 2;}", Arguments());
+    REQUIRE(linb::any_cast<bool>(ret));
+
+    // the errors of the OperatorProvider for operands that are no bool
+    const auto error = [&in](const std::string& macro) {
+      try {
+        in.interpret(macro, Arguments());
+      } catch(...) {
+        return innermost(std::current_exception());
+      }
+      return std::exception_ptr();
+    };
+    using EXC_MISSING =
+        Exc<OperatorProvider::E, OperatorProvider::E::MISSING_OPERATOR>;
+    using EXC_BAD_BOOL =
+        Exc<OperatorProvider::E, OperatorProvider::E::BAD_BOOL_CAST>;
+    REQUIRE_THROWS_AS(
+        std::rethrow_exception(error("def main(){return true && none();}")),
+        EXC_MISSING);
+    REQUIRE_THROWS_AS(
+        std::rethrow_exception(error("def main(){return none() || true;}")),
+        EXC_MISSING);
+    REQUIRE_THROWS_AS(
+        std::rethrow_exception(error("def main(){return true && not_bool();}")),
+        EXC_BAD_BOOL);
+    REQUIRE_THROWS_AS(
+        std::rethrow_exception(error("def main(){return not_bool() || true;}")),
+        EXC_BAD_BOOL);
+  }
+}
+
+TEST_CASE("Constant folding") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream folded_ss;
+  std::stringstream unfolded_ss;
+  Interpreter folded(cp, op, folded_ss);
+  Interpreter unfolded(cp, op, unfolded_ss);
+  unfolded.set_folding(false);
+
+  REQUIRE(folded.folding());
+  REQUIRE_FALSE(unfolded.folding());
+
+  const std::vector<std::string> macros = {
+      "def main(){print 2 * 3.14159 / 180;}",
+      "def main(){print \"prefix_\" + 3;}",
+      "def main(){print 1 + 4 * (2 - 1) % 3;}",
+      "def main(){print typeof (1 + 1.5);}",
+      "def main(){print !(1 < 2) || 3 >= 3 && -2 != +2;}",
+      "def main(){print 7 / 0.0;}",
+      "def main(){"
+      "  var s = 0;"
+      "  for(var i = 0; i < 3 * 3; i = i + 1) {"
+      "    s = s + 2 * 3;"
+      "  }"
+      "  print s;"
+      "}",
+      "def fun(a){return a;} def main(){print fun(a: 40 + 2);}",
+  };
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    folded.set_backend(backend);
+    unfolded.set_backend(backend);
+
+    for(const auto& m : macros) {
+      folded.interpret(m, Arguments());
+      unfolded.interpret(m, Arguments());
+
+      REQUIRE(folded_ss.str() == unfolded_ss.str());
+    }
+
+    // Not folded - the errors are reported at runtime
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;  // Catch issue
+    REQUIRE_THROWS_AS(
+        folded.interpret("def main(){\"foo\" - \"bar\";}", Arguments()),
+        EXC_TAIL);
+    REQUIRE_NOTHROW(folded.compile("def main(){if(false){1 / 0;}}"));
+  }
+}
+
 TEST_CASE("If") {
   auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
   auto op = std::make_shared<OperatorProvider>();
@@ -338,6 +504,203 @@ TEST_CASE("Missing Function") {
   REQUIRE_THROWS_AS(in.interpret("def main(){fun();}", Arguments()), EXC_TAIL);
 }
 
+TEST_CASE("Command link") {
+  auto asp = std::make_shared<ApplicationSettingsProvider>();
+  auto cp = std::make_shared<CommandProvider>(asp, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream ss;
+  Interpreter in(cp, op, ss);
+  int calls = 0;
+
+  Arguments args;
+  args.add("foo", "int", 1);
+
+  cad::core::command::MenuAdder m(cp, [] {});
+  m.name("count").scope("").add<LCommand>("count", cp,
+                                          [&calls](Arguments args) {
+                                            calls += *args.get<int>("foo");
+                                            return calls;
+                                          },
+                                          args);
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    in.set_backend(backend);
+    calls = 0;
+
+    auto macro = in.compile("def main(){"
+                            "  var r = 0;"
+                            "  for(var i = 0; i < 4; i = i + 1) {"
+                            "    r = count(foo: i);"
+                            "  }"
+                            "  return r;"
+                            "}");
+    REQUIRE(linb::any_cast<int>(macro->run(Arguments())) == 6);
+    REQUIRE(linb::any_cast<int>(macro->run(Arguments())) == 12);
+
+    in.invalidate_commands();
+    REQUIRE(linb::any_cast<int>(macro->run(Arguments())) == 18);
+
+    // missing core::Command instances are reported before the execution
+    calls = 0;
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+    REQUIRE_THROWS_AS(in.interpret("def main(){"
+                                   "  print count(foo: 1);"
+                                   "  if(false) {"
+                                   "    missing();"
+                                   "  }"
+                                   "}",
+                                   Arguments()),
+                      EXC_TAIL);
+    REQUIRE(ss.str() == "");
+    REQUIRE(calls == 0);
+  }
+}
+
+TEST_CASE("Batched command") {
+  auto asp = std::make_shared<ApplicationSettingsProvider>();
+  auto cp = std::make_shared<CommandProvider>(asp, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  auto bp = std::make_shared<BatchProvider>(2);
+  std::stringstream ss;
+  Interpreter in(cp, op, ss);
+  std::vector<int> single;
+  std::vector<std::vector<int>> chunks;
+  std::vector<std::string> printed;
+
+  Arguments args;
+  args.add("x", "int", 0);
+
+  cad::core::command::MenuAdder m(cp, [] {});
+  m.name("point").scope("").add<LCommand>("point", cp,
+                                          [&single](Arguments args) {
+                                            single.push_back(
+                                                *args.get<int>("x"));
+                                            return true;
+                                          },
+                                          args);
+  bp->add("", "point", [&](const std::vector<Arguments>& rows) {
+    std::vector<int> chunk;
+    for(auto r : rows) {
+      chunk.push_back(*r.get<int>("x"));
+    }
+    chunks.push_back(chunk);
+    printed.push_back(ss.str());
+  });
+  in.set_batch_provider(bp);
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    in.set_backend(backend);
+    single.clear();
+    chunks.clear();
+    printed.clear();
+    ss.str("");
+
+    auto ret = in.interpret("def main(){"
+                            "  for(var i = 0; i < 5; i = i + 1) {"
+                            "    point(x: i);"
+                            "  }"
+                            "  print \"a\";"
+                            "  point(x: 5);"
+                            "  return point(x: 6);"
+                            "}",
+                            Arguments());
+    REQUIRE(linb::any_cast<bool>(ret));
+    // the result of the last call is used, it isn't batched
+    REQUIRE(single == std::vector<int>({6}));
+    REQUIRE(chunks ==
+            std::vector<std::vector<int>>({{0, 1}, {2, 3}, {4}, {5}}));
+    // queued rows are flushed before anything is printed
+    REQUIRE(printed == std::vector<std::string>({"", "", "", "a"}));
+
+    // the rows of a parallel for are passed on in the order of the iterations
+    in.set_workers(4);
+    in.set_executor([](std::function<void()> task) {
+      std::thread(std::move(task)).detach();
+    });
+    chunks.clear();
+    in.interpret("def main(){"
+                 "  parallel for(var i = 0; i < 7; i = i + 1) {"
+                 "    point(x: i);"
+                 "  }"
+                 "}",
+                 Arguments());
+    REQUIRE(chunks ==
+            std::vector<std::vector<int>>({{0, 1}, {2, 3}, {4, 5}, {6}}));
+    in.set_workers(1);
+  }
+}
+
+TEST_CASE("Async command") {
+  auto asp = std::make_shared<ApplicationSettingsProvider>();
+  auto cp = std::make_shared<CommandProvider>(asp, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+  std::mutex mutex;
+  std::vector<std::thread::id> threads;
+  int launched = 0;
+
+  Arguments args;
+  args.add("x", "int", 0);
+
+  cad::core::command::MenuAdder m(cp, [] {});
+  m.name("slow").scope("").add<LCommand>("slow", cp,
+                                         [&](Arguments args) {
+                                           std::lock_guard<std::mutex> lock(
+                                               mutex);
+                                           threads.push_back(
+                                               std::this_thread::get_id());
+                                           return *args.get<int>("x") * 2;
+                                         },
+                                         args);
+  cad::core::command::MenuAdder m2(cp, [] {});
+  m2.name("fail").scope("").add<LCommand>("fail", cp, [](Arguments) {
+    throw std::runtime_error("fail");
+    return 0;
+  });
+  in.set_executor([&launched](std::function<void()> task) {
+    ++launched;
+    std::thread(std::move(task)).detach();
+  });
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    in.set_backend(backend);
+    threads.clear();
+    launched = 0;
+
+    auto ret = in.interpret("def main(){"
+                            "  var a = async slow(x: 1);"
+                            "  var b = async slow(x: 2);"
+                            "  return a + b;"
+                            "}",
+                            Arguments());
+    REQUIRE(linb::any_cast<int>(ret) == 6);
+    REQUIRE(launched == 2);
+    REQUIRE(threads.size() == 2);
+    REQUIRE(threads[0] != std::this_thread::get_id());
+    REQUIRE(threads[1] != std::this_thread::get_id());
+
+    // the futures that aren't read are joined when the run ends
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+    REQUIRE_THROWS_AS(in.interpret("def main(){ async fail(); }", Arguments()),
+                      EXC_TAIL);
+  }
+
+  // without an executor the calls are made on the calling thread
+  Interpreter inline_in(cp, op);
+  threads.clear();
+  auto ret = inline_in.interpret("def main(){"
+                                 "  var a = async slow(x: 1);"
+                                 "  return a;"
+                                 "}",
+                                 Arguments());
+  REQUIRE(linb::any_cast<int>(ret) == 2);
+  REQUIRE(threads.size() == 1);
+  REQUIRE(threads[0] == std::this_thread::get_id());
+}
+
 TEST_CASE("Missing Operator") {
   auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
   auto op = std::make_shared<OperatorProvider>();
@@ -375,6 +738,106 @@ TEST_CASE("For") {
   REQUIRE(ss.str() == "0\n1\n2\n3\n");
 }
 
+TEST_CASE("Parallel for") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream ss;
+  Interpreter in(cp, op, ss);
+  int launched = 0;
+
+  in.set_workers(4);
+  in.set_executor([&launched](std::function<void()> task) {
+    ++launched;
+    std::thread(std::move(task)).detach();
+  });
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    in.set_backend(backend);
+    ss.str("");
+    launched = 0;
+
+    auto ret = in.interpret(
+        "def main(){"
+        "  var sum = 0; var low; var high; var all;"
+        "  parallel for(var i = 0; i < 100; i = i + 1)"
+        "      reduce(sum: sum, min: low, max: high, collect: all) {"
+        "    var square = i * i;"
+        "    sum = square; low = square; high = square; all = i;"
+        "    if(i < 3) { print i; }"
+        "  }"
+        "  print sum; print \" \"; print low; print \" \"; print high;"
+        "  return all;"
+        "}",
+        Arguments());
+    // reductions and output are combined in the order of the iterations
+    const auto all = linb::any_cast<std::vector<linb::any>>(ret);
+    REQUIRE(all.size() == 100);
+    for(std::size_t i = 0; i < all.size(); ++i) {
+      REQUIRE(linb::any_cast<int>(all[i]) == static_cast<int>(i));
+    }
+    REQUIRE(ss.str() == "012328350 0 9801");
+    REQUIRE(launched == 3);
+
+    // the copies of the reduction variables start at the zero of their type
+    // or at the outer value
+    ret = in.interpret("def main(){"
+                       "  var sum = 10; var text = \"a\"; var low = -1;"
+                       "  parallel for(var i = 0; i < 100; i = i + 1)"
+                       "      reduce(sum: sum, sum: text, min: low) {"
+                       "    sum = sum + i; text = text + \"b\";"
+                       "    if(i < low) { low = i; }"
+                       "  }"
+                       "  print text; print \" \"; print low;"
+                       "  return sum;"
+                       "}",
+                       Arguments());
+    REQUIRE(linb::any_cast<int>(ret) == 4960);
+    REQUIRE(ss.str() == "012328350 0 9801a" + std::string(100, 'b') + " -1");
+
+    // bool has no zero, the sum continues in order from the outer variable
+    // like the sequential loop: true + 1 is 2
+    launched = 0;
+    ret = in.interpret("def main(){"
+                       "  var sum = true; var count = 0;"
+                       "  parallel for(var i = 0; i < 10; i = i + 1)"
+                       "      reduce(sum: sum, sum: count) {"
+                       "    sum = sum + 1; count = count + i;"
+                       "  }"
+                       "  print count;"
+                       "  return sum;"
+                       "}",
+                       Arguments());
+    REQUIRE(linb::any_cast<int>(ret) == 11);
+    REQUIRE(ss.str() == "012328350 0 9801a" + std::string(100, 'b') + " -145");
+    REQUIRE(launched == 0);
+
+    // a collect gets the last value an iteration assigned
+    ret = in.interpret("def main(){"
+                       "  var all;"
+                       "  parallel for(var i = 0; i < 5; i = i + 1)"
+                       "      reduce(collect: all) {"
+                       "    all = i; all = i * 10;"
+                       "  }"
+                       "  return all;"
+                       "}",
+                       Arguments());
+    const auto last = linb::any_cast<std::vector<linb::any>>(ret);
+    REQUIRE(last.size() == 5);
+    for(std::size_t i = 0; i < last.size(); ++i) {
+      REQUIRE(linb::any_cast<int>(last[i]) == static_cast<int>(i) * 10);
+    }
+
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+    REQUIRE_THROWS_AS(in.interpret("def main(){"
+                                   "  parallel for(var i = 0; i < 8; i = i + 1)"
+                                   "  { var s = i - \"b\"; }"
+                                   "}",
+                                   Arguments()),
+                      EXC_TAIL);
+  }
+}
+
 TEST_CASE("Continue") {
   auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
   auto op = std::make_shared<OperatorProvider>();
@@ -394,4 +857,485 @@ TEST_CASE("Continue") {
   REQUIRE(ss.str() == "");
 }
 
+TEST_CASE("Compiled macro") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+
+  auto macro = in.compile("var a = 1;"
+                          "def main(b){"
+                          "  a = a + b;"
+                          "  return a;"
+                          "}");
+
+  SECTION("Runs are independent") {
+    for(int i = 0; i < 3; ++i) {
+      Arguments args;
+      args.add("b", "int", 41);
+      auto ret = macro->run(args);
+      REQUIRE(linb::any_cast<int>(ret) == 42);
+    }
+  }
+  SECTION("Same result as interpret") {
+    Arguments args;
+    args.add("b", "int", 1);
+    auto ret = in.interpret("var a = 1;"
+                            "def main(b){"
+                            "  a = a + b;"
+                            "  return a;"
+                            "}",
+                            args);
+    REQUIRE(linb::any_cast<int>(ret) == linb::any_cast<int>(macro->run(args)));
+  }
+}
+
+TEST_CASE("Concurrent runs") {
+  auto asp = std::make_shared<ApplicationSettingsProvider>();
+  auto cp = std::make_shared<CommandProvider>(asp, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream shared_ss;
+  Interpreter in(cp, op, shared_ss);
+  std::atomic<int> calls(0);
+
+  Arguments args;
+  args.add("foo", "int", 1);
+
+  cad::core::command::MenuAdder m(cp, [] {});
+  m.name("count").scope("").add<LCommand>("count", cp,
+                                          [&calls](Arguments args) {
+                                            calls += *args.get<int>("foo");
+                                            return 0;
+                                          },
+                                          args);
+
+  const std::size_t threads = 8;
+  const int runs = 50;
+
+  for(const auto backend :
+      {Interpreter::Backend::TREE, Interpreter::Backend::BYTECODE}) {
+    // the Interpreter is configured before it is shared
+    in.set_backend(backend);
+    calls = 0;
+
+    auto macro = in.compile("var a = 1;"
+                            "def square(n){return n * n;}"
+                            "def main(b){"
+                            "  var s = 0;"
+                            "  for(var i = 0; i < b; i = i + 1) {"
+                            "    s = s + square(n: i);"
+                            "    count(foo: 1);"
+                            "  }"
+                            "  a = a + b;"
+                            "  print a;"
+                            "  return s;"
+                            "}");
+
+    std::vector<std::stringstream> outs(threads);
+    std::vector<int> correct(threads, 0);
+    std::vector<std::thread> workers;
+
+    for(std::size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&macro, &outs, &correct, t]() {
+        const int b = static_cast<int>(t) + 1;
+
+        for(int r = 0; r < runs; ++r) {
+          Arguments args;
+          args.add("b", "int", b);
+          try {
+            const auto ret = macro->run(args, "", outs[t]);
+            if(linb::any_cast<int>(ret) == (b - 1) * b * (2 * b - 1) / 6) {
+              ++correct[t];
+            }
+          } catch(...) {
+          }
+        }
+      });
+    }
+    for(auto& w : workers) {
+      w.join();
+    }
+
+    int expected_calls = 0;
+    for(std::size_t t = 0; t < threads; ++t) {
+      const int b = static_cast<int>(t) + 1;
+      std::string expected;
+
+      for(int r = 0; r < runs; ++r) {
+        expected += std::to_string(1 + b);
+      }
+      expected_calls += b * runs;
+      REQUIRE(correct[t] == runs);
+      REQUIRE(outs[t].str() == expected);
+    }
+    REQUIRE(calls == expected_calls);
+    REQUIRE(shared_ss.str() == "");
+  }
+}
+
+TEST_CASE("Macro executor") {
+  using MacroExecutor = cad::macro::MacroExecutor;
+
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream shared_ss;
+  Interpreter in(cp, op, shared_ss);
+  std::atomic<int> started(0);
+  MacroExecutor executor(
+      [&started](std::function<void()> task) {
+        ++started;
+        std::thread(std::move(task)).detach();
+      },
+      4);
+
+  auto square = in.compile("def main(n){print n; return n * n;}");
+  auto fail = in.compile("def main(){var a = \"a\"; return 1 - a;}");
+
+  const int jobs = 100;
+  std::vector<std::stringstream> outs(jobs);
+  auto make_jobs = [&]() {
+    std::vector<MacroExecutor::Job> batch;
+    for(int i = 0; i < jobs; ++i) {
+      Arguments args;
+      args.add("n", "int", i);
+      batch.push_back({square, args, "", &outs[i]});
+    }
+    batch.push_back({fail, Arguments(), "", nullptr});
+    return batch;
+  };
+
+  SECTION("Futures") {
+    auto futures = executor.submit(make_jobs());
+
+    REQUIRE(futures.size() == jobs + 1);
+    for(int i = 0; i < jobs; ++i) {
+      REQUIRE(linb::any_cast<int>(futures[i].get()) == i * i);
+      REQUIRE(outs[i].str() == std::to_string(i));
+    }
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+    REQUIRE_THROWS_AS(futures.back().get(), EXC_TAIL);
+    // the workers are started with the executor, at most one per worker
+    REQUIRE(started > 0);
+    REQUIRE(started <= static_cast<int>(executor.workers()));
+  }
+  SECTION("Callback") {
+    std::promise<std::vector<MacroExecutor::Result>> promise;
+    auto future = promise.get_future();
+
+    executor.submit(make_jobs(),
+                    [&promise](std::vector<MacroExecutor::Result> results) {
+                      promise.set_value(std::move(results));
+                    });
+    const auto results = future.get();
+
+    REQUIRE(results.size() == jobs + 1);
+    for(int i = 0; i < jobs; ++i) {
+      REQUIRE(!results[i].error);
+      REQUIRE(linb::any_cast<int>(results[i].value) == i * i);
+    }
+    REQUIRE(results.back().error);
+  }
+  SECTION("Empty batch") {
+    bool called = false;
+    executor.submit({}, [&called](std::vector<MacroExecutor::Result> results) {
+      called = results.empty();
+    });
+    REQUIRE(called);
+    REQUIRE(executor.submit({}).empty());
+  }
+  REQUIRE(shared_ss.str() == "");
+}
+
+TEST_CASE("Suspendable execution") {
+  using Execution = cad::macro::interpreter::Execution;
+
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream ss;
+  Interpreter in(cp, op, ss);
+
+  auto macro = in.compile("def square(n){return n * n;}"
+                          "def main(b){"
+                          "  var s = 0;"
+                          "  for(var i = 0; i < b; i = i + 1) {"
+                          "    s = s + square(n: i);"
+                          "  }"
+                          "  print s;"
+                          "  return s;"
+                          "}");
+  Arguments args;
+  args.add("b", "int", 100);
+
+  SECTION("Steps") {
+    Execution::Budget budget;
+    budget.steps = 10;
+    std::stringstream out;
+    Execution exe(macro, args, "", budget, out);
+    std::size_t resumes = 0;
+
+    REQUIRE(!exe.is_done());
+    using EXC_NOT_DONE = Exc<Execution::E, Execution::E::NOT_DONE>;
+    REQUIRE_THROWS_AS(exe.result(), EXC_NOT_DONE);
+    while(!exe.resume()) {
+      ++resumes;
+    }
+    REQUIRE(resumes > 100);
+    REQUIRE(exe.is_done());
+    REQUIRE(exe.resume());
+    REQUIRE(linb::any_cast<int>(exe.result()) == 328350);
+    REQUIRE(out.str() == "328350");
+  }
+  SECTION("Steps of the root chunk") {
+    // the main function continues with what the root chunk left
+    std::string source;
+    for(int i = 0; i < 10; ++i) {
+      source += "def f" + std::to_string(i) + "(){}";
+    }
+    auto defines = in.compile(source + "def main(){return 1;}");
+    const auto resumes = [&defines](std::size_t steps) {
+      Execution::Budget budget;
+      budget.steps = steps;
+      Execution exe(defines, Arguments(), "", budget);
+      std::size_t count = 1;
+
+      while(!exe.resume()) {
+        ++count;
+      }
+      REQUIRE(linb::any_cast<int>(exe.result()) == 1);
+      return count;
+    };
+    const auto instructions = resumes(1);
+
+    REQUIRE(instructions > 10);
+    for(std::size_t steps = 2; steps <= instructions; ++steps) {
+      REQUIRE(resumes(steps) * steps >= instructions);
+    }
+  }
+  SECTION("Time") {
+    Execution::Budget budget;
+    budget.time = std::chrono::microseconds(1);
+    Execution exe(macro, args, "", budget);
+
+    while(!exe.resume()) {
+    }
+    REQUIRE(linb::any_cast<int>(exe.result()) == 328350);
+    REQUIRE(ss.str() == "328350");
+  }
+  SECTION("No limit") {
+    Execution exe(macro, args);
+
+    REQUIRE(exe.resume());
+    REQUIRE(linb::any_cast<int>(exe.result()) == 328350);
+  }
+  SECTION("Tree backend") {
+    in.set_backend(Interpreter::Backend::TREE);
+    auto tree = in.compile("def main(){return 42;}");
+    Execution::Budget budget;
+    budget.steps = 1;
+    Execution exe(tree, Arguments(), "", budget);
+
+    REQUIRE(exe.resume());
+    REQUIRE(linb::any_cast<int>(exe.result()) == 42);
+  }
+  SECTION("Error") {
+    auto fail = in.compile("def fun(){var a = \"a\"; return 1 - a;}"
+                           "def main(){return fun();}");
+    Execution::Budget budget;
+    budget.steps = 2;
+    Execution exe(fail, Arguments(), "", budget);
+
+    while(!exe.resume()) {
+    }
+    using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+    REQUIRE_THROWS_AS(exe.result(), EXC_TAIL);
+  }
+  SECTION("Abandoned") {
+    Execution::Budget budget;
+    budget.steps = 50;
+    Execution exe(macro, args, "", budget);
+
+    REQUIRE(!exe.resume());
+  }
+}
+
+TEST_CASE("Cancellation") {
+  using Cancellation = cad::macro::interpreter::Cancellation;
+  using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;
+
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  Interpreter in(cp, op);
+  const auto backends = {Interpreter::Backend::TREE,
+                         Interpreter::Backend::BYTECODE};
+
+  auto message = [](const std::exception& e) {
+    std::stringstream ss;
+    exception::print_exception(e, ss);
+    return ss.str();
+  };
+
+  SECTION("Deadline") {
+    for(const auto backend : backends) {
+      in.set_backend(backend);
+      auto loop = in.compile("def main(){var i = 0; while(true){i = i + 1;}}");
+      Cancellation cancellation(Cancellation::Clock::now()
+                                + std::chrono::milliseconds(20));
+
+      try {
+        loop->run(Arguments(), "", cancellation);
+        FAIL("The run didn't stop");
+      } catch(EXC_TAIL& e) {
+        REQUIRE(message(e).find("deadline") != std::string::npos);
+      }
+    }
+  }
+  SECTION("Cancel") {
+    for(const auto backend : backends) {
+      in.set_backend(backend);
+      auto loop = in.compile("def main(){do{}while(true);}");
+      Cancellation cancellation;
+      std::thread canceller([cancellation]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        cancellation.cancel();
+      });
+
+      try {
+        loop->run(Arguments(), "", cancellation);
+        canceller.join();
+        FAIL("The run didn't stop");
+      } catch(EXC_TAIL& e) {
+        canceller.join();
+        REQUIRE(message(e).find("cancelled") != std::string::npos);
+      }
+    }
+  }
+  SECTION("Function call") {
+    Cancellation cancellation;
+    cancellation.cancel();
+
+    for(const auto backend : backends) {
+      in.set_backend(backend);
+      REQUIRE_THROWS_AS(
+          in.interpret("def fun(){return 1;} def main(){return fun();}",
+                       Arguments(), "", "Anonymous", cancellation),
+          EXC_TAIL);
+      REQUIRE(linb::any_cast<int>(
+                  in.interpret("def main(){return 1;}", Arguments(), "",
+                               "Anonymous", cancellation)) == 1);
+    }
+  }
+}
+
+TEST_CASE("Backends") {
+  auto cp = std::make_shared<CommandProvider>(nullptr, nullptr);
+  auto op = std::make_shared<OperatorProvider>();
+  std::stringstream tree_ss;
+  std::stringstream byte_ss;
+  Interpreter tree(cp, op, tree_ss);
+  Interpreter byte(cp, op, byte_ss);
+  tree.set_backend(Interpreter::Backend::TREE);
+  byte.set_backend(Interpreter::Backend::BYTECODE);
+
+  const std::vector<std::string> macros = {
+      "var a = 1; def main(){return a;}",
+      "def fun(){return 1;} def main(){return fun();}",
+      "def fun(foo){return foo;} def main(){return fun(foo:1);}",
+      "def fun(bar){bar=2;do{{{{{bar = 42;}}}}}while(false); "
+      "return bar;} def main(){return fun(bar:1);}",
+      "def main(){return 1 + 4 * (2 - 1);}",
+      "def main(){if(false){return 1;}else{return 2;}}",
+      "def main(){var i = 0; while(i < 3){ i = i + 1; if(i == "
+      "2){break;}} return i;}",
+      "def main(){var i = 0; do{ i = i +1;}while(i < 3); return i;}",
+      "def main(){var i = 0; if(i = 1){ return 1;} else {return 0;}}",
+      "def main(){"
+      "  var s = 0;"
+      "  for(var i = 0; i < 10; i = i + 1) {"
+      "    if(i == 3) {"
+      "      continue;"
+      "    }"
+      "    if(i == 8) {"
+      "      break;"
+      "    }"
+      "    s = s + i;"
+      "    print i;"
+      "  }"
+      "  return s;"
+      "}",
+      "def main(){"
+      "  for(var i = 0; i < 4; i = i + 1) {"
+      "    return 42;"
+      "  }"
+      "}",
+      "def fib(n){"
+      "  if(n < 2) {"
+      "    return n;"
+      "  }"
+      "  return fib(n: n - 1) + fib(n: n - 2);"
+      "}"
+      "def main(){return fib(n: 10);}",
+      "var a = 1; def main(){var b = a; a = 5; return a + b;}",
+      "def main(){"
+      "  var a = 2;"
+      "  def inner(b){return a * b;}"
+      "  return inner(b: 21);"
+      "}",
+      "def t(v){print v; return true;}"
+      "def f(v){print v; return false;}"
+      "def main(){"
+      "  var i = 0;"
+      "  if(f(v: 1) && t(v: 2)) {i = i + 1;}"
+      "  if(t(v: 3) || f(v: 4)) {i = i + 2;}"
+      "  if(t(v: 5) && f(v: 6) || t(v: 7)) {i = i + 4;}"
+      "  return i;"
+      "}",
+      "def sub(a, b){return a - b;}"
+      "def main(){return sub(b: 2, a: 44) * 10 + sub(a: 3, b: 1);}",
+      "def f(a){return 1;}"
+      "def f(b){return 2;}"
+      "def f(a, b){return 3;}"
+      "def main(){return f(b: 0) * 100 + f(a: 0) * 10 + f(b: 0, a: 0);}",
+      "def twice(x){return x * 2;}"
+      "def main(){"
+      "  def add(a, b){return twice(x: a) + b;}"
+      "  var s = 0;"
+      "  for(var i = 0; i < 5; i = i + 1) {"
+      "    s = add(b: s, a: i);"
+      "  }"
+      "  return s;"
+      "}",
+      "def main(){"
+      "  var s = 0;"
+      "  for(var i = 0; i < 3; i = i + 1) {"
+      "    def inc(v){return v + 1;}"
+      "    s = inc(v: s);"
+      "  }"
+      "  return s;"
+      "}",
+      "var a = 1;"
+      "def add(v){a = a + v; return a;}"
+      "def main(){var b = add(v: 41); return b * 10 + a;}",
+      "def main(){"
+      "  var a = 3;"
+      "  def get(){return a;}"
+      "  a = 4;"
+      "  return get();"
+      "}",
+  };
+
+  for(const auto& m : macros) {
+    auto tree_ret = tree.interpret(m, Arguments());
+    auto byte_ret = byte.interpret(m, Arguments());
+
+    REQUIRE(linb::any_cast<int>(tree_ret) == linb::any_cast<int>(byte_ret));
+    REQUIRE(tree_ss.str() == byte_ss.str());
+  }
+
+  using EXC_TAIL = Exc<Interpreter::E, Interpreter::E::TAIL>;  // Catch issue
+  REQUIRE_THROWS_AS(byte.interpret("def main(){fun();}", Arguments()),
+                    EXC_TAIL);
+  REQUIRE_THROWS_AS(
+      byte.interpret("def main(){\"foo\" - \"bar\";}", Arguments()),
+      EXC_TAIL);
+}
+
 // FIXME test history stack  implementation
@@ -7,12 +7,21 @@
 
 #include <exception.h>
 
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
 using OperatorProvider = cad::macro::interpreter::OperatorProvider;
 using BiOp = OperatorProvider::BinaryOperation;
 using UnOp = OperatorProvider::UnaryOperation;
 
 class TestOperatorProvider : public cad::macro::interpreter::OperatorProvider {
 public:
+  using OperatorProvider::add_;
+  using OperatorProvider::bool_;
+  using OperatorProvider::print_;
+
   TestOperatorProvider(const bool initialize = false)
       : OperatorProvider() {
     if(!initialize) {
@@ -42,6 +51,51 @@ CATCH_TRANSLATE_EXCEPTION(std::exception& e) {
   return ss.str();
 }
 
+namespace {
+template <std::size_t N>
+struct Tag {};
+
+// registers Tag<N> + int, int + Tag<N> and print Tag<N> for all N
+template <std::size_t... Ns>
+void add_tags(OperatorProvider& op, std::index_sequence<Ns...>) {
+  const std::type_index i(typeid(int));
+
+  (void)std::initializer_list<int>{
+      (op.add(BiOp::ADD, std::type_index(typeid(Tag<Ns>)), i,
+              [](const linb::any&, const linb::any& rhs) {
+                return static_cast<int>(Ns) + linb::any_cast<int>(rhs);
+              }),
+       op.add(BiOp::ADD, i, std::type_index(typeid(Tag<Ns>)),
+              [](const linb::any& lhs, const linb::any&) {
+                return linb::any_cast<int>(lhs) - static_cast<int>(Ns);
+              }),
+       op.add(UnOp::PRINT, std::type_index(typeid(Tag<Ns>)),
+              [](const linb::any&) { return std::to_string(Ns); }),
+       0)...};
+}
+// checks the operator functions add_tags registered for Tag<N>
+template <std::size_t N>
+bool has_tag(const OperatorProvider& op) {
+  const auto n = static_cast<int>(N);
+  const linb::any tag = Tag<N>();
+  const linb::any i = 100;
+
+  return linb::any_cast<int>(op.eval(BiOp::ADD, tag, i)) == 100 + n &&
+         linb::any_cast<int>(op.eval(BiOp::ADD, i, tag)) == 100 - n &&
+         linb::any_cast<std::string>(op.eval(UnOp::PRINT, tag)) ==
+             std::to_string(N);
+}
+template <std::size_t... Ns>
+bool has_tags(const OperatorProvider& op, std::index_sequence<Ns...>) {
+  for(const auto e : std::initializer_list<bool>{has_tag<Ns>(op)...}) {
+    if(!e) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
 TEST_CASE("Binary Operations") {
   TestOperatorProvider op;
   linb::any lhs = 1;
@@ -126,3 +180,246 @@ TEST_CASE("Unary Operations") {
     REQUIRE_FALSE((op.has(UnOp::TYPEOF, int_index)));
   }
 }
+
+TEST_CASE("User types") {
+  struct Vec {
+    int x;
+  };
+  struct Mat {
+    int x;
+  };
+  TestOperatorProvider op(true);
+  auto vec_index = std::type_index(typeid(Vec));
+  auto mat_index = std::type_index(typeid(Mat));
+  auto int_index = std::type_index(typeid(int));
+
+  REQUIRE_FALSE((op.has(BiOp::MULTIPLY, vec_index, int_index)));
+
+  REQUIRE_NOTHROW((op.add(BiOp::MULTIPLY, vec_index, int_index,
+                          [](const linb::any& lhs, const linb::any& rhs) {
+                            return Vec{linb::any_cast<Vec>(lhs).x *
+                                       linb::any_cast<int>(rhs)};
+                          })));
+  REQUIRE_NOTHROW((op.add(BiOp::MULTIPLY, mat_index, vec_index,
+                          [](const linb::any& lhs, const linb::any& rhs) {
+                            return Vec{linb::any_cast<Mat>(lhs).x *
+                                       linb::any_cast<Vec>(rhs).x};
+                          })));
+
+  SECTION("Dispatch") {
+    auto v = op.eval(BiOp::MULTIPLY, linb::any(Vec{2}), linb::any(3));
+    REQUIRE(linb::any_cast<Vec>(v).x == 6);
+
+    v = op.eval(BiOp::MULTIPLY, linb::any(Mat{7}), linb::any(Vec{6}));
+    REQUIRE(linb::any_cast<Vec>(v).x == 42);
+  }
+  SECTION("Builtin types are not affected") {
+    auto i = op.eval(BiOp::MULTIPLY, linb::any(6), linb::any(7));
+    REQUIRE(linb::any_cast<int>(i) == 42);
+  }
+  SECTION("Missing") {
+    using EXC = Exc<OperatorProvider::E, OperatorProvider::E::MISSING_OPERATOR>;
+    REQUIRE_FALSE((op.has(BiOp::MULTIPLY, int_index, vec_index)));
+    REQUIRE_FALSE((op.has(BiOp::ADD, vec_index, int_index)));
+    REQUIRE_THROWS_AS(
+        op.eval(BiOp::MULTIPLY, linb::any(Vec{2}), linb::any(Vec{2})), EXC);
+  }
+  SECTION("Value") {
+    using Value = cad::macro::interpreter::Value;
+    using EXC = Exc<OperatorProvider::E, OperatorProvider::E::MISSING_OPERATOR>;
+    auto v = op.eval(BiOp::MULTIPLY, Value::from_any(linb::any(Vec{2})),
+                     Value(3));
+    REQUIRE(linb::any_cast<Vec>(v.as_boxed()).x == 6);
+
+    REQUIRE(op.eval(BiOp::ADD, Value(std::string("a")),
+                    Value(std::string("b")))
+                .as_string() == "ab");
+    REQUIRE_FALSE(op.eval(UnOp::NOT, Value(std::string("a"))).as_bool());
+    REQUIRE_THROWS_AS(op.eval(BiOp::MULTIPLY, Value(3), v), EXC);
+  }
+}
+
+TEST_CASE("Growing tables") {
+  OperatorProvider op;
+
+  // every type gets a new id, the tables double a few times
+  add_tags(op, std::make_index_sequence<40>());
+  REQUIRE(has_tags(op, std::make_index_sequence<40>()));
+  REQUIRE(linb::any_cast<int>(op.eval(BiOp::ADD, linb::any(40),
+                                      linb::any(2))) == 42);
+  REQUIRE(linb::any_cast<std::string>(
+              op.eval(UnOp::PRINT, linb::any(std::string("a")))) == "a");
+
+  using EXC = Exc<OperatorProvider::E, OperatorProvider::E::OPERATOR_EXISTS>;
+  REQUIRE_THROWS_AS(
+      op.add(BiOp::ADD, std::type_index(typeid(Tag<3>)),
+             std::type_index(typeid(int)),
+             [](const linb::any&, const linb::any&) { return linb::any(); }),
+      EXC);
+  REQUIRE(has_tags(op, std::make_index_sequence<40>()));
+}
+
+TEST_CASE("Primitives") {
+  TestOperatorProvider fast(true);
+  TestOperatorProvider generic;
+  generic.add<int, int, BiOp::DIVIDE, BiOp::MULTIPLY, BiOp::MODULO, BiOp::ADD,
+              BiOp::SUBTRACT, BiOp::SMALLER, BiOp::EQUAL>();
+  generic.add<int, double, BiOp::DIVIDE, BiOp::ADD, BiOp::GREATER>();
+  generic.add<bool, int, BiOp::MODULO, BiOp::ADD>();
+  generic.add<int, UnOp::BOOL, UnOp::NEGATIVE, UnOp::POSITIVE>();
+  generic.add<bool, UnOp::BOOL, UnOp::NEGATIVE>();
+  // bool and bool has no EQUAL operator, compare the printed values instead
+  auto print = [&fast](const linb::any& v) {
+    return linb::any_cast<std::string>(fast.eval(UnOp::PRINT, v));
+  };
+
+  SECTION("Tables") {
+    REQUIRE(fast.add_.primitives());
+    REQUIRE(fast.bool_.primitives());
+    REQUIRE_FALSE(fast.print_.primitives());
+    REQUIRE_FALSE(generic.add_.primitives());
+    REQUIRE_FALSE(generic.bool_.primitives());
+  }
+  SECTION("Same results") {
+    auto same = [&](const BiOp o, const linb::any& lhs, const linb::any& rhs) {
+      const auto f = fast.eval(o, lhs, rhs);
+      const auto g = generic.eval(o, lhs, rhs);
+      REQUIRE(f.type() == g.type());
+      REQUIRE(print(f) == print(g));
+    };
+    same(BiOp::DIVIDE, 7, 2);
+    same(BiOp::MULTIPLY, 6, 7);
+    same(BiOp::MODULO, 7, 3);
+    same(BiOp::ADD, 1, 2);
+    same(BiOp::SUBTRACT, 1, 2);
+    same(BiOp::SMALLER, 1, 2);
+    same(BiOp::EQUAL, 2, 2);
+    same(BiOp::DIVIDE, 7, 2.0);
+    same(BiOp::ADD, 1, 0.5);
+    same(BiOp::GREATER, 1, 0.5);
+    same(BiOp::MODULO, true, 2);
+    same(BiOp::ADD, true, 2);
+  }
+  SECTION("Same unary results") {
+    auto same = [&](const UnOp o, const linb::any& rhs) {
+      const auto f = fast.eval(o, rhs);
+      const auto g = generic.eval(o, rhs);
+      REQUIRE(f.type() == g.type());
+      REQUIRE(print(f) == print(g));
+    };
+    same(UnOp::BOOL, 0);
+    same(UnOp::BOOL, 42);
+    same(UnOp::NEGATIVE, 42);
+    same(UnOp::POSITIVE, -42);
+    same(UnOp::NEGATIVE, true);
+    same(UnOp::NOT, 42);
+    same(UnOp::NOT, false);
+  }
+  SECTION("Value") {
+    using Value = cad::macro::interpreter::Value;
+    REQUIRE(fast.eval(BiOp::ADD, Value(40), Value(2)).as_int() == 42);
+    REQUIRE(fast.eval(BiOp::MULTIPLY, Value(2.0), Value(2.5)).as_double() ==
+            5.0);
+    REQUIRE(fast.eval(BiOp::SMALLER, Value(1), Value(1.5)).as_bool());
+    REQUIRE(fast.eval(UnOp::NEGATIVE, Value(true)).as_int() == -1);
+    REQUIRE(generic.eval(BiOp::ADD, Value(40), Value(2)).as_int() == 42);
+  }
+  SECTION("Not registered") {
+    using EXC = Exc<OperatorProvider::E, OperatorProvider::E::MISSING_OPERATOR>;
+    // bool and bool isn't a builtin pair, modulo only for int and bool, int
+    REQUIRE_THROWS_AS(fast.eval(BiOp::ADD, linb::any(true), linb::any(true)),
+                      EXC);
+    REQUIRE_THROWS_AS(fast.eval(BiOp::MODULO, linb::any(1.0), linb::any(2)),
+                      EXC);
+    REQUIRE_THROWS_AS(generic.eval(BiOp::ADD, linb::any(1.0), linb::any(2)),
+                      EXC);
+  }
+}
+
+TEST_CASE("Mixed int and double") {
+  using Value = cad::macro::interpreter::Value;
+  using EXC = Exc<OperatorProvider::E, OperatorProvider::E::MISSING_OPERATOR>;
+  // the fast path evaluates the builtin types without the tables, the generic
+  // path only has the tables with the same operator functions
+  TestOperatorProvider fast(true);
+  TestOperatorProvider generic;
+  generic.add<int, int, BiOp::DIVIDE, BiOp::MULTIPLY, BiOp::MODULO, BiOp::ADD,
+              BiOp::SUBTRACT, BiOp::SMALLER, BiOp::SMALLER_EQUAL,
+              BiOp::GREATER, BiOp::GREATER_EQUAL, BiOp::EQUAL,
+              BiOp::NOT_EQUAL>();
+  generic.add<int, double, BiOp::DIVIDE, BiOp::MULTIPLY, BiOp::ADD,
+              BiOp::SUBTRACT, BiOp::SMALLER, BiOp::SMALLER_EQUAL,
+              BiOp::GREATER, BiOp::GREATER_EQUAL, BiOp::EQUAL,
+              BiOp::NOT_EQUAL>();
+  generic.add<double, int, BiOp::DIVIDE, BiOp::MULTIPLY, BiOp::ADD,
+              BiOp::SUBTRACT, BiOp::SMALLER, BiOp::SMALLER_EQUAL,
+              BiOp::GREATER, BiOp::GREATER_EQUAL, BiOp::EQUAL,
+              BiOp::NOT_EQUAL>();
+  generic.add<double, double, BiOp::DIVIDE, BiOp::MULTIPLY, BiOp::ADD,
+              BiOp::SUBTRACT, BiOp::SMALLER, BiOp::SMALLER_EQUAL,
+              BiOp::GREATER, BiOp::GREATER_EQUAL, BiOp::EQUAL,
+              BiOp::NOT_EQUAL>();
+  generic.add<int, UnOp::BOOL, UnOp::NEGATIVE, UnOp::POSITIVE>();
+  generic.add<double, UnOp::BOOL, UnOp::NEGATIVE, UnOp::POSITIVE>();
+  REQUIRE_FALSE(generic.add_.primitives());
+
+  // the printed result, or the error
+  const OperatorProvider printer;
+  auto eval = [&printer](auto&& function) -> std::string {
+    try {
+      const linb::any ret = function();
+      return std::string(ret.type().name()) + " " +
+             linb::any_cast<std::string>(printer.eval(UnOp::PRINT, ret));
+    } catch(EXC&) {
+      return "missing operator";
+    }
+  };
+
+  const std::vector<BiOp> operations = {
+      BiOp::DIVIDE,        BiOp::MULTIPLY, BiOp::MODULO,        BiOp::ADD,
+      BiOp::SUBTRACT,      BiOp::SMALLER,  BiOp::SMALLER_EQUAL, BiOp::GREATER,
+      BiOp::GREATER_EQUAL, BiOp::EQUAL,    BiOp::NOT_EQUAL,     BiOp::AND,
+      BiOp::OR};
+  // no int 0 on the right hand side, int / 0 and int % 0 are undefined
+  const std::vector<linb::any> lhss = {7, -2, 0, 2.5, -0.5, 0.0};
+  const std::vector<linb::any> rhss = {7, -2, 2.5, -0.5, 0.0};
+
+  for(const auto o : operations) {
+    for(const auto& lhs : lhss) {
+      for(const auto& rhs : rhss) {
+        const auto f = eval([&] { return fast.eval(o, lhs, rhs); });
+        const auto g = eval([&] { return generic.eval(o, lhs, rhs); });
+        const auto fv = eval([&] {
+          return fast.eval(o, Value::from_any(lhs), Value::from_any(rhs))
+              .to_any();
+        });
+        const auto gv = eval([&] {
+          return generic.eval(o, Value::from_any(lhs), Value::from_any(rhs))
+              .to_any();
+        });
+
+        const auto l = eval([&] { return lhs; });
+        const auto r = eval([&] { return rhs; });
+        CAPTURE(static_cast<int>(o));
+        CAPTURE(l);
+        CAPTURE(r);
+        REQUIRE(f == g);
+        REQUIRE(fv == g);
+        REQUIRE(gv == g);
+      }
+    }
+  }
+  // modulo is only registered for int and int
+  REQUIRE(eval([&] {
+            return fast.eval(BiOp::MODULO, linb::any(7), linb::any(2.5));
+          }) == "missing operator");
+
+  for(const auto o : {UnOp::BOOL, UnOp::NEGATIVE, UnOp::POSITIVE, UnOp::NOT}) {
+    for(const auto& rhs : lhss) {
+      const auto f = eval([&] { return fast.eval(o, rhs); });
+      const auto g = eval([&] { return generic.eval(o, rhs); });
+
+      REQUIRE(f == g);
+    }
+  }
+}
@@ -2,11 +2,18 @@
 
 #include "cad/macro/ast/Literal.h"
 #include "cad/macro/ast/Scope.h"
+#include "cad/macro/ast/ScopeArena.h"
 #include "cad/macro/ast/ValueProducer.h"
+#include "cad/macro/interpreter/OperatorProvider.h"
 #include "cad/macro/parser/Parser.h"
 
 #include <exception.h>
 
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
 using namespace cad::macro::parser;
 using namespace cad::macro::ast;
 using namespace cad::macro::ast::callable;
@@ -152,6 +159,32 @@ TEST_CASE("Callable") {
     REQUIRE_THROWS_AS(parse("fun ();def main() {}"), ExceptionBase<UserE>);
   }
 
+  SECTION("Async") {
+    auto line1 = std::make_shared<std::string>("async fun();");
+
+    Scope expected({0, 0, ""});
+    {
+      Callable fun({1, 7, "fun", line1});
+      fun.async = true;
+
+      expected.nodes.push_back(std::move(fun));
+      add_main_to_root_end(expected, line1);
+    }
+
+    auto ast = parse(*line1);
+    REQUIRE(ast == expected);
+  }
+
+  SECTION("Async as operand") {
+    REQUIRE_NOTHROW(parse("var a = async fun(); def main(){}"));
+    REQUIRE_THROWS_AS(parse("var a = 1 + async fun(); def main(){}"),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse("gun(a: async fun()); def main(){}"),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse("def main(){ return async fun(); }"),
+                      ExceptionBase<UserE>);
+  }
+
   SECTION("Parameter") {
     auto line1 =
         std::make_shared<std::string>("var herbert; fun(foo:herbert);");
@@ -1651,6 +1684,89 @@ TEST_CASE("For") {
   }
 }
 
+TEST_CASE("Parallel for") {
+  SECTION("Reduction") {
+    auto line1 = std::make_shared<std::string>(
+        "def main() {var s;parallel for(var i = 0;i < 1;) reduce(sum: s){}}");
+
+    Scope expected({0, 0, ""});
+    {
+      Define def_m({1, 1, "def", line1});
+      EntryFunction main({1, 5, "main", line1});
+      Define def_s({1, 13, "var", line1});
+      For f({1, 19, "parallel", line1});
+      Define def_i({1, 32, "var", line1});
+      Operator op_as({1, 38, "=", line1});
+      Operator op_sm({1, 44, "<", line1});
+      Literal<Literals::INT> lit0({1, 40, "0", line1});
+      Literal<Literals::INT> lit1({1, 46, "1", line1});
+
+      main.scope = std::make_unique<Scope>(Token(1, 12, "{", line1));
+      def_s.definition = Variable({1, 17, "s", line1});
+      def_i.definition = Variable({1, 36, "i", line1});
+      lit0.data = 0;
+      lit1.data = 1;
+
+      op_as.operation = Operation::ASSIGNMENT;
+      op_as.left_operand =
+          std::make_unique<ValueProducer>(Variable({1, 36, "i", line1}));
+      op_as.right_operand = std::make_unique<ValueProducer>(std::move(lit0));
+      op_sm.operation = Operation::SMALLER;
+      op_sm.left_operand =
+          std::make_unique<ValueProducer>(Variable({1, 42, "i", line1}));
+      op_sm.right_operand = std::make_unique<ValueProducer>(std::move(lit1));
+
+      f.parallel = true;
+      f.define = std::move(def_i);
+      f.variable = {std::move(op_as)};
+      f.condition = std::make_unique<ValueProducer>(std::move(op_sm));
+      f.reductions.push_back(
+          {For::Reduction::Kind::SUM, Variable({1, 62, "s", line1})});
+      f.scope = std::make_unique<Scope>(Token(1, 64, "{", line1));
+
+      main.scope->nodes.push_back(std::move(def_s));
+      main.scope->nodes.push_back(std::move(f));
+      def_m.definition = std::move(main);
+      expected.nodes.push_back(std::move(def_m));
+    }
+
+    auto ast = parse(*line1);
+    REQUIRE(ast == expected);
+  }
+
+  SECTION("Independent iterations") {
+    auto loop = [](std::string reduce, std::string body) {
+      return "def main() {var s = 0; parallel for(var i = 0; i < 2; "
+             "i = i + 1)" +
+             reduce + "{" + body + "}}";
+    };
+
+    REQUIRE_NOTHROW(parse(loop("", "var t = i; print t;")));
+    REQUIRE_NOTHROW(parse(loop("", "i = i + 1;")));
+    REQUIRE_NOTHROW(parse(loop(" reduce(sum: s)", "s = i;")));
+    REQUIRE_NOTHROW(parse(loop(" reduce(min: s)", "var t = 0; t = s;")));
+    REQUIRE_NOTHROW(parse(loop("", "while(true){ break; }")));
+    REQUIRE_NOTHROW(parse(loop("", "def f(){ return 1; } f();")));
+    REQUIRE_THROWS_AS(parse(loop("", "s = i;")), ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop("", "if(true){ s = i; }")),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop(" reduce(sum: t)", "")),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop(" reduce(sum: s, max: s)", "")),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop(" reduce(avg: s)", "")),
+                      ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop("", "break;")), ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop("", "continue;")), ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse(loop("", "return 1;")), ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(
+        parse("def main() {var s = 0; parallel for(; s < 2;){}}"),
+        ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse("def main() {parallel while(true){}}"),
+                      ExceptionBase<UserE>);
+  }
+}
+
 // TEST_CASE("Complete") {
 //   const std::string raw_macro = "\n"
 //                                 "var a = true;              \n"
@@ -1703,6 +1819,8 @@ TEST_CASE("return and break last") {
   SECTION("return") {
     REQUIRE_THROWS_AS(parse("def main(){return 1; 1 + 1;}"),
                       ExceptionBase<UserE>);
+    REQUIRE_THROWS_AS(parse("def main(){return 1; return 1;}"),
+                      ExceptionBase<UserE>);
   }
   SECTION("break") {
     REQUIRE_THROWS_AS(parse("def main(){while(true){break; 1;}}"),
@@ -1782,3 +1900,307 @@ TEST_CASE("missing condition") {
   REQUIRE_THROWS_AS(parse("def main(){do{}while();}"), ExceptionBase<UserE>);
   REQUIRE_THROWS_AS(parse("def main(){while(){}}"), ExceptionBase<UserE>);
 }
+
+TEST_CASE("Constant folding") {
+  using OperatorProvider = cad::macro::interpreter::OperatorProvider;
+  OperatorProvider op;
+
+  const auto output = [](const Scope& root) -> const ValueProducer& {
+    const auto* def = root.nodes.at(0).target<Define>();
+    REQUIRE(def);
+    const auto* fun = def->definition.target<EntryFunction>();
+    REQUIRE(fun);
+    const auto* ret = fun->scope->nodes.at(0).target<Return>();
+    REQUIRE(ret);
+    return *ret->output;
+  };
+
+  SECTION("Folded") {
+    auto ast = parse("def main(){return 2 * (3 + 4);}", "Anonymous", &op);
+    const auto* lit = output(ast).value.target<Literal<Literals::INT>>();
+
+    REQUIRE(lit);
+    REQUIRE(lit->data == 14);
+  }
+  SECTION("String") {
+    auto ast = parse("def main(){return \"prefix_\" + 3;}", "Anonymous", &op);
+    const auto* lit = output(ast).value.target<Literal<Literals::STRING>>();
+
+    REQUIRE(lit);
+    REQUIRE(lit->data == "prefix_3");
+  }
+  SECTION("Disabled") {
+    auto ast = parse("def main(){return 2 * (3 + 4);}");
+    REQUIRE(output(ast).value.target<Operator>());
+  }
+  SECTION("Partially") {
+    auto ast = parse("def main(a){return a * (3 + 4);}", "Anonymous", &op);
+    const auto* mul = output(ast).value.target<Operator>();
+
+    REQUIRE(mul);
+    REQUIRE(mul->left_operand->value.target<Variable>());
+    const auto* lit =
+        mul->right_operand->value.target<Literal<Literals::INT>>();
+    REQUIRE(lit);
+    REQUIRE(lit->data == 7);
+  }
+  SECTION("Missing operator") {
+    auto ast = parse("def main(){return \"a\" - \"b\";}", "Anonymous", &op);
+    REQUIRE(output(ast).value.target<Operator>());
+  }
+  SECTION("Division by zero") {
+    auto ast = parse("def main(){return 1 / 0;}", "Anonymous", &op);
+    REQUIRE(output(ast).value.target<Operator>());
+  }
+}
+
+TEST_CASE("Function tables") {
+  auto ast = parse("var a = 1;"
+                   "def fun(){"
+                   "  while(true) {"
+                   "    def inner(){}"
+                   "    break;"
+                   "  }"
+                   "}"
+                   "def main(){}");
+
+  REQUIRE(ast.functions.size() == 2);
+  REQUIRE(ast.function(0).token.text() == "fun");
+  REQUIRE(ast.function(1).token.text() == "main");
+
+  const auto& fun = ast.function(0);
+  REQUIRE(fun.scope->functions.empty());
+
+  const auto* whi = fun.scope->nodes.at(0).target<While>();
+  REQUIRE(whi);
+  REQUIRE(whi->scope->functions.size() == 1);
+  REQUIRE(whi->scope->function(0).token.text() == "inner");
+}
+
+TEST_CASE("Scope arena") {
+  const auto ast = parse("def fun(){ while(true){} }"
+                         "def main(){ if(true){} else {} }");
+
+  // the bodies of both functions, the while and both parts of the if
+  REQUIRE(ast.arena);
+  REQUIRE(ast.arena->size() == 5);
+
+  const auto copy = ast.function(0);
+  REQUIRE(copy.scope.get() == ast.function(0).scope.get());
+
+  SECTION("Copy outlives the root") {
+    const auto fun = []() {
+      const auto root = parse("def fun(a){ while(a){ a = a - 1; } }"
+                              "def main(){}");
+      return root.function(0);
+    }();
+
+    REQUIRE(fun.token.text() == "fun");
+    REQUIRE(fun.scope->nodes.size() == 1);
+    const auto* whi = fun.scope->nodes.at(0).target<While>();
+    REQUIRE(whi);
+    REQUIRE(whi->scope->nodes.size() == 1);
+  }
+}
+
+TEST_CASE("Variable addresses") {
+  using Slots = std::vector<std::experimental::string_view>;
+  const auto operation = [](const Scope::Node& node) -> const Operator& {
+    const auto* op = node.target<Operator>();
+    REQUIRE(op);
+    return *op;
+  };
+  const auto variable = [](const std::unique_ptr<ValueProducer>& value)
+      -> const Variable& {
+    REQUIRE(value);
+    const auto* var = value->value.target<Variable>();
+    REQUIRE(var);
+    return *var;
+  };
+
+  SECTION("Function") {
+    auto ast = parse("var a;"
+                     "def fun(b){"
+                     "  var c;"
+                     "  def inner(){ return c; }"
+                     "  a = b;"
+                     "}"
+                     "def main(){}");
+
+    REQUIRE(ast.frame.slots == Slots{"a"});
+
+    const auto& fun = ast.function(0);
+    REQUIRE(fun.parameter.at(0).address.slot == 0);
+    // the parameters come first, an assigned outer variable is shadowed
+    REQUIRE(fun.scope->frame.slots == Slots{"b", "a", "c"});
+    REQUIRE(fun.scope->frame.shadows.size() == 1);
+    REQUIRE(fun.scope->frame.shadows.at(0).outer.depth == 1);
+    REQUIRE(fun.scope->frame.shadows.at(0).outer.slot == 0);
+    REQUIRE(fun.scope->frame.shadows.at(0).slot == 1);
+
+    const auto* def = fun.scope->nodes.at(0).target<Define>();
+    REQUIRE(def);
+    REQUIRE(def->definition.target<Variable>()->address.slot == 2);
+
+    const auto& assign = operation(fun.scope->nodes.at(2));
+    REQUIRE(variable(assign.left_operand).address.depth == 0);
+    REQUIRE(variable(assign.left_operand).address.slot == 1);
+    REQUIRE(variable(assign.right_operand).address.depth == 0);
+    REQUIRE(variable(assign.right_operand).address.slot == 0);
+
+    // a nested function reads the frame it is defined in
+    const auto& inner = fun.scope->function(0);
+    REQUIRE(inner.scope->frame.slots.empty());
+    const auto* ret = inner.scope->nodes.at(0).target<Return>();
+    REQUIRE(ret);
+    REQUIRE(variable(ret->output).address.depth == 1);
+    REQUIRE(variable(ret->output).address.slot == 2);
+  }
+
+  SECTION("Parallel") {
+    auto ast = parse("def main(){"
+                     "  var s;"
+                     "  parallel for(var i = 0; i < 2;) reduce(sum: s){"
+                     "    s = i;"
+                     "  }"
+                     "}");
+
+    const auto& main = ast.function(0);
+    const auto* foor = main.scope->nodes.at(1).target<For>();
+    REQUIRE(foor);
+    // the loop variable and then the reductions
+    REQUIRE(foor->scope->frame.slots == Slots{"i", "s"});
+    REQUIRE(foor->reductions.at(0).variable.address.depth == 0);
+
+    const auto& assign = operation(foor->scope->nodes.at(0));
+    REQUIRE(variable(assign.left_operand).address.depth == 0);
+    REQUIRE(variable(assign.left_operand).address.slot == 1);
+    REQUIRE(variable(assign.right_operand).address.depth == 0);
+    REQUIRE(variable(assign.right_operand).address.slot == 0);
+  }
+}
+
+TEST_CASE("Operator precedence") {
+  // renders the Operator trees with brackets around every Operator
+  std::function<std::string(const ValueProducer&)> render =
+      [&render](const ValueProducer& value) -> std::string {
+    const auto* op = value.value.target<Operator>();
+    if(!op) {
+      const auto* var = value.value.target<Variable>();
+      REQUIRE(var);
+      return var->token.text().to_string();
+    }
+    if(!op->left_operand) {
+      return "(" + op->token.text().to_string() + " " +
+             render(*op->right_operand) + ")";
+    }
+    return "(" + render(*op->left_operand) + " " +
+           op->token.text().to_string() + " " + render(*op->right_operand) +
+           ")";
+  };
+  const auto parsed = [&render](const std::string& expression) {
+    auto ast = parse("def main(a, b, c, d){return " + expression + ";}");
+    const auto* def = ast.nodes.at(0).target<Define>();
+    REQUIRE(def);
+    const auto* fun = def->definition.target<EntryFunction>();
+    REQUIRE(fun);
+    const auto* ret = fun->scope->nodes.at(0).target<Return>();
+    REQUIRE(ret);
+    return render(*ret->output);
+  };
+
+  SECTION("Binary") {
+    REQUIRE(parsed("a + b * c") == "(a + (b * c))");
+    REQUIRE(parsed("a * b + c") == "((a * b) + c)");
+    REQUIRE(parsed("a - b - c") == "((a - b) - c)");
+    REQUIRE(parsed("a / b % c * d") == "(((a / b) % c) * d)");
+    REQUIRE(parsed("a < b == c >= d") == "((a < b) == (c >= d))");
+    REQUIRE(parsed("a || b && c || d") == "((a || (b && c)) || d)");
+    REQUIRE(parsed("a = b = c + d") == "(a = (b = (c + d)))");
+  }
+  SECTION("Unary") {
+    REQUIRE(parsed("-a * -b") == "((- a) * (- b))");
+    REQUIRE(parsed("a - -b") == "(a - (- b))");
+    REQUIRE(parsed("!a == typeof b") == "((! a) == (typeof b))");
+    REQUIRE(parsed("a = print b || c") == "(a = (print (b || c)))");
+  }
+  SECTION("Brackets") {
+    REQUIRE(parsed("(a + b) * c") == "((a + b) * c)");
+    REQUIRE(parsed("(a + b) - c") == "((a + b) - c)");
+  }
+  SECTION("Generated") {
+    // the reference grammar: the operators from the weakest to the strongest
+    // binding one, a leaf binds strongest and a print is bracketed wherever it
+    // is an operand, its own operand reaches up to an assignment
+    struct Reference {
+      const char* text;
+      int power;
+      bool unary;
+      bool right;  // right to left
+    };
+    const std::vector<Reference> references = {
+        {"=", 1, false, true},       {"print", 0, true, false},
+        {"||", 3, false, false},     {"&&", 4, false, false},
+        {"==", 5, false, false},     {"!=", 5, false, false},
+        {"<", 6, false, false},      {"<=", 6, false, false},
+        {">", 6, false, false},      {">=", 6, false, false},
+        {"+", 7, false, false},      {"-", 7, false, false},
+        {"*", 8, false, false},      {"/", 8, false, false},
+        {"%", 8, false, false},      {"-", 9, true, false},
+        {"+", 9, true, false},       {"!", 9, true, false},
+        {"typeof", 9, true, false},
+    };
+    const int leaf = 10;
+    const int print_operand = 3;
+    const std::vector<std::string> variables = {"a", "b", "c", "d"};
+
+    struct Expression {
+      std::string minimal;  // only the brackets the reference grammar needs
+      std::string full;     // brackets around every operator
+      int power;
+    };
+    const auto bracket = [](const Expression& e, const bool needed) {
+      return needed ? "(" + e.minimal + ")" : e.minimal;
+    };
+
+    std::mt19937 random(2305);
+    std::function<Expression(int)> generate = [&](const int depth) {
+      std::uniform_int_distribution<std::size_t> variable(
+          0, variables.size() - 1);
+      if(depth == 0 || random() % 4 == 0) {
+        const auto& name = variables.at(variable(random));
+        return Expression{name, name, leaf};
+      }
+      std::uniform_int_distribution<std::size_t> pick(0,
+                                                      references.size() - 1);
+      const auto& ref = references.at(pick(random));
+
+      if(ref.unary) {
+        const auto operand = generate(depth - 1);
+        const auto reach = ref.power == 0 ? print_operand : ref.power;
+        return Expression{
+            std::string(ref.text) + " " +
+                bracket(operand, operand.power < reach),
+            "(" + std::string(ref.text) + " " + operand.full + ")", ref.power};
+      }
+      // an assignment needs a variable on its left hand side
+      const auto left = ref.power == 1 ? generate(0) : generate(depth - 1);
+      const auto right = generate(depth - 1);
+      return Expression{
+          bracket(left, left.power < ref.power ||
+                            (ref.right && left.power == ref.power)) +
+              " " + ref.text + " " +
+              bracket(right, right.power < ref.power ||
+                                 (!ref.right && right.power == ref.power)),
+          "(" + left.full + " " + ref.text + " " + right.full + ")",
+          ref.power};
+    };
+
+    for(int i = 0; i < 500; ++i) {
+      const auto expression = generate(4);
+      CAPTURE(expression.minimal);
+      REQUIRE(parsed(expression.minimal) == expression.full);
+      REQUIRE(parsed(expression.full) == expression.full);
+    }
+  }
+}
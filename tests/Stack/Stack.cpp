@@ -5,16 +5,18 @@
 #include "cad/macro/ast/callable/Callable.h"
 #include "cad/macro/ast/callable/Function.h"
 
+using Address = cad::macro::ast::Address;
 using Function = cad::macro::ast::callable::Function;
 using Callable = cad::macro::ast::callable::Callable;
+using Value = cad::macro::interpreter::Value;
 
 class TestStack : public cad::macro::interpreter::Stack {
 public:
   TestStack() {
+    reset(nullptr, 0, 2);
   }
-  TestStack(std::shared_ptr<TestStack> parent)
-      : cad::macro::interpreter::Stack(
-            std::dynamic_pointer_cast<Stack>(parent)) {
+  TestStack(TestStack* parent) {
+    reset(parent, 0, 2);
   }
   auto& variables() {
     return variables_;
@@ -33,35 +35,39 @@ CATCH_TRANSLATE_EXCEPTION(std::exception& e) {
 TEST_CASE("Variable") {
   TestStack stack;
 
-  REQUIRE(stack.variables().empty());
-  REQUIRE_FALSE(stack.has_variable("foo"));
-  REQUIRE_FALSE(stack.owns_variable("foo"));
+  REQUIRE(stack.variables().size() == 2);
+  REQUIRE_FALSE(stack.has_variable(1));
+  REQUIRE_FALSE(stack.owns_variable(1));
+  REQUIRE_THROWS(stack.variable(Address{0, 1}, "foo"));
 
   SECTION("Add") {
-    stack.add_variable("foo");
+    stack.add_variable(1, "foo");
 
-    REQUIRE(stack.variables().size() == 1);
-    REQUIRE(stack.has_variable("foo"));
-    REQUIRE(stack.owns_variable("foo"));
-    REQUIRE_FALSE(stack.is_alias("foo"));
+    REQUIRE(stack.has_variable(1));
+    REQUIRE(stack.owns_variable(1));
+    REQUIRE_FALSE(stack.has_variable(0));
+    REQUIRE_THROWS(stack.add_variable(1, "foo"));
 
     SECTION("Access") {
-      stack.variable("foo", [](linb::any& foo) { foo = 1; });
+      stack.variable(1) = 1;
 
-      stack.variable("foo", [](linb::any& foo) {
-        REQUIRE(linb::any_cast<int>(foo) == 1);
-      });
+      REQUIRE(linb::any_cast<int>(stack.variable(1)) == 1);
+      REQUIRE(linb::any_cast<int>(stack.variable(Address{0, 1}, "foo")) == 1);
 
       SECTION("Move") {
-        linb::any my_foo;
-        stack.variable("foo",
-                       [&my_foo](linb::any& foo) { my_foo = std::move(foo); });
+        linb::any my_foo = std::move(stack.variable(1));
 
         int foo = linb::any_cast<int>(my_foo);
         REQUIRE(foo == 1);
       }
     }
   }
+  SECTION("Assign") {
+    stack.assign(1) = 2;
+
+    REQUIRE(stack.owns_variable(1));
+    REQUIRE(linb::any_cast<int>(stack.variable(1)) == 2);
+  }
 }
 
 TEST_CASE("Function") {
@@ -79,26 +85,34 @@ TEST_CASE("Function") {
     REQUIRE(stack->has_function(call));
 
     stack->function(
-        call, [&](const Function& fun, auto) { REQUIRE(orig_fun == fun); });
+        call, [&](const Function& fun, auto&) { REQUIRE(orig_fun == fun); });
+
+    SECTION("Resolve") {
+      cad::macro::interpreter::Stack* defined = nullptr;
+      auto child = std::make_shared<TestStack>(stack.get());
+
+      REQUIRE(child->resolve_function(call, defined) == &orig_fun);
+      REQUIRE(defined == stack.get());
+      REQUIRE(child->resolve_function(Callable({0, 0, "gun"}), defined) ==
+              nullptr);
+    }
 
     SECTION("Access") {
-      stack->function(call, [](const Function& fun, auto) {
+      stack->function(call, [](const Function& fun, auto&) {
         // yes yes evil and so on ... We are tester, we are evil, we are legion
-        const_cast<Function*>(&fun)->token.line = 1;
+        const_cast<Function*>(&fun)->token.integer = 1;
       });
-      stack->function(call, [](const Function& fun, auto) {
-        REQUIRE(fun.token.line == 1);
+      stack->function(call, [](const Function& fun, auto&) {
+        REQUIRE(fun.token.integer == 1);
       });
 
       SECTION("Move") {
         Function my_fun;
         stack->function(
             call, [&my_fun](const Function& fun,
-                            std::shared_ptr<cad::macro::interpreter::Stack>) {
-              my_fun = fun;
-            });
+                            cad::macro::interpreter::Stack&) { my_fun = fun; });
 
-        REQUIRE(my_fun.token.line == 1);
+        REQUIRE(my_fun.token.integer == 1);
       }
     }
   }
@@ -106,51 +120,69 @@ TEST_CASE("Function") {
 
 TEST_CASE("Parent") {
   auto stack_a = std::make_shared<TestStack>();
-  auto stack_b = std::make_shared<TestStack>(stack_a);
-  REQUIRE(stack_a == stack_b->parent());
+  auto stack_b = std::make_shared<TestStack>(stack_a.get());
+  REQUIRE(stack_a.get() == stack_b->parent());
 
   SECTION("Variable") {
     SECTION("Parent has not") {
-      REQUIRE_FALSE(stack_b->has_variable("foo"));
-      REQUIRE_FALSE(stack_b->owns_variable("foo"));
-      REQUIRE_FALSE(stack_b->is_alias("foo"));
-
-      REQUIRE_FALSE(stack_b->has_variable("bar"));
-      REQUIRE_FALSE(stack_b->owns_variable("bar"));
-      REQUIRE_FALSE(stack_b->is_alias("bar"));
-
+      REQUIRE_FALSE(stack_b->has_variable(0));
+      REQUIRE_THROWS(stack_b->variable(Address{1, 0}, "foo"));
 
       SECTION("Parent has") {
-        stack_a->add_variable("foo");
-        stack_a->variable("foo", [](linb::any& foo) { foo = 42; });
+        stack_a->add_variable(0, "foo");
+        stack_a->variable(0) = 42;
 
-        REQUIRE(stack_b->has_variable("foo"));
-        REQUIRE_FALSE(stack_b->owns_variable("foo"));
-        REQUIRE_FALSE(stack_b->is_alias("foo"));
+        REQUIRE_FALSE(stack_b->has_variable(0));
+        REQUIRE(linb::any_cast<int>(stack_b->variable(Address{1, 0}, "foo")) ==
+                42);
 
         SECTION("Add alias") {
-          stack_a->variable("foo", [&stack_b](linb::any& foo) {
-            stack_b->add_alias("bar", foo);
-          });
-          REQUIRE(stack_b->has_variable("bar"));
-          REQUIRE_FALSE(stack_b->owns_variable("bar"));
-          REQUIRE(stack_b->is_alias("bar"));
+          stack_b->add_alias(1, "bar", stack_a->variable(0));
+          REQUIRE(stack_b->has_variable(1));
+          REQUIRE_FALSE(stack_b->owns_variable(1));
 
           SECTION("Use alias") {
-            stack_b->variable("bar", [](linb::any& bar) {
-              REQUIRE(linb::any_cast<int>(bar) == 42);
-            });
+            REQUIRE(linb::any_cast<int>(stack_b->variable(1)) == 42);
           }
 
-          SECTION("Remove alias") {
-            stack_b->remove_alias("bar");
+          SECTION("Assign alias") {
+            stack_b->assign(1) = 7;
 
-            REQUIRE_FALSE(stack_b->has_variable("bar"));
-            REQUIRE_FALSE(stack_b->owns_variable("bar"));
-            REQUIRE_FALSE(stack_b->is_alias("bar"));
+            REQUIRE(stack_b->owns_variable(1));
+            REQUIRE(linb::any_cast<int>(stack_b->variable(1)) == 7);
+            REQUIRE(linb::any_cast<int>(stack_a->variable(0)) == 42);
           }
         }
       }
     }
   }
 }
+
+TEST_CASE("Slot") {
+  auto parent = std::make_shared<cad::macro::interpreter::Stack>(nullptr, 1);
+  auto child =
+      std::make_shared<cad::macro::interpreter::Stack>(parent.get(), 2);
+
+  REQUIRE_FALSE(child->has_slot(0));
+  REQUIRE_FALSE(child->has_slot(1));
+  REQUIRE(child->ancestor(0) == child.get());
+  REQUIRE(child->ancestor(1) == parent.get());
+  REQUIRE(child->ancestor(2) == nullptr);
+
+  SECTION("Add") {
+    child->add_slot(1, "foo");
+    REQUIRE(child->has_slot(1));
+    REQUIRE_FALSE(child->has_slot(0));
+    REQUIRE_THROWS(child->add_slot(1, "foo"));
+
+    SECTION("Access") {
+      child->slot(1) = Value(42);
+      REQUIRE(child->slot(1).as_int() == 42);
+    }
+  }
+  SECTION("Parent") {
+    child->ancestor(1)->add_slot(0, "bar");
+    REQUIRE(parent->has_slot(0));
+    REQUIRE_FALSE(child->has_slot(0));
+  }
+}
@@ -10,7 +10,7 @@ std::vector<std::string> tokens_to_strings(const std::vector<Token>& tokens) {
   stokens.reserve(tokens.size());
 
   for(const auto& t : tokens) {
-    stokens.push_back(t.token);
+    stokens.push_back(t.text().to_string());
   }
   return stokens;
 }
@@ -314,3 +314,90 @@ TEST_CASE("Token Comparison") {
     REQUIRE_FALSE(a == b);
   }
 }
+
+TEST_CASE("Shared source") {
+  const std::string raw_macro = "var a;\r\n  a = \"b\nc\";\n/* d */ e";
+  auto tokens = tokenizer::tokenize(raw_macro);
+
+  REQUIRE(tokens.size() == 8);
+  for(const auto& t : tokens) {
+    REQUIRE(t.source() == tokens.front().source());
+    REQUIRE(raw_macro.compare(t.offset, t.length, t.text().to_string()) ==
+            0);
+  }
+  REQUIRE(tokens.front().source()->text() == raw_macro);
+  REQUIRE(tokens[3].line() == 3);
+  REQUIRE(tokens[3].column() == 3);
+  REQUIRE(tokens[7].line() == 5);
+  REQUIRE(tokens[7].column() == 9);
+  REQUIRE(tokens[0].source_line() == "var a;");
+  REQUIRE(tokens[3].source_line() == "  a = \"b");
+  REQUIRE(tokens[5].source_line() == "  a = \"b");
+  REQUIRE(tokens[7].source_line() == "/* d */ e");
+  REQUIRE(Token(1, 1, "a").source_line() == "");
+  // the Token only points into the Source
+  REQUIRE(sizeof(Token) <= 32);
+}
+
+TEST_CASE("Token kinds") {
+  SECTION("Kinds") {
+    using K = Token::Kind;
+    const std::vector<K> expected = {
+        K::KEYWORD,     K::IDENTIFIER,  K::OPERATOR,    K::INT,
+        K::OPERATOR,    K::DOUBLE,      K::OPERATOR,    K::DOUBLE,
+        K::PUNCTUATION, K::IDENTIFIER,  K::OPERATOR,    K::STRING,
+        K::PUNCTUATION, K::OTHER,       K::OTHER,       K::OTHER,
+        K::OTHER};
+    const std::string raw_macro =
+        "var a_1 = 3 + 0.5 * .25; b <= \"c\"; Abc 1a @ \"d";
+    auto tokens = tokenizer::tokenize(raw_macro);
+
+    REQUIRE(tokens.size() == expected.size());
+    for(size_t i = 0; i < tokens.size(); ++i) {
+      REQUIRE(tokens[i].kind == expected[i]);
+    }
+  }
+  SECTION("Numbers") {
+    auto tokens =
+        tokenizer::tokenize("0 42 007 12.5 .125 2147483647 99999999999");
+
+    REQUIRE(tokens.size() == 7);
+    REQUIRE(tokens[0].integer == 0);
+    REQUIRE(tokens[1].integer == 42);
+    REQUIRE(tokens[2].integer == 7);
+    REQUIRE(tokens[3].number == Approx(12.5));
+    REQUIRE(tokens[4].number == Approx(0.125));
+    REQUIRE(tokens[5].integer == 2147483647);
+    REQUIRE(tokens[6].integer > 2147483647);
+  }
+  SECTION("Strings") {
+    auto tokens = tokenizer::tokenize(
+        "\"a\\\"b\" \"\\n\\t\\/\\\\\" \"\\\\n\" \"\\x\" \"a\nb\"");
+
+    REQUIRE(tokens.size() == 5);
+    REQUIRE(tokens[0].content() == "a\"b");
+    REQUIRE(tokens[1].content() == "\n\t/\\");
+    REQUIRE(tokens[2].content() == "\\n");
+    REQUIRE(tokens[3].content() == "\\x");
+    REQUIRE(tokens[4].content() == "a\nb");
+  }
+  SECTION("Keywords") {
+    using K = Token::Keyword;
+    const std::vector<K> expected = {
+        K::IF,       K::ELSE,     K::DO,     K::WHILE,  K::FOR,
+        K::VAR,      K::DEF,      K::CONTINUE, K::MAIN, K::BREAK,
+        K::RETURN,   K::TRUE,     K::FALSE,  K::TYPEOF, K::PRINT,
+        K::ASYNC,    K::PARALLEL, K::REDUCE, K::NONE,   K::NONE,
+        K::NONE,     K::NONE};
+    auto tokens = tokenizer::tokenize(
+        "if else do while for var def continue main break return true false "
+        "typeof print async parallel reduce iff fi returns Main");
+
+    REQUIRE(tokens.size() == expected.size());
+    for(size_t i = 0; i < tokens.size(); ++i) {
+      REQUIRE(tokens[i].keyword == expected[i]);
+      REQUIRE((tokens[i].kind == Token::Kind::KEYWORD)
+              == (expected[i] != K::NONE));
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#include <Catch/catch.hpp>
+
+#include "cad/macro/interpreter/Value.h"
+
+#include <string>
+
+using Value = cad::macro::interpreter::Value;
+
+namespace {
+struct Foo {
+  int bar;
+};
+}
+
+TEST_CASE("Value") {
+  SECTION("Empty") {
+    Value v;
+    REQUIRE(v.empty());
+    REQUIRE(v.type() == Value::Type::EMPTY);
+    REQUIRE(v.to_any().empty());
+    REQUIRE(Value::from_any(linb::any()).empty());
+  }
+  SECTION("Inline") {
+    REQUIRE(Value(true).type() == Value::Type::BOOL);
+    REQUIRE(Value(true).as_bool());
+    REQUIRE(Value(42).type() == Value::Type::INT);
+    REQUIRE(Value(42).as_int() == 42);
+    REQUIRE(Value(4.2).type() == Value::Type::DOUBLE);
+    REQUIRE(Value(4.2).as_double() == 4.2);
+    REQUIRE(Value(42).type_info() == typeid(int));
+  }
+  SECTION("String") {
+    Value v(std::string("foo"));
+    Value copy = v;
+
+    REQUIRE(v.type() == Value::Type::STRING);
+    REQUIRE(v.type_info() == typeid(std::string));
+    // copies share the immutable string
+    REQUIRE(&copy.as_string() == &v.as_string());
+    REQUIRE(linb::any_cast<std::string>(v.to_any()) == "foo");
+  }
+  SECTION("From any") {
+    REQUIRE(Value::from_any(linb::any(true)).type() == Value::Type::BOOL);
+    REQUIRE(Value::from_any(linb::any(42)).as_int() == 42);
+    REQUIRE(Value::from_any(linb::any(4.2)).as_double() == 4.2);
+    REQUIRE(Value::from_any(linb::any(std::string("foo"))).as_string() ==
+            "foo");
+  }
+  SECTION("Boxed") {
+    const linb::any any = Foo{42};
+    const auto v = Value::from_any(any);
+
+    REQUIRE(v.type() == Value::Type::BOXED);
+    REQUIRE(v.type_info() == typeid(Foo));
+    REQUIRE(linb::any_cast<Foo>(v.to_any()).bar == 42);
+
+    SECTION("Move") {
+      const auto moved = Value::from_any(linb::any(Foo{42}));
+
+      REQUIRE(moved.type() == Value::Type::BOXED);
+      REQUIRE(linb::any_cast<Foo>(moved.as_boxed()).bar == 42);
+    }
+  }
+}